@@ -2,18 +2,90 @@ ROOT="$(dirname `dirname $0`)"
 cd $ROOT
 
 SCRIPTS="tests/scripts"
+UNICODE_SCRIPTS="tests/unicode"
+FCGI="tests/fcgi"
 MALCO="build/malco"
+MALCO_UNICODE="build/unicode/malco"
 RESULT=0
 
-for filename in $SCRIPTS/*.rasm; do
-    echo "[tests] Compiling test `basename $filename`"
-    $MALCO -c $filename
-    if [ "$?" == 0 ] ; then
-        echo "[tests] Test `basename $filename` success"
-    else
-        echo "[tests] Test `basename $filename` error"
+# runs every script of a directory with the given build of malco
+run_tests() {
+    malco=$1
+    dir=$2
+    for filename in $dir/*.rasm; do
+        name=`basename $filename .rasm`
+        echo "[tests] Compiling test `basename $filename`"
+        $malco -c $filename
+        if [ "$?" != 0 ] ; then
+            echo "[tests] Test `basename $filename` error: could not compile"
+            RESULT=1
+            continue
+        fi
+
+        # run the script, leaving out the lines that differ between runs
+        echo "[tests] Running test `basename $filename`"
+        $malco -b test.rbc > test.log 2>&1
+        status=$?
+        grep -v '^Exec time: \|^Regex cache: ' test.log > test.out
+
+        if [ "$status" != 0 ] ; then
+            cat test.log; echo
+            echo "[tests] Test `basename $filename` error: exit code $status"
+            RESULT=1
+        elif grep -q 'Uncaught exception:\|Internal error:' test.log ; then
+            cat test.log; echo
+            echo "[tests] Test `basename $filename` error: uncaught exception"
+            RESULT=1
+        elif [ -f $dir/$name.out ] && ! diff -u $dir/$name.out test.out ; then
+            echo "[tests] Test `basename $filename` error: output differs from $name.out"
+            RESULT=1
+        else
+            echo "[tests] Test `basename $filename` success"
+        fi
+    done
+}
+
+# plays a script in FastCGI mode and checks the answers to two interleaved requests
+run_fcgi_test() {
+    malco=../../$1
+    echo "[tests] Running FastCGI test"
+    cd $FCGI
+    $malco -c hello.rasm > /dev/null
+    $malco -fcgi test.rbc > test.log 2>&1 &
+    server=$!
+
+    if ! python3 client.py test.sock > test.out ; then
+        cat test.log; echo
+        echo "[tests] FastCGI test error: no answer"
+        RESULT=1
+    elif ! diff -u hello.out test.out ; then
+        echo "[tests] FastCGI test error: output differs from hello.out"
         RESULT=1
+    else
+        echo "[tests] FastCGI test success"
     fi
-done
+
+    kill $server
+    wait $server 2> /dev/null
+    rm -f test.rbc test.rdt test.rst test.sock test.log test.out
+    cd ../..
+}
+
+run_tests $MALCO $SCRIPTS
+run_fcgi_test $MALCO
+
+# the same scripts and the UTF-8 ones with strings in unicode mode
+echo "[tests] Building with MALCO_UNICODE"
+mkdir -p build/unicode
+if (cd build/unicode && cmake -DMALCO_UNICODE=ON ../.. && cmake --build .) > build/unicode.log 2>&1 ; then
+    run_tests $MALCO_UNICODE $SCRIPTS
+    run_tests $MALCO_UNICODE $UNICODE_SCRIPTS
+else
+    cat build/unicode.log
+    echo "[tests] Unicode build error"
+    RESULT=1
+fi
+
+rm -f test.rbc test.rdt test.rst test.log test.out
 
 exit $RESULT
@@ -28,10 +28,15 @@ class ic_string;
 
 class ic_regex;
 class ic_match;
+class ic_matchiter;
+class ic_regexset;
 class ic_time;
 class ic_lambda;
 class ic_range;
 class ic_array;
+class ic_lazy;
+class ic_thread;
+class ic_generator;
 
 class ic_file;
 class ic_dir;
@@ -56,18 +61,42 @@ class sc_list;
 class sc_stack;
 class sc_queue;
 
-class sc_mapitem;
+template <typename T> class sc_hashmapitem;
+template <typename T> class sc_hashmap;
 class sc_map;
-class sc_voidmapitem;
-class sc_voidmap;
 
-template <typename T> class sc_anymapitem;
-template <typename T> class sc_anymap;
+typedef sc_hashmapitem<ic_string *> sc_mapitem;
+typedef sc_hashmapitem<void *> sc_voidmapitem;
+typedef sc_hashmap<void *> sc_voidmap;
+
+template <typename T> using sc_anymapitem = sc_hashmapitem<T *>;
+template <typename T> using sc_anymap = sc_hashmap<T *>;
 
 class sc_ini;
 class sc_file;
 class sc_md5;
 class sc_random;
+class sc_strpoolitem;
+class sc_strpool;
+class sc_number;
+class sc_utf8;
+class sc_regex;
+class sc_regexcacheitem;
+class sc_regexcache;
+class sc_strset;
+class sc_numarray;
+template <typename T, typename C> class sc_sort;
+template <typename T, typename C> class sc_hashset;
+class sc_taskpool;
+class sc_reactor;
+class sc_aioreq;
+class sc_aiobatch;
+class sc_aio;
+class sc_request;
+class sc_httprequest;
+class sc_fcgirequest;
+class sc_fcgiconn;
+class sc_httpserver;
 
 //--------------------------------
 //       rc_ classes family
@@ -107,10 +136,101 @@ class rc_vartable;
 #define FILE_APPEND                 4
 #define FILE_REPLACE                8
 #define FILE_BINARY                 16
-
-#define REGEX_MAX_MATCHES           10
+#define FILE_CHUNK                  65536
+#define FILE_MAP_WINDOW             16777216
+#define FILE_COPY_BUF               1048576
+#define FILE_COPY_KERNEL            1073741824
+#define DIR_FILES                   1
+#define DIR_DIRS                    2
+
+#define REGEX_MAX_REPEAT            1000
+#define REGEX_MAX_PROGRAM           32768
+#define REGEX_DFA_MAX_STATES        1024
+#define REGEX_BACKTRACK_LIMIT       10000000
+#define REGEX_LITERAL_MAX           64
+
+#define REGEX_ICASE                 1
+#define REGEX_EXTENDED              2
+#define REGEX_MULTILINE             4
+#define REGEX_DOTALL                8
+
+#define STRPOOL_MIN_SIZE            256
+
+#define ARRAY_MIN_SIZE              16
+
+#define HASHMAP_GROUP               16
+#define HASHMAP_MIN_SIZE            16
+#define HASHMAP_EMPTY               0x80
+#define HASHMAP_DELETED             0xFE
+
+#define NUMARRAY_EXACT_INT          9007199254740992.0
+
+#define SORT_MIN_MERGE              32
+#define SORT_MAX_RUNS               96
+
+#define HASHSET_MIN_SIZE            16
+
+#define POOL_EACH                   1
+#define POOL_MAP                    2
+#define POOL_SELECT                 3
+
+#define SOCKET_TCP                  1
+#define SOCKET_UDP                  2
+#define SOCKET_UNIX                 3
+#define SOCKET_CHUNK                65536
+
+#define REACTOR_EVENTS              64
+
+#define AIO_READ                    1
+#define AIO_WRITE                   2
+#define AIO_STEP_OPEN               1
+#define AIO_STEP_STAT               2
+#define AIO_STEP_IO                 3
+#define AIO_STEP_CLOSE              4
+#define AIO_RING_ENTRIES            256
+
+#define HTTP_CHUNK                  16384
+#define HTTP_MAX_HEAD               16384
+#define HTTP_MAX_HEADERS            100
+
+#define FCGI_VERSION                1
+#define FCGI_BEGIN_REQUEST          1
+#define FCGI_ABORT_REQUEST          2
+#define FCGI_END_REQUEST            3
+#define FCGI_PARAMS                 4
+#define FCGI_STDIN                  5
+#define FCGI_STDOUT                 6
+#define FCGI_STDERR                 7
+#define FCGI_DATA                   8
+#define FCGI_GET_VALUES             9
+#define FCGI_GET_VALUES_RESULT      10
+#define FCGI_UNKNOWN_TYPE           11
+#define FCGI_RESPONDER              1
+#define FCGI_KEEP_CONN              1
+#define FCGI_REQUEST_COMPLETE       0
+#define FCGI_UNKNOWN_ROLE           3
+#define FCGI_HEADER_LEN             8
+#define FCGI_MAX_CONTENT            65528
+#define FCGI_MAX_PARAMS             65536
+
+#define LAZY_RANGE                  1
+#define LAZY_ARRAY                  2
+#define LAZY_MAP                    1
+#define LAZY_SELECT                 2
+#define LAZY_REJECT                 3
+#define LAZY_TAKE                   4
+#define LAZY_ZIP                    5
+
+#define REGEXCACHE_MAX_ITEMS        256
+#define REGEXCACHE_MAX_MEMORY       4194304
+#define REGEXCACHE_MIN_SIZE         64
+
+#define NUMBER_BUF_SIZE             32
+
+#define STR_INDEX_STEP              64
 
 typedef void(*native_func)(rc_head*);
+typedef bool(*pool_task)(rc_head*, long, void*);
 
 //****************************************************************
 //*                                                              *
@@ -224,6 +344,13 @@ class ic_string
   int mNumBuffers;                /**< Number of buffers in the string. */
   long mLength;                   /**< Total length of the string. */
   long mCapacity;                 /**< Total capacity of the string. */
+  long mChars;                    /**< Number of UTF-8 characters, -1 if not counted yet. */
+  long mIndexLength;              /**< Byte length the character index was built for. */
+  long *mIndex;                   /**< Byte offsets of every STR_INDEX_STEP-th character. */
+
+  void grow(long len);
+  void index();
+  void index_reset();
 
   public:
   ic_string();
@@ -240,14 +367,19 @@ class ic_string
   void append(const char *src, long new_len=0);
   void append(const ic_string *src, long new_len=0);
   void append(char src);
+  void append_int(long src);
+  void append_float(double src);
+  void reserve(long cpc);
   void prepend(const char *src, long new_len=0);
   void prepend(ic_string *src, long new_len=0);
   void prepend(char src);
 
   void reverse();
+  void reverse_chars();
   long replace(const char *from, char *to, long max=0);
   long replace(ic_string *from, ic_string *to, long max=0);
   long replace(ic_regex *from, ic_string *to, long max=0);
+  long replace(sc_strset *from, ic_string **to, long max=0);
   void translate(char *from, char *to, long fromlen=0, long tolen=0);
   void translate(ic_string *from, ic_string *to);
   void case_up();
@@ -258,6 +390,11 @@ class ic_string
 
   char &char_at(long pos) const;
   ic_string *substr_get(long start, long len=0);
+  ic_string *substr_chars(long start, long len=0);
+  long chars();
+  long char_offset(long pos);
+  long char_code(long pos);
+  bool is_utf8();
   void substr_set(long start, long len, const char *to);
   void substr_set(long start, long len, ic_string *to);
   long substr_first(const char *str, long offset=0);
@@ -318,12 +455,13 @@ class ic_string
  * The regular expression class.
  * Provides methods for regular expression compilation and matching.
  */
-#include <regex>
-
 class ic_regex
 {
+  friend class ic_matchiter;
+  friend class ic_regexset;
+
   private:
-  std::regex mRegEx;                          /**< The regular expression implementation. */
+  sc_regex *mProgram;                         /**< Compiled program. */
   const char *pError;                         /**< Error message. */
   int mErrorOffset;                           /**< Offset at which regex couldn't compile. */
 
@@ -337,8 +475,8 @@ class ic_regex
   ~ic_regex();
 
   void set(const char *pattern);
-  ic_match *match(const char *str, int offset=0, long len=0);
-  ic_match *match(ic_string *str, int offset=0);
+  ic_match *match(const char *str, long offset=0, long len=0);
+  ic_match *match(ic_string *str, long offset=0);
 
   void study();
 
@@ -352,9 +490,6 @@ class ic_regex
   ic_regex &operator=(ic_regex &right);
   bool operator== (ic_regex &right);
   bool operator!= (ic_regex &right);
-
-private:
-  void set(const char *pattern, std::regex::flag_type flags);
 };
 
 /**
@@ -362,25 +497,106 @@ private:
  * The regular expression result class.
  * Provides info about successful regular expression match.
  * Shouldn't be created by the user, it's returned by ic_regex::match instead.
- * @todo implement
+ * Keeps its own copy of the matched text, so it stays valid when the source string changes.
  */
 class ic_match
 {
   friend class ic_regex;
+  friend class ic_matchiter;
 
   private:
-  long mCount;                                /**< Number of matches found. */
-  int mMatches[REGEX_MAX_MATCHES*2];          /**< Found match bounds. */
-  const char *pString;                        /**< String to be matched. */
-  char *mSubstrings[REGEX_MAX_MATCHES];       /**< Pointers to requested substrings. */
+  long mCount;                                /**< Number of substrings (0 if nothing matched). */
+  long *mMatches;                             /**< Substring bounds, -1 for unset groups. */
+  char *mSource;                              /**< Copy of the source string part covered by substrings. */
+  long mBase;                                 /**< Offset of the copied part in the source string. */
+  char **mSubstrings;                         /**< Pointers to requested substrings. */
   ic_match();
 
+  void set(const char *str, const long *captures, long count);
+  void clear();
+
   public:
   ~ic_match();
 
   long count();
-  const char *get(int id);
-  void bounds(int id, long *where);
+  const char *get(long id);
+  void bounds(long id, long *where);
+
+  ic_match &operator=(ic_match &right);
+};
+
+
+/**
+ * @class ic_matchiter
+ * Lazy iterator over all matches of a regex in a string.
+ * Each step resumes the search where the previous match ended, so the string
+ * is scanned once however many matches it has. An empty match is never
+ * repeated: the next search starts one character after it.
+ */
+class ic_matchiter
+{
+  private:
+  ic_regex *pRegex;                           /**< Regex being matched, must outlive the iterator. */
+  const char *pString;                        /**< String being scanned. */
+  long mLength;                               /**< Length of the string. */
+  long mOffset;                               /**< Position to resume from, -1 when finished. */
+  long mCount;                                /**< Number of substrings in every match. */
+  long *mCaptures;                            /**< Substring bounds of the current match. */
+
+  public:
+  ic_matchiter(ic_regex *regex, const char *str, long len=0, long offset=0);
+  ~ic_matchiter();
+
+  void source(const char *str, long len);
+  bool find();
+  ic_match *next();
+
+  long count();
+  const long *captures();
+};
+
+
+/**
+ * @class ic_regexset
+ * The regular expression set class.
+ * Tells which of many regular expressions match a string. The regexes are
+ * compiled into one automaton, so the string is read once whatever their
+ * number is. Sets of plain strings are searched by an Aho-Corasick dictionary.
+ */
+class ic_regexset
+{
+  private:
+  ic_regex **mItems;                          /**< Regexes of the set. */
+  long mLength;                               /**< Number of regexes. */
+  long mSize;                                 /**< Allocated room for regexes. */
+
+  sc_regex **mPrograms;                       /**< Combined programs, NULL for a regex matched on its own. */
+  long *mFirst;                               /**< First regex of every program, followed by mLength. */
+  long mNumPrograms;                          /**< Number of combined programs. */
+  char *mExact;                               /**< Whether the combined program decides the regex by itself. */
+  sc_strset *mLiterals;                       /**< Dictionary used when all regexes are plain strings. */
+  bool mCompiled;                             /**< Programs are up to date. */
+
+  void compile();
+  void compile_range(long from, long to);
+  void forget();
+  static bool literal(ic_regex *regex, ic_string *str);
+
+  public:
+  ic_regexset();
+  ~ic_regexset();
+
+  void add(ic_regex *regex);
+  void add(const char *pattern);
+  void clear();
+
+  long length();
+  ic_regex *get(long id);
+  long match(const char *str, long len, char *found);
+
+  bool to_b();
+
+  ic_regexset &operator=(ic_regexset &right);
 };
 
 
@@ -437,6 +653,8 @@ class ic_time
  * Represents an range, allows iterating it and checking values
  * for being inside.
  */
+#include <string>
+
 class ic_range
 {
   private:
@@ -496,6 +714,7 @@ class ic_object
 
   sc_voidmap *mMembers;       /**< Object members. */
   bool mFrozen;               /**< Flag indicating the object is frozen (no further modifications allowed). */
+  bool mShared;               /**< Flag indicating the object is a shared constant (copied on assignment or modification). */
   bool mTainted;              /**< Flag indicating the object is tainted. */
   void *mData;                /**< Object binary data (ic_*). */
   rc_class *pClass;           /**< Object class. */
@@ -512,6 +731,20 @@ class ic_object
  */
 class ic_file
 {
+  private:
+  char *mBuf;                   /**< Line reader buffer. */
+  long mBufStart;               /**< Offset of the first unread byte in the buffer. */
+  long mBufEnd;                 /**< Number of bytes in the buffer. */
+  long mBufCapacity;            /**< Size of the buffer. */
+  char *mMap;                   /**< Mapped file, read instead of the buffer. */
+  long mMapLength;              /**< Length of the mapped file. */
+  long mMapDropped;             /**< Length of the mapping already released to the system. */
+  long mLinePos;                /**< Position of the line reader in the file. */
+  bool mReading;                /**< The line reader is ahead of the stream. */
+
+  bool reader();
+  void sync();
+
   public:
   FILE *mFile;                  /**< File object. */
   char *mName;                  /**< File path / name. */
@@ -521,12 +754,14 @@ class ic_file
   ic_file(const char *name);
   ic_file(ic_string *name);
   ~ic_file();
+  ic_file &operator=(const ic_file &file);
 
   void choose(const char *name);
   void choose(ic_string *name);
   bool open(char mode);
   void close();
   ic_string *read(long size);
+  bool read_line(const char **line, long *length);
   bool write(const char *data, long size = 0);
   bool write(ic_string *data, long size = 0);
 
@@ -556,25 +791,33 @@ class ic_dir
 {
   private:
   char *mName;
-  long mLength;
+  void *mIter;                  /**< Directory stream being iterated. */
 
-  bool copy_r(const char *from, const char *to);
+  bool copy_r(const char *from, const char *to, sc_voidarray *files, void *top);
   bool remove_r(const char *name);
+  static char *path(const char *dir, const char *name);
+  static bool copy_item(rc_head *head, long item, void *data);
 
   public:
   ic_dir();
   ic_dir(const char *path);
   ic_dir(ic_string *path);
+  ~ic_dir();
+  ic_dir &operator=(const ic_dir &dir);
 
-  bool copy(const char *name);
-  bool copy(ic_string *name);
+  void choose(const char *name);
+  void choose(ic_string *name);
+  bool exists();
+  bool copy(const char *name, sc_taskpool *pool = NULL);
+  bool copy(ic_string *name, sc_taskpool *pool = NULL);
   bool rename(const char *name);
   bool rename(ic_string *name);
   bool create();
-  bool remove();
+  bool remove(bool really = false);
   long length();
+  char *to_s();
 
-  ic_string *iter_next();
+  ic_string *iter_next(char type = 0);
   void iter_rewind();
 };
 
@@ -582,25 +825,50 @@ class ic_dir
 /**
  * @class ic_socket
  * The socket class.
- * Represents a network socket object.
+ * Represents a non-blocking TCP, UDP or Unix domain socket.
+ * Data is received straight into the input string and data that could
+ * not be sent at once waits in the output string for the reactor.
  */
 class ic_socket
 {
   private:
-  char *mName;                  /**< Socket path / name. */
-  char mMode;                   /**< Socket access mode. */
+  long mSent;                   /**< Number of output bytes sent already. */
+
+  bool create(int family);
+  bool address(const char *host, long port, void *addr, long *len);
 
   public:
-  ic_socket();
-  ic_socket(const char *name);
-  ic_socket(ic_string *name);
+  int mFd;                      /**< Descriptor, -1 if the socket is not open. */
+  char mType;                   /**< SOCKET_TCP, SOCKET_UDP or SOCKET_UNIX. */
+  bool mListening;              /**< Flag indicating the socket accepts connections. */
+  bool mEof;                    /**< Flag indicating the peer has closed the connection. */
+  ic_string *mInput;            /**< Data received, but not read yet. */
+  ic_string *mOutput;           /**< Data written, but not sent yet. */
+  rc_var *pOnRead;              /**< Method called when there is data to read or a connection to accept. */
+  rc_var *pOnWrite;             /**< Method called once everything written has been sent. */
+  rc_var *pWatch;               /**< Variable held by the reactor while the socket is watched. */
+  int mEvents;                  /**< Events the socket is watched for. */
+
+  ic_socket(char type = SOCKET_TCP);
   ~ic_socket();
 
-  bool open(char mode);
+  bool listen(const char *host, long port);
+  bool connect(const char *host, long port);
+  bool accept(ic_socket *conn);
+  bool copy(ic_socket *sock);
   void close();
-  ic_string *read(long size);
-  bool write(const char *data, long size = 0);
-  bool write(ic_string *data, long size = 0);
+
+  long fill();
+  long flush();
+  ic_string *read(long size = 0);
+  ic_string *read_line();
+  bool write(const char *data, long size);
+  bool write(ic_string *data);
+  long pending();
+
+  bool to_b();
+  long to_i();
+  const char *to_s();
 };
 
 
@@ -608,16 +876,27 @@ class ic_socket
  * @class ic_array
  * The array class.
  * Represents a homogenous dynamic array containing ic_objects.
- * Actually it is a wrapper around sc_voidmap class.
+ * While the keys are 0..n-1 in order, values are kept in a plain vector indexed
+ * by number and have no keys made for them. Any other key moves the items into
+ * a sc_voidmap for good. Iterating a packed array gives out a single cursor item.
  */
 class ic_array
 {
   private:
   long mCurrIdx;                /**< Current iteration index. */
   rc_var *mCurr;                /**< Current object. */
-  sc_voidmap *mItems;           /**< Array storage. */
+  rc_var **mValues;             /**< Values of a packed array, value N having key N. */
+  long mLength;                 /**< Number of packed values. */
+  long mSize;                   /**< Allocated size of the packed vector. */
+  sc_voidmap *mItems;           /**< Array storage once unpacked, NULL before. */
+  sc_voidmapitem *mCursor;      /**< Item handed out by the iteration of a packed array. */
   ic_int mAutoIndex;            /**< Automatic index generator. */
 
+  void push(rc_var *obj);
+  void unpack();
+  sc_voidmapitem *cursor(long idx);
+  static long index(const char *key);
+
   public:
   bool mFinished;               /**< Flag indicating the iteration has finished. */
 
@@ -627,18 +906,24 @@ class ic_array
   void append(rc_var *obj, bool check = true);
   void set(ic_string *key, rc_var *obj);
   void set(const char *key, rc_var *obj);
+  void set(long key, rc_var *obj);
   void unset(ic_string *key);
   void unset(const char *key);
+  void unset(long key);
   void clear();
   rc_var *get(ic_string *key);
   rc_var *get(const char *key);
+  rc_var *get(long key);
   void copy(ic_array *arr);
+  void reindex();
 
   sc_voidmapitem *iter_next();
+  sc_voidmapitem *iter_next(long &pos);
   sc_voidmapitem *iter_last();
   void iter_rewind();
 
   long length();
+  bool packed();
 
   bool to_b();
   long to_i();
@@ -646,6 +931,128 @@ class ic_array
 };
 
 
+/**
+ * @class ic_lazy
+ * The lazy enumerator class.
+ * Describes a range or an array with a chain of stages (map, select, reject,
+ * take, zip) applied to it. Nothing is computed until the items are requested,
+ * then every item passes all the stages before the next one is taken.
+ * Variables the enumerator refers to are listed in mVars, each holding a link.
+ */
+class ic_lazy
+{
+  public:
+  struct stage
+  {
+    char mType;                 /**< Stage type, LAZY_MAP etc. */
+    rc_var *pArg;               /**< Method or zipped enumerator. */
+    long mCount;                /**< Number of items to take. */
+  };
+
+  char mSource;                 /**< Source type, LAZY_RANGE or LAZY_ARRAY. */
+  long mStart;                  /**< First value of the range. */
+  long mEnd;                    /**< Last value of the range. */
+  rc_var *pArray;               /**< Source array. */
+  sc_voidarray *mVars;          /**< Variables held by the enumerator. */
+
+  ic_lazy();
+  ~ic_lazy();
+
+  void set(long start, long end);
+  void set(rc_var *arr);
+  void add(char type, rc_var *arg = NULL, long count = 0);
+  void link();
+
+  long length();
+  stage *get(long idx);
+
+  bool to_b();
+  const char *to_s();
+
+  ic_lazy &operator=(ic_lazy &right);
+
+  private:
+  stage *mStages;               /**< Stages in the order of application. */
+  long mLength;                 /**< Number of stages. */
+  long mSize;                   /**< Allocated room for stages. */
+};
+
+
+/**
+ * @class ic_thread
+ * The thread class.
+ * Runs a method on an execution head of it's own in a separate OS thread.
+ * All heads share the program image of the core (tape, string table and classes),
+ * which is not modified after rc_core::image_seal(), but never share objects:
+ * arguments, the result and messages are deep-copied by rc_head::obj_copy().
+ */
+class ic_thread
+{
+  public:
+  rc_head *mHead;               /**< Execution head of the thread, NULL when finished. */
+  rc_core *pCore;               /**< Core the thread has been started by, NULL until then. */
+  rc_method *pMethod;           /**< Method being run. */
+  rc_var *mResult;              /**< Value returned by the method or the exception it has thrown. */
+  bool mFailed;                 /**< The method has thrown an exception. */
+
+  ic_thread();
+  ~ic_thread();
+
+  void start(rc_head *parent, rc_method *method);
+  void join();
+  bool alive();
+
+  void send(rc_var *msg);
+  rc_var *receive();
+  void reply(rc_var *msg);
+  rc_var *listen();
+  void wake();
+  rc_var *drain();
+
+  bool to_b();
+  const char *to_s();
+
+  private:
+  std::mutex mLock;             /**< Guards the mailboxes. */
+  std::condition_variable mSignal; /**< Signalled when a message arrives or the thread ends. */
+  sc_queue *mInbox;             /**< Messages sent to the thread. */
+  sc_queue *mOutbox;            /**< Messages sent by the thread. */
+  std::atomic<bool> mRunning;   /**< The method is still running. */
+
+  void run();
+};
+
+
+/**
+ * @class ic_generator
+ * The generator class.
+ * Runs a method on an execution head of it's own, which is suspended by every
+ * YIELD command and resumed when the next value is requested. The frames of a
+ * suspended method stay in the head's call stack, not on the C stack, so any
+ * number of generators can be suspended at once. Objects are shared with the
+ * head that has created the generator, as both run in the same thread.
+ */
+class ic_generator
+{
+  public:
+  rc_head *mHead;               /**< Execution head of the generator. */
+  rc_method *pMethod;           /**< Method being run. */
+  bool mStarted;                /**< The method has been called. */
+  bool mFinished;               /**< The method has returned or thrown an exception. */
+
+  ic_generator();
+  ~ic_generator();
+
+  void start(rc_head *parent, rc_method *method);
+  bool resume();
+  rc_var *value();
+  rc_var *error();
+
+  bool to_b();
+  const char *to_s();
+};
+
+
 /**
  * @class sc_exception
  * The exception class.
@@ -812,265 +1219,134 @@ class sc_queue: public sc_list
 
 
 /**
- * @class sc_mapitem
- * Stores a record of sc_map.
- * A sc_map tree node containing it's key and value as ic_strings.
+ * @class sc_hashmapitem
+ * Stores a record of sc_hashmap.
+ * Items are allocated one by one, so pointers to them survive the table growing.
  */
-class sc_mapitem
+template <typename T>
+class sc_hashmapitem
 {
   public:
-  int mBalance;           /**< Balance of the current item. */
-  sc_mapitem *mLink[2];   /**< Links to left and right children. */
-  sc_mapitem *pRoot;      /**< Link to parent item. */
-  ic_string *mKey;        /**< Key. */
-  ic_string *mValue;      /**< Value. */
-  sc_mapitem *pPrev;      /**< Pointer to previous item. */
-  sc_mapitem *pNext;      /**< Pointer to next item. */
+  ic_string *mKey;              /**< Key. */
+  unsigned long mHash;          /**< Precomputed key hash. */
+  T mValue;                     /**< Value. */
+  long mIndex;                  /**< Position in the order of insertion. */
 
-  sc_mapitem();
-  sc_mapitem(const char *key, const char *val);
-  ~sc_mapitem();
+  sc_hashmapitem(const char *key, T val, unsigned long hash);
+  ~sc_hashmapitem();
 };
 
 
 /**
- * @class sc_map
+ * @class sc_hashmap
  * The hash table / map class.
- * Provides a hash table with both keys and values being ic_strings.
- * Is implemented as an AVL tree.
+ * Provides a hash table with keys being ic_strings, iterated in the order of insertion.
+ * Is implemented with open addressing: slots are probed in groups, each slot having
+ * a control byte with 7 bits of the key hash, and a whole group of control bytes
+ * is compared at once.
  */
-class sc_map
+template <typename T>
+class sc_hashmap
 {
   private:
-  long mLength;  /**< Length of the map. */
-
-  // tree rotation methods
-  void adjust_balance(sc_mapitem *root, int dir, int bal);
-  sc_mapitem *rotate_single(sc_mapitem *root, int dir);
-  sc_mapitem *rotate_double(sc_mapitem *root, int dir);
-
-  sc_mapitem *insert(const char *key, const char *val);
-  sc_mapitem *insert_r(sc_mapitem *root, const char *key, const char *val, int *done, sc_mapitem **item);
-  sc_mapitem *insert_balance(sc_mapitem *root, int dir);
-
-  sc_mapitem *remove_r(sc_mapitem *root, const char *key, int *done);
-  sc_mapitem *remove_balance(sc_mapitem *root, int dir, int *done);
-
-  void clear_r(sc_mapitem *item);
-
-  sc_mapitem *find(const char *key);
+  unsigned char *mCtrl;         /**< Control bytes, one per slot. */
+  sc_hashmapitem<T> **mSlots;   /**< Items by slots. */
+  long mCapacity;               /**< Number of slots, a power of two. */
+  long mUsed;                   /**< Number of slots either full or deleted. */
+  sc_hashmapitem<T> **mItems;   /**< Items in the order of insertion, NULL for removed ones. */
+  long mNumItems;               /**< Number of used places in mItems. */
+  long mItemsSize;              /**< Allocated size of mItems. */
+  long mFirst;                  /**< Index of the first item, all places before it are empty. */
+  long mLength;                 /**< Length of the map. */
+  long mCurr;                   /**< Current index for iteration. */
+
+  long slot_find(const char *key, unsigned long hash);
+  long slot_free(unsigned long hash);
+  void insert(sc_hashmapitem<T> *item);
+  void rehash(long capacity);
+
+  static unsigned char ctrl_byte(unsigned long hash);
+  static unsigned int group_match(const unsigned char *group, unsigned char ctrl);
+  static unsigned int group_free(const unsigned char *group);
+  static int bit_first(unsigned int mask);
 
   public:
-  sc_mapitem *mRoot;      /**< Root item of the tree. */
-  sc_mapitem *mCurr;      /**< Current item for iteration. */
-  sc_mapitem *mCurrKey;   /**< Current item for key-based iteration. */
-  sc_mapitem *mFirst;     /**< First item of the linked list. */
-  sc_mapitem *mLast;      /**< Last item of the linked list. */
-  sc_map();
-  sc_map(sc_map &map);
-  ~sc_map();
-
-  void set(const char *key, const char *value);
-  void set(const char *key, ic_string *value);
-  void set(ic_string *key, ic_string *value);
-  char *get(const char *key);
-  char *get(ic_string *key);
+  sc_hashmap();
+  sc_hashmap(sc_hashmap &map);
+  ~sc_hashmap();
+
+  sc_hashmapitem<T> *find(const char *key);
+  sc_hashmapitem<T> *find(const char *key, unsigned long hash);
+  void set(const char *key, T value);
+  void set(const char *key, unsigned long hash, T value);
+  void set(ic_string *key, T value);
+  void adopt(sc_hashmapitem<T> *item);
+  T get(const char *key);
+  T get(const char *key, unsigned long hash);
+  T get(ic_string *key);
   void remove(const char *key);
   void remove(ic_string *key);
 
   void clear();
 
   void iter_rewind();
-  sc_mapitem *iter_next();
-  void key_rewind();
-  sc_mapitem *key_next();
+  sc_hashmapitem<T> *iter_next();
+  sc_hashmapitem<T> *iter_next(long &pos);
+  sc_hashmapitem<T> *last();
 
   long length();
 
   sc_voidarray *get_keys();
 
-  ic_string &operator[](const char *key);
-  ic_string &operator[](ic_string &key);
-  ic_string &operator[](ic_string *key);
+  T operator[](const char *key);
+  T operator[](ic_string &key);
+  T operator[](ic_string *key);
 
 #if MALCO_DEBUG == 1
-  void debug(sc_mapitem *item = NULL);
+  void debug();
 #endif
 };
 
 
-
 /**
- * @class sc_voidmapitem
- * Stores a record of sc_voidmap.
- * A sc_voidmap tree node containing it's key as ic_string and value as void *.
- */
-class sc_voidmapitem
-{
-  public:
-  int mBalance;               /**< Balance of the current item. */
-  sc_voidmapitem *mLink[2];   /**< Links to left and right children. */
-  sc_voidmapitem *pRoot;      /**< Link to parent item. */
-  ic_string *mKey;            /**< Key. */
-  void *mValue;               /**< Value. */
-  sc_voidmapitem *pPrev;      /**< Pointer to previous item. */
-  sc_voidmapitem *pNext;      /**< Pointer to next item. */
-
-  sc_voidmapitem();
-  sc_voidmapitem(const char *key, void *val);
-  ~sc_voidmapitem();
-};
-
-
-/**
- * @class sc_voidmap
- * The hash table / map class.
- * Provides a hash table with keys being ic_strings and values being void *.
- * Is implemented as an AVL tree.
+ * @class sc_map
+ * The string map class.
+ * Provides a hash table with both keys and values being ic_strings.
+ * Is a wrapper around sc_hashmap that owns the values.
  */
-class sc_voidmap
+class sc_map
 {
   private:
-  long mLength;               /**< Length of the map. */
-
-  // tree rotation methods
-  void adjust_balance(sc_voidmapitem *root, int dir, int bal);
-  sc_voidmapitem *rotate_single(sc_voidmapitem *root, int dir);
-  sc_voidmapitem *rotate_double(sc_voidmapitem *root, int dir);
-
-  sc_voidmapitem *insert(const char *key, void *val);
-  sc_voidmapitem *insert_r(sc_voidmapitem *root, const char *key, void *val, int *done, sc_voidmapitem **item);
-  sc_voidmapitem *insert_balance(sc_voidmapitem *root, int dir);
-
-  sc_voidmapitem *remove_r(sc_voidmapitem *root, const char *key, int *done);
-  sc_voidmapitem *remove_balance(sc_voidmapitem *root, int dir, int *done);
-
-  void clear_r(sc_voidmapitem *item);
+  sc_hashmap<ic_string *> mItems;  /**< Map storage. */
 
   public:
-  sc_voidmapitem *mRoot;      /**< Root item of the tree. */
-  sc_voidmapitem *mCurr;      /**< Current item for iteration. */
-  sc_voidmapitem *mCurrKey;   /**< Current item for key-based iteration. */
-  sc_voidmapitem *mFirst;     /**< First item of the linked list. */
-  sc_voidmapitem *mLast;      /**< Last item of the linked list. */
-
-  sc_voidmap();
-  sc_voidmap(sc_voidmap &map);
-  ~sc_voidmap();
+  sc_map();
+  sc_map(sc_map &map);
+  ~sc_map();
 
-  sc_voidmapitem *find(const char *key);
-  void set(const char *key, void *value);
-  void set(ic_string *key, void *value);
-  void *get(const char *key);
-  void *get(ic_string *key);
+  void set(const char *key, const char *value);
+  void set(const char *key, ic_string *value);
+  void set(ic_string *key, ic_string *value);
+  char *get(const char *key);
+  char *get(ic_string *key);
   void remove(const char *key);
   void remove(ic_string *key);
 
   void clear();
 
   void iter_rewind();
-  sc_voidmapitem *iter_next();
-  void key_rewind();
-  sc_voidmapitem *key_next();
+  sc_mapitem *iter_next();
 
   long length();
 
   sc_voidarray *get_keys();
 
-  void *operator[](const char *key);
-  void *operator[](ic_string &key);
-  void *operator[](ic_string *key);
-
-#if MALCO_DEBUG == 1
-  void debug(sc_voidmapitem *item = NULL);
-#endif
-};
-
-/**
- * @class sc_anymapitem
- * Templated map item class.
- */
-template <typename T>
-class sc_anymapitem
-{
-  public:
-  int mBalance;               /**< Balance of the current item. */
-  sc_anymapitem *mLink[2];    /**< Links to left and right children. */
-  sc_anymapitem *pRoot;       /**< Link to parent item. */
-  ic_string *mKey;            /**< Key. */
-  T *mValue;                  /**< Value. */
-  sc_anymapitem *pPrev;       /**< Pointer to previous item. */
-  sc_anymapitem *pNext;       /**< Pointer to next item. */
-
-  sc_anymapitem();
-  sc_anymapitem(const char *key, T *val);
-  ~sc_anymapitem();
+  ic_string &operator[](const char *key);
+  ic_string &operator[](ic_string &key);
+  ic_string &operator[](ic_string *key);
 };
 
 
-/**
- * @class sc_anymap
- */
-template <typename T>
-class sc_anymap
-{
-private:
-  long mLength;               /**< Length of the map. */
-
-  // tree rotation methods
-  void adjust_balance(sc_anymapitem<T> *root, int dir, int bal);
-  sc_voidmapitem *rotate_single(sc_anymapitem<T> *root, int dir);
-  sc_voidmapitem *rotate_double(sc_anymapitem<T> *root, int dir);
-
-  sc_voidmapitem *insert(const char *key, void *val);
-  sc_voidmapitem *insert_r(sc_anymapitem<T> *root, const char *key, T *val, int *done, sc_anymapitem<T> **item);
-  sc_voidmapitem *insert_balance(sc_anymapitem<T> *root, int dir);
-
-  sc_voidmapitem *remove_r(sc_anymapitem<T> *root, const char *key, int *done);
-  sc_voidmapitem *remove_balance(sc_anymapitem<T> *root, int dir, int *done);
-
-  void clear_r(sc_anymapitem<T> *item);
-
-  sc_anymapitem<T> *find(const char *key);
-
-public:
-  sc_anymapitem<T> *mRoot;      /**< Root item of the tree. */
-  sc_anymapitem<T> *mCurr;      /**< Current item for iteration. */
-  sc_anymapitem<T> *mCurrKey;   /**< Current item for key-based iteration. */
-  sc_anymapitem<T> *mFirst;     /**< First item of the linked list. */
-  sc_anymapitem<T> *mLast;      /**< Last item of the linked list. */
-
-  sc_anymap();
-  sc_anymap(sc_anymap &map);
-  ~sc_anymap();
-
-  void set(const char *key, T *value);
-  void set(ic_string *key, T *value);
-  T *get(const char *key);
-  T *get(ic_string *key);
-  void remove(const char *key);
-  void remove(ic_string *key);
-
-  void clear();
-
-  void iter_rewind();
-  sc_anymapitem<T>  *iter_next();
-  void key_rewind();
-  sc_anymapitem<T> *key_next();
-
-  long length();
-
-  sc_voidarray *get_keys();
-
-  T *operator[](const char *key);
-  T *operator[](ic_string &key);
-  T *operator[](ic_string *key);
-
-#if MALCO_DEBUG == 1
-  void debug(sc_anymapitem<T> *item = NULL);
-#endif
-};
-
 /**
  * @class sc_ini_section
  * Stores a section for sc_ini.
@@ -1162,7 +1438,7 @@ class sc_md5
 class sc_file
 {
   private:
-  static char mStrBuf[16];
+  static thread_local char mStrBuf[16];
 
   public:
   static long time(const char *name);
@@ -1177,6 +1453,8 @@ class sc_file
   static bool remove(const char *name);
   static bool remove(ic_string *name);
 
+  static bool copy(const char *from, const char *to);
+
   static char *checksum(const char *name);
   static char *checksum(ic_string *name);
 };
@@ -1197,11 +1475,873 @@ class sc_random
   private:
   static int state[624]; // 624 is magic number
   static int index;
+  static std::mutex mLock;      /**< Guards the state, as all threads share the generator. */
 
   static void generate();
 };
 
 
+/**
+ * @class sc_strpoolitem
+ * Stores a record of sc_strpool.
+ * Contains an interned string, it's length and precomputed hash.
+ */
+class sc_strpoolitem
+{
+  public:
+  char *mString;              /**< Interned string. */
+  long mLength;               /**< String length. */
+  unsigned long mHash;        /**< Precomputed hash. */
+};
+
+
+/**
+ * @class sc_strpool
+ * The string interning pool.
+ * Keeps a single copy of every interned string, so that equal identifiers
+ * share storage and may be compared by pointer. Interned strings are never released.
+ */
+class sc_strpool
+{
+  public:
+  static unsigned long hash(const char *str, long len = 0);
+  static sc_strpoolitem *find(const char *str, long len = 0);
+  static sc_strpoolitem *add(const char *str, long len = 0);
+  static const char *intern(const char *str, long len = 0);
+  static long length();
+
+  private:
+  static sc_strpoolitem **mItems;   /**< Open-addressed table of records. */
+  static long mSize;                /**< Table capacity (power of 2). */
+  static long mLength;              /**< Number of interned strings. */
+  static std::mutex mLock;          /**< Guards the table, as strings may be added by any thread. */
+
+  static void grow();
+};
+
+
+/**
+ * @class sc_number
+ * Number <-> string conversions.
+ * Integers are printed two digits at a time, floats are printed with the
+ * shortest representation that reads back to the same value (Grisu3, with
+ * a slow search for the few values it cannot decide).
+ * Neither formatting nor parsing depends on the current locale.
+ */
+class sc_number
+{
+  public:
+  static long format_int(char *buf, long value);
+  static long format_float(char *buf, double value);
+  static long parse_int(const char *str, long len = 0);
+  static double parse_float(const char *str, long len = 0);
+
+  private:
+  struct diyfp
+  {
+    uint64_t f;               /**< Significand. */
+    int e;                    /**< Binary exponent. */
+  };
+
+  struct cached_power
+  {
+    uint64_t f;               /**< Normalized significand of 10^k. */
+    int e;                    /**< Binary exponent of 10^k. */
+    int k;                    /**< Decimal exponent. */
+  };
+
+  static const char mDigits[201];           /**< "00".."99" digit pairs. */
+  static const cached_power mPowers[79];    /**< 10^k for k = -300..324 step 8. */
+  static const double mExact[23];           /**< Exactly representable powers of 10. */
+
+  static long format_uint(char *buf, uint64_t value);
+  static diyfp mul(diyfp x, diyfp y);
+  static diyfp normalize(diyfp x);
+  static bool grisu3(char *buf, int &len, int &exp, double value);
+  static bool round_weed(char *buf, int len, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t ten_k, uint64_t unit);
+  static void shortest(char *buf, int &len, int &exp, double value);
+};
+
+
+/**
+ * @class sc_utf8
+ * UTF-8 helpers used by strings in unicode mode (MALCO_UNICODE).
+ */
+class sc_utf8
+{
+  public:
+  static bool is_tail(char chr);
+  static bool validate(const char *str, long len);
+  static long length(const char *str, long len);
+  static long next(const char *str, long len, long pos);
+  static long decode(const char *str, long len, long *code);
+  static long encode(long code, char *buf);
+  static long case_up(long code);
+  static long case_down(long code);
+  static void case_map(char *str, long len, char mode);
+};
+
+
+/**
+ * @class sc_regex
+ * Compiled regular expression program used by ic_regex.
+ * The pattern is compiled into an NFA program which is executed by a Pike VM
+ * in linear time. A lazily built DFA rejects non-matching input before the VM
+ * is started. Programs with back references fall back to backtracking.
+ * Several patterns can be compiled into one program that only tells which
+ * of them occur in a string, see compile_set() and scan().
+ * Literals every match must start with or contain are searched with memchr
+ * first, so input without them never reaches the automata.
+ */
+class sc_regex
+{
+  friend class sc_regexcache;
+
+  public:
+  sc_regex();
+  ~sc_regex();
+
+  static sc_regex *compile(const char *pattern, long len, int flags, const char **error, long *error_pos);
+  static sc_regex *compile_set(long count, const char **patterns, const long *lens, const int *flags, const char **error);
+  bool exec(const char *str, long len, long offset, long *captures);
+  long scan(const char *str, long len, char *found);
+  int groups();
+  long size();
+  bool exact();
+  void study();
+
+  private:
+  struct node
+  {
+    int type;                 /**< Node type (RX_NODE_*). */
+    int value;                /**< Character, group id, assertion or lookaround kind. */
+    int min;                  /**< Minimal repetition count. */
+    int max;                  /**< Maximal repetition count, -1 for infinity. */
+    bool greedy;              /**< Greedy repetition flag. */
+    unsigned char *set;       /**< Character set bitmap. */
+    node *left;               /**< Left or only child. */
+    node *right;              /**< Right child. */
+  };
+
+  struct inst
+  {
+    int op;                   /**< Opcode (RX_OP_*). */
+    int x;                    /**< First argument. */
+    int y;                    /**< Second argument. */
+  };
+
+  struct state
+  {
+    int *pcs;                 /**< Sorted NFA instructions the state stands for. */
+    int length;               /**< Number of instructions. */
+    unsigned long hash;       /**< Hash of the instruction list. */
+    bool match;               /**< Whether the state contains a match. */
+    int *next;                /**< Transitions by byte class, -1 if not computed yet. */
+  };
+
+  struct literal
+  {
+    char pre[REGEX_LITERAL_MAX];  /**< Every match starts with this string. */
+    int pre_len;                  /**< Length of the prefix. */
+    char suf[REGEX_LITERAL_MAX];  /**< Every match ends with this string. */
+    int suf_len;                  /**< Length of the suffix. */
+    char req[REGEX_LITERAL_MAX];  /**< Every match contains this string. */
+    int req_len;                  /**< Length of the required string. */
+    bool full;                    /**< Every match is exactly the prefix. */
+  };
+
+  struct parser
+  {
+    const char *src;          /**< Pattern. */
+    long pos;                 /**< Current position. */
+    long len;                 /**< Pattern length. */
+    int flags;                /**< Active REGEX_* flags. */
+    int groups;               /**< Capture groups opened so far. */
+    int max_ref;              /**< Largest back reference used. */
+    bool quote;               /**< Inside a \\Q...\\E literal. */
+    const char *error;        /**< Error message. */
+    long error_pos;           /**< Error position. */
+  };
+
+  inst *mProgram;             /**< Instructions. */
+  int mLength;                /**< Number of instructions. */
+  unsigned char *mSets;       /**< Character set bitmaps, 32 bytes each. */
+  int mNumSets;               /**< Number of character sets. */
+  sc_regex **mLooks;          /**< Lookaround sub-programs. */
+  int mNumLooks;              /**< Number of lookaround sub-programs. */
+  int mGroups;                /**< Capture groups, group 0 included. */
+  int mRegisters;             /**< Empty loop check registers. */
+  bool mAnchored;             /**< Match can only start at the offset. */
+  bool mBacktrack;            /**< Program needs the backtracking matcher. */
+  int mLookKind;              /**< Lookaround kind of a sub-program. */
+  int mMinWidth;              /**< Minimal match width of a lookbehind. */
+  int mMaxWidth;              /**< Maximal match width of a lookbehind. */
+  bool mSaves;                /**< Lookaround sub-program sets capture groups. */
+
+  unsigned char mByteMap[256];  /**< Byte to byte class mapping. */
+  int mByteClasses;           /**< Number of byte classes. */
+  state **mStates;            /**< Cached DFA states. */
+  int mNumStates;             /**< Number of cached DFA states. */
+  int *mStateHash;            /**< Open addressing index of DFA states. */
+  bool mDFAFailed;            /**< DFA cache overflowed, only the VM is used. */
+  long mLinks;                /**< Number of owners (sc_regexcache and ic_regex instances). */
+  long mPatterns;             /**< Number of patterns in a compile_set() program. */
+
+  char mPrefix[REGEX_LITERAL_MAX];    /**< Literal every match starts with. */
+  int mPrefixLen;                     /**< Length of the prefix, 0 if there is none. */
+  int mPrefixRare;                    /**< Position of the prefix byte to look for first. */
+  char mRequired[REGEX_LITERAL_MAX];  /**< Literal every match contains, if longer than the prefix. */
+  int mRequiredLen;                   /**< Length of the required literal, 0 if there is none. */
+  int mRequiredRare;                  /**< Position of the required byte to look for first. */
+
+  static node *node_new(int type, node *left = NULL, node *right = NULL);
+  static void node_free(node *item);
+  static bool node_nullable(node *item);
+  static void node_width(node *item, int *min, int *max);
+  static int node_size(node *item);
+  static node *node_join(node **trees, long from, long to);
+  static void node_literal(node *item, literal *info);
+  static void literal_cat(literal *left, literal *right, literal *info);
+  static void literal_best(literal *info, const char *str, int len);
+  static int literal_rare(const char *str, int len);
+  static long literal_find(const char *str, long len, long offset, const char *lit, int lit_len, int rare);
+
+  static node *parse(const char *pattern, long len, int flags, int *groups, const char **error, long *error_pos);
+
+  static node *parse_alt(parser *p);
+  static node *parse_cat(parser *p);
+  static node *parse_repeat(parser *p);
+  static node *parse_atom(parser *p);
+  static node *parse_escape(parser *p);
+  static node *parse_set(parser *p);
+  static bool parse_count(parser *p, int *min, int *max);
+  static bool parse_literal(parser *p, char chr, int *value);
+  static void parse_skip(parser *p);
+  static node *parse_error(parser *p, const char *msg);
+  static node *make_char(parser *p, unsigned char chr);
+  static void set_add(unsigned char *set, unsigned char chr, bool icase);
+  static bool set_escape(unsigned char *set, char chr);
+
+  static sc_regex *build(node *tree, int groups, bool anchored, const char **error);
+  int emit(node *item, int pc);
+  int emit_set(unsigned char *set);
+
+  bool test(const char *str, long len, long pos, long *captures);
+  bool check(const inst *cmd, const char *str, long len, long pos);
+  bool run_vm(const char *str, long len, long offset, long need_end, long *captures);
+  bool run_backtrack(const char *str, long len, long offset, long need_end, long *captures);
+  void add_thread(int *list, int &count, long *caps, int pc, const char *str, long len, long pos, long *curr);
+
+  int dfa_run(const char *str, long len, long offset);
+  int dfa_state(int *pcs, int length);
+  int dfa_step(int from, int cls);
+  void dfa_closure(int pc, int *pcs, int &length, char *seen);
+  void dfa_init();
+  void dfa_flush();
+  long dfa_accept(int from, char *seen, char *found);
+  int dfa_restart(int from);
+};
+
+
+/**
+ * @class sc_regexcacheitem
+ * Stores a record of sc_regexcache.
+ */
+class sc_regexcacheitem
+{
+  public:
+  char *mPattern;             /**< Pattern body. */
+  long mLength;               /**< Pattern length. */
+  int mFlags;                 /**< REGEX_* flags the pattern was compiled with. */
+  unsigned long mHash;        /**< Hash of the pattern and flags. */
+  long mSize;                 /**< Approximate memory taken by the program. */
+  sc_regex *mProgram;         /**< Compiled program. */
+
+  sc_regexcacheitem *pNext;   /**< Next record in the same bucket. */
+  sc_regexcacheitem *pNewer;  /**< More recently used record. */
+  sc_regexcacheitem *pOlder;  /**< Less recently used record. */
+};
+
+
+/**
+ * @class sc_regexcache
+ * Per-thread LRU cache of compiled regular expressions.
+ * Programs are keyed by pattern body and flags and shared between all ic_regex
+ * instances, so a regex built in a loop is only compiled once. A shared program
+ * is never modified except for its internal DFA cache, and it is only deleted
+ * when the last owner releases it. As the DFA cache is filled while matching,
+ * every thread keeps a cache of it's own; only the limits are process-wide.
+ */
+class sc_regexcache
+{
+  public:
+  static void setup(long items, long memory);
+  static sc_regex *get(const char *pattern, long len, int flags, const char **error, long *error_pos);
+  static void release(sc_regex *program);
+  static void clear();
+
+  static long length();
+  static long memory();
+  static long hits();
+  static long misses();
+
+  private:
+  static thread_local sc_regexcacheitem **mItems;  /**< Hash buckets. */
+  static thread_local long mSize;                  /**< Number of buckets (power of 2). */
+  static thread_local long mLength;                /**< Number of cached programs. */
+  static thread_local long mMemory;                /**< Memory taken by cached programs. */
+  static long mMaxItems;                           /**< Maximum number of cached programs, 0 disables caching. */
+  static long mMaxMemory;                          /**< Maximum memory taken by cached programs. */
+  static thread_local long mHits;                  /**< Lookups served from the cache. */
+  static thread_local long mMisses;                /**< Lookups that compiled a program. */
+  static thread_local sc_regexcacheitem *pNewest;  /**< Most recently used record. */
+  static thread_local sc_regexcacheitem *pOldest;  /**< Least recently used record. */
+
+  static unsigned long hash(const char *pattern, long len, int flags);
+  static void remove(sc_regexcacheitem *item);
+  static void grow();
+};
+
+
+/**
+ * @class sc_strset
+ * Aho-Corasick dictionary of strings.
+ * Finds occurences of any number of strings in a single pass over the text.
+ * The root has a full transition table, other trie nodes keep sparse edge lists.
+ */
+class sc_strset
+{
+  public:
+  sc_strset();
+  ~sc_strset();
+
+  long add(const char *str, long len);
+  void build();
+  long length();
+  long width(long id);
+
+  bool any(const char *str, long len);
+  long scan(const char *str, long len, char *found);
+  bool find(const char *str, long len, long offset, long *start, long *id);
+
+  private:
+  struct node
+  {
+    int edges;                /**< First outgoing edge, -1 if none. */
+    int fail;                 /**< Node of the longest proper suffix that is in the trie. */
+    int output;               /**< Nearest node by failure links that ends a string, -1 if none. */
+    int depth;                /**< Length of the prefix. */
+    long id;                  /**< First string ending at the node, -1 if none. */
+  };
+
+  struct edge
+  {
+    char chr;                 /**< Character. */
+    int target;               /**< Child node. */
+    int next;                 /**< Next edge of the same node, -1 if none. */
+  };
+
+  node *mNodes;               /**< Trie nodes, 0 is the root. */
+  long mNumNodes;             /**< Number of nodes. */
+  long mNodesSize;            /**< Allocated room for nodes. */
+  edge *mEdges;               /**< Trie edges. */
+  long mNumEdges;             /**< Number of edges. */
+  long mEdgesSize;            /**< Allocated room for edges. */
+  int mRoot[256];             /**< Children of the root by character, 0 if none. */
+  long *mSame;                /**< Next string equal to the given one, -1 if none. */
+  long *mWidths;              /**< Lengths of the strings. */
+  long mLength;               /**< Number of strings. */
+  long mSize;                 /**< Allocated room for strings. */
+  bool mBuilt;                /**< Links are up to date. */
+
+  int step(int from, char chr);
+  int child(int from, char chr);
+  long report(int from, char *found);
+  int node_new(int depth);
+  void edge_new(int from, char chr, int to);
+};
+
+
+/**
+ * @class sc_numarray
+ * Unboxed numbers stored contiguously.
+ * Numbers are kept as integers until the first float comes, then all of them
+ * are converted to floats, just as mixed arithmetics does. Reductions are
+ * performed over the whole buffer at once, several lanes at a time.
+ */
+class sc_numarray
+{
+  private:
+  long *mInts;                /**< Values while all of them are integers. */
+  double *mFloats;            /**< Values once any of them is a float. */
+  long mLength;               /**< Number of values. */
+  long mSize;                 /**< Allocated room for values. */
+  bool mUnordered;            /**< Some float is NaN or some integer has lost precision. */
+
+  void grow();
+  double at(long idx);
+
+  public:
+  sc_numarray(long size = 0);
+  ~sc_numarray();
+
+  void add(long value);
+  void add(double value);
+
+  long length();
+  bool is_float();
+  bool ordered();
+
+  double sum();
+  double product();
+  double dot(sc_numarray *other);
+  long min_index();
+  long max_index();
+};
+
+
+/**
+ * @class sc_sort
+ * Stable sort of an array of T.
+ * Runs that are already ordered are found in the input (descending ones get
+ * reversed), short runs are extended with binary insertion and then merged,
+ * keeping the lengths of the pending runs balanced. Sorted or nearly sorted
+ * input takes linear time.
+ * C is a comparer with a bool less(const T &, const T &) method.
+ */
+template <typename T, typename C>
+class sc_sort
+{
+  public:
+  static void sort(T *items, long length, C &cmp);
+
+  private:
+  static long min_run(long length);
+  static long run(T *items, long from, long length, C &cmp);
+  static void insert(T *items, long from, long sorted, long to, C &cmp);
+  static void merge(T *items, long from, long mid, long to, T *buf, C &cmp);
+  static void merge_at(T *items, long *runs, long *lengths, int &count, int idx, T *buf, C &cmp);
+};
+
+
+/**
+ * @class sc_hashset
+ * Set of T with hashes supplied by the caller.
+ * Open addressing with linear probing, the table is kept at most half full.
+ * C is a comparer with a bool equal(const T &, const T &) method.
+ */
+template <typename T, typename C>
+class sc_hashset
+{
+  public:
+  sc_hashset(C &cmp, long size = 0);
+  ~sc_hashset();
+
+  bool add(const T &item, unsigned long hash);
+  bool has(const T &item, unsigned long hash);
+  long length();
+
+  private:
+  C &mCmp;                      /**< Comparer. */
+  T *mItems;                    /**< Items by slots. */
+  unsigned long *mHashes;       /**< Hashes of items by slots. */
+  bool *mUsed;                  /**< Flags of occupied slots. */
+  long mCapacity;               /**< Number of slots (power of 2). */
+  long mLength;                 /**< Number of items. */
+
+  long slot_find(const T &item, unsigned long hash);
+  void rehash(long capacity);
+};
+
+
+/**
+ * @class sc_taskpool
+ * Work-stealing pool of OS threads.
+ * A job of N items is split into equal shares, one per worker. Each worker
+ * takes items from the front of it's own share and, once it's empty, steals
+ * the back half of the largest share left. Every worker runs the items on a
+ * head of it's own, created for the job and deleted by the same thread.
+ */
+class sc_taskpool
+{
+  public:
+  sc_taskpool(rc_core *core, int workers);
+  ~sc_taskpool();
+
+  bool run(long count, pool_task task, void *data);
+  int workers();
+
+  private:
+  struct sc_taskshare
+  {
+    std::mutex mLock;           /**< Guards the bounds. */
+    long mFrom;                 /**< First item left. */
+    long mTo;                   /**< Item after the last one. */
+  };
+
+  rc_core *pCore;               /**< Core whose image the heads run. */
+  int mCount;                   /**< Number of workers. */
+  std::thread *mThreads;        /**< Worker threads. */
+  sc_taskshare *mShares;        /**< Items left for each worker. */
+
+  std::mutex mLock;             /**< Guards the job state below. */
+  std::condition_variable mWake; /**< Signalled when a job is posted. */
+  std::condition_variable mDone; /**< Signalled when a worker finishes a job. */
+  long mJob;                    /**< Number of the current job. */
+  int mBusy;                    /**< Workers still running the current job. */
+  bool mStop;                   /**< The pool is shutting down. */
+  pool_task pTask;              /**< Function run for each item. */
+  void *pData;                  /**< Job data passed to the function. */
+  std::atomic<bool> mAbort;     /**< An item has failed, no more are taken. */
+
+  void work(int idx);
+  bool take(int idx, long &item);
+};
+
+
+/**
+ * @class sc_reactor
+ * Event loop for non-blocking sockets.
+ * Sockets are watched through epoll for as long as they have callbacks
+ * or output waiting to be sent. Every watched socket is held by a variable
+ * of the reactor, so it stays alive even if the script has dropped it.
+ * The loop runs the callbacks on the head that has started it.
+ * Completions of asynchronous file operations are signalled on a descriptor
+ * of their own, so the same loop runs their callbacks as well.
+ */
+class sc_reactor
+{
+  public:
+  sc_reactor();
+  ~sc_reactor();
+
+  void watch(rc_head *head, ic_object *obj);
+  void forget(rc_head *head, ic_socket *sock);
+  void attach(sc_aio *aio);
+  long run(rc_head *head, long timeout);
+  void stop();
+  long length();
+
+  private:
+  int mFd;                      /**< epoll descriptor. */
+  long mWatched;                /**< Number of sockets watched. */
+  bool mStop;                   /**< The loop has been asked to stop. */
+  sc_aio *pAio;                 /**< Asynchronous file operations, NULL until they are used. */
+
+  void dispatch(rc_head *head, rc_var *var, int events);
+  void call(rc_head *head, rc_var *fx, rc_var *var);
+};
+
+
+/**
+ * @class sc_aioreq
+ * Asynchronous operation on a whole file.
+ * The name and the data are owned by the request, so the kernel or the worker
+ * running it never touches objects of the VM. The variables are only used by
+ * the main thread, once the operation is complete.
+ */
+class sc_aioreq
+{
+  public:
+  char mOp;                     /**< AIO_READ or AIO_WRITE. */
+  char mStep;                   /**< Step run by the ring. */
+  char *mName;                  /**< File name. */
+  int mFd;                      /**< Descriptor, -1 while the file is not open. */
+  int mError;                   /**< errno of the step that has failed, 0 on success. */
+  char *mBuf;                   /**< Data read or to be written. */
+  long mLength;                 /**< Number of bytes read or to be written. */
+  long mCapacity;               /**< Size of the read buffer. */
+  long mDone;                   /**< Number of bytes written. */
+  long mSize;                   /**< Size of the file when it was opened, 0 if unknown. */
+#if MALCO_URING
+  struct statx mStat;           /**< Filled by the ring. */
+#endif
+  rc_var *pFile;                /**< File the callback is called with, NULL in batches. */
+  rc_var *pCallback;            /**< Method called on completion, may be NULL. */
+  sc_aiobatch *pBatch;          /**< Batch of reads the request belongs to. */
+  long mIndex;                  /**< Index of the request in the batch. */
+  sc_aioreq *pNext;             /**< Next request in the same queue. */
+
+  sc_aioreq(char op, const char *name);
+  ~sc_aioreq();
+
+  void reserve(long size);
+};
+
+
+/**
+ * @class sc_aiobatch
+ * Reads submitted together, whose results are passed to a single callback.
+ */
+class sc_aiobatch
+{
+  public:
+  rc_var *pCallback;            /**< Method called once all reads are complete. */
+  rc_var **mResults;            /**< Contents of the files or false, in the order of names. */
+  long mCount;                  /**< Number of reads. */
+  long mLeft;                   /**< Number of reads not complete yet. */
+
+  sc_aiobatch(long count, rc_var *fx);
+  ~sc_aiobatch();
+};
+
+
+/**
+ * @class sc_aio
+ * Asynchronous file operations.
+ * Requests go through io_uring when the kernel supports it: every request
+ * opens, reads or writes and closes the file in steps, each step being
+ * submitted when the previous one completes. Otherwise they are run from
+ * start to end by worker threads. Either way, completions are signalled
+ * on an eventfd watched by the reactor, whose loop runs the callbacks.
+ */
+class sc_aio
+{
+  public:
+  sc_aio(bool uring, int workers);
+  ~sc_aio();
+
+  void submit(sc_aioreq *req);
+  void commit();
+  long dispatch(rc_head *head);
+  int fd();
+  long length();
+  bool uring();
+
+  private:
+  int mEvent;                   /**< eventfd signalled on completion. */
+  long mPending;                /**< Requests submitted and not delivered yet. */
+
+  int mRing;                    /**< io_uring descriptor, -1 if workers are used. */
+  unsigned mEntries;            /**< Size of the submission queue. */
+  long mInRing;                 /**< Requests having a step in the ring. */
+  unsigned mQueued;             /**< Steps queued and not submitted yet. */
+  void *mSqMap;                 /**< Submission queue ring. */
+  void *mCqMap;                 /**< Completion queue ring, may be the same mapping. */
+  void *mSqes;                  /**< Submission queue entries. */
+  long mSqMapLength;            /**< Length of the submission queue ring. */
+  long mCqMapLength;            /**< Length of the completion queue ring. */
+  unsigned *mSqTail, *mSqMask, *mSqArray;
+  unsigned *mCqHead, *mCqTail, *mCqMask;
+  void *mCqes;                  /**< Completion queue entries. */
+  sc_aioreq *mBacklog;          /**< Requests waiting for room in the ring. */
+  sc_aioreq *mBacklogEnd;
+
+  int mCount;                   /**< Number of workers. */
+  std::thread *mThreads;        /**< Workers, NULL if the ring is used. */
+  std::mutex mLock;             /**< Guards the queues below. */
+  std::condition_variable mWake; /**< Signalled when a request is queued. */
+  bool mStop;                   /**< The workers are shutting down. */
+  sc_aioreq *mQueue;            /**< Requests waiting for a worker. */
+  sc_aioreq *mQueueEnd;
+  sc_aioreq *mDone;             /**< Completed requests. */
+  sc_aioreq *mDoneEnd;
+
+  bool ring_open();
+  void ring_close();
+  void ring_push(sc_aioreq *req);
+  void ring_reap();
+  void step(sc_aioreq *req, long result);
+  void complete(sc_aioreq *req);
+  void work();
+  void perform(sc_aioreq *req);
+  void deliver(rc_head *head, sc_aioreq *req);
+  void call(rc_head *head, rc_var *fx, rc_var *arg, rc_var *file);
+
+  static void enqueue(sc_aioreq **first, sc_aioreq **last, sc_aioreq *req);
+};
+
+
+/**
+ * @class sc_request
+ * Request served by one of the built-in servers and the response to it.
+ * The data of the request is what the env class reads, while the response
+ * is written by print() and sent by the front end the request came from.
+ */
+class sc_request
+{
+  public:
+  sc_map mGet;                  /**< Query string parameters. */
+  sc_map mPost;                 /**< Fields of a form sent in the body. */
+  sc_map mCookie;               /**< Cookies. */
+  sc_map mServer;               /**< Request line, headers and connection info, named as in CGI. */
+  ic_string *mBody;             /**< Raw body. */
+
+  sc_request();
+  virtual ~sc_request();
+
+  bool status(int code);
+  bool header(const char *name, const char *value);
+  void write(const char *data, long size);
+  void error(int code);
+  virtual void flush() = 0;
+  virtual bool finish() = 0;
+
+  protected:
+  ic_string *mHeaders;          /**< Response headers set by the script. */
+  ic_string *mOutput;           /**< Response body not sent yet. */
+  int mStatus;                  /**< Response status. */
+  bool mNoBody;                 /**< The request is HEAD, only headers are sent. */
+  bool mTyped;                  /**< The script has set the Content-Type. */
+  bool mSent;                   /**< Response headers have been sent. */
+  bool mFailed;                 /**< The connection has failed or been abandoned. */
+
+  void clear();
+  void parse_query(sc_map *map, const char *str, long length);
+  void parse_cookies(char *str);
+  void parse_body();
+
+  static ic_string *url_decode(const char *str, long length);
+  static const char *reason(int code);
+};
+
+
+/**
+ * @class sc_httprequest
+ * HTTP/1.1 request served by the built-in server.
+ * Requests are read from the connection one after another, so the object
+ * lives as long as the connection is kept alive. The response is kept in
+ * memory and sent with it's length once the script has finished, unless the
+ * script writes more than HTTP_CHUNK bytes: then it is streamed in chunks.
+ */
+class sc_httprequest: public sc_request
+{
+  public:
+  sc_httprequest(int fd, const char *remote);
+  ~sc_httprequest();
+
+  int receive(long timeout, long max_body);
+  void flush();
+  bool finish();
+
+  private:
+  int mFd;                      /**< Connection descriptor. */
+  ic_string *mRemote;           /**< Address of the client. */
+  ic_string *mInput;            /**< Data received, but not parsed yet. */
+  bool mHttp10;                 /**< The client speaks HTTP/1.0 and knows nothing of chunks. */
+  bool mKeepAlive;              /**< The connection is kept open after the response. */
+
+  void reset();
+  int read(long timeout, long max_body);
+  bool fill(long timeout);
+  int parse_head(char *buf);
+  bool send(const char *data, long size, bool more = false);
+  void send_head(ic_string *head, long length);
+  void send_chunk();
+};
+
+
+/**
+ * @class sc_fcgirequest
+ * Request passed by a web server over FastCGI.
+ * The parameters and the body arrive in records that may be interleaved with
+ * the records of other requests on the same connection, so the request is
+ * only played once both streams have ended. The response goes back as
+ * FCGI_STDOUT records in the CGI format, with a Status header.
+ */
+class sc_fcgirequest: public sc_request
+{
+  public:
+  int mId;                      /**< FastCGI request ID. */
+  int mCode;                    /**< HTTP status to answer with instead of playing the script, 0 if none. */
+
+  sc_fcgirequest(sc_fcgiconn *conn, int id, bool keep);
+  ~sc_fcgirequest();
+
+  void params(const char *data, long size);
+  void input(const char *data, long size, long max_body);
+  bool ready();
+  void flush();
+  bool finish();
+
+  private:
+  sc_fcgiconn *pConn;           /**< Connection the request came from. */
+  char *mParams;                /**< FCGI_PARAMS stream, until it ends. */
+  long mParamsLength;           /**< Number of bytes of the stream received. */
+  long mParamsCapacity;         /**< Size of the stream buffer. */
+  bool mKeepConn;               /**< The web server keeps the connection open after the response. */
+  bool mParamsDone;             /**< FCGI_PARAMS stream has ended. */
+  bool mInputDone;              /**< FCGI_STDIN stream has ended. */
+
+  bool parse_params();
+  void send_head(ic_string *head, long length);
+};
+
+
+/**
+ * @class sc_fcgiconn
+ * Connection from a web server speaking FastCGI.
+ * Records are read and sorted out to the requests they belong to until one of
+ * them is complete. Output records are gathered and sent with a single call.
+ * Records carry binary lengths, so the buffers are plain memory, not strings.
+ */
+class sc_fcgiconn
+{
+  public:
+  sc_fcgiconn(int fd);
+  ~sc_fcgiconn();
+
+  sc_fcgirequest *receive(long timeout, long max_body);
+  void record(int type, int id, const char *data, long size);
+  void end(int id, int protocol_status);
+  bool send();
+  void forget(sc_fcgirequest *req);
+
+  static long pair(const char *data, long size, long *name_len, long *value_len);
+  static void reserve(char **buf, long *capacity, long length, long size);
+
+  private:
+  int mFd;                      /**< Connection descriptor. */
+  char *mInput;                 /**< Data received. */
+  long mInputLength;            /**< Number of bytes received. */
+  long mInputPos;               /**< Offset of the first record not parsed yet. */
+  long mInputCapacity;          /**< Size of the input buffer. */
+  char *mOutput;                /**< Records to be sent. */
+  long mOutputLength;           /**< Number of bytes to be sent. */
+  long mOutputCapacity;         /**< Size of the output buffer. */
+  sc_voidarray mRequests;       /**< Requests being received, in order of arrival. */
+  bool mFailed;                 /**< The connection has failed or broken the protocol. */
+
+  sc_fcgirequest *find(int id);
+  bool dispatch(int type, int id, const char *data, long size, long max_body);
+  void values(const char *data, long size);
+  bool fill(long timeout);
+};
+
+
+/**
+ * @class sc_httpserver
+ * Built-in HTTP server, also serving a web server over FastCGI.
+ * The image is loaded once, then worker processes are forked, each running
+ * a number of threads. All of them accept connections from the same socket.
+ * A thread serves one connection at a time on a head of it's own, which plays
+ * the whole tape for every request and is reset afterwards.
+ */
+class sc_httpserver
+{
+  public:
+  sc_httpserver(rc_core *core, long keepalive, long max_body);
+  ~sc_httpserver();
+
+  bool listen(const char *host, long port);
+  bool listen_unix(const char *path);
+  int run(int processes, int threads);
+
+  private:
+  rc_core *pCore;               /**< Core whose image the heads run. */
+  int mFd;                      /**< Listening socket. */
+  long mKeepAlive;              /**< Milliseconds an idle connection is kept open. */
+  long mMaxBody;                /**< Largest request body accepted, in bytes. */
+  bool mFastCgi;                /**< Connections speak FastCGI rather than HTTP. */
+
+  void spawn(int threads);
+  void work();
+  void serve(rc_head *head, int fd, const char *remote);
+  void serve_fcgi(rc_head *head, int fd);
+  bool respond(rc_head *head, sc_request *req);
+};
+
+
 /**
  * @class rc_core
  * The Radix core class.
@@ -1228,6 +2368,19 @@ class rc_core
   rc_class *pClassRoot;         /**< Root class for object hierarchy. */
 
   sc_voidmap *mPlugins;         /**< Core plugins. */
+  bool mSealed;                 /**< The image is shared by several heads and must not change. */
+  sc_taskpool *mPool;           /**< Worker threads for parallel methods, created on first use. */
+  int mPoolSize;                /**< Number of pool workers, 0 for one per core. */
+  sc_reactor *mReactor;         /**< Socket event loop, created on first use. */
+  sc_aio *mAio;                 /**< Asynchronous file operations, created on first use. */
+  bool mAioUring;               /**< io_uring may be used for asynchronous file operations. */
+  int mAioWorkers;              /**< Number of workers running them otherwise, 0 for four per core. */
+  std::thread::id mMainThread;  /**< Thread the core has been started in. */
+  sc_voidarray mThreads;        /**< Script threads that have been started and not deleted yet. */
+  long mThreadsRunning;         /**< Number of script threads still running. */
+  std::atomic<bool> mClosing;   /**< The main head has finished, listen() no longer waits. */
+  std::mutex mThreadLock;       /**< Guards the thread list and counter. */
+  std::condition_variable mThreadDone; /**< Signalled when a script thread finishes. */
 
   struct rc_classcache
   {
@@ -1240,6 +2393,10 @@ class rc_core
     rc_class *pRange;
     rc_class *pRegex;
     rc_class *pMatch;
+    rc_class *pRegexSet;
+    rc_class *pLazy;
+    rc_class *pThread;
+    rc_class *pGenerator;
     rc_class *pTime;
     rc_class *pFile;
     rc_class *pDir;
@@ -1256,6 +2413,15 @@ class rc_core
   void init();
   int process(int argc, char *argv[]);
   void equip();
+  void image_seal();
+  sc_taskpool *pool();
+  sc_reactor *reactor();
+  sc_aio *aio();
+  void image_load();
+  void thread_add(ic_thread *thread);
+  void thread_remove(ic_thread *thread);
+  void thread_done();
+  void threads_wait();
 
   // general core commands
   rc_class *class_create(const char *name, rc_class *parent = NULL, short properties = 0, rc_class *root = NULL);
@@ -1279,11 +2445,14 @@ class rc_core
 
   private:
   int cmdline_task(const char *task);
+  long setup_int(const char *name, const char *section, long def);
 
   // malco tasks
   int task_compile(const char *file);
   int task_run(const char *file);
   int task_run_bc(const char *file);
+  int task_serve(const char *file);
+  int task_fcgi(const char *file);
   int task_eval(const char *code);
   int task_version();
   int task_credits();
@@ -1296,7 +2465,7 @@ class rc_core
  * @class rc_head
  * The Radix execution head class.
  * Represents an "execution head" class that traverses the bytecode "tape" and executes commands one by one.
- * It is defined as a separate class to make Malco easier to convert to multithreading when the time comes.
+ * Every thread has a head of it's own, while the program image is shared through the core.
  */
 class rc_head
 {
@@ -1307,6 +2476,11 @@ class rc_head
   rc_cmd *pCmd;                 /**< Current command. */
 
   rc_core *pCore;
+  ic_thread *pThread;           /**< Thread the head runs in, NULL for the main head and pool workers. */
+  ic_generator *pGenerator;     /**< Generator the head runs, NULL otherwise. */
+  sc_request *pRequest;         /**< Request the head serves, NULL outside of the server. */
+  int mState;                   /**< State of the head, M_STATE_DEAD once stopped by an exception, M_STATE_PAUSED by a yield,
+                                     M_STATE_UNWIND while an exception is passed out of a native method's callback. */
   long mStatLines;              /**< Number of lines processed. */
   long mStatFiles;              /**< Number of files processed. */
   long mStatCommands;           /**< Number of commands processed. */
@@ -1321,6 +2495,8 @@ class rc_head
   sc_stack rUS;                 /**< User stack. */
   sc_voidarray rCS;             /**< Call stack. */
   sc_voidlist rSS;              /**< Safe zone stack. */
+  rc_var *rEX;                  /**< Exception waiting for the playback that has a handler for it. */
+  long mBase;                   /**< Call stack depth the innermost playback has started at. */
 
   // location info
   sc_voidarray *mVars;          /**< Variable table for current execution point. */
@@ -1339,9 +2515,14 @@ class rc_head
 
   void state_save();
   void state_load();
+  void state_unwind(long depth);
+  void unwind();
+  void reset();
   rc_method *method_resolve(const char *name, rc_class *root);
+  rc_method *method_resolve(const char *name, unsigned long hash, rc_class *root);
   void method_invoke(const char *name, rc_var *object = NULL, bool report=true);
   void method_invoke(rc_method *method, rc_var *object = NULL);
+  bool method_enter(rc_method *method, rc_var *object = NULL);
 
   void nsp_select(const char *name);
   void nsp_flush();
@@ -1351,8 +2532,8 @@ class rc_head
   ic_object *var_get(rc_var *var);
 
   rc_var *scope_get(long id);
-  rc_var *bare_id_resolve(const char *name);
-  rc_var *member_resolve(const char *name, rc_var *obj, rc_class *cls);
+  rc_var *bare_id_resolve(const char *name, unsigned long hash);
+  rc_var *member_resolve(const char *name, unsigned long hash, rc_var *obj, rc_class *cls);
 
   void members_release(rc_var *obj);
 
@@ -1366,6 +2547,8 @@ class rc_head
   ic_string *obj_inspect(rc_var *obj);
   rc_var *obj_create(rc_class *objclass);
   rc_var *obj_clone(rc_var *obj);
+  rc_var *obj_copy(rc_var *obj);
+  void obj_own(rc_var *var);
   void obj_unlink(rc_var *obj);
   void obj_unlink(ic_object *obj);
 
@@ -1385,6 +2568,7 @@ class rc_head
   rc_var *new_float(ic_float *value, bool tainted = false);
   rc_var *new_string(const char *string, bool tainted = false);
   rc_var *new_string(ic_string *string, bool tainted = false);
+  rc_var *new_string_const(long idx);
   rc_var *new_regex(ic_regex *regex, bool tainted = false);
   rc_var *new_match(ic_match *match, bool tainted = false);
   rc_var *new_range(long start, long end, bool tainted = false);
@@ -1395,6 +2579,7 @@ class rc_head
   rc_var *new_class(rc_class *cls, bool tainted = false);
   rc_var *new_array(ic_array *arr, bool tainted = false);
   rc_var *new_array(bool tainted = false);
+  rc_var *new_lazy(ic_lazy *lazy, bool tainted = false);
   rc_var *new_exception(const char *msg, int type, bool tainted = false);
   rc_var *new_exception(ic_string *msg, int type, bool tainted = false);
 
@@ -1462,6 +2647,7 @@ class rc_head
   void cmd_return();
   void cmd_nsp();
   void cmd_bindlambda();
+  void cmd_yield();
 
   // interpreter behavior modificators
   void cmd_include();
@@ -1488,6 +2674,25 @@ class rc_head
   char sub_compare(bool strict = false);
   char sub_compare(rc_var *left, rc_var *right, bool strict = false);
   bool sub_value(rc_var *var);
+  bool sub_hash(rc_var *var, unsigned long *hash);
+
+  // parallel execution
+  bool parallel(rc_method *method, rc_var **items, long start, long count, int mode, rc_var **results, bool tainted = false);
+
+  private:
+  struct parallel_job
+  {
+    rc_method *pMethod;         /**< Method called for each item. */
+    rc_var **mArgs;             /**< Copies of the items, NULL for a range of ints. */
+    long mStart;                /**< First int of the range. */
+    bool mTainted;              /**< Taint of the ints. */
+    int mMode;                  /**< POOL_EACH, POOL_MAP or POOL_SELECT. */
+    rc_var **mResults;          /**< Values returned for the items or the exceptions thrown. */
+    bool *mFailed;              /**< Items that have thrown an exception. */
+  };
+
+  static bool parallel_item(rc_head *head, long idx, void *data);
+  rc_var *parallel_result(rc_var *res, int mode);
 };
 
 /**
@@ -1501,6 +2706,7 @@ class rc_headstate
   rc_var *rAX;                  /**< AX register state. */
 
   long mOffset;                 /**< State's command offset. */
+  long mDepth;                  /**< Call stack depth of a safe zone. */
 
   sc_voidarray *mVars;          /**< Variable table for state's execution point. */
   rc_class *pStateClass;        /**< State's local namespace for execution. */
@@ -1626,14 +2832,17 @@ class rc_tape
 /**
  * @class rc_stritem
  * The RVM string table item class.
- * Stores a constant string and it's length.
+ * Stores a constant string, it's length and hash.
  */
 class rc_stritem
 {
   friend class rc_strtable;
   private:
-  char *mString;                      /**< String. */
+  char *mString;                      /**< String (interned unless owned). */
   long mLength;                       /**< String precomputed length. */
+  unsigned long mHash;                /**< String precomputed hash. */
+  bool mOwned;                        /**< Flag indicating the string is owned by the item rather than sc_strpool. */
+  ic_object *pObject;                 /**< Shared immutable object for the string, if created. */
 
   rc_stritem();
   ~rc_stritem();
@@ -1655,6 +2864,8 @@ class rc_strtable
   long mLastLength;                   /**< Length of the table's last buffer. */
   long mLastBuf;                      /**< Number of buffers used in table. */
 
+  rc_stritem *item(long idx);
+
   public:
   rc_strtable();
   ~rc_strtable();
@@ -1668,6 +2879,9 @@ class rc_strtable
   void clear();
 
   char *get(long idx);
+  unsigned long hash(long idx);
+  ic_object *get_object(long idx);
+  void set_object(long idx, ic_object *obj);
 
   long length();
   void file_load(const char *name);
@@ -1721,7 +2935,7 @@ class rc_class
   char *mFullName;              /**< Full class name, from root to current class. */
   rc_class *pParent;            /**< Pointer to parent class. */
   rc_class *pRoot;              /**< Pointer to root class. */
-  long mNumObjs;                /**< Total count of objects of this class. */
+  std::atomic<long> mNumObjs;   /**< Total count of objects of this class, kept by all threads. */
   short mProperties;            /**< Bit set of class properties. */
 
   sc_voidmap mClasses;          /**< Subclass table (rc_class). */
@@ -1729,6 +2943,8 @@ class rc_class
   sc_voidmap mMembers;          /**< Members table (rc_var). */
   sc_voidmap mStaticMembers;    /**< Static members table (rc_var). */
   int mDataType;                /**< Indicates ic_basic type if this class derives from a basic class. */
+
+  rc_class &operator=(const rc_class &right);
 };
 
 
@@ -13,7 +13,11 @@
  */
 ic_array::ic_array()
 {
-  mItems = new sc_voidmap();
+  mValues = NULL;
+  mLength = 0;
+  mSize = 0;
+  mItems = NULL;
+  mCursor = NULL;
 
   mCurrIdx = 0;
   mCurr = NULL;
@@ -26,7 +30,7 @@ ic_array::ic_array()
  */
 ic_array::~ic_array()
 {
-  delete mItems;
+  clear();
 }
 
 /**
@@ -35,18 +39,28 @@ ic_array::~ic_array()
  */
 void ic_array::append(rc_var *obj, bool check)
 {
-  ic_string str = mAutoIndex.to_s();
+  long idx = mAutoIndex.mValue;
   if(check)
   {
-    while(get(&str) != NULL)
+    if(!mItems)
+    {
+      while(idx >= 0 && idx < mLength && mValues[idx])
+        idx++;
+    }
+    else
     {
-      mAutoIndex.mValue++;
-      str = mAutoIndex.to_s();
+      char key[NUMBER_BUF_SIZE];
+      sc_number::format_int(key, idx);
+      while(mItems->get(key) != NULL)
+      {
+        idx++;
+        sc_number::format_int(key, idx);
+      }
     }
   }
 
-  set(&str, obj);
-  mAutoIndex.mValue++;
+  set(idx, obj);
+  mAutoIndex.mValue = idx + 1;
 }
 
 /**
@@ -56,7 +70,7 @@ void ic_array::append(rc_var *obj, bool check)
  */
 inline void ic_array::set(ic_string *key, rc_var *obj)
 {
-  mItems->set(key, (void *)obj);
+  set(key->get(), obj);
 }
 
 /**
@@ -64,27 +78,109 @@ inline void ic_array::set(ic_string *key, rc_var *obj)
  * @param key Key of the array to be modified.
  * @param obj Object to be set.
  */
-inline void ic_array::set(const char *key, rc_var *obj)
+void ic_array::set(const char *key, rc_var *obj)
 {
+  if(!mItems)
+  {
+    long idx = index(key);
+    if(idx >= 0)
+    {
+      set(idx, obj);
+      return;
+    }
+
+    if(!obj) return;
+    unpack();
+  }
+
   mItems->set(key, (void *)obj);
 }
 
+/**
+ * Sets a specific item of the array to a new object.
+ * @param key Numeric key of the array to be modified.
+ * @param obj Object to be set.
+ */
+void ic_array::set(long key, rc_var *obj)
+{
+  char str[NUMBER_BUF_SIZE];
+
+  if(!mItems)
+  {
+    if(key >= 0 && key < mLength)
+    {
+      mValues[key] = obj;
+      return;
+    }
+
+    // just like the map, ignore empty values for new keys
+    if(!obj) return;
+
+    if(key == mLength)
+    {
+      push(obj);
+      return;
+    }
+
+    unpack();
+  }
+
+  sc_number::format_int(str, key);
+  mItems->set(str, (void *)obj);
+}
+
 /**
  * Clears a key out.
  * @param key Key to be cleared.
  */
 inline void ic_array::unset(ic_string *key)
 {
-  mItems->remove(key);
+  unset(key->get());
 }
 
 /**
  * Clears a key out.
  * @param key Key to be cleared.
  */
-inline void ic_array::unset(const char *key)
+void ic_array::unset(const char *key)
 {
-  mItems->remove(key);
+  if(!mItems)
+  {
+    long idx = index(key);
+    if(idx >= 0)
+      unset(idx);
+    else
+      mCurrIdx = 0;
+  }
+  else
+    mItems->remove(key);
+}
+
+/**
+ * Clears a key out.
+ * @param key Numeric key to be cleared.
+ */
+void ic_array::unset(long key)
+{
+  if(!mItems)
+  {
+    // removing rewinds iteration, as the map does
+    mCurrIdx = 0;
+    if(key < 0 || key >= mLength) return;
+
+    // only the last item can go without breaking the sequence
+    if(key == mLength - 1)
+    {
+      mLength--;
+      return;
+    }
+
+    unpack();
+  }
+
+  char str[NUMBER_BUF_SIZE];
+  sc_number::format_int(str, key);
+  mItems->remove(str);
 }
 
 /**
@@ -92,7 +188,14 @@ inline void ic_array::unset(const char *key)
  */
 void ic_array::clear()
 {
-  mItems->clear();
+  delete [] mValues;
+  delete mItems;
+  delete mCursor;
+  mValues = NULL;
+  mLength = 0;
+  mSize = 0;
+  mItems = NULL;
+  mCursor = NULL;
 
   mCurrIdx = 0;
   mCurr = NULL;
@@ -110,7 +213,7 @@ inline rc_var *ic_array::get(ic_string *key)
   // note that ic_array is not aware of the existance of rc_head and rc_core,
   // thus being unable to automatically create an undef object if the requested
   // key is not found. it should be done in the wrapper layer instead.
-  return (rc_var *)mItems->get(key);
+  return get(key->get());
 }
 
 /**
@@ -118,10 +221,31 @@ inline rc_var *ic_array::get(ic_string *key)
 * @param key Key of the object.
 * @return Object.
 */
-inline rc_var *ic_array::get(const char *key)
+rc_var *ic_array::get(const char *key)
 {
-  ic_string str = key;
-  return (rc_var *)mItems->get(&str);
+  if(!mItems)
+  {
+    // anything but a number is missing from a packed array
+    long idx = index(key);
+    return (idx >= 0 && idx < mLength) ? mValues[idx] : NULL;
+  }
+
+  return (rc_var *)mItems->get(key);
+}
+
+/**
+* Returns an object by it's numeric key.
+* @param key Key of the object.
+* @return Object.
+*/
+rc_var *ic_array::get(long key)
+{
+  if(!mItems)
+    return (key >= 0 && key < mLength) ? mValues[key] : NULL;
+
+  char str[NUMBER_BUF_SIZE];
+  sc_number::format_int(str, key);
+  return (rc_var *)mItems->get(str);
 }
 
 /**
@@ -133,25 +257,68 @@ void ic_array::copy(ic_array *arr)
   sc_voidmapitem *curr;
   arr->iter_rewind();
   while(curr = arr->iter_next())
-    mItems->set(curr->mKey, curr->mValue);
+    set(curr->mKey, (rc_var *)curr->mValue);
+}
+
+/**
+ * Changes keys to go from 0 in the order of items.
+ * The array gets packed again.
+ */
+void ic_array::reindex()
+{
+  if(mItems)
+  {
+    sc_voidmap *items = mItems;
+    sc_voidmapitem *curr;
+    mItems = NULL;
+
+    items->iter_rewind();
+    while(curr = items->iter_next())
+      push((rc_var *)curr->mValue);
+
+    delete items;
+  }
+
+  mAutoIndex.mValue = mLength;
 }
 
 /**
  * Get next object from array for iteration.
+ * A packed array returns it's cursor, which only holds until the array is iterated again.
  * @return Current object.
  */
 inline sc_voidmapitem *ic_array::iter_next()
 {
+  if(!mItems)
+    return mCurrIdx < mLength ? cursor(mCurrIdx++) : NULL;
+
   return mItems->iter_next();
 }
 
+/**
+ * Get next object from array, using an outer position.
+ * Independent passes over the array don't disturb each other this way.
+ * @param pos Position to start from, 0 for the first object. Is moved past the object.
+ * @return Current object.
+ */
+inline sc_voidmapitem *ic_array::iter_next(long &pos)
+{
+  if(!mItems)
+    return pos < mLength ? cursor(pos++) : NULL;
+
+  return mItems->iter_next(pos);
+}
+
 /**
  * Get last object from array for iteration.
  * @return Current object.
  */
 inline sc_voidmapitem *ic_array::iter_last()
 {
-  return mItems->mLast;
+  if(!mItems)
+    return mLength ? cursor(mLength-1) : NULL;
+
+  return mItems->last();
 }
 
 /**
@@ -159,7 +326,9 @@ inline sc_voidmapitem *ic_array::iter_last()
  */
 inline void ic_array::iter_rewind()
 {
-  mItems->iter_rewind();
+  mCurrIdx = 0;
+  if(mItems)
+    mItems->iter_rewind();
 }
 
 /**
@@ -168,7 +337,15 @@ inline void ic_array::iter_rewind()
  */
 inline long ic_array::length()
 {
-  return mItems->length();
+  return mItems ? mItems->length() : mLength;
+}
+
+/**
+ * Checks whether the array still has keys 0..n-1 in order.
+ */
+inline bool ic_array::packed()
+{
+  return mItems == NULL;
 }
 
 /**
@@ -177,7 +354,7 @@ inline long ic_array::length()
  */
 inline bool ic_array::to_b()
 {
-  return mItems->length() ? true : false;
+  return length() ? true : false;
 }
 
 /**
@@ -198,4 +375,98 @@ inline const char *ic_array::to_s()
   return "Array";
 }
 
+/**
+ * Adds an item to the end of a packed array.
+ * @param obj Object to be added.
+ */
+void ic_array::push(rc_var *obj)
+{
+  if(mLength == mSize)
+  {
+    long new_size = mSize ? mSize * 2 : ARRAY_MIN_SIZE;
+    rc_var **values = new rc_var*[new_size];
+    if(!values) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+    if(mLength) memcpy(values, mValues, mLength * sizeof(rc_var *));
+    delete [] mValues;
+    mValues = values;
+    mSize = new_size;
+  }
+
+  mValues[mLength++] = obj;
+
+  // inserting rewinds iteration, as the map does
+  mCurrIdx = 0;
+}
+
+/**
+ * Moves packed values into a map, once a key breaks the sequence.
+ * Keys are only made at this point. Values are inserted in order, so an item
+ * keeps it's iteration position, and empty ones are kept as well.
+ */
+void ic_array::unpack()
+{
+  mItems = new sc_voidmap();
+  if(!mItems) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  char key[NUMBER_BUF_SIZE];
+  for(long idx=0; idx<mLength; idx++)
+  {
+    sc_number::format_int(key, idx);
+    sc_voidmapitem *item = new sc_voidmapitem(key, (void *)mValues[idx], sc_strpool::hash(key));
+    if(!item) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+    mItems->adopt(item);
+  }
+
+  delete [] mValues;
+  mValues = NULL;
+  mLength = 0;
+  mSize = 0;
+}
+
+/**
+ * Points the cursor at a packed value, making it's key.
+ * The cursor is the only item a packed array has, so it changes with every call.
+ * @param idx Index of the value.
+ * @return Cursor.
+ */
+sc_voidmapitem *ic_array::cursor(long idx)
+{
+  if(!mCursor)
+  {
+    mCursor = new sc_voidmapitem("", NULL, 0);
+    if(!mCursor) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  }
+
+  char key[NUMBER_BUF_SIZE];
+  sc_number::format_int(key, idx);
+  mCursor->mKey->set(key);
+  mCursor->mValue = (void *)mValues[idx];
+  mCursor->mIndex = idx;
+  return mCursor;
+}
+
+/**
+ * Converts a key to a packed index.
+ * Only the canonical form is accepted: "1" is an index, while "01" or "+1" are not.
+ * @param key Key to be converted.
+ * @return Index or -1 if the key is not a number.
+ */
+long ic_array::index(const char *key)
+{
+  if(*key < '0' || *key > '9' || (*key == '0' && key[1]))
+    return -1;
+
+  long idx = 0;
+  for(const char *chr = key; *chr; chr++)
+  {
+    // longer keys might overflow and can't fit an array anyway
+    if(*chr < '0' || *chr > '9' || chr - key >= 18)
+      return -1;
+
+    idx = idx * 10 + (*chr - '0');
+  }
+
+  return idx;
+}
+
 #endif
@@ -2,7 +2,7 @@
  * @file ic_dir.h
  * @author impworks.
  * ic_dir header.
- * Defines properties and methods of ic_socket class.
+ * Defines properties and methods of ic_dir class.
  */
 
 #ifndef IC_DIR_H
@@ -14,7 +14,7 @@
 ic_dir::ic_dir()
 {
   mName = NULL;
-  mLength = 0;  
+  mIter = NULL;
 }
 
 /**
@@ -23,20 +23,132 @@ ic_dir::ic_dir()
  */
 ic_dir::ic_dir(const char *name)
 {
-  mName = new char[strlen(name)];
-  strcpy(mName, name);
-  mLength = 0;  
+  mName = NULL;
+  mIter = NULL;
+  choose(name);
 }
 
 /**
  * ic_dir constructor.
  * @param name Directory name.
  */
-ic_dir::ic_dir(ic_string *name) 
+ic_dir::ic_dir(ic_string *name)
+{
+  mName = NULL;
+  mIter = NULL;
+  choose(name->get());
+}
+
+/**
+ * ic_dir destructor.
+ */
+ic_dir::~ic_dir()
+{
+  iter_rewind();
+  delete [] mName;
+}
+
+/**
+ * Copies the directory name.
+ * The iterator is not shared, the copy starts from the first item.
+ * @param dir Directory to copy.
+ */
+ic_dir &ic_dir::operator=(const ic_dir &dir)
+{
+  if(this != &dir)
+    choose(dir.mName);
+
+  return *this;
+}
+
+/**
+ * Sets the directory name.
+ * @param name Directory name or NULL.
+ */
+void ic_dir::choose(const char *name)
+{
+  iter_rewind();
+  delete [] mName;
+  mName = NULL;
+
+  if(name)
+  {
+    mName = new char[strlen(name) + 1];
+    if(!mName) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+    strcpy(mName, name);
+  }
+}
+
+/**
+ * Sets the directory name.
+ * @param name Directory name.
+ */
+inline void ic_dir::choose(ic_string *name)
+{
+  choose(name->get());
+}
+
+/**
+ * Copies directory to another place.
+ * @param name Destination path.
+ * @param pool Pool to copy the files on, NULL to copy them one by one.
+ * @return Success flag.
+ */
+inline bool ic_dir::copy(ic_string *name, sc_taskpool *pool)
+{
+  return copy(name->get(), pool);
+}
+
+/**
+ * Moves directory to another place.
+ * @param name Destination path.
+ * @return Success flag.
+ */
+inline bool ic_dir::rename(ic_string *name)
+{
+  return rename(name->get());
+}
+
+/**
+ * Returns the directory name.
+ * @return Name or NULL.
+ */
+inline char *ic_dir::to_s()
 {
-  mName = new char[name->length()];
-  strcpy(mName, name->get());
-  mLength = 0;
+  return mName;
+}
+
+/**
+ * Joins a directory and an item name into a path.
+ * @param dir Directory path.
+ * @param name Item name.
+ * @return New path, to be deleted by the caller.
+ */
+char *ic_dir::path(const char *dir, const char *name)
+{
+  long len = strlen(dir);
+  char *result = new char[len + strlen(name) + 2];
+  if(!result) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  strcpy(result, dir);
+  if(len && dir[len - 1] != '/')
+    result[len++] = '/';
+
+  strcpy(result + len, name);
+  return result;
+}
+
+/**
+ * Copies one of the files collected by copy_r, run by the pool.
+ * @param head Head of the worker, not used.
+ * @param item Index of the file.
+ * @param data Array of source and destination names, in pairs.
+ * @return Success flag.
+ */
+bool ic_dir::copy_item(rc_head *head, long item, void *data)
+{
+  sc_voidarray *files = (sc_voidarray *)data;
+  return sc_file::copy((const char *)(*files)[item * 2], (const char *)(*files)[item * 2 + 1]);
 }
 
 #if MALCO_PLATFORM == M_PLATF_WIN32
@@ -47,4 +159,4 @@ ic_dir::ic_dir(ic_string *name)
 #include "ic_dir.nix.h"
 #endif
 
-#endif
\ No newline at end of file
+#endif
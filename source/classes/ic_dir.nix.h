@@ -6,53 +6,160 @@
 
 /**
  * Recursively copies items in the directory.
+ * Subdirectories and symbolic links are made at once, regular files are only
+ * collected, so that the caller can copy them in parallel.
  * @param from Source path.
- * @param to Destination path.
+ * @param to Destination path, which has to exist.
+ * @param files Array to add source and destination names of files to, in pairs.
+ * @param top Stat of the topmost destination, which is skipped if it is inside the source.
  * @return Success flag.
  */
-bool ic_dir::copy_r(const char *from, const char *to)
+bool ic_dir::copy_r(const char *from, const char *to, sc_voidarray *files, void *top)
 {
+  DIR *dir = opendir(from);
+  if(!dir)
+    return false;
 
+  bool result = true;
+  dirent *item;
+  while(result && (item = readdir(dir)))
+  {
+    if(!strcmp(item->d_name, ".") || !strcmp(item->d_name, ".."))
+      continue;
+
+    char *src = path(from, item->d_name);
+    char *dst = path(to, item->d_name);
+
+    // large trees are mostly files, which need no stat of their own here
+    struct stat info;
+    if(item->d_type == DT_REG)
+      info.st_mode = S_IFREG;
+    else if(lstat(src, &info))
+    {
+      info.st_mode = 0;
+      result = false;
+    }
+
+    if(S_ISREG(info.st_mode))
+    {
+      files->add(src);
+      files->add(dst);
+      continue;
+    }
+    else if(S_ISDIR(info.st_mode))
+    {
+      struct stat *skip = (struct stat *)top;
+      if(info.st_dev != skip->st_dev || info.st_ino != skip->st_ino)
+      {
+        // the owner must be able to fill the copy, even if the source is read-only
+        if(mkdir(dst, (info.st_mode & 07777) | S_IRWXU) && errno != EEXIST)
+          result = false;
+        else
+          result = copy_r(src, dst, files, top);
+      }
+    }
+    else if(S_ISLNK(info.st_mode))
+    {
+      char target[PATH_MAX];
+      ssize_t len = readlink(src, target, sizeof(target) - 1);
+      if(len < 0)
+        result = false;
+      else
+      {
+        target[len] = '\0';
+        unlink(dst);
+        result = !symlink(target, dst);
+      }
+    }
+
+    // sockets, pipes and devices are not copied
+    delete [] src;
+    delete [] dst;
+  }
+
+  closedir(dir);
+  return result;
 }
 
 /**
- * Recursively removes items in the directory.
+ * Recursively removes items in the directory and the directory itself.
+ * Symbolic links are removed, not followed.
  * @param name Directory path.
  * @return Success flag.
  */
 bool ic_dir::remove_r(const char *name)
 {
+  DIR *dir = opendir(name);
+  if(!dir)
+    return false;
 
-}
+  bool result = true;
+  dirent *item;
+  while(result && (item = readdir(dir)))
+  {
+    if(!strcmp(item->d_name, ".") || !strcmp(item->d_name, ".."))
+      continue;
 
-/**
- * Copies directory to another place.
- * @param name Destination path.
- * @return Success flag.
- */
-bool ic_dir::copy(const char *name)
-{
+    char *curr = path(name, item->d_name);
+    struct stat info;
+    if(item->d_type == DT_DIR || item->d_type == DT_UNKNOWN && !lstat(curr, &info) && S_ISDIR(info.st_mode))
+      result = remove_r(curr);
+    else
+      result = !unlink(curr);
+
+    delete [] curr;
+  }
 
+  closedir(dir);
+  return result && !rmdir(name);
 }
 
 /**
- * Copies directory to another place.
- * @param name Destination path.
- * @return Success flag.
+ * Checks if the directory exists.
+ * @return true if the name belongs to a directory.
  */
-bool ic_dir::copy(ic_string *name)
+bool ic_dir::exists()
 {
-  copy(name->get());
+  struct stat info;
+  return mName && !stat(mName, &info) && S_ISDIR(info.st_mode);
 }
 
 /**
- * Moves directory to another place.
- * @param name Destination path.
+ * Copies directory to another place.
+ * The tree of directories is made first, then the files are copied with
+ * sc_file::copy, on the workers of the pool if there is one.
+ * @param name Destination path, created if it doesn't exist.
+ * @param pool Pool to copy the files on, NULL to copy them one by one.
  * @return Success flag.
  */
-bool ic_dir::rename(const char *name)
+bool ic_dir::copy(const char *name, sc_taskpool *pool)
 {
+  struct stat info, top;
+  if(!mName || stat(mName, &info) || !S_ISDIR(info.st_mode))
+    return false;
+
+  if(mkdir(name, (info.st_mode & 07777) | S_IRWXU) && errno != EEXIST)
+    return false;
+
+  if(stat(name, &top) || !S_ISDIR(top.st_mode))
+    return false;
 
+  sc_voidarray files;
+  bool result = copy_r(mName, name, &files, &top);
+
+  long count = files.length() / 2;
+  if(result && pool && count > 1)
+    result = pool->run(count, copy_item, &files);
+  else
+  {
+    for(long idx = 0; result && idx < count; idx++)
+      result = copy_item(NULL, idx, &files);
+  }
+
+  for(long idx = 0; idx < files.length(); idx++)
+    delete [] (char *)files[idx];
+
+  return result;
 }
 
 /**
@@ -60,9 +167,13 @@ bool ic_dir::rename(const char *name)
  * @param name Destination path.
  * @return Success flag.
  */
-bool ic_dir::rename(ic_string *name)
+bool ic_dir::rename(const char *name)
 {
-  rename(name->get());
+  if(!mName || ::rename(mName, name))
+    return false;
+
+  choose(name);
+  return true;
 }
 
 /**
@@ -71,16 +182,24 @@ bool ic_dir::rename(ic_string *name)
  */
 bool ic_dir::create()
 {
+  if(!mName)
+    return false;
 
+  return !mkdir(mName, 0777) || errno == EEXIST && exists();
 }
 
 /**
  * Removes the directory if it exists.
+ * @param really Remove the contents as well, otherwise the directory has to be empty.
  * @return Success flag.
  */
-bool ic_dir::remove()
+bool ic_dir::remove(bool really)
 {
+  if(!mName)
+    return false;
 
+  iter_rewind();
+  return really ? remove_r(mName) : !rmdir(mName);
 }
 
 /**
@@ -89,22 +208,71 @@ bool ic_dir::remove()
  */
 long ic_dir::length()
 {
+  DIR *dir = mName ? opendir(mName) : NULL;
+  if(!dir)
+    return 0;
+
+  long count = 0;
+  dirent *item;
+  while(item = readdir(dir))
+    if(strcmp(item->d_name, ".") && strcmp(item->d_name, ".."))
+      count++;
 
+  closedir(dir);
+  return count;
 }
 
 /**
  * Returns another item from the dir.
- * @return Current item's name.
+ * Symbolic links are counted as what they point to.
+ * @param type DIR_FILES or DIR_DIRS to skip other items, 0 for any item.
+ * @return Current item's name or NULL once all items have been returned.
  */
-ic_string *ic_dir::iter_next()
+ic_string *ic_dir::iter_next(char type)
 {
+  if(!mIter)
+  {
+    if(!mName || !(mIter = opendir(mName)))
+      return NULL;
+  }
+
+  dirent *item;
+  while(item = readdir((DIR *)mIter))
+  {
+    if(!strcmp(item->d_name, ".") || !strcmp(item->d_name, ".."))
+      continue;
+
+    if(type)
+    {
+      bool is_dir = item->d_type == DT_DIR;
+      if(item->d_type == DT_UNKNOWN || item->d_type == DT_LNK)
+      {
+        char *curr = path(mName, item->d_name);
+        struct stat info;
+        is_dir = !stat(curr, &info) && S_ISDIR(info.st_mode);
+        delete [] curr;
+      }
 
+      if(is_dir != (type == DIR_DIRS))
+        continue;
+    }
+
+    ic_string *name = new ic_string(item->d_name);
+    if(!name) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+    return name;
+  }
+
+  iter_rewind();
+  return NULL;
 }
- 
+
 /**
- * Rewinds the directory iterator,
+ * Rewinds the directory iterator.
  */
 void ic_dir::iter_rewind()
 {
+  if(mIter)
+    closedir((DIR *)mIter);
 
-}
\ No newline at end of file
+  mIter = NULL;
+}
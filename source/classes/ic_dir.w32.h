@@ -10,7 +10,7 @@
  * @param to Destination path.
  * @return Success flag.
  */
-bool ic_dir::copy_r(const char *from, const char *to)
+bool ic_dir::copy_r(const char *from, const char *to, sc_voidarray *files, void *top)
 {
   return true;
 }
@@ -26,11 +26,10 @@ bool ic_dir::remove_r(const char *name)
 }
 
 /**
- * Copies directory to another place.
- * @param name Destination path.
- * @return Success flag.
+ * Checks if the directory exists.
+ * @return true if the name belongs to a directory.
  */
-bool ic_dir::copy(const char *name)
+bool ic_dir::exists()
 {
   return true;
 }
@@ -38,11 +37,12 @@ bool ic_dir::copy(const char *name)
 /**
  * Copies directory to another place.
  * @param name Destination path.
+ * @param pool Pool to copy the files on, NULL to copy them one by one.
  * @return Success flag.
  */
-bool ic_dir::copy(ic_string *name)
+bool ic_dir::copy(const char *name, sc_taskpool *pool)
 {
-  return copy(name->get());
+  return true;
 }
 
 /**
@@ -55,16 +55,6 @@ bool ic_dir::rename(const char *name)
   return true;
 }
 
-/**
- * Moves directory to another place.
- * @param name Destination path.
- * @return Success flag.
- */
-bool ic_dir::rename(ic_string *name)
-{
-  return rename(name->get());
-}
-
 /**
  * Creates the directory if it doesn't exist.
  * @return Success flag.
@@ -76,9 +66,10 @@ bool ic_dir::create()
 
 /**
  * Removes the directory if it exists.
+ * @param really Remove the contents as well, otherwise the directory has to be empty.
  * @return Success flag.
  */
-bool ic_dir::remove()
+bool ic_dir::remove(bool really)
 {
   return true;
 }
@@ -94,9 +85,10 @@ long ic_dir::length()
 
 /**
  * Returns another item from the dir.
+ * @param type DIR_FILES or DIR_DIRS to skip other items, 0 for any item.
  * @return Current item's name.
  */
-ic_string *ic_dir::iter_next()
+ic_string *ic_dir::iter_next(char type)
 {
   return NULL;
 }
@@ -16,6 +16,10 @@ ic_file::ic_file()
   mFile = NULL;
   mName = NULL;
   mMode = 0;
+
+  mBuf = mMap = NULL;
+  mBufStart = mBufEnd = mBufCapacity = mMapLength = mMapDropped = mLinePos = 0;
+  mReading = false;
 }
 
 /**
@@ -25,9 +29,13 @@ ic_file::ic_file()
 ic_file::ic_file(const char *name)
 {
   mFile = NULL;
-  mName = new char[strlen(name)];
+  mName = new char[strlen(name) + 1];
   strcpy(mName, name);
   mMode = 0;
+
+  mBuf = mMap = NULL;
+  mBufStart = mBufEnd = mBufCapacity = mMapLength = mMapDropped = mLinePos = 0;
+  mReading = false;
 }
 
 /**
@@ -37,9 +45,13 @@ ic_file::ic_file(const char *name)
 ic_file::ic_file(ic_string *name)
 {
   mFile = NULL;
-  mName = new char[name->length()];
+  mName = new char[name->length() + 1];
   strcpy(mName, name->get());
   mMode = 0;
+
+  mBuf = mMap = NULL;
+  mBufStart = mBufEnd = mBufCapacity = mMapLength = mMapDropped = mLinePos = 0;
+  mReading = false;
 }
 
 /**
@@ -48,6 +60,32 @@ ic_file::ic_file(ic_string *name)
 ic_file::~ic_file()
 {
   this->close();
+  delete [] mName;
+  delete [] mBuf;
+}
+
+/**
+ * Copies the file name from another file.
+ * The stream is not shared, the copy has to be opened on it's own.
+ * @param file File to be copied.
+ * @return Itself.
+ */
+ic_file &ic_file::operator=(const ic_file &file)
+{
+  if(this != &file)
+  {
+    if(file.mName)
+      choose(file.mName);
+    else
+    {
+      this->close();
+      delete [] mName;
+      mName = NULL;
+      mMode = 0;
+    }
+  }
+
+  return *this;
 }
 
 /**
@@ -56,12 +94,7 @@ ic_file::~ic_file()
  */
 void ic_file::choose(ic_string *name)
 {
-  this->close();
-  delete mName;
-
-  mName = new char[name->length()];
-  strcpy(mName, name->get());
-  mMode = 0;
+  choose(name->get());
 }
 
 /**
@@ -71,10 +104,12 @@ void ic_file::choose(ic_string *name)
 void ic_file::choose(const char *name)
 {
   this->close();
-  delete mName;
 
-  mName = new char[strlen(name)];
-  strcpy(mName, name);
+  char *new_name = new char[strlen(name) + 1];
+  strcpy(new_name, name);
+
+  delete [] mName;
+  mName = new_name;
   mMode = 0;
 }
 
@@ -90,9 +125,8 @@ bool ic_file::open(char mode)
     this->close();
 
   char mode_str[4] = { 0, 0, 0, 0 };
-  char idx = 0;
 
-  switch(mode)
+  switch(mode & ~FILE_BINARY)
   {
     case IO_READ:                   mode_str[0] = 'r'; break;
     case IO_WRITE:                  mode_str[0] = 'w'; break;
@@ -100,6 +134,7 @@ bool ic_file::open(char mode)
     case IO_RW:                     mode_str[0] = 'r'; mode_str[1] = '+'; break;
     case IO_RW | FILE_REPLACE:      mode_str[0] = 'w'; mode_str[1] = '+'; break;
     case IO_RW | FILE_APPEND:       mode_str[0] = 'a'; mode_str[1] = '+'; break;
+    default:                        return false;
   }
 
   if(mode & FILE_BINARY)
@@ -110,7 +145,11 @@ bool ic_file::open(char mode)
       mode_str[2] = 'b';
   }
 
+  if(!mName)
+    return false;
+
   mFile = fopen(mName, mode_str);
+  mMode = mFile ? mode : 0;
   return mFile ? true : false;
 }
 
@@ -121,10 +160,182 @@ void ic_file::close()
 {
   if(mFile)
   {
+    sync();
     fclose(mFile);
-    delete mFile;
     mFile = NULL;
+    mMode = 0;
+  }
+}
+
+/**
+ * Starts the line reader at the current position of the stream.
+ * A regular file is mapped into memory as a whole, so that lines are
+ * taken right from the page cache; other streams are read in chunks.
+ * @return false if the file is not open for reading.
+ */
+bool ic_file::reader()
+{
+  if(mReading)
+    return true;
+
+  if(!mFile || !(mMode & IO_READ))
+    return false;
+
+  long pos = ftell(mFile);
+  mLinePos = pos > 0 ? pos : 0;
+
+#if MALCO_PLATFORM == M_PLATF_NIX
+  struct stat info;
+  if(pos >= 0 && !fstat(fileno(mFile), &info) && S_ISREG(info.st_mode) && info.st_size > pos)
+  {
+    // data written in update mode has to reach the file first
+    fflush(mFile);
+
+    void *map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fileno(mFile), 0);
+    if(map != MAP_FAILED)
+    {
+      madvise(map, info.st_size, MADV_SEQUENTIAL);
+      mMap = (char *)map;
+      mMapLength = info.st_size;
+      mMapDropped = 0;
+      mReading = true;
+      return true;
+    }
+  }
+#endif
+
+  if(!mBuf)
+  {
+    mBuf = new char[FILE_CHUNK];
+    if(!mBuf) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+    mBufCapacity = FILE_CHUNK;
+  }
+
+  mBufStart = mBufEnd = 0;
+  mReading = true;
+  return true;
+}
+
+/**
+ * Stops the line reader and moves the stream to where it has stopped,
+ * so that the stream can be used directly again.
+ */
+void ic_file::sync()
+{
+  if(!mReading)
+    return;
+
+#if MALCO_PLATFORM == M_PLATF_NIX
+  if(mMap)
+  {
+    munmap(mMap, mMapLength);
+    mMap = NULL;
+    mMapLength = 0;
   }
+#endif
+
+  mBufStart = mBufEnd = 0;
+  mReading = false;
+  fseek(mFile, mLinePos, SEEK_SET);
+}
+
+/**
+ * Reads the next line of the file.
+ * The line is not copied: it stays valid until the file is read, written,
+ * moved or closed. Lines end with LF or CRLF, which are not included.
+ * @param[out] line First character of the line.
+ * @param[out] length Length of the line.
+ * @return false at the end of the file or if it is not open for reading.
+ */
+bool ic_file::read_line(const char **line, long *length)
+{
+  if(!reader())
+    return false;
+
+  char *start, *end;
+  long len;
+
+  if(mMap)
+  {
+    if(mLinePos >= mMapLength)
+      return false;
+
+#if MALCO_PLATFORM == M_PLATF_NIX
+    // pages left behind are given back, so that a huge file does not fill the memory
+    if(mLinePos - mMapDropped >= FILE_MAP_WINDOW)
+    {
+      long page = sysconf(_SC_PAGESIZE);
+      long upto = mLinePos / page * page;
+      madvise(mMap + mMapDropped, upto - mMapDropped, MADV_DONTNEED);
+      mMapDropped = upto;
+    }
+#endif
+
+    start = mMap + mLinePos;
+    end = (char *)memchr(start, '\n', mMapLength - mLinePos);
+    len = end ? end - start : mMapLength - mLinePos;
+    mLinePos += end ? len + 1 : len;
+  }
+  else
+  {
+    long scanned = 0;
+    while(true)
+    {
+      start = mBuf + mBufStart;
+      len = mBufEnd - mBufStart;
+      end = (char *)memchr(start + scanned, '\n', len - scanned);
+      if(end)
+      {
+        len = end - start;
+        mBufStart += len + 1;
+        mLinePos += len + 1;
+        break;
+      }
+
+      scanned = len;
+
+      // keep the unfinished line and make room for the rest of it
+      if(mBufStart)
+      {
+        memmove(mBuf, start, len);
+        mBufStart = 0;
+        mBufEnd = len;
+      }
+
+      if(mBufEnd == mBufCapacity)
+      {
+        char *new_buf = new char[mBufCapacity * 2];
+        if(!new_buf) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+        memcpy(new_buf, mBuf, mBufEnd);
+        delete [] mBuf;
+        mBuf = new_buf;
+        mBufCapacity *= 2;
+      }
+
+      long got = fread(mBuf + mBufEnd, 1, mBufCapacity - mBufEnd, mFile);
+      if(got <= 0)
+      {
+        // the last line has no line break
+        if(!len)
+          return false;
+
+        start = mBuf;
+        mBufStart = mBufEnd;
+        mLinePos += len;
+        break;
+      }
+
+      mBufEnd += got;
+    }
+  }
+
+  if(len && start[len - 1] == '\r')
+    len--;
+
+  *line = start;
+  *length = len;
+  return true;
 }
 
 /**
@@ -135,19 +346,22 @@ void ic_file::close()
 ic_string *ic_file::read(long size)
 {
   // is file open and readable?
-  if(!(mMode & IO_READ)) return nullptr;
+  if(!mFile || !(mMode & IO_READ)) return nullptr;
+  sync();
 
-  // detect actual file size
-  long tmpseek = ftell(mFile);
-  fseek(mFile, 0, SEEK_END);
-  long realsize = ftell(mFile);
-  size = MIN(size, realsize);
-  fseek(mFile, tmpseek, 0);
-
-  // load data from file
   ic_string *str = new ic_string();
-  str->empty(size);
-  fread(str->mFirst->mBuf, 1, size, mFile);
+  if(!str) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  if(size <= 0)
+    return str;
+
+  char *buf = new char[size];
+  if(!buf) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  long len = fread(buf, 1, size, mFile);
+  if(len > 0)
+    str->set(buf, len);
+
+  delete [] buf;
   return str;
 }
 
@@ -160,7 +374,8 @@ ic_string *ic_file::read(long size)
 bool ic_file::write(const char *data, long size)
 {
   // is file open and writable?
-  if(!(mMode & IO_WRITE)) return false;
+  if(!mFile || !(mMode & IO_WRITE)) return false;
+  sync();
 
   // detect filesize
   if(!size) size = strlen(data);
@@ -178,7 +393,8 @@ bool ic_file::write(const char *data, long size)
 bool ic_file::write(ic_string *data, long size)
 {
   // is file open and writable?
-  if(!(mMode & IO_WRITE)) return false;
+  if(!mFile || !(mMode & IO_WRITE)) return false;
+  sync();
 
   // detect filesize
   if(!size) size = data->length();
@@ -215,7 +431,10 @@ bool ic_file::exists()
 void ic_file::seek(long pos, char mode)
 {
   if(mFile)
+  {
+    sync();
     fseek(mFile, pos, mode);
+  }
 }
 
 /**
@@ -224,7 +443,9 @@ void ic_file::seek(long pos, char mode)
  */
 inline long ic_file::tell()
 {
-  if(mFile)
+  if(mReading)
+    return mLinePos;
+  else if(mFile)
     return ftell(mFile);
   else
     return 0;
@@ -232,31 +453,19 @@ inline long ic_file::tell()
 
 /**
  * Copies a file to another location.
+ * Data written through an open file is flushed to be copied as well.
  * @param name New file name.
  * @return Flag indicating success of the operation.
  */
 bool ic_file::copy(const char *name)
 {
-  FILE *from = fopen(mName, "rb");
-  FILE *to = fopen(name, "wb");
-  if(!from || !to)
-  {
-    fclose(from);
-    fclose(to);
+  if(!mName)
     return false;
-  }
 
-  char buf[4096];
-  while(!feof(from))
-  {
-    int size = fread(buf, 4096, 1, from);
-    fwrite(buf, size, 1, to);
-  }
-
-  fclose(from);
-  fclose(to);
+  if(mFile && mMode & IO_WRITE)
+    fflush(mFile);
 
-  return true;
+  return sc_file::copy(mName, name);
 }
 
 /**
@@ -266,7 +475,7 @@ bool ic_file::copy(const char *name)
  */
 inline bool ic_file::copy(ic_string *name)
 {
-  copy(name->get());
+  return copy(name->get());
 }
 
 /**
@@ -274,9 +483,18 @@ inline bool ic_file::copy(ic_string *name)
  * @param name New file name.
  * @return Flag indicating success of the operation.
  */
-inline bool ic_file::rename(const char *name)
+bool ic_file::rename(const char *name)
 {
-  return std::rename(mName, name) == 0;
+  if(!mName || std::rename(mName, name))
+    return false;
+
+  // an open stream follows the file to it's new place
+  char *new_name = new char[strlen(name) + 1];
+  strcpy(new_name, name);
+
+  delete [] mName;
+  mName = new_name;
+  return true;
 }
 
 /**
@@ -286,7 +504,7 @@ inline bool ic_file::rename(const char *name)
  */
 inline bool ic_file::rename(ic_string *name)
 {
-  return std::rename(mName, name->get()) == 0;
+  return rename(name->get());
 }
 
 /**
@@ -295,7 +513,7 @@ inline bool ic_file::rename(ic_string *name)
  */
 inline bool ic_file::remove()
 {
-  return std::remove(mName) == 0;
+  return mName && std::remove(mName) == 0;
 }
 
 /**
@@ -361,10 +579,13 @@ long ic_file::length()
   }
   else
   {
-    FILE *file = fopen(mName, "r");
-    fseek(file, 0, SEEK_END);
-    length = ftell(file);
-    fclose(file);
+    FILE *file = mName ? fopen(mName, "r") : NULL;
+    if(file)
+    {
+      fseek(file, 0, SEEK_END);
+      length = ftell(file);
+      fclose(file);
+    }
   }
 
   return length;
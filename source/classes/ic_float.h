@@ -23,7 +23,7 @@ ic_float::ic_float(double value)
  */
 ic_float::~ic_float()
 {
-  delete mStrBuf;
+  delete [] mStrBuf;
 }
 
 /**
@@ -50,18 +50,10 @@ inline long ic_float::to_i()
  */
 const char *ic_float::to_s()
 {
-  delete mStrBuf;
-
-  mStrBuf = new char[32];
-  char len = sprintf(mStrBuf, "%.10f", mValue) - 1;
-
-  // trim off trailing zeroes
-  while(len > 1 && mStrBuf[len] == '0' && mStrBuf[len-1] != '.')
-  {
-    mStrBuf[len] = '\0';
-    len--;
-  }
+  if(!mStrBuf)
+    mStrBuf = new char[NUMBER_BUF_SIZE];
 
+  sc_number::format_float(mStrBuf, mValue);
   return mStrBuf;
 }
 
@@ -0,0 +1,141 @@
+/**
+ * @file ic_generator.h
+ * @author impworks.
+ * ic_generator header.
+ * Defines properties and methods of ic_generator class.
+ */
+
+#ifndef IC_GENERATOR_H
+#define IC_GENERATOR_H
+
+/**
+ * ic_generator constructor.
+ */
+ic_generator::ic_generator()
+{
+  mHead = NULL;
+  pMethod = NULL;
+  mStarted = false;
+  mFinished = true;
+}
+
+/**
+ * ic_generator destructor.
+ * Frames of a method that has not finished are released.
+ */
+ic_generator::~ic_generator()
+{
+  if(mHead)
+  {
+    mHead->unwind();
+    delete mHead;
+  }
+}
+
+/**
+ * Prepares the method to be run by the generator.
+ * Arguments left in the parent head's accumulator are handed over to the method.
+ * @param parent Head that creates the generator.
+ * @param method Method to be run.
+ */
+void ic_generator::start(rc_head *parent, rc_method *method)
+{
+  mHead = new rc_head(parent->pCore);
+  if(!mHead) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  mHead->pGenerator = this;
+  mHead->pThread = parent->pThread;
+  strcpy(mHead->mFile, parent->mFile);
+  mHead->mLine = parent->mLine;
+
+  while(parent->rSRC.mLength)
+    mHead->rSRC.push(parent->rSRC.pop());
+
+  pMethod = method;
+  mFinished = false;
+}
+
+/**
+ * Runs the method until it yields the next value.
+ * @return false if the method has returned or thrown an exception.
+ */
+bool ic_generator::resume()
+{
+  if(mFinished) return false;
+
+  mHead->mState = M_STATE_RUN;
+  if(!mStarted)
+  {
+    rc_cmd cmd;
+    cmd.mCmd = RASM_CMD_CALL;
+    cmd.mModifier = 0;
+    cmd.mParam.addr = 0;
+
+    mHead->pCmd = &cmd;
+    mHead->pCurrClass = mHead->pTmpClass = mHead->pCore->mClassCache.pObject;
+    mHead->pCurrObj = NULL;
+    mStarted = true;
+
+    mHead->method_invoke(pMethod);
+  }
+  else
+    mHead->playback(false);
+
+  if(mHead->mState == M_STATE_PAUSED)
+    return true;
+
+  // values returned by the method are not used
+  mFinished = true;
+  mHead->cmd_clrsrc();
+  return false;
+}
+
+/**
+ * Takes the value yielded by the method.
+ * @return Value.
+ */
+rc_var *ic_generator::value()
+{
+  rc_var *value = mHead->rAX;
+  mHead->rAX = NULL;
+  return value;
+}
+
+/**
+ * Takes the exception the method has thrown.
+ * The file name is kept by the generator's head, so it is interned.
+ * @return Exception or NULL if the method has not failed.
+ */
+rc_var *ic_generator::error()
+{
+  if(!mHead || mHead->mState != M_STATE_DEAD || !mHead->rAX)
+    return NULL;
+
+  rc_var *exc = mHead->rAX;
+  mHead->rAX = NULL;
+
+  sc_exception *data = (sc_exception *)exc->get()->mData;
+  if(data->mFile)
+    data->mFile = sc_strpool::intern(data->mFile);
+
+  return exc;
+}
+
+/**
+ * ic_generator -> boolean convertor.
+ * @return bool
+ */
+inline bool ic_generator::to_b()
+{
+  return !mFinished;
+}
+
+/**
+ * ic_generator -> string convertor.
+ * @return char*
+ */
+inline const char *ic_generator::to_s()
+{
+  return "Generator";
+}
+
+#endif
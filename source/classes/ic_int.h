@@ -23,7 +23,7 @@ ic_int::ic_int(long value)
  */
 ic_int::~ic_int()
 {
-   delete mStrBuf;
+   delete [] mStrBuf;
 }
 
 /**
@@ -50,11 +50,10 @@ inline double ic_int::to_f()
  */
 const char *ic_int::to_s()
 {
-  delete mStrBuf;
+  if(!mStrBuf)
+    mStrBuf = new char[NUMBER_BUF_SIZE];
 
-  auto val = std::to_string(mValue);
-  mStrBuf = new char[val.size() + 1];
-  std::strncpy(mStrBuf, val.c_str(), val.size() + 1);
+  sc_number::format_int(mStrBuf, mValue);
   return mStrBuf;
 }
 
@@ -0,0 +1,163 @@
+/**
+ * @file ic_lazy.h
+ * @author impworks.
+ * ic_lazy header.
+ * Defines properties and methods of ic_lazy class.
+ */
+
+#ifndef IC_LAZY_H
+#define IC_LAZY_H
+
+/**
+ * ic_lazy constructor.
+ */
+ic_lazy::ic_lazy()
+{
+  mSource = LAZY_RANGE;
+  mStart = 0;
+  mEnd = 0;
+  pArray = NULL;
+  mVars = new sc_voidarray();
+  if(!mVars) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  mStages = NULL;
+  mLength = 0;
+  mSize = 0;
+}
+
+/**
+ * ic_lazy destructor.
+ * Variables are unlinked by rc_head, as the enumerator is not aware of it.
+ */
+ic_lazy::~ic_lazy()
+{
+  delete [] mStages;
+  delete mVars;
+}
+
+/**
+ * Sets a range as the source.
+ * @param start First value.
+ * @param end Last value.
+ */
+void ic_lazy::set(long start, long end)
+{
+  mSource = LAZY_RANGE;
+  mStart = start;
+  mEnd = end;
+}
+
+/**
+ * Sets an array as the source.
+ * @param arr Variable holding the array. The enumerator takes over the link.
+ */
+void ic_lazy::set(rc_var *arr)
+{
+  mSource = LAZY_ARRAY;
+  pArray = arr;
+  mVars->add(arr);
+}
+
+/**
+ * Appends a stage.
+ * @param type Stage type.
+ * @param arg Method or zipped enumerator. The enumerator takes over the link.
+ * @param count Number of items to take.
+ */
+void ic_lazy::add(char type, rc_var *arg, long count)
+{
+  if(mLength == mSize)
+  {
+    long new_size = mSize ? mSize * 2 : 4;
+    stage *stages = new stage[new_size];
+    if(!stages) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+    if(mLength) memcpy(stages, mStages, mLength * sizeof(stage));
+    delete [] mStages;
+    mStages = stages;
+    mSize = new_size;
+  }
+
+  mStages[mLength].mType = type;
+  mStages[mLength].pArg = arg;
+  mStages[mLength].mCount = count;
+  mLength++;
+
+  if(arg) mVars->add(arg);
+}
+
+/**
+ * Adds a link to every variable held, after the enumerator has been copied.
+ */
+void ic_lazy::link()
+{
+  for(long idx = 0; idx < mVars->length(); idx++)
+    ((rc_var *)mVars->get(idx))->mLinks++;
+}
+
+/**
+ * Returns the number of stages.
+ */
+inline long ic_lazy::length()
+{
+  return mLength;
+}
+
+/**
+ * Returns a stage.
+ * @param idx Index of the stage.
+ */
+inline ic_lazy::stage *ic_lazy::get(long idx)
+{
+  return (idx >= 0 && idx < mLength) ? mStages + idx : NULL;
+}
+
+/**
+ * ic_lazy -> boolean convertor.
+ * @return bool
+ */
+inline bool ic_lazy::to_b()
+{
+  return true;
+}
+
+/**
+ * ic_lazy -> string convertor.
+ * @return char*
+ */
+inline const char *ic_lazy::to_s()
+{
+  return "Lazy";
+}
+
+/**
+ * Assignment operator.
+ * Copies the description, links are not added: see link().
+ * @param right Enumerator to be copied.
+ */
+ic_lazy &ic_lazy::operator=(ic_lazy &right)
+{
+  if(this == &right) return *this;
+
+  mSource = right.mSource;
+  mStart = right.mStart;
+  mEnd = right.mEnd;
+  pArray = right.pArray;
+
+  while(mVars->length())
+    mVars->pop();
+  for(long idx = 0; idx < right.mVars->length(); idx++)
+    mVars->add(right.mVars->get(idx));
+
+  delete [] mStages;
+  mStages = NULL;
+  mLength = mSize = 0;
+  for(long idx = 0; idx < right.mLength; idx++)
+  {
+    add(right.mStages[idx].mType, NULL, right.mStages[idx].mCount);
+    mStages[idx].pArg = right.mStages[idx].pArg;
+  }
+
+  return *this;
+}
+
+#endif
@@ -13,32 +13,76 @@
  */
 ic_match::ic_match()
 {
-  pString = NULL;
-  mCount = -1;
+  mCount = 0;
+  mMatches = NULL;
+  mSource = NULL;
+  mBase = 0;
+  mSubstrings = NULL;
+}
+
+/**
+ * ic_match default destructor.
+ */
+ic_match::~ic_match()
+{
+  clear();
+}
 
-  for(int idx=0; idx<REGEX_MAX_MATCHES; idx++)
+/**
+ * Stores a successful match.
+ * Only the part of the string covered by substrings is copied.
+ * @param str Matched string.
+ * @param captures Substring bounds, -1 for unset groups.
+ * @param count Number of substrings.
+ */
+void ic_match::set(const char *str, const long *captures, long count)
+{
+  clear();
+
+  long start = captures[0], end = captures[1];
+  for(long idx=1; idx<count; idx++)
   {
-    mMatches[idx*2+1] = 0;
-    mMatches[idx*2] = 0;
-    mSubstrings[idx] = NULL;
+    // groups inside lookarounds may lie outside of the whole match
+    if(captures[idx*2] < 0) continue;
+    if(captures[idx*2] < start) start = captures[idx*2];
+    if(captures[idx*2+1] > end) end = captures[idx*2+1];
   }
+
+  mMatches = new long[count*2];
+  mSource = new char[end-start+1];
+  if(!mMatches || !mSource) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  memcpy(mMatches, captures, count*2*sizeof(long));
+  memcpy(mSource, str+start, end-start);
+  mSource[end-start] = '\0';
+  mBase = start;
+  mCount = count;
 }
 
 /**
- * ic_match default destructor.
+ * Forgets the stored match.
  */
-ic_match::~ic_match()
+void ic_match::clear()
 {
-  for(int idx=0; idx<REGEX_MAX_MATCHES; idx++)
+  if(mSubstrings)
   {
-    if(mSubstrings[idx])
+    for(long idx=0; idx<mCount; idx++)
       delete [] mSubstrings[idx];
+    delete [] mSubstrings;
+    mSubstrings = NULL;
   }
+
+  delete [] mMatches;
+  delete [] mSource;
+  mMatches = NULL;
+  mSource = NULL;
+  mBase = 0;
+  mCount = 0;
 }
 
 /**
- * Returns the number of found substrings.
- * @return Found substrings count.
+ * Returns the number of found substrings: the whole match and all capture groups.
+ * @return Found substrings count, 0 if the regex did not match.
  */
 inline long ic_match::count()
 {
@@ -48,18 +92,26 @@ inline long ic_match::count()
 /**
  * Returns a pointer to found substring.
  * @param Substring id
- * @return Substring (copied from source)
+ * @return Substring (copied from source), empty for a group that did not participate.
  */
-const char *ic_match::get(int id)
+const char *ic_match::get(long id)
 {
-  if(id < 0 || id > 9 || id > mCount) return NULL;
+  if(id < 0 || id >= mCount) return NULL;
+
+  if(!mSubstrings)
+  {
+    mSubstrings = new char*[mCount];
+    if(!mSubstrings) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+    for(long idx=0; idx<mCount; idx++)
+      mSubstrings[idx] = NULL;
+  }
 
   if(!mSubstrings[id])
   {
-    long new_len = mMatches[id*2+1] - mMatches[id*2];
+    long new_len = mMatches[id*2] < 0 ? 0 : mMatches[id*2+1] - mMatches[id*2];
     mSubstrings[id] = new char[new_len+1];
     if(!mSubstrings[id]) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
-    strncpy(mSubstrings[id], pString+mMatches[id*2], new_len);
+    if(new_len) memcpy(mSubstrings[id], mSource+mMatches[id*2]-mBase, new_len);
     *(mSubstrings[id]+new_len) = '\0';
   }
 
@@ -68,15 +120,50 @@ const char *ic_match::get(int id)
 
 /**
  * Save starting and ending points of a match to an array of longs.
- * @param id Substring id (0..9)
- * @param[out] where Pointer to long[2] to save values to.
+ * @param id Substring id (0 is the whole match)
+ * @param[out] where Pointer to long[2] to save values to (-1 for a group that did not participate).
  */
-void ic_match::bounds(int id, long *where)
+void ic_match::bounds(long id, long *where)
 {
-  if(!where || id < 0 || id > 9 || id > mCount) return;
+  if(!where || id < 0 || id >= mCount) return;
 
   *where = mMatches[id*2];
   *(where+1) = mMatches[id*2+1];
 }
 
-#endif
\ No newline at end of file
+/**
+ * Assign operator.
+ * @param right Source match.
+ * @return Link to this.
+ */
+ic_match &ic_match::operator=(ic_match &right)
+{
+  if(&right == this) return *this;
+
+  clear();
+  if(right.mCount)
+  {
+    mMatches = new long[right.mCount*2];
+    if(!mMatches) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+    memcpy(mMatches, right.mMatches, right.mCount*2*sizeof(long));
+
+    // the copied part ends with the rightmost substring
+    long len = 0;
+    for(long idx=0; idx<right.mCount; idx++)
+    {
+      if(right.mMatches[idx*2+1] - right.mBase > len)
+        len = right.mMatches[idx*2+1] - right.mBase;
+    }
+
+    mSource = new char[len+1];
+    if(!mSource) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+    memcpy(mSource, right.mSource, len+1);
+
+    mBase = right.mBase;
+    mCount = right.mCount;
+  }
+
+  return *this;
+}
+
+#endif
@@ -0,0 +1,106 @@
+/**
+ * @file ic_matchiter.h
+ * @author impworks.
+ * ic_matchiter header.
+ * Defines properties and methods of ic_matchiter class.
+ */
+
+#ifndef IC_MATCHITER_H
+#define IC_MATCHITER_H
+
+/**
+ * ic_matchiter constructor.
+ * @param regex Regex to be matched.
+ * @param str String to be scanned.
+ * @param len Length of the string (0 to autocalculate).
+ * @param offset Position to start scanning from.
+ */
+ic_matchiter::ic_matchiter(ic_regex *regex, const char *str, long len, long offset)
+{
+  if(regex->mProgram == NULL)
+    ERROR(M_ERR_BAD_REGEXP, M_EMODE_ERROR);
+
+  pRegex = regex;
+  pString = str;
+  mLength = len ? len : strlen(str);
+  mOffset = offset;
+
+  mCount = regex->mProgram->groups();
+  mCaptures = new long[mCount*2];
+  if(!mCaptures) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  for(long idx=0; idx<mCount*2; idx++)
+    mCaptures[idx] = -1;
+
+  // looped matching pays for the DFA once
+  regex->study();
+}
+
+/**
+ * ic_matchiter destructor.
+ */
+ic_matchiter::~ic_matchiter()
+{
+  delete [] mCaptures;
+}
+
+/**
+ * Points the iterator to a new buffer of the same string.
+ * Used when the string could have been reallocated between steps, the position is kept.
+ * @param str String to be scanned.
+ * @param len Length of the string.
+ */
+inline void ic_matchiter::source(const char *str, long len)
+{
+  pString = str;
+  mLength = len;
+}
+
+/**
+ * Finds the next match.
+ * Its bounds are available via captures() until the next call.
+ * @return Whether a match was found.
+ */
+bool ic_matchiter::find()
+{
+  if(mOffset < 0 || mOffset > mLength || !pRegex->mProgram->exec(pString, mLength, mOffset, mCaptures))
+  {
+    mOffset = -1;
+    return false;
+  }
+
+  // do not find the same empty match again
+  mOffset = mCaptures[1] > mCaptures[0] ? mCaptures[1] : mCaptures[1] + 1;
+  return true;
+}
+
+/**
+ * Finds the next match and returns it as an ic_match.
+ * @return Match object or NULL if there are no more matches.
+ */
+ic_match *ic_matchiter::next()
+{
+  if(!find()) return NULL;
+
+  ic_match *match = new ic_match();
+  if(!match) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  match->set(pString, mCaptures, mCount);
+  return match;
+}
+
+/**
+ * Returns the number of substrings in every match: the whole match and all capture groups.
+ */
+inline long ic_matchiter::count()
+{
+  return mCount;
+}
+
+/**
+ * Returns substring bounds of the last match found, -1 for unset groups.
+ */
+inline const long *ic_matchiter::captures()
+{
+  return mCaptures;
+}
+
+#endif
@@ -18,7 +18,7 @@ ic_object::ic_object(rc_class *root, void *data)
   mLinks = 1;
   pClass = root;
   mData = data;
-  mFrozen = mTainted = false;
+  mFrozen = mTainted = mShared = false;
 
   mMembers = new sc_voidmap(root->mMembers);
 
@@ -8,15 +8,14 @@
 #ifndef IC_REGEX_H
 #define IC_REGEX_H
 
-#include <memory>
-#include <regex>
-
 /**
  * ic_regex constructor.
  */
 ic_regex::ic_regex()
 {
+  mProgram = NULL;
   mPattern = NULL;
+  pError = NULL;
   mErrorOffset = -1;
   mOptions = 0;
 }
@@ -27,7 +26,9 @@ ic_regex::ic_regex()
  */
 ic_regex::ic_regex(const char *pattern)
 {
+  mProgram = NULL;
   mPattern = NULL;
+  pError = NULL;
   mErrorOffset = -1;
   mOptions = 0;
 
@@ -40,7 +41,9 @@ ic_regex::ic_regex(const char *pattern)
  */
 ic_regex::ic_regex(ic_regex* regex)
 {
+  mProgram = NULL;
   mPattern = NULL;
+  pError = NULL;
   mErrorOffset = -1;
   mOptions = 0;
 
@@ -52,28 +55,25 @@ ic_regex::ic_regex(ic_regex* regex)
  */
 ic_regex::~ic_regex()
 {
+  sc_regexcache::release(mProgram);
+  delete [] mPattern;
 }
 
 /**
  * Assigns a new regular expression.
+ * Pattern syntax is /body/flags, where flags are:
+ * i - case insensitive, x - extended (whitespace and comments ignored),
+ * m - multiline (^ and $ match at line breaks), s - dot matches a line break.
  * @param pattern Pointer to source string to be compiled.
  */
 void ic_regex::set(const char *pattern)
-{
-  set(pattern, std::regex::flag_type{});
-}
-
-/**
-* Assigns a new regular expression.
-* @param pattern Pointer to source string to be compiled.
-* @param flags Initial flags of the regex.
-*/
-void ic_regex::set(const char *pattern, std::regex::flag_type flags)
 {
   // validate pattern
   register long idx;
   long new_len = strlen(pattern);
+  int flags = 0;
   char chr;
+  pError = NULL;
   if(*pattern != '/')
   {
     mErrorOffset = -1;
@@ -87,13 +87,25 @@ void ic_regex::set(const char *pattern, std::regex::flag_type flags)
     chr = *(pattern+idx);
     if(chr == 'i')
     {
-      flags |= std::regex::icase;
+      flags |= REGEX_ICASE;
       continue;
     }
 
     if(chr == 'x')
     {
-      flags |= std::regex::extended;
+      flags |= REGEX_EXTENDED;
+      continue;
+    }
+
+    if(chr == 'm')
+    {
+      flags |= REGEX_MULTILINE;
+      continue;
+    }
+
+    if(chr == 's')
+    {
+      flags |= REGEX_DOTALL;
       continue;
     }
 
@@ -121,62 +133,60 @@ void ic_regex::set(const char *pattern, std::regex::flag_type flags)
 
   // store data
   delete [] mPattern;
-  
+  sc_regexcache::release(mProgram);
+  mProgram = NULL;
+
   mPattern = new char[new_len+1];
   if(!mPattern) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
   strcpy(mPattern, pattern);
   mOptions = flags;
 
-  // compile regular expression
-  const auto tmp_buf = std::string(pattern + 1, idx - 1);
-  try {
-    mRegEx = std::regex(tmp_buf, flags);
-  } catch (const std::regex_error &error) {
-    pError = error.what();
+  // compile regular expression or take it from the cache
+  long error_pos;
+  mProgram = sc_regexcache::get(pattern + 1, idx - 1, flags, &pError, &error_pos);
+  if(!mProgram)
+  {
+    mErrorOffset = error_pos;
     ERROR(M_ERR_BAD_REGEXP, M_EMODE_ERROR);
   }
 }
 
 /**
- * Collects matches of a string.
+ * Finds the leftmost match in a string.
+ * Substring 0 is the whole match, the following substrings are capture groups.
  * @param str String to be matched.
  * @param offset Offset from the start of the string.
  * @param len Number of characters in the string to account for.
- * @return Number of matches found.
+ * @return Match object, its count() is 0 if nothing was found.
  */
-ic_match *ic_regex::match(const char *str, int offset, long len)
+ic_match *ic_regex::match(const char *str, long offset, long len)
 {
-  if(mPattern == nullptr)
+  if(mProgram == NULL)
     ERROR(M_ERR_BAD_REGEXP, M_EMODE_ERROR);
 
   if(!len) len = strlen(str);
 
-  auto match = std::unique_ptr<ic_match>(new ic_match());
+  ic_match *match = new ic_match();
+  if(!match) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
 
-  auto search = std::cregex_iterator(str + offset, str + len, mRegEx);
-  auto end = std::cregex_iterator();
-  auto count = 0;
-  for(auto i = 0; i < REGEX_MAX_MATCHES && search != end; ++i, ++search)
-  {
-    ++count;
-    auto begin = offset + search->position();
-    auto end = begin + search->length();
-    match->mMatches[i * 2] = begin;
-    match->mMatches[i * 2 + 1] = end;
-  }
-  
-  match->mCount = count;
-  match->pString = str;
-  return match.release();
+  long groups = mProgram->groups();
+  long *captures = new long[groups*2];
+  if(!captures) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  if(mProgram->exec(str, len, offset, captures))
+    match->set(str, captures, groups);
+
+  delete [] captures;
+  return match;
 }
 
 /**
- * Collects matches of an ic_string.
+ * Finds the leftmost match in an ic_string.
  * @param str String to be matched.
  * @param offset Offset from the start of the string.
- * @return Number of matches found.
+ * @return Match object.
  */
-ic_match *ic_regex::match(ic_string *str, int offset)
+ic_match *ic_regex::match(ic_string *str, long offset)
 {
   return match(str->get(), offset, str->length());
 }
@@ -186,12 +196,9 @@ ic_match *ic_regex::match(ic_string *str, int offset)
  */
 inline void ic_regex::study()
 {
-  if(mPattern == nullptr) return;
+  if(mProgram == nullptr) return;
 
-  if(!(mRegEx.flags() & std::regex::optimize))
-  {
-    set(mPattern, std::regex::optimize);
-  }
+  mProgram->study();
 }
 
 /**
@@ -248,7 +255,6 @@ ic_regex &ic_regex::operator=(const char *right)
  */
 ic_regex &ic_regex::operator=(ic_regex &right)
 {
-  mPattern = NULL;
   pError = NULL;
   mErrorOffset = -1;
   mOptions = 0;
@@ -0,0 +1,330 @@
+/**
+ * @file ic_regexset.h
+ * @author impworks.
+ * ic_regexset header.
+ * Defines properties and methods of ic_regexset class.
+ */
+
+#ifndef IC_REGEXSET_H
+#define IC_REGEXSET_H
+
+/**
+ * ic_regexset constructor.
+ */
+ic_regexset::ic_regexset()
+{
+  mItems = NULL;
+  mLength = 0;
+  mSize = 0;
+  mPrograms = NULL;
+  mFirst = NULL;
+  mNumPrograms = 0;
+  mExact = NULL;
+  mLiterals = NULL;
+  mCompiled = false;
+}
+
+/**
+ * ic_regexset destructor.
+ */
+ic_regexset::~ic_regexset()
+{
+  clear();
+}
+
+/**
+ * Adds a copy of the regex to the set.
+ * @param regex Compiled regex.
+ */
+void ic_regexset::add(ic_regex *regex)
+{
+  if(regex->mProgram == NULL)
+    ERROR(M_ERR_BAD_REGEXP, M_EMODE_ERROR);
+
+  add(regex->to_s());
+}
+
+/**
+ * Compiles a regex and adds it to the set.
+ * @param pattern Regex in /body/flags form.
+ */
+void ic_regexset::add(const char *pattern)
+{
+  if(mLength == mSize)
+  {
+    long new_size = mSize ? mSize * 2 : 8;
+    ic_regex **items = new ic_regex*[new_size];
+    if(!items) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+    if(mLength) memcpy(items, mItems, mLength * sizeof(ic_regex *));
+    delete [] mItems;
+    mItems = items;
+    mSize = new_size;
+  }
+
+  ic_regex *item = new ic_regex(pattern);
+  if(!item) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  if(item->mProgram == NULL)
+  {
+    delete item;
+    ERROR(M_ERR_BAD_REGEXP, M_EMODE_ERROR);
+  }
+  mItems[mLength++] = item;
+
+  forget();
+}
+
+/**
+ * Removes all regexes from the set.
+ */
+void ic_regexset::clear()
+{
+  forget();
+
+  for(long idx=0; idx<mLength; idx++)
+    delete mItems[idx];
+
+  delete [] mItems;
+  mItems = NULL;
+  mLength = 0;
+  mSize = 0;
+}
+
+/**
+ * Returns the number of regexes in the set.
+ */
+inline long ic_regexset::length()
+{
+  return mLength;
+}
+
+/**
+ * Returns a regex from the set.
+ * @param id Regex index.
+ * @return Regex or NULL if the index is out of bounds.
+ */
+inline ic_regex *ic_regexset::get(long id)
+{
+  return (id >= 0 && id < mLength) ? mItems[id] : NULL;
+}
+
+/**
+ * Finds out which regexes of the set match the string.
+ * Regexes are compiled into a single automaton on the first call, so the string is
+ * read once instead of once per regex. Only candidates the automaton cannot decide
+ * on its own (anchors, lookarounds, back references) are matched separately.
+ * @param str String to be matched.
+ * @param len Length of the string.
+ * @param[out] found Flags for every regex of the set.
+ * @return Number of matched regexes.
+ */
+long ic_regexset::match(const char *str, long len, char *found)
+{
+  if(!mCompiled) compile();
+  if(!mLength) return 0;
+
+  memset(found, 0, mLength);
+  if(mLiterals)
+    return mLiterals->scan(str, len, found);
+
+  // inexact patterns stay candidates until verified
+  for(long idx=0; idx<mLength; idx++)
+    if(!mExact[idx]) found[idx] = 1;
+
+  for(long idx=0; idx<mNumPrograms; idx++)
+  {
+    if(!mPrograms[idx]) continue;
+
+    long from = mFirst[idx], to = mFirst[idx+1];
+    for(long item=from; item<to; item++)
+      found[item] = 0;
+    mPrograms[idx]->scan(str, len, found + from);
+  }
+
+  long count = 0;
+  for(long idx=0; idx<mLength; idx++)
+  {
+    if(found[idx] && !mExact[idx])
+    {
+      sc_regex *program = mItems[idx]->mProgram;
+      long *captures = new long[program->groups()*2];
+      if(!captures) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+      found[idx] = program->exec(str, len, 0, captures);
+      delete [] captures;
+    }
+
+    if(found[idx]) count++;
+  }
+
+  return count;
+}
+
+/**
+ * ic_regexset -> boolean converter.
+ * @return bool
+ */
+inline bool ic_regexset::to_b()
+{
+  return mLength > 0;
+}
+
+/**
+ * Assign operator.
+ * @param right Source set.
+ * @return Link to this.
+ */
+ic_regexset &ic_regexset::operator=(ic_regexset &right)
+{
+  if(&right == this) return *this;
+
+  clear();
+  for(long idx=0; idx<right.mLength; idx++)
+    add(right.mItems[idx]);
+
+  return *this;
+}
+
+/**
+ * Compiles the regexes into combined programs.
+ * A set of plain strings is put into an Aho-Corasick dictionary instead.
+ */
+void ic_regexset::compile()
+{
+  forget();
+  mCompiled = true;
+  if(!mLength) return;
+
+  mExact = new char[mLength];
+  if(!mExact) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  // try plain strings first
+  mLiterals = new sc_strset();
+  if(!mLiterals) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  ic_string str;
+  for(long idx=0; idx<mLength && mLiterals; idx++)
+  {
+    if(literal(mItems[idx], &str))
+      mLiterals->add(str.get(), str.length());
+    else
+    {
+      delete mLiterals;
+      mLiterals = NULL;
+    }
+  }
+
+  if(mLiterals)
+  {
+    mLiterals->build();
+    return;
+  }
+
+  mPrograms = new sc_regex*[mLength];
+  mFirst = new long[mLength+1];
+  if(!mPrograms || !mFirst) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  compile_range(0, mLength);
+  mFirst[mNumPrograms] = mLength;
+}
+
+/**
+ * Compiles a range of regexes into one program.
+ * A range that is too large for one program is split in halves.
+ * @param from First regex.
+ * @param to Position after the last regex.
+ */
+void ic_regexset::compile_range(long from, long to)
+{
+  long count = to - from;
+  const char **patterns = new const char*[count];
+  long *lens = new long[count];
+  int *flags = new int[count];
+  if(!patterns || !lens || !flags) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  for(long idx=0; idx<count; idx++)
+  {
+    ic_regex *item = mItems[from+idx];
+    patterns[idx] = item->mPattern + 1;
+    lens[idx] = strrchr(item->mPattern, '/') - patterns[idx];
+    flags[idx] = item->mOptions;
+  }
+
+  const char *error;
+  sc_regex *program = sc_regex::compile_set(count, patterns, lens, flags, &error);
+
+  delete [] patterns;
+  delete [] lens;
+  delete [] flags;
+
+  if(program)
+  {
+    // programs cover consecutive ranges, so the next one starts where this one ends
+    mPrograms[mNumPrograms] = program;
+    mFirst[mNumPrograms++] = from;
+    for(long idx=from; idx<to; idx++)
+      mExact[idx] = mItems[idx]->mProgram->exact();
+  }
+  else if(count > 1)
+  {
+    compile_range(from, from + count / 2);
+    compile_range(from + count / 2, to);
+  }
+  else
+  {
+    // a single huge regex is matched on its own
+    mPrograms[mNumPrograms] = NULL;
+    mFirst[mNumPrograms] = from;
+    mExact[from] = 0;
+  }
+}
+
+/**
+ * Drops the compiled programs.
+ */
+void ic_regexset::forget()
+{
+  for(long idx=0; idx<mNumPrograms; idx++)
+    delete mPrograms[idx];
+
+  delete [] mPrograms;
+  delete [] mFirst;
+  delete [] mExact;
+  delete mLiterals;
+  mPrograms = NULL;
+  mFirst = NULL;
+  mNumPrograms = 0;
+  mExact = NULL;
+  mLiterals = NULL;
+  mCompiled = false;
+}
+
+/**
+ * Checks whether the regex only matches a plain string.
+ * @param regex Regex to be checked.
+ * @param[out] str The string with escapes resolved.
+ * @return Whether the regex is a plain string.
+ */
+bool ic_regexset::literal(ic_regex *regex, ic_string *str)
+{
+  if(regex->mOptions & (REGEX_ICASE | REGEX_EXTENDED)) return false;
+
+  const char *body = regex->mPattern + 1;
+  long len = strrchr(regex->mPattern, '/') - body;
+
+  str->empty();
+  for(long idx=0; idx<len; idx++)
+  {
+    char chr = body[idx];
+    if(chr == '\\')
+    {
+      // only escaped punctuation stands for itself
+      if(idx+1 == len || isalnum((unsigned char)body[idx+1])) return false;
+      chr = body[++idx];
+    }
+    else if(strchr("^$.|?*+()[]{}", chr))
+      return false;
+
+    str->append(chr);
+  }
+
+  return true;
+}
+
+#endif
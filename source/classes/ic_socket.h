@@ -9,12 +9,156 @@
 #define IC_SOCKET_H
 
 /**
- * ic_file constructor.
+ * ic_socket constructor.
+ * The descriptor is created once the socket listens or connects,
+ * when the address family is known.
+ * @param type SOCKET_TCP, SOCKET_UDP or SOCKET_UNIX.
  */
-ic_socket::ic_socket()
+ic_socket::ic_socket(char type)
 {
-  mName = NULL;
-  mMode = 0;
+  mFd = -1;
+  mType = type;
+  mListening = false;
+  mEof = false;
+  mSent = 0;
+  mEvents = 0;
+  pOnRead = NULL;
+  pOnWrite = NULL;
+  pWatch = NULL;
+
+  mInput = new ic_string();
+  mOutput = new ic_string();
+  if(!mInput || !mOutput) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+}
+
+/**
+ * ic_socket destructor.
+ * The callbacks are unlinked by rc_head.
+ */
+ic_socket::~ic_socket()
+{
+  close();
+
+  delete mInput;
+  delete mOutput;
+}
+
+/**
+ * Reads the data received.
+ * Taking everything hands the input string over without copying it,
+ * unless it is mostly empty space the socket would rather keep.
+ * @param size Number of bytes to read, 0 for everything received.
+ * @return String, empty if nothing has been received.
+ */
+ic_string *ic_socket::read(long size)
+{
+  fill();
+
+  ic_string *str;
+  if(size <= 0 || size >= mInput->length())
+  {
+    if(mInput->length() >= mInput->capacity() / 4)
+    {
+      str = mInput;
+      mInput = new ic_string();
+      if(!mInput) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+    }
+    else
+    {
+      str = mInput->length() ? new ic_string(mInput->get(), mInput->length()) : new ic_string();
+      if(!str) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+      mInput->empty(mInput->capacity());
+    }
+  }
+  else
+  {
+    str = mInput->substr_get(0, size);
+    mInput->substr_set(0, size, "");
+  }
+
+  return str;
+}
+
+/**
+ * Reads a line of the data received, without the line break.
+ * @return String or NULL if no whole line has been received yet.
+ */
+ic_string *ic_socket::read_line()
+{
+  fill();
+
+  char *buf = mInput->get();
+  char *end = (char *)memchr(buf, '\n', mInput->length());
+  if(!end)
+    return mEof && mInput->length() ? read(0) : NULL;
+
+  long pos = end - buf;
+  long len = pos && buf[pos-1] == '\r' ? pos-1 : pos;
+  ic_string *str = len ? new ic_string(buf, len) : new ic_string();
+  if(!str) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  mInput->substr_set(0, pos+1, "");
+  return str;
+}
+
+/**
+ * Writes data to the socket.
+ * Whatever cannot be sent at once is kept until the socket is ready.
+ * @param data Data to be written.
+ * @param size Number of bytes.
+ * @return Flag indicating the socket is open.
+ */
+bool ic_socket::write(const char *data, long size)
+{
+  if(mFd < 0) return false;
+
+  mOutput->append(data, size);
+  flush();
+  return mFd >= 0;
+}
+
+/**
+ * Writes data to the socket.
+ * @param data Data to be written.
+ * @return Flag indicating the socket is open.
+ */
+bool ic_socket::write(ic_string *data)
+{
+  return data->length() ? write(data->get(), data->length()) : mFd >= 0;
+}
+
+/**
+ * Returns the number of bytes written, but not sent yet.
+ */
+inline long ic_socket::pending()
+{
+  return mOutput->length() - mSent;
+}
+
+/**
+ * ic_socket -> boolean convertor.
+ * @return bool
+ */
+inline bool ic_socket::to_b()
+{
+  return mFd >= 0;
+}
+
+/**
+ * ic_socket -> int convertor.
+ * @return Descriptor.
+ */
+inline long ic_socket::to_i()
+{
+  return mFd;
+}
+
+/**
+ * ic_socket -> string convertor.
+ * @return char*
+ */
+inline const char *ic_socket::to_s()
+{
+  return "Socket";
 }
 
 #if MALCO_PLATFORM == M_PLATF_WIN32
@@ -22,7 +166,7 @@ ic_socket::ic_socket()
 #endif
 
 #if MALCO_PLATFORM == M_PLATF_NIX
-#include "ic_socket.nix.h""
+#include "ic_socket.nix.h"
 #endif
 
-#endif
\ No newline at end of file
+#endif
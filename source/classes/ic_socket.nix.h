@@ -2,4 +2,259 @@
  * @file ic_socket.nix.h
  * @author impworks
  * Platform-specific method definitions for ic_socket class.
- */
\ No newline at end of file
+ */
+
+/**
+ * Creates a non-blocking descriptor for the socket.
+ * @param family Address family.
+ * @return Success flag.
+ */
+bool ic_socket::create(int family)
+{
+  int type = mType == SOCKET_UDP ? SOCK_DGRAM : SOCK_STREAM;
+  mFd = ::socket(family, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if(mFd < 0) return false;
+
+  int on = 1;
+  if(mType == SOCKET_TCP)
+    setsockopt(mFd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+  mEof = false;
+  return true;
+}
+
+/**
+ * Resolves an address for the socket.
+ * @param host Host name or address, path for Unix domain sockets.
+ * @param port Port number.
+ * @param[out] addr sockaddr_storage to be filled.
+ * @param[out] len Length of the address.
+ * @return Success flag.
+ */
+bool ic_socket::address(const char *host, long port, void *addr, long *len)
+{
+  memset(addr, 0, sizeof(sockaddr_storage));
+
+  if(mType == SOCKET_UNIX)
+  {
+    sockaddr_un *un = (sockaddr_un *)addr;
+    if(strlen(host) >= sizeof(un->sun_path)) return false;
+
+    un->sun_family = AF_UNIX;
+    strcpy(un->sun_path, host);
+    *len = sizeof(sockaddr_un);
+    return true;
+  }
+
+  char service[NUMBER_BUF_SIZE];
+  sprintf(service, "%ld", port);
+
+  addrinfo hints, *info;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = mType == SOCKET_UDP ? SOCK_DGRAM : SOCK_STREAM;
+  hints.ai_flags = AI_NUMERICSERV | (*host ? 0 : AI_PASSIVE);
+
+  if(getaddrinfo(*host ? host : NULL, service, &hints, &info) != 0)
+    return false;
+
+  memcpy(addr, info->ai_addr, info->ai_addrlen);
+  *len = info->ai_addrlen;
+  freeaddrinfo(info);
+  return true;
+}
+
+/**
+ * Binds the socket and starts accepting connections.
+ * UDP sockets are only bound.
+ * @param host Address to listen at, empty for any, path for Unix domain sockets.
+ * @param port Port number.
+ * @return Success flag.
+ */
+bool ic_socket::listen(const char *host, long port)
+{
+  sockaddr_storage addr;
+  long len;
+
+  close();
+  if(!address(host, port, &addr, &len) || !create(addr.ss_family))
+    return false;
+
+  int on = 1;
+  if(mType != SOCKET_UNIX)
+    setsockopt(mFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+  if(::bind(mFd, (sockaddr *)&addr, len) < 0 || (mType != SOCKET_UDP && ::listen(mFd, SOMAXCONN) < 0))
+  {
+    close();
+    return false;
+  }
+
+  mListening = mType != SOCKET_UDP;
+  return true;
+}
+
+/**
+ * Connects the socket.
+ * The connection is established in the background, the socket is
+ * writable once it's done.
+ * @param host Host name or address, path for Unix domain sockets.
+ * @param port Port number.
+ * @return Success flag.
+ */
+bool ic_socket::connect(const char *host, long port)
+{
+  sockaddr_storage addr;
+  long len;
+
+  close();
+  if(!address(host, port, &addr, &len) || !create(addr.ss_family))
+    return false;
+
+  if(::connect(mFd, (sockaddr *)&addr, len) < 0 && errno != EINPROGRESS)
+  {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Accepts a pending connection.
+ * @param conn Socket to take the connection.
+ * @return false if there are no connections pending.
+ */
+bool ic_socket::accept(ic_socket *conn)
+{
+  if(!mListening) return false;
+
+  int fd = ::accept4(mFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+  if(fd < 0) return false;
+
+  int on = 1;
+  if(mType == SOCKET_TCP)
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+  conn->close();
+  conn->mFd = fd;
+  conn->mType = mType;
+  return true;
+}
+
+/**
+ * Makes the socket use a duplicate of another socket's descriptor.
+ * Data buffered by the other socket and it's callbacks are not copied.
+ * @param sock Socket to be copied.
+ * @return Success flag.
+ */
+bool ic_socket::copy(ic_socket *sock)
+{
+  close();
+  mType = sock->mType;
+  mListening = sock->mListening;
+  mEof = sock->mEof;
+
+  if(sock->mFd < 0) return true;
+  mFd = fcntl(sock->mFd, F_DUPFD_CLOEXEC, 0);
+  return mFd >= 0;
+}
+
+/**
+ * Closes the socket.
+ * The kernel drops the descriptor from the reactor by itself.
+ */
+void ic_socket::close()
+{
+  if(mFd >= 0)
+    ::close(mFd);
+
+  mFd = -1;
+  mListening = false;
+  mInput->empty();
+  mOutput->empty();
+  mSent = 0;
+}
+
+/**
+ * Receives everything the kernel has for the socket into the input string.
+ * The data is received straight into the string's buffer.
+ * @return Number of bytes received.
+ */
+long ic_socket::fill()
+{
+  long total = 0;
+
+  while(mFd >= 0 && !mEof && !mListening)
+  {
+    if(mInput->mLast->mCapacity - mInput->mLast->mLength < SOCKET_CHUNK / 4)
+      mInput->grow(SOCKET_CHUNK);
+
+    ic_strbuffer *buf = mInput->mLast;
+
+    ssize_t len = ::recv(mFd, buf->mBuf + buf->mLength, buf->mCapacity - buf->mLength, 0);
+    if(len > 0)
+    {
+      buf->mLength += len;
+      buf->mBuf[buf->mLength] = '\0';
+      mInput->mLength += len;
+      total += len;
+      continue;
+    }
+
+    if(len < 0 && errno == EINTR)
+      continue;
+
+    // an empty datagram is not the end of anything
+    if((len == 0 && mType != SOCKET_UDP) || (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+      mEof = true;
+
+    break;
+  }
+
+  if(total)
+    mInput->index_reset();
+
+  return total;
+}
+
+/**
+ * Sends as much of the output waiting as the kernel takes.
+ * @return Number of bytes sent.
+ */
+long ic_socket::flush()
+{
+  long total = 0;
+
+  while(mFd >= 0 && mSent < mOutput->length())
+  {
+    ssize_t len = ::send(mFd, mOutput->get() + mSent, mOutput->length() - mSent, MSG_NOSIGNAL);
+    if(len > 0)
+    {
+      mSent += len;
+      total += len;
+      continue;
+    }
+
+    if(len < 0 && errno == EINTR)
+      continue;
+
+    // the peer is gone, nothing will ever be sent
+    if(len < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+      mEof = true;
+      mOutput->empty();
+      mSent = 0;
+    }
+
+    break;
+  }
+
+  if(mSent && mSent == mOutput->length())
+  {
+    mOutput->empty();
+    mSent = 0;
+  }
+
+  return total;
+}
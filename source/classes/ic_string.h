@@ -53,6 +53,8 @@ ic_string::ic_string()
   mNumBuffers = 1;
   mLength = 0;
   mCapacity = STR_MIN_CPC;
+  mChars = -1;
+  mIndex = NULL;
 }
 
 /**
@@ -66,6 +68,8 @@ ic_string::ic_string(long cpc)
   mNumBuffers = 1;
   mLength = 0;
   mCapacity = cpc;
+  mChars = -1;
+  mIndex = NULL;
 }
 
 /**
@@ -88,6 +92,8 @@ ic_string::ic_string(const char *str, long new_len)
   mFirst->mLength = mLength = new_len;
   mCapacity = mFirst->mCapacity = new_cpc;
   mNumBuffers = 1;
+  mChars = -1;
+  mIndex = NULL;
 }
 
 /**
@@ -100,6 +106,10 @@ ic_string::ic_string(const ic_string &str)
   if(!mFirst) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
   mLast = mFirst;
   mNumBuffers = 1;
+  mLength = 0;
+  mCapacity = mFirst->mCapacity;
+  mChars = -1;
+  mIndex = NULL;
   set(&str);
 }
 
@@ -108,6 +118,7 @@ ic_string::ic_string(const ic_string &str)
  */
 ic_string::~ic_string()
 {
+  delete [] mIndex;
   ic_strbuffer *tmp, *curr=mFirst;
   for(int idx=0; idx<mNumBuffers; idx++)
   {
@@ -170,6 +181,7 @@ char *ic_string::get()
  */
 void ic_string::empty(long cpc)
 {
+  index_reset();
   if(cpc < STR_MIN_CPC) cpc = STR_MIN_CPC;
 
   if(mNumBuffers > 1)
@@ -196,6 +208,8 @@ void ic_string::empty(long cpc)
     mFirst->mLength = 0;
   }
 
+  mLast = mFirst;
+  mNumBuffers = 1;
   mCapacity = cpc;
   mLength = 0;
 }
@@ -237,38 +251,22 @@ void ic_string::set(const ic_string *src, long new_len)
  */
 void ic_string::append(const char *src, long new_len)
 {
-  register long new_cpc = mLast->mCapacity << 1, idx=0, idx2=0;
-  while(*(src+idx2) != '\0')
+  index_reset();
+  if(!new_len)
+    new_len = strlen(src);
+  else
   {
-    if(new_len != 0 && idx2 == new_len) break;
-
-    if(mLast->mLength+idx == mLast->mCapacity-1)
-    {
-      // Finish up old buffer
-      mLast->mLength = mLast->mCapacity-1;
-      *(mLast->mBuf+mLast->mLength) = '\0';
-
-      // Create a new buffer
-      ic_strbuffer *new_buf = new ic_strbuffer(new_cpc);
-      if(!new_buf) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
-      mNumBuffers++;
-      new_cpc <<= 1;
-      mLast->pNext = new_buf;
-      new_buf->pPrev = mLast;
-      mLast = new_buf;
-
-      // Reset buffer offset
-      idx=0;
-    }
-
-    *(mLast->mBuf+mLast->mLength+idx) = *(src+idx2);
-    idx++;
-    idx2++;
+    // appending stops at the terminating zero as it always did
+    const char *end = (const char *)memchr(src, '\0', new_len);
+    if(end) new_len = end - src;
   }
+  if(!new_len) return;
 
-  mLast->mLength += idx;
+  grow(new_len);
+  memcpy(mLast->mBuf+mLast->mLength, src, new_len);
+  mLast->mLength += new_len;
   *(mLast->mBuf+mLast->mLength) = '\0';
-  mLength += idx2;
+  mLength += new_len;
 }
 
 /**
@@ -294,12 +292,80 @@ void ic_string::append(const ic_string *src, long new_len)
 /**
  * Appends a character to the string.
  * @param src Character to append.
- * @todo Rewrite with optimization.
  */
 void ic_string::append(char src)
 {
-  char str[2] = {src, 0};
-  append(str, 1);
+  index_reset();
+  if(!src) return;
+
+  grow(1);
+  *(mLast->mBuf+mLast->mLength) = src;
+  mLast->mLength++;
+  *(mLast->mBuf+mLast->mLength) = '\0';
+  mLength++;
+}
+
+/**
+ * Appends the decimal representation of an integer.
+ * The number is printed right into the last buffer, no temporary is created.
+ * @param src Number to append.
+ */
+void ic_string::append_int(long src)
+{
+  index_reset();
+  grow(NUMBER_BUF_SIZE);
+  long len = sc_number::format_int(mLast->mBuf+mLast->mLength, src);
+  mLast->mLength += len;
+  mLength += len;
+}
+
+/**
+ * Appends the representation of a float, formatted as ic_float::to_s does.
+ * The number is printed right into the last buffer, no temporary is created.
+ * @param src Number to append.
+ */
+void ic_string::append_float(double src)
+{
+  index_reset();
+  grow(NUMBER_BUF_SIZE);
+  long len = sc_number::format_float(mLast->mBuf+mLast->mLength, src);
+  mLast->mLength += len;
+  mLength += len;
+}
+
+/**
+ * Makes sure the string can grow up to the given length without reallocating.
+ * The string is flattened, so a following get() does not copy anything.
+ * @param cpc Desired capacity.
+ */
+void ic_string::reserve(long cpc)
+{
+  get();
+  if(cpc > mLength)
+    grow(cpc - mLength);
+}
+
+/**
+ * Makes room for more characters at the end of the last buffer.
+ * The buffer capacity is at least doubled, so that a series of appends
+ * takes amortized linear time and the string stays flat.
+ * @param len Number of characters to make room for.
+ */
+void ic_string::grow(long len)
+{
+  long new_len = mLast->mLength + len;
+  if(new_len <= mLast->mCapacity) return;
+
+  register long new_cpc = mLast->mCapacity > STR_MIN_CPC ? mLast->mCapacity << 1 : STR_MIN_CPC;
+  while(new_cpc < new_len) new_cpc <<= 1;
+
+  char *buf = new char[new_cpc+1];
+  if(!buf) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  memcpy(buf, mLast->mBuf, mLast->mLength+1);
+  delete [] mLast->mBuf;
+  mLast->mBuf = buf;
+  mCapacity += new_cpc - mLast->mCapacity;
+  mLast->mCapacity = new_cpc;
 }
 
 /**
@@ -309,6 +375,7 @@ void ic_string::append(char src)
  */
 void ic_string::prepend(const char *str, long new_len)
 {
+  index_reset();
   if(!new_len) new_len = strlen(str);
   if(mFirst->mLength + new_len < mFirst->mCapacity)
   {
@@ -356,6 +423,7 @@ void ic_string::prepend(char src)
  */
 void ic_string::reverse()
 {
+  index_reset();
   register long first_char=0, last_char=mLast->mLength-1;
   ic_strbuffer *first_buf=mFirst, *last_buf=mLast;
   long half_len = mLength >> 1;
@@ -386,6 +454,35 @@ void ic_string::reverse()
   }
 }
 
+/**
+ * Reverses the order of UTF-8 characters in the string.
+ */
+void ic_string::reverse_chars()
+{
+  if(chars() == mLength)
+  {
+    reverse();
+    return;
+  }
+
+  // reverse bytes of every multibyte character first,
+  // so that they are restored by reversing the whole string
+  char *buf = get(), tmp;
+  for(long pos = 0; pos < mLength; )
+  {
+    long next = sc_utf8::next(buf, mLength, pos);
+    for(long left = pos, right = next - 1; left < right; left++, right--)
+    {
+      tmp = buf[left];
+      buf[left] = buf[right];
+      buf[right] = tmp;
+    }
+    pos = next;
+  }
+
+  reverse();
+}
+
 /**
  * Replaces substrings.
  * @param from String to search for.
@@ -395,6 +492,7 @@ void ic_string::reverse()
  */
 long ic_string::replace(const char *from, char *to, long max)
 {
+  index_reset();
   bool found_flag = false;
   long from_len = strlen(from), to_len = strlen(to);
   register long idx, count = 0;
@@ -524,9 +622,7 @@ long ic_string::replace(ic_string *from, ic_string *to, long max)
 long ic_string::replace(ic_regex *from, ic_string *to, long max)
 {
   register long idx;
-  long from_len = length(), to_len = to->length(), count=0, offset=0, to_offset, to_pos;
-  long bounds[2];
-  ic_match *found;
+  long from_len = length(), to_len = to->length(), count=0, offset=0, to_offset, to_pos, id;
   char *from_buf, *to_buf;
 
   // compile to-string into an array of anchors (string ends) and indexes (\\i)
@@ -550,17 +646,13 @@ long ic_string::replace(ic_regex *from, ic_string *to, long max)
   from_buf = base->get();
   empty();
 
-  // study regexp to make it faster
-  from->study();
   // process string in a loop
-  while(1)
+  ic_matchiter iter(from, from_buf, from_len);
+  const long *bounds = iter.captures();
+  while(iter.find())
   {
-    found = from->match(from_buf, offset, from_len);
-    if(!found) break;
-
     // append 'piece' (everything before match)
-    found->bounds(0, bounds);
-    if(offset != bounds[0])
+    if(offset < bounds[0])
       append(from_buf+offset, bounds[0]-offset);
 
     // append interpolated string
@@ -574,14 +666,17 @@ long ic_string::replace(ic_regex *from, ic_string *to, long max)
       // set offset to start of next string (\i = 2 bytes)
       to_offset = to_pos+2;
 
-      // append back reference
+      // append back reference (groups that do not exist or did not match are skipped)
       if(idx < indexes->mLength)
-        append(found->get(reinterpret_cast<intptr_t>(indexes->mPtr[idx])));
+      {
+        id = reinterpret_cast<intptr_t>(indexes->mPtr[idx]);
+        if(id < iter.count() && bounds[id*2+1] > bounds[id*2])
+          append(from_buf+bounds[id*2], bounds[id*2+1]-bounds[id*2]);
+      }
     }
 
     offset = bounds[1];
     count++;
-    delete found;
 
     if(count == max) break;
   }
@@ -595,6 +690,43 @@ long ic_string::replace(ic_regex *from, ic_string *to, long max)
   return count;
 }
 
+/**
+ * Replaces occurences of any string from a dictionary in a single pass.
+ * The leftmost occurence is replaced first, the longest one if several start there.
+ * @param from Dictionary of strings to search for.
+ * @param to Replacement for every string of the dictionary.
+ * @param max Maximum number of replaces (0 for any number).
+ * @return Number of occurences replaced.
+ */
+long ic_string::replace(sc_strset *from, ic_string **to, long max)
+{
+  long from_len = length(), count = 0, offset = 0, start, id;
+
+  // create source string and flush current one
+  ic_string *base = new ic_string(*this);
+  if(!base) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  char *from_buf = base->get();
+  empty();
+
+  while(offset < from_len && from->find(from_buf, from_len, offset, &start, &id))
+  {
+    if(offset < start)
+      append(from_buf+offset, start-offset);
+    append(to[id]);
+
+    offset = start + from->width(id);
+    count++;
+
+    if(count == max) break;
+  }
+
+  if(offset < from_len)
+    append(from_buf+offset, from_len-offset);
+
+  delete base;
+  return count;
+}
+
 /**
  * Translates characters in the string.
  * @param from Source characters.
@@ -602,6 +734,7 @@ long ic_string::replace(ic_regex *from, ic_string *to, long max)
  */
 void ic_string::translate(char *from, char *to, long fromlen, long tolen)
 {
+  index_reset();
   register long idx, idx2, buf_offset=0;
   ic_strbuffer *curr = mFirst;
   if(!fromlen) fromlen = strlen(from);
@@ -647,6 +780,10 @@ void ic_string::translate(ic_string *from, ic_string *to)
  */
 void ic_string::case_up()
 {
+  index_reset();
+#if MALCO_UNICODE == 1
+  sc_utf8::case_map(get(), mLength, 'u');
+#else
   register long idx, buf_offset=0;
   ic_strbuffer *curr = mFirst;
   for(idx=0; idx<mLength; idx++, buf_offset++)
@@ -660,6 +797,7 @@ void ic_string::case_up()
 
     *(curr->mBuf+buf_offset) = toupper(*(curr->mBuf+buf_offset));
   }
+#endif
 }
 
 /**
@@ -667,6 +805,10 @@ void ic_string::case_up()
  */
 void ic_string::case_down()
 {
+  index_reset();
+#if MALCO_UNICODE == 1
+  sc_utf8::case_map(get(), mLength, 'd');
+#else
   register long idx, buf_offset=0;
   ic_strbuffer *curr = mFirst;
   for(idx=0; idx<mLength; idx++, buf_offset++)
@@ -680,6 +822,7 @@ void ic_string::case_down()
 
     *(curr->mBuf+buf_offset) = tolower(*(curr->mBuf+buf_offset));
   }
+#endif
 }
 
 /**
@@ -687,6 +830,10 @@ void ic_string::case_down()
  */
 void ic_string::case_swap()
 {
+  index_reset();
+#if MALCO_UNICODE == 1
+  sc_utf8::case_map(get(), mLength, 's');
+#else
   register long idx, buf_offset=0;
   ic_strbuffer *curr = mFirst;
   for(idx=0; idx<mLength; idx++, buf_offset++)
@@ -704,6 +851,7 @@ void ic_string::case_swap()
     else
       *ch = toupper(*ch);
   }
+#endif
 }
 
 /**
@@ -756,14 +904,15 @@ int ic_string::compare(ic_string *str, long len)
   long str_len = MIN(mLength, str->length());
   long done_len = 0, cmp_len = 0, offset1 = 0, offset2 = 0;
   ic_strbuffer *buf1 = mFirst, *buf2 = str->mFirst;
+  if(len > 0 && len < str_len) str_len = len;
 
   while(done_len < str_len)
   {
     // attempt to compare minimum size of buffers
     cmp_len = MIN(buf1->mLength-offset1, buf2->mLength-offset2);
-    if(len > 0 && done_len + cmp_len > len) cmp_len = done_len - len;
-    int result = memcmp(buf1->mBuf, buf2->mBuf, cmp_len);
-    if(result != 0) return -result;
+    if(done_len + cmp_len > str_len) cmp_len = str_len - done_len;
+    int result = memcmp(buf1->mBuf+offset1, buf2->mBuf+offset2, cmp_len);
+    if(result != 0) return result > 0 ? -1 : 1;
 
     // wrap first buffer if needed
     if(offset1+cmp_len == buf1->mLength)
@@ -786,8 +935,10 @@ int ic_string::compare(ic_string *str, long len)
     done_len += cmp_len;
   }
 
-  if(mLength < str->length()) return -1;
-  if(mLength > str->length()) return 1;
+  // equal prefixes: the shorter string is the smaller one
+  if(len > 0 && mLength >= len && str->length() >= len) return 0;
+  if(mLength < str->length()) return 1;
+  if(mLength > str->length()) return -1;
 
   return 0;
 }
@@ -847,6 +998,126 @@ ic_string* ic_string::substr_get(long start, long len)
   return str;
 }
 
+/**
+ * Returns a substring, counting positions in UTF-8 characters.
+ * @param start The character to start from (negative counts from the end).
+ * @param len The number of characters (0 for the rest of the string).
+ * @return Resulting substring.
+ */
+ic_string *ic_string::substr_chars(long start, long len)
+{
+  long count = chars();
+  if(start < 0) start += count;
+  if(len == 0) len = count - start;
+
+  // test for idiotic cases
+  if(start < 0) start = 0;
+  if(start + len > count) len = count - start;
+
+  long from = char_offset(start), to = char_offset(start + len);
+  if(len <= 0 || to <= from)
+    return new ic_string();
+
+  return substr_get(from, to - from);
+}
+
+/**
+ * Returns the number of UTF-8 characters in the string.
+ * The count and the character index are cached until the string is modified.
+ * @return Number of characters.
+ */
+long ic_string::chars()
+{
+  if(mChars < 0 || mIndexLength != mLength)
+    index();
+
+  return mChars;
+}
+
+/**
+ * Returns the byte offset of a character.
+ * Takes at most STR_INDEX_STEP steps from the nearest indexed character.
+ * @param pos Character position.
+ * @return Byte offset (string length if pos is out of bounds).
+ */
+long ic_string::char_offset(long pos)
+{
+  long count = chars();
+  if(pos <= 0) return 0;
+  if(pos >= count) return mLength;
+
+  // pure ASCII strings have no index
+  if(!mIndex) return pos;
+
+  char *buf = get();
+  long offset = mIndex[pos / STR_INDEX_STEP];
+  for(long idx = pos % STR_INDEX_STEP; idx > 0; idx--)
+    offset = sc_utf8::next(buf, mLength, offset);
+
+  return offset;
+}
+
+/**
+ * Returns the code point of a character.
+ * @param pos Character position.
+ * @return Code point (0 if pos is out of bounds).
+ */
+long ic_string::char_code(long pos)
+{
+  long offset = char_offset(pos), code = 0;
+  if(pos < 0 || offset >= mLength) return 0;
+
+  sc_utf8::decode(get() + offset, mLength - offset, &code);
+  return code;
+}
+
+/**
+ * Checks whether the string is well-formed UTF-8.
+ * @return true if the string is valid.
+ */
+bool ic_string::is_utf8()
+{
+  return sc_utf8::validate(get(), mLength);
+}
+
+/**
+ * Builds the character count and the sparse character index.
+ */
+void ic_string::index()
+{
+  index_reset();
+  char *buf = get();
+  mChars = sc_utf8::length(buf, mLength);
+  mIndexLength = mLength;
+
+  // character positions equal byte offsets, nothing to index
+  if(mChars == mLength) return;
+
+  mIndex = new long[mChars / STR_INDEX_STEP + 1];
+  if(!mIndex) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  long offset = 0;
+  for(long idx = 0; idx < mChars; idx++)
+  {
+    if(idx % STR_INDEX_STEP == 0)
+      mIndex[idx / STR_INDEX_STEP] = offset;
+    offset = sc_utf8::next(buf, mLength, offset);
+  }
+}
+
+/**
+ * Drops the cached character index. Is called by every modifying method.
+ */
+inline void ic_string::index_reset()
+{
+  if(mIndex)
+  {
+    delete [] mIndex;
+    mIndex = NULL;
+  }
+  mChars = -1;
+}
+
 /**
  * Replaces a substring.
  * @param start The position in the string to start from.
@@ -855,6 +1126,7 @@ ic_string* ic_string::substr_get(long start, long len)
  */
 void ic_string::substr_set(long start, long len, const char *to)
 {
+  index_reset();
   long to_len = strlen(to), to_offset = 0;
   ic_strbuffer *curr = mFirst;
   register long idx, buf_offset=start;
@@ -898,9 +1170,9 @@ void ic_string::substr_set(long start, long len, const char *to)
     get();
     char *new_buf = new char[new_cpc+1];
     if(!new_buf) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
-    strncpy(new_buf, mFirst->mBuf, start);
-    strcpy(new_buf+start, to);
-    strncpy(new_buf+start+to_len, mFirst->mBuf+start+len, mLength-len);
+    memcpy(new_buf, mFirst->mBuf, start);
+    memcpy(new_buf+start, to, to_len);
+    memcpy(new_buf+start+to_len, mFirst->mBuf+start+len, mLength-start-len);
     *(new_buf+new_len) = '\0';
     delete [] mFirst->mBuf;
     mFirst->mBuf = new_buf;
@@ -1115,6 +1387,7 @@ long ic_string::substr_count(ic_string *str) const
  */
 void ic_string::ltrim()
 {
+  index_reset();
   ic_strbuffer *curr = mFirst, *new_buf;
   register long idx, buf_offset = 0;
   long tmp_len = mLength, new_len, new_cpc = STR_MIN_CPC;
@@ -1165,6 +1438,7 @@ void ic_string::ltrim()
  */
 void ic_string::rtrim()
 {
+  index_reset();
   ic_strbuffer *curr = mLast;
   long tmp_len = mLength;
   register long idx, buf_offset = mLast->mLength;
@@ -1307,21 +1581,19 @@ sc_voidarray *ic_string::split(ic_string *delimiter, long max)
 sc_voidarray *ic_string::split(ic_regex *delimiter, long max)
 {
   long offset=0, count=0;
-  long bounds[2];
   ic_string *new_str;
-  ic_match *found;
   sc_voidlist items;
 
   get();
 
-  // study regexp to make it faster
-  delimiter->study();
-  while(1)
+  ic_matchiter iter(delimiter, mFirst->mBuf, mLength);
+  const long *bounds = iter.captures();
+  while(iter.find())
   {
-    found = delimiter->match(mFirst->mBuf, offset);
-    if(found == 0) break;
+    // an empty delimiter cannot split at the start of a piece or at the end of the string
+    if(bounds[0] == bounds[1] && (bounds[0] == offset || bounds[0] >= mLength))
+      continue;
 
-    found->bounds(0, bounds);
     if(bounds[0] > offset)
       new_str = new ic_string(mFirst->mBuf+offset, bounds[0]-offset);
     else
@@ -1332,7 +1604,6 @@ sc_voidarray *ic_string::split(ic_regex *delimiter, long max)
     offset = bounds[1];
 
     count++;
-    delete found;
     if(count == max) break;
   }
 
@@ -1356,6 +1627,7 @@ sc_voidarray *ic_string::split(ic_regex *delimiter, long max)
  */
 void ic_string::format(sc_voidarray strings)
 {
+  index_reset();
   long idx, bufidx = 0, stridx = 0, new_cpc = mLength;
   sc_voidarray lengths;
 
@@ -1429,6 +1701,7 @@ ic_string *ic_string::format_list(const char *str, va_list args)
   ic_string *newstr = new ic_string(str);
   ic_int *num = new ic_int();
   ic_float *fl = new ic_float();
+  const char *value;
   long pos = 0;
   bool todo;
 
@@ -1440,24 +1713,29 @@ ic_string *ic_string::format_list(const char *str, va_list args)
     pos = newstr->substr_first("%", pos);
     if(pos != -1)
     {
+      value = NULL;
+
       // found a string
       if(newstr->char_at(pos+1) == 's')
-      {
-        newstr->substr_set(pos, 2, va_arg(args, const char*));
-        todo = true;
-      }
+        value = va_arg(args, const char*);
       // found an integer
       else if(newstr->char_at(pos+1) == 'i')
       {
         num->mValue = va_arg(args, long);
-        newstr->substr_set(pos, 2, num->to_s());
-        todo = true;
+        value = num->to_s();
       }
       // found a float
       else if(newstr->char_at(pos+1) == 'f')
       {
         fl->mValue = va_arg(args, double);
-        newstr->substr_set(pos, 2, fl->to_s());
+        value = fl->to_s();
+      }
+
+      // the inserted value is not scanned: it may contain a % itself
+      if(value)
+      {
+        newstr->substr_set(pos, 2, value);
+        pos += strlen(value);
         todo = true;
       }
     }
@@ -1475,6 +1753,7 @@ ic_string *ic_string::format_list(const char *str, va_list args)
  */
 void ic_string::file_load(const char *name)
 {
+  index_reset();
   register long new_cpc = STR_MIN_CPC;
   FILE *f = fopen(name, "rb");
   if(f)
@@ -1528,8 +1807,7 @@ void ic_string::file_save(const char *name, char mode)
  */
 inline long ic_string::to_i()
 {
-  if(this->mLength <= 16) return atol(get());
-  else return 0;
+  return sc_number::parse_int(get(), mLength);
 }
 
 /**
@@ -1538,8 +1816,7 @@ inline long ic_string::to_i()
  */
 inline double ic_string::to_f()
 {
-  if(this->mLength <= 16) return atof(get());
-  else return 0;
+  return sc_number::parse_float(get(), mLength);
 }
 
 /**
@@ -0,0 +1,242 @@
+/**
+ * @file ic_thread.h
+ * @author impworks.
+ * ic_thread header.
+ * Defines properties and methods of ic_thread class.
+ */
+
+#ifndef IC_THREAD_H
+#define IC_THREAD_H
+
+/**
+ * ic_thread constructor.
+ */
+ic_thread::ic_thread()
+{
+  mHead = NULL;
+  pCore = NULL;
+  pMethod = NULL;
+  mResult = NULL;
+  mFailed = false;
+  mRunning = false;
+
+  mInbox = new sc_queue();
+  mOutbox = new sc_queue();
+  if(!mInbox || !mOutbox) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+}
+
+/**
+ * ic_thread destructor.
+ * The result and messages are unlinked by rc_head, see drain().
+ */
+ic_thread::~ic_thread()
+{
+  join();
+  if(pCore)
+    pCore->thread_remove(this);
+
+  delete mInbox;
+  delete mOutbox;
+}
+
+/**
+ * Starts running the method in a new thread.
+ * Arguments left in the parent head's accumulator are copied for the thread.
+ * @param parent Head that starts the thread.
+ * @param method Method to be run.
+ */
+void ic_thread::start(rc_head *parent, rc_method *method)
+{
+  parent->pCore->image_seal();
+
+  mHead = new rc_head(parent->pCore);
+  if(!mHead) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  mHead->pThread = this;
+
+  while(parent->rSRC.mLength)
+  {
+    rc_var *arg = parent->rSRC.pop();
+    mHead->rSRC.push(parent->obj_copy(arg));
+    parent->obj_unlink(arg);
+  }
+
+  pCore = parent->pCore;
+  pMethod = method;
+  mRunning = true;
+
+  // the OS thread is detached: join() waits for mRunning, and the core
+  // waits for every thread still running before it shuts down
+  pCore->thread_add(this);
+  std::thread(&ic_thread::run, this).detach();
+}
+
+/**
+ * Waits for the thread to finish.
+ */
+void ic_thread::join()
+{
+  std::unique_lock<std::mutex> lock(mLock);
+  mSignal.wait(lock, [this] { return !mRunning; });
+}
+
+/**
+ * Checks whether the method is still running.
+ */
+inline bool ic_thread::alive()
+{
+  return mRunning;
+}
+
+/**
+ * Sends a message to the thread.
+ * @param msg Message copied by the sending head.
+ */
+void ic_thread::send(rc_var *msg)
+{
+  std::lock_guard<std::mutex> lock(mLock);
+  mInbox->push(msg);
+  mSignal.notify_all();
+}
+
+/**
+ * Waits for a message from the thread.
+ * @return Message or NULL if the thread has finished without sending one.
+ */
+rc_var *ic_thread::receive()
+{
+  std::unique_lock<std::mutex> lock(mLock);
+  mSignal.wait(lock, [this] { return mOutbox->mLength || !mRunning; });
+
+  return mOutbox->mLength ? mOutbox->pop() : NULL;
+}
+
+/**
+ * Sends a message from the thread to the head that started it.
+ * @param msg Message copied by the thread's head.
+ */
+void ic_thread::reply(rc_var *msg)
+{
+  std::lock_guard<std::mutex> lock(mLock);
+  mOutbox->push(msg);
+  mSignal.notify_all();
+}
+
+/**
+ * Waits for a message sent to the thread.
+ * Is called by the thread's own head.
+ * @return Message or NULL if the main head has finished and no message will come.
+ */
+rc_var *ic_thread::listen()
+{
+  std::unique_lock<std::mutex> lock(mLock);
+  mSignal.wait(lock, [this] { return mInbox->mLength > 0 || pCore->mClosing; });
+
+  return mInbox->mLength ? mInbox->pop() : NULL;
+}
+
+/**
+ * Wakes up the thread if it is waiting in listen().
+ * Is called by the core when the main head has finished.
+ */
+void ic_thread::wake()
+{
+  std::lock_guard<std::mutex> lock(mLock);
+  mSignal.notify_all();
+}
+
+/**
+ * Takes any message left in the mailboxes.
+ * @return Message or NULL if there are none.
+ */
+rc_var *ic_thread::drain()
+{
+  std::lock_guard<std::mutex> lock(mLock);
+  if(mInbox->mLength) return mInbox->pop();
+  if(mOutbox->mLength) return mOutbox->pop();
+
+  return NULL;
+}
+
+/**
+ * ic_thread -> boolean convertor.
+ * @return bool
+ */
+inline bool ic_thread::to_b()
+{
+  return mRunning;
+}
+
+/**
+ * ic_thread -> string convertor.
+ * @return char*
+ */
+inline const char *ic_thread::to_s()
+{
+  return "Thread";
+}
+
+/**
+ * Thread body: runs the method and keeps a copy of what it returns.
+ * The head is deleted here, so that everything it holds is released
+ * by the thread that has created it.
+ */
+void ic_thread::run()
+{
+  rc_cmd cmd;
+  cmd.mCmd = RASM_CMD_CALL;
+  cmd.mModifier = 0;
+  cmd.mParam.addr = 0;
+
+  mHead->pCmd = &cmd;
+  mHead->pCurrClass = mHead->pTmpClass = mHead->pCore->mClassCache.pObject;
+  mHead->pCurrObj = NULL;
+
+  try
+  {
+    mHead->method_invoke(pMethod);
+
+    rc_var *res;
+    if(mHead->mState == M_STATE_DEAD)
+    {
+      res = mHead->rAX;
+      mHead->rAX = NULL;
+      mFailed = true;
+    }
+    else
+      res = mHead->rSRC.mLength ? mHead->rSRC.pop() : mHead->new_undef();
+
+    mResult = mHead->obj_copy(res);
+    mHead->obj_unlink(res);
+
+    // the result could not be copied
+    if(!mFailed && mHead->mState == M_STATE_DEAD)
+    {
+      mHead->obj_unlink(mResult);
+      mResult = mHead->obj_copy(mHead->rAX);
+      mFailed = true;
+    }
+  }
+  catch(const sc_exception &ex)
+  {
+    // internal errors stop the thread only
+    rc_var *exc = mHead->new_exception(ex.mErrorMsg->get(), M_EXC_INTERNAL);
+    mResult = mHead->obj_copy(exc);
+    mHead->obj_unlink(exc);
+    mFailed = true;
+  }
+
+  delete mHead;
+  mHead = NULL;
+  sc_regexcache::clear();
+
+  // the object may be deleted as soon as mRunning is cleared
+  rc_core *core = pCore;
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+    mRunning = false;
+    mSignal.notify_all();
+  }
+  core->thread_done();
+}
+
+#endif
@@ -0,0 +1,35 @@
+/**
+ * @file rc_class.h
+ * @author impworks.
+ * rc_class header.
+ * Defines properties and methods of rc_class class.
+ */
+
+#ifndef RC_CLASS_H
+#define RC_CLASS_H
+
+/**
+ * Assignment operator.
+ * The copy has no objects of it's own yet, so the counter is not copied.
+ * @param right Class to be copied.
+ */
+rc_class &rc_class::operator=(const rc_class &right)
+{
+  if(this == &right) return *this;
+
+  mName = right.mName;
+  mFullName = right.mFullName;
+  pParent = right.pParent;
+  pRoot = right.pRoot;
+  mProperties = right.mProperties;
+
+  mClasses = right.mClasses;
+  mMethods = right.mMethods;
+  mMembers = right.mMembers;
+  mStaticMembers = right.mStaticMembers;
+  mDataType = right.mDataType;
+
+  return *this;
+}
+
+#endif
@@ -26,6 +26,16 @@ rc_core::rc_core()
   mTape = NULL;
 
   mPlugins = NULL;
+  mSealed = false;
+  mPool = NULL;
+  mPoolSize = 0;
+  mReactor = NULL;
+  mAio = NULL;
+  mAioUring = true;
+  mAioWorkers = 0;
+  mMainThread = std::this_thread::get_id();
+  mThreadsRunning = 0;
+  mClosing = false;
 
   mStrTable = NULL;
 
@@ -38,6 +48,11 @@ rc_core::rc_core()
  */
 rc_core::~rc_core()
 {
+  threads_wait();
+
+  delete mPool;
+  delete mAio;
+  delete mReactor;
   delete mSetup;
   delete mParser;
   delete mCompiler;
@@ -49,6 +64,8 @@ rc_core::~rc_core()
   delete mStrTable;
 
   delete mPlugins;
+
+  sc_regexcache::clear();
 }
 
 /**
@@ -75,6 +92,17 @@ void rc_core::init()
       throw;
   }
 
+  // compiled regex cache limits
+  sc_regexcache::setup(setup_int("cache_size", "regex", REGEXCACHE_MAX_ITEMS),
+                       setup_int("cache_memory", "regex", REGEXCACHE_MAX_MEMORY));
+
+  // parallel methods
+  mPoolSize = setup_int("pool_size", "thread", 0);
+
+  // asynchronous file operations
+  mAioUring = setup_int("uring", "file", 1) != 0;
+  mAioWorkers = setup_int("workers", "file", 0);
+
   mFile = new ic_string();
   mSource = new ic_string();
   mTape = new rc_tape();
@@ -87,6 +115,24 @@ void rc_core::init()
   sc_random::seed(time(NULL));
 }
 
+/**
+ * Reads an integer setting from the configuration.
+ * @param name Setting name.
+ * @param section Section name.
+ * @param def Value to be used if the setting is missing.
+ * @return Setting value.
+ */
+long rc_core::setup_int(const char *name, const char *section, long def)
+{
+  if(!mSetup) return def;
+
+  ic_string *value = mSetup->get_value(name, section);
+  long result = value->length() ? value->to_i() : def;
+  delete value;
+
+  return result;
+}
+
 /**
  * Processes specified Malco task.
  * @param argc Count of arguments.
@@ -116,6 +162,8 @@ int rc_core::process(int argc, char *argv[])
         case M_TASK_RUN:      return task_run(argv[2]);
         case M_TASK_RUN_BC:   return task_run_bc(argv[2]);
         case M_TASK_EVAL:     return task_eval(argv[2]);
+        case M_TASK_SERVE:    return task_serve(argv[2]);
+        case M_TASK_FCGI:     return task_fcgi(argv[2]);
       }
     }
   }
@@ -137,6 +185,7 @@ void rc_core::equip()
   method_add("freeze!", mClassCache.pObject, object_freeze_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("frozen", mClassCache.pObject, object_frozen, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("id", mClassCache.pObject, object_id, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("#hash", mClassCache.pObject, object_op_hash, M_PROP_PUBLIC)->setup(0);
   method_add("exec", mClassCache.pObject, object_exec, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "name");
   method_add("assert", mClassCache.pObject, object_assert, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, true, "names");
   method_add("class", mClassCache.pObject, object_class, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
@@ -207,8 +256,8 @@ void rc_core::equip()
   method_add("#band_int", mClassCache.pInt, int_op_band_int, M_PROP_PUBLIC | M_PROP_FINAL)->op();
   method_add("#bor_int", mClassCache.pInt, int_op_bor_int, M_PROP_PUBLIC | M_PROP_FINAL)->op();
   method_add("#bxor_int", mClassCache.pInt, int_op_bxor_int, M_PROP_PUBLIC | M_PROP_FINAL)->op();
-  method_add("#inc", mClassCache.pInt, int_op_inc, M_PROP_PUBLIC | M_PROP_FINAL)->op();
-  method_add("#dec", mClassCache.pInt, int_op_dec, M_PROP_PUBLIC | M_PROP_FINAL)->op();
+  method_add("#inc", mClassCache.pInt, int_op_inc, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("#dec", mClassCache.pInt, int_op_dec, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("#cmp_int", mClassCache.pInt, int_op_cmp_int, M_PROP_PUBLIC | M_PROP_FINAL)->op();
   method_add("#cmp_bool", mClassCache.pInt, int_op_cmp_bool, M_PROP_PUBLIC | M_PROP_FINAL)->op();
   method_add("#cmp_float", mClassCache.pInt, int_op_cmp_float, M_PROP_PUBLIC | M_PROP_FINAL)->op();
@@ -238,8 +287,8 @@ void rc_core::equip()
   method_add("#div_float", mClassCache.pFloat, float_op_div_float, M_PROP_PUBLIC | M_PROP_FINAL)->op();
   method_add("#pow_int", mClassCache.pFloat, float_op_pow_int, M_PROP_PUBLIC | M_PROP_FINAL)->op();
   method_add("#pow_float", mClassCache.pFloat, float_op_pow_float, M_PROP_PUBLIC | M_PROP_FINAL)->op();
-  method_add("#inc", mClassCache.pFloat, float_op_inc, M_PROP_PUBLIC | M_PROP_FINAL)->op();
-  method_add("#dec", mClassCache.pFloat, float_op_dec, M_PROP_PUBLIC | M_PROP_FINAL)->op();
+  method_add("#inc", mClassCache.pFloat, float_op_inc, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("#dec", mClassCache.pFloat, float_op_dec, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("#cmp_int", mClassCache.pFloat, float_op_cmp_int, M_PROP_PUBLIC | M_PROP_FINAL)->op();
   method_add("#cmp_float", mClassCache.pFloat, float_op_cmp_float, M_PROP_PUBLIC | M_PROP_FINAL)->op();
   method_add("#cmp_string", mClassCache.pFloat, float_op_cmp_string, M_PROP_PUBLIC | M_PROP_FINAL)->op();
@@ -275,6 +324,8 @@ void rc_core::equip()
   method_add("#rel_regex", mClassCache.pString, string_op_rel_regex, M_PROP_PUBLIC | M_PROP_FINAL)->op();
   method_add("inspect", mClassCache.pString, string_inspect, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("length", mClassCache.pString, string_length, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("capacity", mClassCache.pString, string_capacity, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("reserve!", mClassCache.pString, string_reserve_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "cpc");
   method_add("trim", mClassCache.pString, string_trim, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("trim_left", mClassCache.pString, string_trim_left, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("trim_right", mClassCache.pString, string_trim_right, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
@@ -295,6 +346,7 @@ void rc_core::equip()
   method_add("prepend!", mClassCache.pString, string_prepend_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "str");
   method_add("replace!", mClassCache.pString, string_replace_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(2, 3, false, "from", "to", "max");
   method_add("split", mClassCache.pString, string_split, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 2, false, "by", "max");
+  method_add("scan", mClassCache.pString, string_scan, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 2, false, "regex", "fx");
   method_add("apply", mClassCache.pString, string_apply, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 2, false, "range", "fx");
   method_add("apply!", mClassCache.pString, string_apply_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "fx");
   method_add("insert", mClassCache.pString, string_insert, M_PROP_PUBLIC | M_PROP_FINAL)->setup(2, 2, false, "str", "offset");
@@ -326,7 +378,11 @@ void rc_core::equip()
   method_add("inspect", mClassCache.pRange, range_inspect, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("set!", mClassCache.pRange, range_set_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 2, false, "start", "end");
   method_add("has", mClassCache.pRange, range_has, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "num");
-  method_add("each", mClassCache.pRange, range_each, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "fx");
+  method_add("each", mClassCache.pRange, range_each, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0, 1, false, "fx");
+  method_add("lazy", mClassCache.pRange, range_lazy, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("parallel_each", mClassCache.pRange, range_parallel_each, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "fx");
+  method_add("parallel_map", mClassCache.pRange, range_parallel_map, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "fx");
+  method_add("parallel_select", mClassCache.pRange, range_parallel_select, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "fx");
   method_add("length", mClassCache.pRange, range_length, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("next", mClassCache.pRange, range_next, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("rewind", mClassCache.pRange, range_next, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
@@ -344,7 +400,9 @@ void rc_core::equip()
   method_add("#cmp_string", mClassCache.pRegex, regex_op_cmp_string, M_PROP_PUBLIC | M_PROP_FINAL)->op();
   method_add("inspect", mClassCache.pRegex, regex_inspect, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("match", mClassCache.pRegex, regex_match, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "str");
+  method_add("each_match", mClassCache.pRegex, regex_each_match, M_PROP_PUBLIC | M_PROP_FINAL)->setup(2, 2, false, "str", "fx");
   method_add("study", mClassCache.pRegex, regex_study, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("cache", mClassCache.pRegex, regex_cache, M_PROP_STATIC | M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("to_b", mClassCache.pRegex, regex_to_b, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("to_s", mClassCache.pRegex, regex_to_s, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
 
@@ -358,6 +416,15 @@ void rc_core::equip()
   method_add("bounds", mClassCache.pMatch, match_bounds, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "id");
   method_add("get", mClassCache.pMatch, match_get, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "id");
 
+  // regex_set
+  mClassCache.pRegexSet = class_create("regex_set");
+  method_add("#create", mClassCache.pRegexSet, regexset_op_create, M_PROP_PUBLIC | M_PROP_FINAL)->op();
+  method_add("add!", mClassCache.pRegexSet, regexset_add_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "regex");
+  method_add("count", mClassCache.pRegexSet, regexset_count, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("inspect", mClassCache.pRegexSet, regexset_inspect, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("match", mClassCache.pRegexSet, regexset_match, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "str");
+  method_add("to_b", mClassCache.pRegexSet, regexset_to_b, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+
   // time
   mClassCache.pTime = class_create("time");
   method_add("#create", mClassCache.pTime, time_op_create, M_PROP_PUBLIC | M_PROP_FINAL)->op();
@@ -367,8 +434,8 @@ void rc_core::equip()
   method_add("#sub_time", mClassCache.pTime, time_op_sub_time, M_PROP_PUBLIC | M_PROP_FINAL)->op();
   method_add("#mul_int", mClassCache.pTime, time_op_mul_int, M_PROP_PUBLIC | M_PROP_FINAL)->op();
   method_add("#div_int", mClassCache.pTime, time_op_div_int, M_PROP_PUBLIC | M_PROP_FINAL)->op();
-  method_add("#inc", mClassCache.pTime, time_op_inc, M_PROP_PUBLIC | M_PROP_FINAL)->op();
-  method_add("#dec", mClassCache.pTime, time_op_dec, M_PROP_PUBLIC | M_PROP_FINAL)->op();
+  method_add("#inc", mClassCache.pTime, time_op_inc, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("#dec", mClassCache.pTime, time_op_dec, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("#cmp_time", mClassCache.pTime, time_op_cmp_time, M_PROP_PUBLIC | M_PROP_FINAL)->op();
   method_add("#cmp_int", mClassCache.pTime, time_op_cmp_time, M_PROP_PUBLIC | M_PROP_FINAL)->op();
   method_add("#cmp_bool", mClassCache.pTime, time_op_cmp_time, M_PROP_PUBLIC | M_PROP_FINAL)->op();
@@ -414,21 +481,23 @@ void rc_core::equip()
   method_add("next_pair", mClassCache.pArray, array_next_pair, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("rewind", mClassCache.pArray, array_rewind, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("find", mClassCache.pArray, array_find, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "obj");
-  method_add("sort", mClassCache.pArray, array_sort, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "order");
-  method_add("sort!", mClassCache.pArray, array_sort_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "order");
-  method_add("sort_by", mClassCache.pArray, array_sort_by, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 2, false, "order", "fx");
-  method_add("sort_by!", mClassCache.pArray, array_sort_by_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 2, false, "order", "fx");
+  method_add("flip", mClassCache.pArray, array_flip, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("sort", mClassCache.pArray, array_sort, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0, 1, false, "order");
+  method_add("sort!", mClassCache.pArray, array_sort_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0, 1, false, "order");
+  method_add("sort_by", mClassCache.pArray, array_sort_by, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 2, false, "fx", "order");
+  method_add("sort_by!", mClassCache.pArray, array_sort_by_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 2, false, "fx", "order");
   method_add("shuffle!", mClassCache.pArray, array_shuffle_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("shuffle", mClassCache.pArray, array_shuffle, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("map!", mClassCache.pArray, array_map_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 2, false, "array", "mode");
   method_add("sum", mClassCache.pArray, array_sum, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("mult", mClassCache.pArray, array_mul, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("dot", mClassCache.pArray, array_dot, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "arr");
   method_add("join", mClassCache.pArray, array_join, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0, 1, false, "spacer");
   method_add("push!", mClassCache.pArray, array_push_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, true, "objects");
-  method_add("pop!", mClassCache.pArray, array_pop_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0, 1, "count");
+  method_add("pop!", mClassCache.pArray, array_pop_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0, 1, false, "count");
   method_add("reindex", mClassCache.pArray, array_reindex, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
-  method_add("sort_shell", mClassCache.pArray, array_sort_shell, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
-  method_add("sort_quick", mClassCache.pArray, array_sort_quick, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("sort_shell", mClassCache.pArray, array_sort, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0, 1, false, "order");
+  method_add("sort_quick", mClassCache.pArray, array_sort, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0, 1, false, "order");
   method_add("flatten", mClassCache.pArray, array_flatten, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("inflate", mClassCache.pArray, array_inflate, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("unique", mClassCache.pArray, array_unique, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
@@ -436,10 +505,11 @@ void rc_core::equip()
   method_add("reject", mClassCache.pArray, array_reject, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "fx");
   method_add("collect", mClassCache.pArray, array_collect, M_PROP_PUBLIC | M_PROP_FINAL)->setup(2, 2, false, "start", "fx");
   method_add("reindex!", mClassCache.pArray, array_reindex_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
-  method_add("sort_shell!", mClassCache.pArray, array_sort_shell_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
-  method_add("sort_quick!", mClassCache.pArray, array_sort_quick_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("sort_shell!", mClassCache.pArray, array_sort_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0, 1, false, "order");
+  method_add("sort_quick!", mClassCache.pArray, array_sort_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0, 1, false, "order");
   method_add("flatten!", mClassCache.pArray, array_flatten_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("inflate!", mClassCache.pArray, array_inflate_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("flip!", mClassCache.pArray, array_flip_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("unique!", mClassCache.pArray, array_unique_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("select!", mClassCache.pArray, array_select_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "fx");
   method_add("reject!", mClassCache.pArray, array_reject_do, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "fx");
@@ -453,6 +523,115 @@ void rc_core::equip()
   method_add("to_b", mClassCache.pArray, array_to_b, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("to_i", mClassCache.pArray, array_to_i, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
   method_add("to_s", mClassCache.pArray, array_to_s, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("lazy", mClassCache.pArray, array_lazy, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("parallel_each", mClassCache.pArray, array_parallel_each, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "fx");
+  method_add("parallel_map", mClassCache.pArray, array_parallel_map, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "fx");
+  method_add("parallel_select", mClassCache.pArray, array_parallel_select, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "fx");
+
+  // lazy
+  mClassCache.pLazy = class_create("lazy");
+  method_add("#create", mClassCache.pLazy, lazy_op_create, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "source");
+  method_add("count", mClassCache.pLazy, lazy_count, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("each", mClassCache.pLazy, lazy_each, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "fx");
+  method_add("first", mClassCache.pLazy, lazy_first, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("inspect", mClassCache.pLazy, lazy_inspect, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("map", mClassCache.pLazy, lazy_map, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "fx");
+  method_add("reject", mClassCache.pLazy, lazy_reject, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "fx");
+  method_add("select", mClassCache.pLazy, lazy_select, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "fx");
+  method_add("sum", mClassCache.pLazy, lazy_sum, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("take", mClassCache.pLazy, lazy_take, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "count");
+  method_add("to_a", mClassCache.pLazy, lazy_to_a, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("to_b", mClassCache.pLazy, lazy_to_b, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("to_s", mClassCache.pLazy, lazy_to_s, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("zip", mClassCache.pLazy, lazy_zip, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "other");
+
+  // thread
+  mClassCache.pThread = class_create("thread");
+  method_add("#create", mClassCache.pThread, thread_op_create, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, true, "fx");
+  method_add("alive", mClassCache.pThread, thread_alive, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("cores", mClassCache.pThread, thread_cores, M_PROP_STATIC | M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("join", mClassCache.pThread, thread_join, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("listen", mClassCache.pThread, thread_listen, M_PROP_STATIC | M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("receive", mClassCache.pThread, thread_receive, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("reply", mClassCache.pThread, thread_reply, M_PROP_STATIC | M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "msg");
+  method_add("send", mClassCache.pThread, thread_send, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "msg");
+  method_add("to_b", mClassCache.pThread, thread_to_b, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("to_s", mClassCache.pThread, thread_to_s, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+
+  // generator
+  mClassCache.pGenerator = class_create("generator");
+  method_add("#create", mClassCache.pGenerator, generator_op_create, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, true, "fx");
+  method_add("each", mClassCache.pGenerator, generator_each, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "fx");
+  method_add("next", mClassCache.pGenerator, generator_next, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("take", mClassCache.pGenerator, generator_take, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "count");
+  method_add("to_a", mClassCache.pGenerator, generator_to_a, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("to_b", mClassCache.pGenerator, generator_to_b, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("to_s", mClassCache.pGenerator, generator_to_s, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+
+  // file
+  mClassCache.pFile = class_create("file");
+  method_add("#create", mClassCache.pFile, file_op_create, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "name");
+  method_add("close", mClassCache.pFile, file_close, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("copy", mClassCache.pFile, file_copy, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "name");
+  method_add("each_line", mClassCache.pFile, file_each_line, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "fx");
+  method_add("exists", mClassCache.pFile, file_exists, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("inspect", mClassCache.pFile, file_inspect, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("length", mClassCache.pFile, file_length, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("loop", mClassCache.pFile, file_loop, M_PROP_STATIC | M_PROP_PUBLIC | M_PROP_FINAL)->setup(0, 1, false, "timeout");
+  method_add("open", mClassCache.pFile, file_open, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0, 1, false, "mode");
+  method_add("read", mClassCache.pFile, file_read, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "size");
+  method_add("read_all", mClassCache.pFile, file_read_all, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("read_async", mClassCache.pFile, file_read_async, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "fx");
+  method_add("read_line", mClassCache.pFile, file_read_line, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("read_lines", mClassCache.pFile, file_read_lines, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("read_many", mClassCache.pFile, file_read_many, M_PROP_STATIC | M_PROP_PUBLIC | M_PROP_FINAL)->setup(2, 2, false, "names", "fx");
+  method_add("remove", mClassCache.pFile, file_remove, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("rename", mClassCache.pFile, file_rename, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "name");
+  method_add("seek", mClassCache.pFile, file_seek, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 2, false, "pos", "from");
+  method_add("tell", mClassCache.pFile, file_tell, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("to_b", mClassCache.pFile, file_to_b, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("to_i", mClassCache.pFile, file_to_i, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("to_s", mClassCache.pFile, file_to_s, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("write", mClassCache.pFile, file_write, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "data");
+  method_add("write_async", mClassCache.pFile, file_write_async, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 2, false, "data", "fx");
+
+  // dir
+  mClassCache.pDir = class_create("dir");
+  method_add("#create", mClassCache.pDir, dir_op_create, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "name");
+  method_add("content", mClassCache.pDir, dir_content, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("copy", mClassCache.pDir, dir_copy, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "name");
+  method_add("create", mClassCache.pDir, dir_create, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("dirs", mClassCache.pDir, dir_dirs, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("exists", mClassCache.pDir, dir_exists, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("files", mClassCache.pDir, dir_files, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("inspect", mClassCache.pDir, dir_inspect, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("remove", mClassCache.pDir, dir_remove, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0, 1, false, "really");
+  method_add("rename", mClassCache.pDir, dir_rename, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "name");
+  method_add("to_b", mClassCache.pDir, dir_to_b, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("to_f", mClassCache.pDir, dir_to_f, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("to_i", mClassCache.pDir, dir_to_i, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("to_s", mClassCache.pDir, dir_to_s, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+
+  // socket
+  mClassCache.pSocket = class_create("socket");
+  method_add("#create", mClassCache.pSocket, socket_op_create, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0, 1, false, "type");
+  method_add("accept", mClassCache.pSocket, socket_accept, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("close", mClassCache.pSocket, socket_close, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("connect", mClassCache.pSocket, socket_connect, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 2, false, "host", "port");
+  method_add("eof", mClassCache.pSocket, socket_eof, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("length", mClassCache.pSocket, socket_length, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("listen", mClassCache.pSocket, socket_listen, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 2, false, "host", "port");
+  method_add("loop", mClassCache.pSocket, socket_loop, M_PROP_STATIC | M_PROP_PUBLIC | M_PROP_FINAL)->setup(0, 1, false, "timeout");
+  method_add("on_read", mClassCache.pSocket, socket_on_read, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "fx");
+  method_add("on_write", mClassCache.pSocket, socket_on_write, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "fx");
+  method_add("pending", mClassCache.pSocket, socket_pending, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("read", mClassCache.pSocket, socket_read, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0, 1, false, "size");
+  method_add("read_line", mClassCache.pSocket, socket_read_line, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("stop", mClassCache.pSocket, socket_stop, M_PROP_STATIC | M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("to_b", mClassCache.pSocket, socket_to_b, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("to_i", mClassCache.pSocket, socket_to_i, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("to_s", mClassCache.pSocket, socket_to_s, M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("write", mClassCache.pSocket, socket_write, M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "data");
 
   // exception
   mClassCache.pException = class_create("exception");
@@ -535,6 +714,17 @@ void rc_core::equip()
   method_add("max", math, math_max, M_PROP_STATIC | M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, true, "objects");
   method_add("min", math, math_min, M_PROP_STATIC | M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, true, "objects");
   method_add("even", math, math_even, M_PROP_STATIC | M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "value");
+
+  // env
+  rc_class *env = class_create("env", NULL, M_PROP_STATIC);
+  method_add("body", env, env_body, M_PROP_STATIC | M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("cookie", env, env_cookie, M_PROP_STATIC | M_PROP_PUBLIC | M_PROP_FINAL)->setup(0, 1, false, "name");
+  method_add("flush", env, env_flush, M_PROP_STATIC | M_PROP_PUBLIC | M_PROP_FINAL)->setup(0);
+  method_add("get", env, env_get, M_PROP_STATIC | M_PROP_PUBLIC | M_PROP_FINAL)->setup(0, 1, false, "name");
+  method_add("header", env, env_header, M_PROP_STATIC | M_PROP_PUBLIC | M_PROP_FINAL)->setup(2, 2, false, "name", "value");
+  method_add("post", env, env_post, M_PROP_STATIC | M_PROP_PUBLIC | M_PROP_FINAL)->setup(0, 1, false, "name");
+  method_add("server", env, env_server, M_PROP_STATIC | M_PROP_PUBLIC | M_PROP_FINAL)->setup(0, 1, false, "name");
+  method_add("status", env, env_status, M_PROP_STATIC | M_PROP_PUBLIC | M_PROP_FINAL)->setup(1, 1, false, "code");
 }
 
 /**
@@ -544,6 +734,9 @@ void rc_core::equip()
  */
 int rc_core::cmdline_task(const char *task)
 {
+  if(!strcmp(task, "-fcgi"))
+    return M_TASK_FCGI;
+
   if(*task == '-')
   {
     switch(*(task+1))
@@ -552,6 +745,7 @@ int rc_core::cmdline_task(const char *task)
       case 'b':   return M_TASK_RUN_BC;
       case 'e':   return M_TASK_EVAL;
       case 'c':   return M_TASK_COMPILE;
+      case 's':   return M_TASK_SERVE;
       case 'v':   return M_TASK_VERSION;
       case 'i':   return M_TASK_CREDITS;
     }
@@ -590,6 +784,13 @@ int rc_core::task_compile(const char *file)
     mFile->set(file);
 
   mSource->file_load(file);
+#if MALCO_UNICODE == 1
+  if(!mSource->is_utf8())
+  {
+    error(M_ERR_BAD_SOURCE_UTF8);
+    return 1;
+  }
+#endif
   ic_string filename = file;
 
   // first check whether we compile .mlc or .rasm file.
@@ -639,15 +840,81 @@ int rc_core::task_compile(const char *file)
 int rc_core::task_run_bc(const char *file)
 {
   equip();
+  image_load();
 
-  mTape->file_load("test.rbc");
-  mStrTable->file_load("test.rst");
+  return mHead->playback();
+}
 
-  rc_deftable *dt = new rc_deftable(this);
-  dt->file_load("test.rdt");
-  dt->declare(this);
+/**
+ * Serves HTTP requests with compiled bytecode.
+ * The image is loaded once and shared by all workers, which are set up
+ * in the [server] section of the configuration.
+ */
+int rc_core::task_serve(const char *file)
+{
+#if MALCO_PLATFORM == M_PLATF_NIX
+  equip();
+  image_load();
+  image_seal();
 
-  return mHead->playback();
+  ic_string *host = mSetup->get_value("host", "server");
+  long port = setup_int("port", "server", 8080);
+  sc_httpserver server(this, setup_int("keepalive", "server", 5000), setup_int("max_body", "server", 1048576));
+
+  if(!server.listen(host->get(), port))
+  {
+    ic_string *msg = ic_string::format(M_ERR_SERVER_LISTEN, host->get(), port);
+    error(msg);
+    delete msg;
+    delete host;
+    return 1;
+  }
+
+  printf("Serving on port %ld...\n", port);
+  delete host;
+
+  return server.run(setup_int("processes", "server", 1), setup_int("threads", "server", 0));
+#else
+  error(M_ERR_SERVER_PLATFORM);
+  return 1;
+#endif
+}
+
+/**
+ * Serves FastCGI requests of a web server with compiled bytecode.
+ * The image is loaded once and shared by all workers, which are set up
+ * in the [fastcgi] section of the configuration.
+ */
+int rc_core::task_fcgi(const char *file)
+{
+#if MALCO_PLATFORM == M_PLATF_NIX
+  equip();
+  image_load();
+  image_seal();
+
+  ic_string *path = mSetup->get_value("socket", "fastcgi");
+  if(!path->length())
+    path->set("/tmp/malco.sock");
+
+  sc_httpserver server(this, setup_int("keepalive", "fastcgi", 60000), setup_int("max_body", "fastcgi", 1048576));
+
+  if(!server.listen_unix(path->get()))
+  {
+    ic_string *msg = ic_string::format(M_ERR_SERVER_SOCKET, path->get());
+    error(msg);
+    delete msg;
+    delete path;
+    return 1;
+  }
+
+  printf("Serving FastCGI at %s...\n", path->get());
+  delete path;
+
+  return server.run(setup_int("processes", "fastcgi", 1), setup_int("threads", "fastcgi", 0));
+#else
+  error(M_ERR_SERVER_PLATFORM);
+  return 1;
+#endif
 }
 
 /**
@@ -679,6 +946,136 @@ int rc_core::task_credits()
   return 0;
 }
 
+/**
+ * Loads the compiled image: the tape, the string table and the definitions.
+ */
+void rc_core::image_load()
+{
+  mTape->file_load("test.rbc");
+  mStrTable->file_load("test.rst");
+
+  rc_deftable *dt = new rc_deftable(this);
+  dt->file_load("test.rdt");
+  dt->declare(this);
+}
+
+/**
+ * Prepares the image to be shared by several heads.
+ * Shared string constants are otherwise created on first use, so all of them
+ * are created at once. Nothing else is changed by heads while running.
+ */
+void rc_core::image_seal()
+{
+  if(mSealed) return;
+
+  for(long idx = 0; idx < mStrTable->length(); idx++)
+    delete mHead->new_string_const(idx);
+
+  mSealed = true;
+}
+
+/**
+ * Returns the pool of workers for parallel methods.
+ * The pool is started on first use, with as many workers as set up
+ * or one for each core.
+ */
+sc_taskpool *rc_core::pool()
+{
+  if(!mPool)
+  {
+    image_seal();
+
+    int size = mPoolSize > 0 ? mPoolSize : (int)std::thread::hardware_concurrency();
+    mPool = new sc_taskpool(this, size);
+    if(!mPool) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  }
+
+  return mPool;
+}
+
+/**
+ * Returns the event loop for sockets.
+ * The loop is created on first use.
+ */
+sc_reactor *rc_core::reactor()
+{
+  if(!mReactor)
+  {
+    mReactor = new sc_reactor();
+    if(!mReactor) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  }
+
+  return mReactor;
+}
+
+/**
+ * Returns the engine of asynchronous file operations.
+ * The engine is created on first use and attached to the event loop,
+ * which runs the callbacks.
+ */
+sc_aio *rc_core::aio()
+{
+  if(!mAio)
+  {
+    mAio = new sc_aio(mAioUring, mAioWorkers);
+    if(!mAio) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+    reactor()->attach(mAio);
+  }
+
+  return mAio;
+}
+
+/**
+ * Registers a script thread that has been started.
+ * @param thread Thread object.
+ */
+void rc_core::thread_add(ic_thread *thread)
+{
+  std::lock_guard<std::mutex> lock(mThreadLock);
+  mThreads.add(thread);
+  mThreadsRunning++;
+}
+
+/**
+ * Forgets a script thread whose object is being deleted.
+ * @param thread Thread object.
+ */
+void rc_core::thread_remove(ic_thread *thread)
+{
+  std::lock_guard<std::mutex> lock(mThreadLock);
+  for(long idx = 0; idx < mThreads.length(); idx++)
+    if(mThreads[idx] == thread)
+    {
+      mThreads.del(idx);
+      break;
+    }
+}
+
+/**
+ * Is called by a script thread as the last thing it does.
+ */
+void rc_core::thread_done()
+{
+  std::lock_guard<std::mutex> lock(mThreadLock);
+  mThreadsRunning--;
+  mThreadDone.notify_all();
+}
+
+/**
+ * Waits for the script threads still running once the main head has finished.
+ * Threads waiting for a message are woken up and get undef instead.
+ */
+void rc_core::threads_wait()
+{
+  std::unique_lock<std::mutex> lock(mThreadLock);
+  mClosing = true;
+  for(long idx = 0; idx < mThreads.length(); idx++)
+    ((ic_thread *)mThreads[idx])->wake();
+
+  mThreadDone.wait(lock, [this] { return mThreadsRunning == 0; });
+}
+
 /**
  * Creates a new class.
  * @param name Name of the new class.
@@ -695,7 +1092,7 @@ rc_class *rc_core::class_create(const char *name, rc_class *parent, short proper
   cls->pRoot = root;
 
   int namelen = strlen(name);
-  cls->mName = new char[namelen];
+  cls->mName = new char[namelen+1];
   strcpy(cls->mName, name);
 
   // affix class to it's root
@@ -710,9 +1107,9 @@ rc_class *rc_core::class_create(const char *name, rc_class *parent, short proper
     }
     else
     {
-      // fullname is parentname::name
+      // fullname is parentname::name, with the separator and a null
       int rootlen = strlen(root->mFullName);
-      cls->mFullName = new char[namelen + 2 + rootlen];
+      cls->mFullName = new char[namelen + rootlen + 3];
       strcpy(cls->mFullName, root->mFullName);
       strcpy(cls->mFullName + rootlen, "::");
       strcpy(cls->mFullName + rootlen + 2, name);
@@ -830,6 +1227,10 @@ int rc_core::class_type(rc_class *cls)
     else if(cls == mClassCache.pRange) return M_CLASS_RANGE;
     else if(cls == mClassCache.pRegex) return M_CLASS_REGEX;
     else if(cls == mClassCache.pMatch) return M_CLASS_MATCH;
+    else if(cls == mClassCache.pRegexSet) return M_CLASS_REGEXSET;
+    else if(cls == mClassCache.pLazy) return M_CLASS_LAZY;
+    else if(cls == mClassCache.pThread) return M_CLASS_THREAD;
+    else if(cls == mClassCache.pGenerator) return M_CLASS_GENERATOR;
     else if(cls == mClassCache.pMethod) return M_CLASS_METHOD;
     else if(cls == mClassCache.pTime) return M_CLASS_TIME;
     else if(cls == mClassCache.pFile) return M_CLASS_FILE;
@@ -909,32 +1310,34 @@ inline rc_method *rc_core::method_add(const char *name, rc_class *root, native_f
  */
 rc_method *rc_core::op_resolve(const char *name, rc_class *ax, rc_class *bx)
 {
-  ic_string *opname = new ic_string(name);
-  opname->append('_');
+  // operator names are built in a local buffer to avoid allocations
+  char buf[256];
+  long len = strlen(name);
 
   while(ax != NULL)
   {
-    while(bx != NULL)
+    rc_class *curr = bx;
+    while(curr != NULL)
     {
-      ic_string *full = new ic_string(*opname);
-      full->append(bx->mName);
+      long namelen = strlen(curr->mName);
+      char *full = (len + namelen + 2 <= (long)sizeof(buf) ? buf : new char[len + namelen + 2]);
+      memcpy(full, name, len);
+      full[len] = '_';
+      memcpy(full + len + 1, curr->mName, namelen + 1);
 
       rc_method *method = (rc_method *)ax->mMethods.get(full);
+      if(full != buf)
+        delete [] full;
+
       if(method)
-      {
-        delete opname;
-        delete full;
         return method;
-      }
 
-      delete full;
-      bx = bx->pParent;
+      curr = curr->pParent;
     }
 
     ax = ax->pParent;
   }
 
-  delete opname;
   return NULL;
 }
 
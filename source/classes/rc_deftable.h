@@ -75,7 +75,7 @@ void rc_deftable::declare_method(long id)
   len = strlen(parent);
   idx += len + 1;
 
-  // props, point, min_args, max_args, splat
+  // props, point, min_args, max_args, splat, number of argument names
   short props = *(short *)(str + idx);
   idx += sizeof(short);
   long point = *(long *)(str + idx);
@@ -86,6 +86,8 @@ void rc_deftable::declare_method(long id)
   idx += sizeof(long);
   bool splat = *(bool *)(str + idx);
   idx += sizeof(bool);
+  long name_count = *(long *)(str + idx);
+  idx += sizeof(long);
 
   rc_class *cls = pCore->class_resolve(parent);
   if(cls)
@@ -95,8 +97,8 @@ void rc_deftable::declare_method(long id)
     method->mMinArgs = min_args;
     method->mSplatArgs = splat;
 
-    // load argument names
-    for(long idx2 = 0; idx2 < max_args; idx2 ++)
+    // load argument names, the assembler may not have any
+    for(long idx2 = 0; idx2 < name_count; idx2 ++)
     {
       ic_string *curr = new ic_string((char *)(str + idx));
       idx += curr->length() + 1;
@@ -152,8 +154,8 @@ void rc_deftable::add_class(const char *name, const char *parent, short props, c
 
   // magic constant assumes prefix character to determine definition type
   // ( '' = class, 'm' = method, 'p' = property )
-  // and two nulls after name and parent.
-  char *buf = new char[name_len + parent_len + root_len + sizeof(short) + 3];
+  // three nulls after name, parent and root and a trailing null character.
+  char *buf = new char[name_len + parent_len + root_len + sizeof(short) + 5];
 
   // prefix
   *buf = 'c';
@@ -173,6 +175,7 @@ void rc_deftable::add_class(const char *name, const char *parent, short props, c
   // (props:short)
   *(short *)(buf + pos) = props;
   pos += sizeof(short);
+  buf[pos] = '\0';
 
   // register in the table
   mTable.add_existing(buf, pos);
@@ -186,7 +189,7 @@ void rc_deftable::add_class(const char *name, const char *parent, short props, c
  * @param min_args Minimal number of arguments.
  * @param max_args Maximal number of arguments.
  * @param splat Flag saying method accepts any number of arguments.
- * @param names Array of method names as char pointers, zero-ended, names->length() = max_args.
+ * @param names Array of argument names as char pointers, zero-ended, at most max_args of them.
  * @param point Code execution point, relative to current script.
  */
 void rc_deftable::add_method(const char *name, const char *cls, short props, long point, long min_args, long max_args, bool splat, sc_voidarray *names)
@@ -203,7 +206,7 @@ void rc_deftable::add_method(const char *name, const char *cls, short props, lon
     total += lengths[idx];
   }
 
-  char *buf = new char[name_len + cls_len + sizeof(short) + sizeof(long)*2 + sizeof(bool) + total + 3];
+  char *buf = new char[name_len + cls_len + sizeof(short) + sizeof(long)*4 + sizeof(bool) + total + 4];
 
   // prefix
   *buf = 'm';
@@ -217,7 +220,7 @@ void rc_deftable::add_method(const char *name, const char *cls, short props, lon
   strcpy(buf + pos, cls);
   pos += cls_len + 1;
 
-  // (props:short) (point:long) (min_args:long) (max_args:long) (splat:bool)
+  // (props:short) (point:long) (min_args:long) (max_args:long) (splat:bool) (name_count:long)
   *(short *)(buf + pos) = props;
   pos += sizeof(short);
   *(long *)(buf + pos) = point;
@@ -228,13 +231,16 @@ void rc_deftable::add_method(const char *name, const char *cls, short props, lon
   pos += sizeof(long);
   *(bool *)(buf + pos) = splat;
   pos += sizeof(bool);
+  *(long *)(buf + pos) = names->length();
+  pos += sizeof(long);
 
   // argument names
   for(idx = 0; idx < names->length(); idx++)
   {
     strcpy(buf + pos, (char *)names->get(idx));
-    pos += name_len + 1;
+    pos += lengths[idx];
   }
+  buf[pos] = '\0';
 
   // register in the table
   delete [] lengths;
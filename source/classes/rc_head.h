@@ -15,6 +15,10 @@ rc_head::rc_head(rc_core *core)
 {
   // set misc stuff
   pCore = core;
+  pThread = NULL;
+  pGenerator = NULL;
+  pRequest = NULL;
+  mState = M_STATE_RUN;
   mLine = mOffset = 0;
   strcpy(mFile, "<unknown>");
   mStartTime = clock();
@@ -24,6 +28,8 @@ rc_head::rc_head(rc_core *core)
 
   // define registers
   rAX = NULL;
+  rEX = NULL;
+  mBase = 0;
   rCS.resize(16);
 }
 
@@ -36,6 +42,9 @@ rc_head::~rc_head()
   if(rAX)
     obj_unlink(rAX);
 
+  if(rEX)
+    obj_unlink(rEX);
+
   cmd_clrsrc();
   cmd_clrdst();
 
@@ -43,8 +52,12 @@ rc_head::~rc_head()
     cmd_popus();
 
 #if MALCO_DEBUG
+  if(this != pCore->mHead) return;
+
   clock_t end_time = clock();
   printf("\nExec time: %f s", ((float)end_time - (float)mStartTime) / CLOCKS_PER_SEC);
+  printf("\nRegex cache: %ld hits, %ld misses, %ld programs (%ld bytes)",
+         sc_regexcache::hits(), sc_regexcache::misses(), sc_regexcache::length(), sc_regexcache::memory());
 #endif
 }
 
@@ -61,7 +74,13 @@ int rc_head::playback(bool main)
     pCurrObj = NULL;
   }
 
-  while((pCmd = pCore->mTape->select(mOffset)) != NULL && pCore->mState != M_STATE_DEAD)
+  // script methods are entered and left by this very loop, so a method's
+  // playback ends when it's own frame is gone
+  long depth = rCS.length();
+  long base = mBase;
+  mBase = depth;
+
+  while((pCmd = pCore->mTape->select(mOffset)) != NULL && pCore->mState != M_STATE_DEAD && mState == M_STATE_RUN)
   {
     // exit
     if(pCmd->mCmd == RASM_CMD_EXIT)
@@ -69,7 +88,18 @@ int rc_head::playback(bool main)
 
     execute();
 
-    if(!main && pCmd->mCmd == RASM_CMD_RETURN)
+    // an exception has left a callback: it is thrown again
+    // once the native method that has called it is gone
+    if(mState == M_STATE_UNWIND && rCS.length() >= depth)
+    {
+      mState = M_STATE_RUN;
+      obj_unlink(rAX);
+      rAX = rEX;
+      rEX = NULL;
+      cmd_throw();
+    }
+
+    if(!main && rCS.length() < depth)
       break;
 
     mStatCommands++;
@@ -78,6 +108,7 @@ int rc_head::playback(bool main)
       mOffset++;
   }
 
+  mBase = base;
   return 0;
 }
 
@@ -145,6 +176,7 @@ void rc_head::execute()
     case RASM_CMD_RETURN:       cmd_return(); break;
     case RASM_CMD_NSP:          cmd_nsp(); break;
     case RASM_CMD_BINDLAMBDA:   cmd_bindlambda(); break;
+    case RASM_CMD_YIELD:        cmd_yield(); break;
 
     case RASM_CMD_INDEX:        cmd_index(); break;
 
@@ -179,6 +211,7 @@ void rc_head::state_save()
   state->pStateObj = pCurrObj;
   state->mOffset = mOffset;
   state->mExternalScope = mExternalScope;
+  state->mDepth = rCS.length();
   rCS.add((void *)state);
 
   rAX = NULL;
@@ -201,22 +234,104 @@ void rc_head::state_load()
     mOffset = state->mOffset;
 
     rCS.del(rCS.length() - 1);
+    delete state;
   }
   else
     exception(M_ERR_RETURN_1);
 }
 
+/**
+ * Returns from methods until the call stack is back to a given depth, releasing their variables.
+ * Frames of native methods share the variable table of their caller.
+ * @param depth Call stack depth.
+ */
+void rc_head::state_unwind(long depth)
+{
+  while(rCS.length() > depth)
+  {
+    obj_unlink(rAX);
+    rAX = NULL;
+
+    rc_headstate *state = (rc_headstate *)rCS.get(rCS.length() - 1);
+    if(!mExternalScope && mVars != state->mVars)
+    {
+      for(long idx=0; idx < mVars->length(); idx++)
+        obj_unlink((rc_var *)mVars->get(idx));
+
+      delete mVars;
+    }
+
+    state_load();
+  }
+}
+
+/**
+ * Returns from all methods the head is in, releasing their variables.
+ * Is used to drop a generator that has not finished.
+ */
+void rc_head::unwind()
+{
+  state_unwind(0);
+
+  while(rSS.mLength)
+    delete (rc_headstate *)rSS.pop();
+}
+
+/**
+ * Prepares the head to play the tape once again.
+ * Nothing of the previous run is left: the methods are left and
+ * the variables and registers are released.
+ */
+void rc_head::reset()
+{
+  unwind();
+
+  obj_unlink(rAX);
+  obj_unlink(rEX);
+  rAX = rEX = NULL;
+
+  cmd_clrsrc();
+  cmd_clrdst();
+
+  while(rUS.mLength)
+    cmd_popus();
+
+  for(long idx=0; idx < mVars->length(); idx++)
+    obj_unlink((rc_var *)mVars->get(idx));
+
+  delete mVars;
+  mVars = new sc_voidarray();
+  if(!mVars) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  mState = M_STATE_RUN;
+  mOffset = mLine = mBase = 0;
+  mExternalScope = false;
+  strcpy(mFile, "<unknown>");
+}
+
 /**
  * Finds a method by it's name.
  * @param name Method name.
  * @param root Root class to start search from.
  * @return Pointer to resolved method.
  */
-rc_method *rc_head::method_resolve(const char *name, rc_class *root)
+inline rc_method *rc_head::method_resolve(const char *name, rc_class *root)
+{
+  return method_resolve(name, sc_strpool::hash(name), root);
+}
+
+/**
+ * Finds a method by it's name.
+ * @param name Method name.
+ * @param hash Precomputed name hash.
+ * @param root Root class to start search from.
+ * @return Pointer to resolved method.
+ */
+rc_method *rc_head::method_resolve(const char *name, unsigned long hash, rc_class *root)
 {
   while(root != NULL)
   {
-    rc_method *method = (rc_method *)root->mMethods.get(name);
+    rc_method *method = (rc_method *)root->mMethods.get(name, hash);
     if(method) return method;
     root = root->pParent;
   }
@@ -242,33 +357,64 @@ inline void rc_head::method_invoke(const char *name, rc_var *object, bool report
 }
 
 /**
- * Invokes a method of a specified object.
+ * Invokes a method of a specified object and waits for it to return.
+ * Is the way native methods call back into the script: a script method
+ * gets a playback of it's own, which ends once the method returns.
  * @param method Method pointer.
  * @param obj Object to call method on.
- * @param report Flag indicating whether to report method inexistance or not.
  */
 void rc_head::method_invoke(rc_method *method, rc_var *object)
 {
+  if(method_enter(method, object))
+    playback(false);
+}
+
+/**
+ * Enters a method of a specified object.
+ * A native method is run at once, while for a script method only the frame
+ * is prepared and the offset is set to it's first command.
+ * @param method Method pointer.
+ * @param obj Object to call method on.
+ * @return true if a script method has been entered and is to be played back.
+ */
+bool rc_head::method_enter(rc_method *method, rc_var *object)
+{
+  // an exception is on it's way out: nothing gets called
+  if(mState != M_STATE_RUN)
+    return false;
+
   if(!method)
   {
     exception(ic_string::format(M_ERR_NO_FX, "<unknown>", pTmpClass->mName), M_EXC_NOT_FOUND);
-    return;
+    return false;
   }
 
   // ensure method can be called: if it's dynamical and called statically, throw an error
   if(!(method->mProperties & M_PROP_STATIC) && !object)
+  {
     exception(ic_string::format(M_ERR_BAD_STATIC_CALL, method->mName), M_EXC_SCRIPT);
+    return false;
+  }
 
   // validate method's privacy restrictions
   if(((method->mProperties & M_PROP_INTERNAL) && var_get(object)->pClass != pCurrClass) || ((method->mProperties & M_PROP_PRIVATE) && object != pCurrObj))
+  {
     exception(ic_string::format(M_ERR_FX_PRIVATE, method->mName), M_EXC_NOT_FOUND);
+    return false;
+  }
 
-  // validate method's number of arguments
+  // validate method's number of arguments, slick mode lets the call go on
   if(pCmd->mModifier != RASM_MOD_NAMES && rSRC.mLength < method->mMinArgs)
+  {
     exception(ic_string::format(M_ERR_FX_FEW_PARAMS, method->mName), M_EXC_ARGS);
+    if(pCore->mRunMode != M_RUNMODE_SLICK) return false;
+  }
 
   if(pCmd->mModifier != RASM_MOD_NAMES && rSRC.mLength > method->mMaxArgs && !method->mSplatArgs)
+  {
     exception(ic_string::format(M_ERR_FX_MANY_PARAMS, method->mName), M_EXC_ARGS);
+    if(pCore->mRunMode != M_RUNMODE_SLICK) return false;
+  }
 
   // everything's okay
   state_save();
@@ -323,21 +469,30 @@ void rc_head::method_invoke(rc_method *method, rc_var *object)
       rSRC.push(new_undef());
   }
 
+  // in-place methods end with '!' and must not change a shared constant
+  if(object && var_get(object)->mShared && method->mName[strlen(method->mName) - 1] == '!')
+    obj_own(object);
+
   pCurrClass = method->pClass;
   pCurrObj = (method->mProperties & M_PROP_STATIC) ? NULL : object;
 
   // execute the method actually
   if(method->mNative)
   {
+    long depth = rCS.length();
     (method->pNativeFunc)(this);
-    // reset state to previous
-    state_load();
-  }
-  else
-  {
-    mOffset = method->mExecPoint;
-    playback(false);
+
+    // reset state to previous, unless an exception has already left the frame
+    if(rCS.length() == depth)
+      state_load();
+
+    return false;
   }
+
+  // a method called back from a native one must not resolve names in the caller's namespace
+  nsp_flush();
+  mOffset = method->mExecPoint;
+  return true;
 }
 
 /**
@@ -406,6 +561,13 @@ void rc_head::var_save(rc_var *var, ic_object *obj)
   // check for dumb cases
   if(!var) return;
 
+  // shared constants are never bound to variables, a private copy is saved instead
+  if(obj->mShared)
+  {
+    obj = new ic_object(obj->pClass, new ic_string(*(ic_string *)obj->mData));
+    obj->mLinks--;
+  }
+
   obj_unlink((ic_object *)var->pObj);
   var->pObj = obj;
   obj->mLinks++;
@@ -473,17 +635,18 @@ rc_var *rc_head::scope_get(long id)
 /**
  * Resolve a bare identifier, possibly a class / method / constant.
  * @param name Identifier name
+ * @param hash Precomputed name hash.
  * @return Related object
  */
-rc_var *rc_head::bare_id_resolve(const char *name)
+rc_var *rc_head::bare_id_resolve(const char *name, unsigned long hash)
 {
   // first try a class (more common)
-  rc_class *cls = (rc_class *)pTmpClass->mClasses.get(name);
+  rc_class *cls = (rc_class *)pTmpClass->mClasses.get(name, hash);
   if(cls)
     return new_class(cls, false);
 
   // then attempt a method
-  rc_method *mth = (rc_method *)pTmpClass->mMethods.get(name);
+  rc_method *mth = (rc_method *)pTmpClass->mMethods.get(name, hash);
   if(mth)
     return new_method(mth, false);
 
@@ -495,11 +658,12 @@ rc_var *rc_head::bare_id_resolve(const char *name)
 /**
  * Finds a member by it's name.
  * @param name Member name.
+ * @param hash Precomputed name hash.
  * @param obj Object to find member in.
  * @param cls Root class to start search from.
  * @return Pointer to resolved member.
  */
-inline rc_var *rc_head::member_resolve(const char *name, rc_var *obj, rc_class *cls)
+inline rc_var *rc_head::member_resolve(const char *name, unsigned long hash, rc_var *obj, rc_class *cls)
 {
   rc_var *var;
   bool dynamic = false; // false = member is static, belongs to class
@@ -507,14 +671,14 @@ inline rc_var *rc_head::member_resolve(const char *name, rc_var *obj, rc_class *
   if(obj)
   {
     cls = obj->get()->pClass;
-    var = (rc_var *)(obj->get()->mMembers->get(name));
+    var = (rc_var *)(obj->get()->mMembers->get(name, hash));
     if(var)
       dynamic = true;
     else
-      var = (rc_var *)(cls->mStaticMembers.get(name));
+      var = (rc_var *)(cls->mStaticMembers.get(name, hash));
   }
   else
-    var = (rc_var *)cls->mStaticMembers.get(name);
+    var = (rc_var *)cls->mStaticMembers.get(name, hash);
 
   // variable has not been found
   if(!var)
@@ -553,6 +717,13 @@ inline rc_var *rc_head::member_resolve(const char *name, rc_var *obj, rc_class *
     return NULL;
   }
 
+  // static members are not synchronized, so other threads may not touch them
+  if(!dynamic && std::this_thread::get_id() != pCore->mMainThread)
+  {
+    exception(ic_string::format(M_ERR_STATIC_THREAD, name, cls->mName), M_EXC_SCRIPT);
+    return NULL;
+  }
+
   if(!var->get())
     var_save(var, new_undef());
 
@@ -657,7 +828,11 @@ rc_var *rc_head::obj_clone(rc_var *var)
 {
   sc_voidmapitem *curr;
   ic_object *obj = var_get(var);
-  rc_var *newvar = obj_create(obj->pClass);
+
+  // the copy gets it's state from the original, so the constructor is not
+  // called: it might expect parameters that are not there
+  rc_var *newvar = new rc_var(new ic_object(obj->pClass, new_basic(pCore->class_type(obj->pClass))));
+  method_invoke("#init", newvar, false);
   ic_object *newobj = var_get(newvar);
 
   // clone basic object
@@ -672,8 +847,11 @@ rc_var *rc_head::obj_clone(rc_var *var)
     case M_CLASS_REGEX:     *((ic_regex *)newobj->mData) = *((ic_regex *)obj->mData); break;
     case M_CLASS_RANGE:     *((ic_range *)newobj->mData) = *((ic_range *)obj->mData); break;
     case M_CLASS_MATCH:     *((ic_match *)newobj->mData) = *((ic_match *)obj->mData); break;
+    case M_CLASS_REGEXSET:  *((ic_regexset *)newobj->mData) = *((ic_regexset *)obj->mData); break;
+    case M_CLASS_LAZY:      *((ic_lazy *)newobj->mData) = *((ic_lazy *)obj->mData);
+                            ((ic_lazy *)newobj->mData)->link(); break;
     case M_CLASS_DIR:       *((ic_dir *)newobj->mData) = *((ic_dir *)obj->mData); break;
-    case M_CLASS_SOCKET:    *((ic_socket *)newobj->mData) = *((ic_socket *)obj->mData); break;
+    case M_CLASS_SOCKET:    ((ic_socket *)newobj->mData)->copy((ic_socket *)obj->mData); break;
     case M_CLASS_FILE:      *((ic_file *)newobj->mData) = *((ic_file *)obj->mData); break;
     case M_CLASS_CLASS:     *((rc_class *)newobj->mData) = *((rc_class *)obj->mData); break;
     case M_CLASS_METHOD:    *((rc_method *)newobj->mData) = *((rc_method *)obj->mData); break;
@@ -690,6 +868,99 @@ rc_var *rc_head::obj_clone(rc_var *var)
   return newvar;
 }
 
+/**
+ * Creates a deep copy of the object, to be handed over to another head.
+ * Nothing is shared with the original except the program image,
+ * so the copy can be used by a head running in another thread.
+ * @param var Variable holding the object to be copied.
+ * @return Variable holding the copy.
+ */
+rc_var *rc_head::obj_copy(rc_var *var)
+{
+  ic_object *obj = var_get(var);
+  void *data = NULL;
+  long pos = 0;
+
+  switch(pCore->class_type(obj->pClass))
+  {
+    case M_CLASS_UNDEF:     break;
+    case M_CLASS_BOOL:      data = new ic_bool(((ic_bool *)obj->mData)->mValue); break;
+    case M_CLASS_INT:       data = new ic_int(((ic_int *)obj->mData)->mValue); break;
+    case M_CLASS_FLOAT:     data = new ic_float(((ic_float *)obj->mData)->mValue); break;
+    case M_CLASS_STRING:    data = new ic_string(*(ic_string *)obj->mData); break;
+    case M_CLASS_RANGE:     data = new ic_range(((ic_range *)obj->mData)->mStart, ((ic_range *)obj->mData)->mEnd); break;
+    case M_CLASS_TIME:      data = new ic_time(((ic_time *)obj->mData)->get()); break;
+    case M_CLASS_EXCEPTION: data = new sc_exception(*(sc_exception *)obj->mData);
+                            // the file name is kept by the head, which may be gone by then
+                            if(((sc_exception *)data)->mFile)
+                              ((sc_exception *)data)->mFile = sc_strpool::intern(((sc_exception *)data)->mFile);
+                            break;
+
+    // methods and classes are a part of the image
+    case M_CLASS_METHOD:    return new_method((rc_method *)obj->mData, obj->mTainted);
+    case M_CLASS_CLASS:     return new_class((rc_class *)obj->mData, obj->mTainted);
+
+    case M_CLASS_ARRAY:
+    {
+      ic_array *arr = (ic_array *)obj->mData, *copy = new ic_array();
+      if(!copy) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+      sc_voidmapitem *curr;
+      while(curr = arr->iter_next(pos))
+        copy->set(curr->mKey, obj_copy((rc_var *)curr->mValue));
+
+      data = copy;
+      break;
+    }
+
+    case M_CLASS_OTHER:     break;
+
+    // compiled regular expressions are cached per thread, files and
+    // sockets can't be used by two heads, enumerators, threads and
+    // generators hold variables of their head
+    default:                exception(ic_string::format(M_ERR_THREAD_COPY, obj->pClass->mName), M_EXC_ARGS);
+                            return new_undef();
+  }
+
+  ic_object *copy = new ic_object(obj->pClass, data);
+  if(!copy) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  copy->mTainted = obj->mTainted;
+  copy->mFrozen = obj->mFrozen;
+
+  // copy members
+  sc_voidmapitem *curr;
+  pos = 0;
+  while(curr = obj->mMembers->iter_next(pos))
+  {
+    rc_var *member = (rc_var *)curr->mValue;
+    if(member && var_get(member))
+      copy->mMembers->set(curr->mKey->get(), curr->mHash, (void *)obj_copy(member));
+  }
+
+  return new rc_var(copy);
+}
+
+/**
+ * Replaces a shared constant held by a variable with a private copy,
+ * so that the variable can be modified without affecting other uses of it.
+ * @param var Variable holding the object.
+ */
+void rc_head::obj_own(rc_var *var)
+{
+  while(var->mProperties & M_PROP_LINK)
+    var = (rc_var *)var->pObj;
+
+  ic_object *obj = (ic_object *)var->pObj;
+  if(!obj->mShared)
+    return;
+
+  ic_object *copy = new ic_object(obj->pClass, new ic_string(*(ic_string *)obj->mData));
+  if(!copy) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  // shared constants are not counted, the copy belongs to the variable alone
+  var->pObj = copy;
+}
+
 /**
  * Declares one link being removed from object.
  * @param obj Object of the link.
@@ -738,7 +1009,8 @@ void rc_head::obj_unlink(rc_var *obj)
  */
 void rc_head::obj_unlink(ic_object *obj)
 {
-  if(!obj)
+  // shared constants are never released by heads, see rc_var
+  if(!obj || obj->mShared)
     return;
 
   if(obj->mLinks <= 1)
@@ -763,6 +1035,72 @@ void rc_head::obj_unlink(ic_object *obj)
       arr->iter_rewind();
       while(sc_voidmapitem *curr = arr->iter_next())
         obj_unlink((rc_var*)curr->mValue);
+
+      delete arr;
+      obj->mData = NULL;
+    }
+
+    // release the buffers of a string
+    if(pCore->class_type(obj->pClass) == M_CLASS_STRING)
+    {
+      delete (ic_string *)obj->mData;
+      obj->mData = NULL;
+    }
+
+    // unlink the source and the stages of a lazy enumerator
+    if(pCore->class_type(obj->pClass) == M_CLASS_LAZY)
+    {
+      ic_lazy *lazy = (ic_lazy *)obj->mData;
+      for(long idx = 0; idx < lazy->mVars->length(); idx++)
+        obj_unlink((rc_var *)lazy->mVars->get(idx));
+
+      delete lazy;
+      obj->mData = NULL;
+    }
+
+    // drop the frames of a suspended generator
+    if(pCore->class_type(obj->pClass) == M_CLASS_GENERATOR)
+    {
+      delete (ic_generator *)obj->mData;
+      obj->mData = NULL;
+    }
+
+    // close the file and drop it's buffers
+    if(pCore->class_type(obj->pClass) == M_CLASS_FILE)
+    {
+      delete (ic_file *)obj->mData;
+      obj->mData = NULL;
+    }
+
+    // close the directory stream
+    if(pCore->class_type(obj->pClass) == M_CLASS_DIR)
+    {
+      delete (ic_dir *)obj->mData;
+      obj->mData = NULL;
+    }
+
+    // close the socket and drop it's callbacks
+    if(pCore->class_type(obj->pClass) == M_CLASS_SOCKET)
+    {
+      ic_socket *sock = (ic_socket *)obj->mData;
+      obj_unlink(sock->pOnRead);
+      obj_unlink(sock->pOnWrite);
+
+      delete sock;
+      obj->mData = NULL;
+    }
+
+    // wait for the thread and drop what it has left
+    if(pCore->class_type(obj->pClass) == M_CLASS_THREAD)
+    {
+      ic_thread *thread = (ic_thread *)obj->mData;
+      thread->join();
+      obj_unlink(thread->mResult);
+      while(rc_var *msg = thread->drain())
+        obj_unlink(msg);
+
+      delete thread;
+      obj->mData = NULL;
     }
 
     //printf("do %p  ", obj);
@@ -857,6 +1195,10 @@ inline void *rc_head::new_basic(char type)
     case M_CLASS_STRING:    return new ic_string();
     case M_CLASS_RANGE:     return new ic_range();
     case M_CLASS_REGEX:     return new ic_regex();
+    case M_CLASS_REGEXSET:  return new ic_regexset();
+    case M_CLASS_LAZY:      return new ic_lazy();
+    case M_CLASS_THREAD:    return new ic_thread();
+    case M_CLASS_GENERATOR: return new ic_generator();
     case M_CLASS_TIME:      return new ic_time();
     case M_CLASS_FILE:      return new ic_file();
     case M_CLASS_DIR:       return new ic_dir();
@@ -967,6 +1309,31 @@ inline rc_var *rc_head::new_string(ic_string *string, bool tainted)
   return new rc_var((new ic_object(pCore->mClassCache.pString, string))->taint(tainted));
 }
 
+/**
+ * Returns a shared constant string object from the string table.
+ * The object is created on first use and is never modified, so no
+ * allocation happens when the same constant is loaded again. Variables
+ * and in-place methods get a private copy, see var_save() and obj_own().
+ * @param idx Index of the string in the table.
+ * @return Pointer to created variable.
+ */
+inline rc_var *rc_head::new_string_const(long idx)
+{
+  ic_object *obj = pCore->mStrTable->get_object(idx);
+  if(!obj)
+  {
+    obj = new ic_object(pCore->mClassCache.pString, new ic_string(pCore->mStrTable->get(idx)));
+    obj->mShared = true;
+#if MALCO_UNICODE == 1
+    if(!((ic_string *)obj->mData)->is_utf8())
+      warning(M_WARN_BAD_UTF8);
+#endif
+    pCore->mStrTable->set_object(idx, obj);
+  }
+
+  return new rc_var(obj);
+}
+
 /**
  * Creates a new regex object.
  * @param regex Pointer to ic_regex.
@@ -1077,6 +1444,17 @@ inline rc_var *rc_head::new_array(ic_array *arr, bool tainted)
   return new rc_var((new ic_object(pCore->mClassCache.pArray, arr))->taint(tainted));
 }
 
+/**
+ * Creates a lazy enumerator object.
+ * @param lazy Enumerator.
+ * @param tainted Tainted flag.
+ * @return Pointer to created object.
+ */
+inline rc_var *rc_head::new_lazy(ic_lazy *lazy, bool tainted)
+{
+  return new rc_var((new ic_object(pCore->mClassCache.pLazy, lazy))->taint(tainted));
+}
+
 /**
  * Creates an exception object.
  * @param msg Exception message.
@@ -1120,18 +1498,22 @@ void rc_head::cmd_loadax()
     case RASM_MOD_TRUE:       rAX = new_bool(true); break;
     case RASM_MOD_INT:        rAX = new_int(pCmd->mParam.addr); break;
     case RASM_MOD_FLOAT:      rAX = new_float(pCmd->mParam.val); break;
-    case RASM_MOD_STRING:     rAX = new_string(pCore->mStrTable->get(pCmd->mParam.addr)); break;
+    case RASM_MOD_STRING:     rAX = new_string_const(pCmd->mParam.addr); break;
 
     case RASM_MOD_VAR:        rAX = scope_get(pCmd->mParam.addr);
                               if(rAX) rAX->mLinks++;
                               break;
 
-    case RASM_MOD_PROPERTY:   rAX = member_resolve(pCore->mStrTable->get(pCmd->mParam.addr), rAX, pTmpClass);
-                              if(rAX) rAX->mLinks++;
+    case RASM_MOD_PROPERTY:   // on failure AX holds the exception that has been thrown
+                              if(rc_var *var = member_resolve(pCore->mStrTable->get(pCmd->mParam.addr), pCore->mStrTable->hash(pCmd->mParam.addr), rAX, pTmpClass))
+                              {
+                                rAX = var;
+                                rAX->mLinks++;
+                              }
                               nsp_flush();
                               break;
 
-    case RASM_MOD_CONST:      rAX = bare_id_resolve(pCore->mStrTable->get(pCmd->mParam.addr));
+    case RASM_MOD_CONST:      rAX = bare_id_resolve(pCore->mStrTable->get(pCmd->mParam.addr), pCore->mStrTable->hash(pCmd->mParam.addr));
                               if(rAX) rAX->mLinks++;
                               nsp_flush();
                               break;
@@ -1165,18 +1547,18 @@ void rc_head::cmd_loadbx()
     case RASM_MOD_TRUE:       bx = new_bool(true); break;
     case RASM_MOD_INT:        bx = new_int(pCmd->mParam.addr); break;
     case RASM_MOD_FLOAT:      bx = new_float(pCmd->mParam.val); break;
-    case RASM_MOD_STRING:     bx = new_string(pCore->mStrTable->get(pCmd->mParam.addr)); break;
+    case RASM_MOD_STRING:     bx = new_string_const(pCmd->mParam.addr); break;
 
     case RASM_MOD_VAR:        bx = scope_get(pCmd->mParam.addr);
                               if(bx) bx->mLinks++;
                               break;
 
-    case RASM_MOD_PROPERTY:   bx = member_resolve(pCore->mStrTable->get(pCmd->mParam.addr), rAX, pTmpClass);
+    case RASM_MOD_PROPERTY:   bx = member_resolve(pCore->mStrTable->get(pCmd->mParam.addr), pCore->mStrTable->hash(pCmd->mParam.addr), rAX, pTmpClass);
                               if(bx) bx->mLinks++;
                               nsp_flush();
                               break;
 
-    case RASM_MOD_CONST:      bx = bare_id_resolve(pCore->mStrTable->get(pCmd->mParam.addr));
+    case RASM_MOD_CONST:      bx = bare_id_resolve(pCore->mStrTable->get(pCmd->mParam.addr), pCore->mStrTable->hash(pCmd->mParam.addr));
                               if(bx) bx->mLinks++;
                               nsp_flush();
                               break;
@@ -1788,9 +2170,16 @@ inline void rc_head::cmd_new()
 {
   if(rAX)
     obj_unlink(rAX);
+  rAX = NULL;
 
   char *classname = pCore->mStrTable->get(pCmd->mParam.addr);
-  rAX = obj_create(pCore->class_resolve(classname, pTmpClass));
+  rc_var *obj = obj_create(pCore->class_resolve(classname, pTmpClass));
+
+  // a constructor that has thrown leaves the exception in AX
+  if(rAX)
+    obj_unlink(obj);
+  else
+    rAX = obj;
   nsp_flush();
 }
 
@@ -1801,10 +2190,18 @@ inline void rc_head::cmd_call()
 {
   const char *name = pCore->mStrTable->get(pCmd->mParam.addr);
 
-  rc_method *method;
-
+  // resolve using the name hash precomputed by the string table
   rc_var *curr = rAX ? rAX : pCurrObj;
-  method_invoke(name, curr);
+  rc_class *cls = (curr ? curr->get()->pClass : pTmpClass);
+  rc_method *method = method_resolve(name, pCore->mStrTable->hash(pCmd->mParam.addr), cls);
+  if(method)
+  {
+    // a script method is run by the current playback, which steps onto it's first command
+    if(method_enter(method, curr))
+      mOffset--;
+  }
+  else
+    exception(ic_string::format(M_ERR_NO_FX, name, pTmpClass->mName), M_EXC_NOT_FOUND);
 
   // remove pTmpClass if any
   nsp_flush();
@@ -1850,6 +2247,25 @@ inline void rc_head::cmd_bindlambda()
     exception(M_ERR_BAD_BIND, M_EXC_SCRIPT);
 }
 
+/**
+ * Suspends the generator's method, handing AX over as the next value.
+ * The method is resumed with the command that follows.
+ */
+inline void rc_head::cmd_yield()
+{
+  // deeper frames would have to be resumed by the C code that called them
+  if(!pGenerator || rCS.length() != 1)
+  {
+    exception(M_ERR_YIELD, M_EXC_SCRIPT);
+    return;
+  }
+
+  if(!rAX)
+    rAX = new_undef();
+
+  mState = M_STATE_PAUSED;
+}
+
 /**
  * Indexes array in AX with SRC.
  * Puts resulting array of objects back into SRC.
@@ -1948,13 +2364,43 @@ void rc_head::cmd_throw()
     rAX = tmp;
   }
 
-  if(rSS.mLength)
+  rc_headstate *zone = rSS.mLength ? (rc_headstate *)rSS.get(rSS.mLength - 1) : NULL;
+  if(zone && zone->mDepth >= mBase)
   {
+    // leave the methods called inside the safe zone
+    rc_var *exc = rAX;
+    rAX = NULL;
+    state_unwind(zone->mDepth);
+    obj_unlink(rAX);
+    rAX = exc;
+
     cmd_clrsrc();
     cmd_pushsrc();
 
+    // the playback steps onto the catch label's first command
     rCS.add(rSS.pop());
     state_load();
+    mOffset--;
+  }
+  else if(zone)
+  {
+    // the safe zone is outside of a native method's callback: the callback is left
+    // and the playback around the native method throws the exception again
+    rc_var *exc = rAX;
+    rAX = NULL;
+    state_unwind(mBase - 1);
+
+    if(rEX)
+      obj_unlink(exc);
+    else
+      rEX = exc;
+
+    mState = M_STATE_UNWIND;
+  }
+  else if(this != pCore->mHead)
+  {
+    // only the thread or pool worker stops, the exception stays in AX for the head waiting for it
+    mState = M_STATE_DEAD;
   }
   else
   {
@@ -1983,7 +2429,7 @@ inline void rc_head::cmd_try()
  */
 inline void rc_head::cmd_tried()
 {
-  rSS.pop();
+  delete (rc_headstate *)rSS.pop();
 }
 
 /**
@@ -2209,7 +2655,6 @@ inline char rc_head::sub_compare(rc_var *left, rc_var *right, bool strict)
  * User classes need to define a 'to_b' method.
  * @param var Variable to be inspected.
  * @return Flag indicating the value is non-empty.
- * @todo implement M_CLASS_DIR, M_CLASS_FILE
  */
 bool rc_head::sub_value(rc_var *var)
 {
@@ -2238,12 +2683,14 @@ bool rc_head::sub_value(rc_var *var)
     case M_CLASS_REGEX:           return (((ic_regex *)obj->mData)->to_b());
     case M_CLASS_ARRAY:           return (((ic_array *)obj->mData)->length() != 0);
     case M_CLASS_FILE:            return (((ic_file *)obj->mData)->exists());
+    case M_CLASS_DIR:             return (((ic_dir *)obj->mData)->exists());
     case M_CLASS_TIME:            return (((ic_time *)obj->mData)->to_b());
     case M_CLASS_MATCH:           return (((ic_match *)obj->mData)->count() > 0);
-
-    // todo
-    case M_CLASS_DIR:             return true;
-    case M_CLASS_SOCKET:          return true;
+    case M_CLASS_REGEXSET:        return (((ic_regexset *)obj->mData)->to_b());
+    case M_CLASS_LAZY:            return (((ic_lazy *)obj->mData)->to_b());
+    case M_CLASS_THREAD:          return (((ic_thread *)obj->mData)->to_b());
+    case M_CLASS_GENERATOR:       return (((ic_generator *)obj->mData)->to_b());
+    case M_CLASS_SOCKET:          return (((ic_socket *)obj->mData)->to_b());
 
     // user classes
     case M_CLASS_OTHER:           tmp = convert_bool(var);
@@ -2261,4 +2708,261 @@ bool rc_head::sub_value(rc_var *var)
 
     default:                      return false;
   }
-}
\ No newline at end of file
+}
+
+/**
+ * Calculates a hash of the variable's value.
+ * Values that are strictly equal have equal hashes. Built-in values are hashed
+ * natively, user classes need to define a '#hash' method returning an int.
+ * @param var Variable to be hashed.
+ * @param hash Pointer to store the hash to.
+ * @return Flag indicating the value can be hashed.
+ */
+bool rc_head::sub_hash(rc_var *var, unsigned long *hash)
+{
+  if(!var) return false;
+
+  ic_object *obj = var_get(var);
+  long value;
+  double fvalue;
+  rc_method *op;
+  rc_var *res;
+
+  switch(pCore->class_type(obj->pClass))
+  {
+    case M_CLASS_BOOL:            value = ((ic_bool *)obj->mData)->mValue ? 1 : 0;
+                                  break;
+    case M_CLASS_INT:             value = ((ic_int *)obj->mData)->mValue;
+                                  break;
+    case M_CLASS_RANGE:           value = ((ic_range *)obj->mData)->length();
+                                  break;
+    case M_CLASS_TIME:            value = (long)((ic_time *)obj->mData)->mTimestamp;
+                                  break;
+
+    case M_CLASS_FLOAT:           fvalue = ((ic_float *)obj->mData)->mValue;
+                                  // NaN equals nothing, while 0.0 and -0.0 are equal
+                                  if(fvalue != fvalue) return false;
+                                  if(fvalue == 0) fvalue = 0;
+                                  *hash = sc_strpool::hash((const char *)&fvalue, sizeof(fvalue));
+                                  return true;
+
+    case M_CLASS_STRING:          *hash = sc_strpool::hash(((ic_string *)obj->mData)->get(), ((ic_string *)obj->mData)->mLength);
+                                  return true;
+
+    // user classes
+    case M_CLASS_OTHER:           op = method_resolve("#hash", obj->pClass);
+                                  if(!op || op->pClass == pCore->mClassCache.pObject) return false;
+
+                                  var->mLinks++;
+                                  method_invoke(op, var);
+                                  if(!rSRC.mLength) return false;
+
+                                  res = rSRC.pop();
+                                  obj = var_get(res);
+                                  if(pCore->class_type(obj->pClass) != M_CLASS_INT)
+                                  {
+                                    obj_unlink(res);
+                                    return false;
+                                  }
+
+                                  value = ((ic_int *)obj->mData)->mValue;
+                                  obj_unlink(res);
+                                  break;
+
+    default:                      return false;
+  }
+
+  *hash = sc_strpool::hash((const char *)&value, sizeof(value));
+  return true;
+}
+
+/**
+ * Calls the method for each item on the pool workers.
+ * Workers get copies of the items and hand back copies of the results, which
+ * are stored in the order of the items, whichever worker has made them.
+ * Heads other than the main one call the method for the items by themselves.
+ * @param method Method to be called.
+ * @param items Array values, NULL to call the method with ints instead.
+ * @param start First int, if there are no items.
+ * @param count Number of items.
+ * @param mode POOL_EACH, POOL_MAP or POOL_SELECT.
+ * @param results Values for POOL_MAP, true for items passing POOL_SELECT, NULL otherwise.
+ * @param tainted Taint of the ints.
+ * @return false if the method has thrown an exception, which is thrown again by this head.
+ */
+bool rc_head::parallel(rc_method *method, rc_var **items, long start, long count, int mode, rc_var **results, bool tainted)
+{
+  if(count <= 0)
+    return true;
+
+  long idx;
+  for(idx=0; idx<count; idx++)
+    results[idx] = NULL;
+
+  // threads and workers might wait for the very pool they are running on
+  if(this != pCore->mHead)
+  {
+    for(idx=0; idx<count; idx++)
+    {
+      rc_var *arg;
+      if(items)
+      {
+        arg = items[idx];
+        arg->mLinks++;
+      }
+      else
+        arg = new_int(start + idx, tainted);
+
+      rSRC.push(arg);
+      method_invoke(method);
+      if(mState != M_STATE_RUN)
+        break;
+
+      results[idx] = parallel_result(rSRC.mLength ? rSRC.pop() : new_undef(), mode);
+      cmd_clrsrc();
+    }
+
+    if(idx == count)
+      return true;
+
+    for(idx=0; idx<count; idx++)
+    {
+      obj_unlink(results[idx]);
+      results[idx] = NULL;
+    }
+
+    return false;
+  }
+
+  parallel_job job;
+  job.pMethod = method;
+  job.mArgs = NULL;
+  job.mStart = start;
+  job.mTainted = tainted;
+  job.mMode = mode;
+  job.mResults = results;
+  job.mFailed = new bool[count];
+  if(!job.mFailed) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  for(idx=0; idx<count; idx++)
+    job.mFailed[idx] = false;
+
+  if(items)
+  {
+    job.mArgs = new rc_var*[count];
+    if(!job.mArgs) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+    for(idx=0; idx<count; idx++)
+      job.mArgs[idx] = obj_copy(items[idx]);
+  }
+
+  pCore->pool()->run(count, parallel_item, &job);
+
+  // items left over after a failure, the first failed item wins
+  long failed = -1;
+  for(idx=0; idx<count; idx++)
+  {
+    if(job.mArgs)
+      obj_unlink(job.mArgs[idx]);
+
+    if(failed < 0 && job.mFailed[idx])
+      failed = idx;
+  }
+
+  delete [] job.mArgs;
+  delete [] job.mFailed;
+
+  if(failed < 0)
+    return true;
+
+  rc_var *exc = results[failed];
+  results[failed] = NULL;
+  for(idx=0; idx<count; idx++)
+  {
+    obj_unlink(results[idx]);
+    results[idx] = NULL;
+  }
+
+  obj_unlink(rAX);
+  rAX = exc;
+  cmd_throw();
+
+  return false;
+}
+
+/**
+ * Calls the method for an item on a pool worker's head.
+ * @param head Worker's head.
+ * @param idx Index of the item.
+ * @param data Job.
+ * @return false if the method has thrown an exception.
+ */
+bool rc_head::parallel_item(rc_head *head, long idx, void *data)
+{
+  parallel_job *job = (parallel_job *)data;
+
+  rc_var *arg;
+  if(job->mArgs)
+  {
+    arg = job->mArgs[idx];
+    job->mArgs[idx] = NULL;
+  }
+  else
+    arg = head->new_int(job->mStart + idx, job->mTainted);
+
+  try
+  {
+    head->rSRC.push(arg);
+    head->method_invoke(job->pMethod);
+
+    if(head->mState != M_STATE_DEAD)
+    {
+      rc_var *res = head->parallel_result(head->rSRC.mLength ? head->rSRC.pop() : head->new_undef(), job->mMode);
+      head->cmd_clrsrc();
+
+      // the worker's head is deleted after the job
+      if(res && job->mMode == POOL_MAP)
+      {
+        job->mResults[idx] = head->obj_copy(res);
+        head->obj_unlink(res);
+      }
+      else
+        job->mResults[idx] = res;
+    }
+
+    // the method or copying the result has failed
+    if(head->mState == M_STATE_DEAD)
+    {
+      head->obj_unlink(job->mResults[idx]);
+      job->mResults[idx] = head->obj_copy(head->rAX);
+      job->mFailed[idx] = true;
+    }
+  }
+  catch(const sc_exception &ex)
+  {
+    rc_var *exc = head->new_exception(ex.mErrorMsg->get(), M_EXC_INTERNAL);
+    head->obj_unlink(job->mResults[idx]);
+    job->mResults[idx] = head->obj_copy(exc);
+    head->obj_unlink(exc);
+    job->mFailed[idx] = true;
+  }
+
+  return !job->mFailed[idx];
+}
+
+/**
+ * Turns the value returned for an item into what is kept for it.
+ * @param res Value returned by the method.
+ * @param mode POOL_EACH, POOL_MAP or POOL_SELECT.
+ * @return The value for POOL_MAP, true for an item passing POOL_SELECT, NULL otherwise.
+ */
+rc_var *rc_head::parallel_result(rc_var *res, int mode)
+{
+  if(mode == POOL_MAP)
+    return res;
+
+  bool pass = mode == POOL_SELECT && sub_value(res);
+  obj_unlink(res);
+
+  return pass ? new_bool(true) : NULL;
+}
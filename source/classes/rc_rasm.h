@@ -521,6 +521,7 @@ int rc_rasm::get_command_code(ic_string *command)
   COMMAND(RETURN)
   COMMAND(NSP)
   COMMAND(BINDLAMBDA)
+  COMMAND(YIELD)
 
   // array-specific actions
   COMMAND(INDEX)
@@ -760,7 +761,8 @@ ic_string *rc_rasm::extract_string_parameter(ic_string *line, int index)
     ERROR(msg, M_EMODE_COMPILE);
   }
 
-  ic_string *string_parameter = raw_parameter->substr_get(1, length - 2);
+  // substr_get() takes zero length as "up to the end"
+  ic_string *string_parameter = length > 2 ? raw_parameter->substr_get(1, length - 2) : new ic_string();
   solve_escape_seq(string_parameter);
 
   delete raw_parameter;
@@ -775,14 +777,10 @@ bool rc_rasm::is_parameter_int(ic_string *line, int index)
   ic_string *parameter = extract_raw_parameter(line, index);
   ic_regex int_regex = ic_regex("/^-?\\d+$/");
   ic_match *match = int_regex.match(parameter);
+  bool result = match->count() > 0;
+  delete match;
   delete parameter;
-  if(match != NULL)
-  {
-    delete match;
-    return true;
-  }
-  else
-    return false;
+  return result;
 }
 
 /**
@@ -793,14 +791,10 @@ bool rc_rasm::is_parameter_float(ic_string *line, int index)
   ic_string *parameter = extract_raw_parameter(line, index);
   ic_regex float_regex = ic_regex("/^-?\\d+\\.\\d+$/");
   ic_match *match = float_regex.match(parameter);
+  bool result = match->count() > 0;
+  delete match;
   delete parameter;
-  if(match != NULL)
-  {
-    delete match;
-    return true;
-  }
-  else
-    return false;
+  return result;
 }
 
 /**
@@ -811,14 +805,10 @@ bool rc_rasm::is_parameter_string(ic_string *line, int index)
   ic_string *parameter = extract_raw_parameter(line, index);
   ic_regex int_regex = ic_regex("/\".*?(?<!\\\\)(?:\\\\\\\\)*\"/");
   ic_match *match = int_regex.match(parameter);
+  bool result = match->count() > 0;
+  delete match;
   delete parameter;
-  if(match != NULL)
-  {
-    delete match;
-    return true;
-  }
-  else
-    return false;
+  return result;
 }
 
 /**
@@ -843,6 +833,9 @@ void rc_rasm::solve_escape_seq(ic_string *string)
       case 'n':
         escaped = '\n';
         break;
+      case 'r':
+        escaped = '\r';
+        break;
       case 't':
         escaped = '\t';
         break;
@@ -876,7 +869,6 @@ void rc_rasm::solve_escape_seq(ic_string *string)
       buff[1] = '\0';
 
       string->substr_set(i, 2, buff);
-      i++;
     }
     else
     {
@@ -18,15 +18,20 @@
 rc_stritem::rc_stritem()
 {
   mLength = 0;
+  mHash = 0;
   mString = NULL;
+  mOwned = false;
+  pObject = NULL;
 }
 
 /**
  * rc_stritem destructor.
+ * Interned strings belong to sc_strpool and are not released.
  */
 rc_stritem::~rc_stritem()
 {
-  delete [] mString;
+  if(mOwned)
+    delete [] mString;
 }
 
 //--------------------------------
@@ -40,8 +45,7 @@ rc_strtable::rc_strtable()
 {
   mLastBuf = mLength = mLastLength = 0;
   mTable.resize(STRTABLE_CHUNK_SIZE);
-  mTable.mPtr[0] = (void *)new rc_stritem[STRTABLE_BUF_SIZE];
-  if(!mTable.mPtr[0]) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  mTable.set(0, (void *)new rc_stritem[STRTABLE_BUF_SIZE]);
 }
 
 /**
@@ -67,19 +71,21 @@ long rc_strtable::add(const char *str, long len)
   if(mLastLength == STRTABLE_BUF_SIZE)
   {
     // need to allocate new chunk
-    if(mLastBuf == mTable.length())
+    if(mLastBuf + 1 == mTable.length())
       mTable.resize(mTable.length() + STRTABLE_CHUNK_SIZE);
 
     mLastBuf++;
     mLastLength = 0;
-    mTable.mPtr[mLastBuf] = new rc_stritem[STRTABLE_BUF_SIZE];
+    mTable.set(mLastBuf, (void *)new rc_stritem[STRTABLE_BUF_SIZE]);
   }
 
+  // equal strings share storage and precomputed hash
+  sc_strpoolitem *interned = sc_strpool::add(str, len);
   rc_stritem *curr = ((rc_stritem *)mTable.mPtr[mLastBuf])+mLastLength;
-  curr->mString = new char[len+1];
-  strncpy(curr->mString, str, len);
-  *(curr->mString + len) = '\0';
+  curr->mString = interned->mString;
   curr->mLength = len;
+  curr->mHash = interned->mHash;
+  curr->mOwned = false;
 
   mLength++;
   mLastLength++;
@@ -112,17 +118,19 @@ long rc_strtable::add_existing(char *str, long len)
   if(mLastLength == STRTABLE_BUF_SIZE)
   {
     // need to allocate new chunk
-    if(mLastBuf == mTable.length())
+    if(mLastBuf + 1 == mTable.length())
       mTable.resize(mTable.length() + STRTABLE_CHUNK_SIZE);
 
     mLastBuf++;
     mLastLength = 0;
-    mTable.mPtr[mLastBuf] = new rc_stritem[STRTABLE_BUF_SIZE];
+    mTable.set(mLastBuf, (void *)new rc_stritem[STRTABLE_BUF_SIZE]);
   }
 
   rc_stritem *curr = ((rc_stritem *)mTable.mPtr[mLastBuf])+mLastLength;
   curr->mString = str;
   curr->mLength = len;
+  curr->mHash = sc_strpool::hash(str, len);
+  curr->mOwned = true;
 
   mLength++;
   mLastLength++;
@@ -137,13 +145,13 @@ long rc_strtable::add_existing(char *str, long len)
  */
 long rc_strtable::find(const char *str)
 {
-  for(long idx = 0; idx < mTable.length(); idx ++)
+  long len = strlen(str);
+  unsigned long hash = sc_strpool::hash(str, len);
+  for(long idx = 0; idx < mLength; idx ++)
   {
-    for(int idx2 = 0; idx2 < (idx == mTable.length()-1 ? mLastLength : STRTABLE_BUF_SIZE); idx2++)
-    {
-      if(!strcmp(str, (((rc_stritem *)mTable.mPtr[idx])[idx2]).mString))
-        return idx*STRTABLE_BUF_SIZE + idx2;
-    }
+    rc_stritem *curr = item(idx);
+    if(curr->mHash == hash && curr->mLength == len && !memcmp(str, curr->mString, len))
+      return idx;
   }
 
   return -1;
@@ -165,14 +173,22 @@ inline long rc_strtable::find(ic_string *str)
 void rc_strtable::clear()
 {
   // clear data
-  for(long idx=0; idx < mTable.length(); idx++)
-    delete [] (rc_cmd*)mTable.mPtr[idx];
+  while(mTable.length())
+    delete [] (rc_stritem *)mTable.pop();
 
   // fill new data
   mLastBuf = mLength = mLastLength = 0;
-  mTable.resize(STRTABLE_CHUNK_SIZE);
-  mTable.mPtr[0] = (void *)new rc_stritem[STRTABLE_BUF_SIZE];
-  if(!mTable.mPtr[0]) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);  
+  mTable.set(0, (void *)new rc_stritem[STRTABLE_BUF_SIZE]);
+}
+
+/**
+ * Returns the item at current index.
+ * @param idx Index of the string in the table.
+ * @return Pointer to item.
+ */
+inline rc_stritem *rc_strtable::item(long idx)
+{
+  return ((rc_stritem *)mTable.mPtr[idx / STRTABLE_BUF_SIZE]) + (idx % STRTABLE_BUF_SIZE);
 }
 
 /**
@@ -183,19 +199,45 @@ void rc_strtable::clear()
 char *rc_strtable::get(long idx)
 {
   if(idx < mLength)
-  {
-    long buf=0;
-    while(idx > STRTABLE_BUF_SIZE)
-    {
-      idx-=STRTABLE_BUF_SIZE;
-      buf++;
-    }
-    return (((rc_stritem *)mTable.mPtr[buf])[idx]).mString;
-  }
+    return item(idx)->mString;
   else
     return NULL;
 }
 
+/**
+ * Returns the precomputed hash of the string at current index.
+ * @param idx Index of the string in the table.
+ * @return Hash of the string.
+ */
+unsigned long rc_strtable::hash(long idx)
+{
+  if(idx < mLength)
+    return item(idx)->mHash;
+  else
+    return 0;
+}
+
+/**
+ * Returns the shared constant object created for the string at current index.
+ * @param idx Index of the string in the table.
+ * @return Pointer to object or NULL if it has not been created yet.
+ */
+inline ic_object *rc_strtable::get_object(long idx)
+{
+  return idx < mLength ? item(idx)->pObject : NULL;
+}
+
+/**
+ * Binds a shared constant object to the string at current index.
+ * @param idx Index of the string in the table.
+ * @param obj Object to be bound.
+ */
+inline void rc_strtable::set_object(long idx, ic_object *obj)
+{
+  if(idx < mLength)
+    item(idx)->pObject = obj;
+}
+
 /**
  * Returns string table length.
  */
@@ -214,34 +256,43 @@ void rc_strtable::file_load(const char *name)
   if(f)
   {
     // clear current table
-    for(long idx=0; idx < mTable.length(); idx++)
-    {
-      if(mTable.mPtr[idx])
-        delete [] (rc_stritem *)(mTable.mPtr[idx]);
-    }
+    while(mTable.length())
+      delete [] (rc_stritem *)mTable.pop();
     mLength = mLastBuf = mLastLength = 0;
 
     // load new table
     fseek(f, 0, SEEK_SET);
     fread(&mLength, sizeof(long), 1, f);
-    mLastBuf = (long)floorf((float)mLength / (float)STRTABLE_BUF_SIZE);
-    mLastLength = mLength % STRTABLE_BUF_SIZE;
-    if(!mLastLength) mLastLength = STRTABLE_BUF_SIZE;
+    // an empty table keeps a single empty buffer, a full last buffer stays the last one
+    mLastBuf = mLength ? (mLength - 1) / STRTABLE_BUF_SIZE : 0;
+    mLastLength = mLength - mLastBuf * STRTABLE_BUF_SIZE;
 
-    // load tape
+    // load strings into the pool through a temporary buffer
+    long buf_size = STR_MIN_CPC;
+    char *buf = new char[buf_size+1];
     mTable.resize(mLastBuf + (STRTABLE_CHUNK_SIZE - mLastBuf % STRTABLE_CHUNK_SIZE));
     for(long idx=0; idx <= mLastBuf; idx++)
     {
-      mTable.mPtr[idx] = new rc_stritem[STRTABLE_BUF_SIZE];
+      mTable.set(idx, (void *)new rc_stritem[STRTABLE_BUF_SIZE]);
       for(int idx2=0; idx2 < STRTABLE_BUF_SIZE; idx2++)
       {
         if(idx == mLastBuf && idx2 == mLastLength) break;
         rc_stritem *curr = ((rc_stritem *)mTable.mPtr[idx])+idx2;
         fread(&(curr->mLength), sizeof(long), 1, f);
-        curr->mString = new char[curr->mLength+1];
-        fread(curr->mString, sizeof(char), curr->mLength+1, f);
+        if(curr->mLength > buf_size)
+        {
+          delete [] buf;
+          buf_size = curr->mLength;
+          buf = new char[buf_size+1];
+        }
+        fread(buf, sizeof(char), curr->mLength+1, f);
+
+        sc_strpoolitem *interned = sc_strpool::add(buf, curr->mLength);
+        curr->mString = interned->mString;
+        curr->mHash = interned->mHash;
       }
     }
+    delete [] buf;
     fclose(f);
   }
   else
@@ -32,7 +32,10 @@ rc_var::rc_var(ic_object *obj)
   //pBaseVar = NULL;
   //pBaseClass = NULL;
   pObj = (void *)obj;
-  obj->mLinks++;
+
+  // shared constants belong to the string table and are used by all heads at once
+  if(!obj->mShared)
+    obj->mLinks++;
 }
 
 /**
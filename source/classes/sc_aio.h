@@ -0,0 +1,744 @@
+/**
+ * @file sc_aio.h
+ * @author impworks.
+ * sc_aio header.
+ * Defines properties and methods of sc_aioreq, sc_aiobatch and sc_aio classes.
+ */
+
+#ifndef SC_AIO_H
+#define SC_AIO_H
+
+#if MALCO_PLATFORM == M_PLATF_NIX
+
+/**
+ * sc_aioreq constructor.
+ * @param op AIO_READ or AIO_WRITE.
+ * @param name File name.
+ */
+sc_aioreq::sc_aioreq(char op, const char *name)
+{
+  mOp = op;
+  mStep = 0;
+
+  mName = new char[strlen(name) + 1];
+  if(!mName) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  strcpy(mName, name);
+
+  mFd = -1;
+  mError = 0;
+  mBuf = NULL;
+  mLength = mCapacity = mDone = mSize = 0;
+
+  pFile = pCallback = NULL;
+  pBatch = NULL;
+  mIndex = 0;
+  pNext = NULL;
+}
+
+/**
+ * sc_aioreq destructor.
+ */
+sc_aioreq::~sc_aioreq()
+{
+  if(mFd >= 0)
+    ::close(mFd);
+
+  delete [] mName;
+  delete [] mBuf;
+}
+
+/**
+ * Makes sure the buffer has room for more data.
+ * @param size Number of bytes to be added.
+ */
+void sc_aioreq::reserve(long size)
+{
+  if(mLength + size <= mCapacity)
+    return;
+
+  long capacity = MAX(mCapacity * 2, mLength + size);
+  char *buf = new char[capacity];
+  if(!buf) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  if(mLength)
+    memcpy(buf, mBuf, mLength);
+
+  delete [] mBuf;
+  mBuf = buf;
+  mCapacity = capacity;
+}
+
+/**
+ * sc_aiobatch constructor.
+ * @param count Number of reads.
+ * @param fx Variable holding the callback, owned by the batch.
+ */
+sc_aiobatch::sc_aiobatch(long count, rc_var *fx)
+{
+  pCallback = fx;
+  mCount = mLeft = count;
+
+  mResults = new rc_var*[count];
+  if(!mResults) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  for(long idx=0; idx<count; idx++)
+    mResults[idx] = NULL;
+}
+
+/**
+ * sc_aiobatch destructor.
+ * The results are passed to the callback by then.
+ */
+sc_aiobatch::~sc_aiobatch()
+{
+  delete [] mResults;
+}
+
+/**
+ * sc_aio constructor.
+ * @param uring io_uring may be used, if the kernel supports it.
+ * @param workers Number of workers otherwise, 0 for four per core.
+ */
+sc_aio::sc_aio(bool uring, int workers)
+{
+  mEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if(mEvent < 0) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  mPending = 0;
+
+  mRing = -1;
+  mEntries = 0;
+  mInRing = 0;
+  mQueued = 0;
+  mSqMap = mCqMap = mSqes = mCqes = NULL;
+  mSqMapLength = mCqMapLength = 0;
+  mSqTail = mSqMask = mSqArray = NULL;
+  mCqHead = mCqTail = mCqMask = NULL;
+  mBacklog = mBacklogEnd = NULL;
+
+  mCount = 0;
+  mThreads = NULL;
+  mStop = false;
+  mQueue = mQueueEnd = NULL;
+  mDone = mDoneEnd = NULL;
+
+  if(uring && ring_open())
+    return;
+
+  // the workers mostly wait for the disk, so there are more of them than cores
+  mCount = workers > 0 ? workers : 4 * (int)std::thread::hardware_concurrency();
+  if(mCount < 1) mCount = 4;
+
+  mThreads = new std::thread[mCount];
+  if(!mThreads) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  for(int idx=0; idx<mCount; idx++)
+    mThreads[idx] = std::thread(&sc_aio::work, this);
+}
+
+/**
+ * sc_aio destructor.
+ * Requests that are still running are left along with the head, which is gone by then.
+ */
+sc_aio::~sc_aio()
+{
+  if(mThreads)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mLock);
+      mStop = true;
+    }
+
+    mWake.notify_all();
+    for(int idx=0; idx<mCount; idx++)
+      mThreads[idx].join();
+
+    delete [] mThreads;
+  }
+
+  ring_close();
+  ::close(mEvent);
+}
+
+/**
+ * Starts a request.
+ * Steps queued in the ring are only submitted by commit(), so that a batch
+ * of requests takes a single system call.
+ * @param req Request, owned by the object until it is delivered.
+ */
+void sc_aio::submit(sc_aioreq *req)
+{
+  mPending++;
+
+  if(mRing >= 0)
+  {
+    // every request in the ring has one step at a time, so neither queue overflows
+    if(mInRing < (long)mEntries)
+    {
+      mInRing++;
+      req->mStep = AIO_STEP_OPEN;
+      ring_push(req);
+    }
+    else
+      enqueue(&mBacklog, &mBacklogEnd, req);
+
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+    enqueue(&mQueue, &mQueueEnd, req);
+  }
+
+  mWake.notify_one();
+}
+
+/**
+ * Submits the steps queued in the ring.
+ */
+void sc_aio::commit()
+{
+#if MALCO_URING
+  while(mQueued)
+  {
+    long done = syscall(__NR_io_uring_enter, mRing, mQueued, 0, 0, NULL, 0);
+    if(done < 0)
+    {
+      if(errno == EINTR)
+        continue;
+
+      // the kernel is short of memory: the steps are submitted along with the next ones
+      break;
+    }
+
+    mQueued -= done;
+  }
+#endif
+}
+
+/**
+ * Runs the callbacks of completed requests.
+ * @param head Head to run the callbacks on.
+ * @return Number of requests completed.
+ */
+long sc_aio::dispatch(rc_head *head)
+{
+  uint64_t count;
+  while(read(mEvent, &count, sizeof(count)) < 0 && errno == EINTR);
+
+  if(mRing >= 0)
+    ring_reap();
+
+  sc_aioreq *req;
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+    req = mDone;
+    mDone = mDoneEnd = NULL;
+  }
+
+  // callbacks may submit requests of their own
+  long handled = 0;
+  while(req)
+  {
+    sc_aioreq *next = req->pNext;
+    mPending--;
+    deliver(head, req);
+    handled++;
+    req = next;
+  }
+
+  return handled;
+}
+
+/**
+ * Returns the descriptor signalled when requests complete.
+ */
+inline int sc_aio::fd()
+{
+  return mEvent;
+}
+
+/**
+ * Returns the number of requests that have not been delivered yet.
+ */
+inline long sc_aio::length()
+{
+  return mPending;
+}
+
+/**
+ * Checks if requests go through io_uring.
+ */
+inline bool sc_aio::uring()
+{
+  return mRing >= 0;
+}
+
+/**
+ * Sets up the ring.
+ * Kernels older than 5.6, or those where io_uring is disabled, leave the requests to the workers.
+ * @return false if the ring cannot be used.
+ */
+bool sc_aio::ring_open()
+{
+#if MALCO_URING
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+
+  mRing = syscall(__NR_io_uring_setup, AIO_RING_ENTRIES, &params);
+  if(mRing < 0)
+  {
+    mRing = -1;
+    return false;
+  }
+
+  mEntries = params.sq_entries;
+  mSqMapLength = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  mCqMapLength = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  if(params.features & IORING_FEAT_SINGLE_MMAP)
+    mSqMapLength = mCqMapLength = MAX(mSqMapLength, mCqMapLength);
+
+  mSqMap = mmap(NULL, mSqMapLength, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_SQ_RING);
+  if(mSqMap == MAP_FAILED)
+    mSqMap = NULL;
+
+  if(params.features & IORING_FEAT_SINGLE_MMAP)
+    mCqMap = mSqMap;
+  else if((mCqMap = mmap(NULL, mCqMapLength, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_CQ_RING)) == MAP_FAILED)
+    mCqMap = NULL;
+
+  mSqes = mmap(NULL, mEntries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_SQES);
+  if(mSqes == MAP_FAILED)
+    mSqes = NULL;
+
+  if(!mSqMap || !mCqMap || !mSqes)
+  {
+    ring_close();
+    return false;
+  }
+
+  char *sq = (char *)mSqMap, *cq = (char *)mCqMap;
+  mSqTail = (unsigned *)(sq + params.sq_off.tail);
+  mSqMask = (unsigned *)(sq + params.sq_off.ring_mask);
+  mSqArray = (unsigned *)(sq + params.sq_off.array);
+  mCqHead = (unsigned *)(cq + params.cq_off.head);
+  mCqTail = (unsigned *)(cq + params.cq_off.tail);
+  mCqMask = (unsigned *)(cq + params.cq_off.ring_mask);
+  mCqes = cq + params.cq_off.cqes;
+
+  // every step of the requests has to be supported
+  long size = sizeof(io_uring_probe) + IORING_OP_LAST * sizeof(io_uring_probe_op);
+  io_uring_probe *probe = (io_uring_probe *)new char[size];
+  if(!probe) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  memset(probe, 0, size);
+
+  const int ops[] = { IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_WRITE, IORING_OP_CLOSE };
+  bool supported = syscall(__NR_io_uring_register, mRing, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) >= 0;
+  for(int idx=0; supported && idx<(int)(sizeof(ops) / sizeof(ops[0])); idx++)
+    supported = ops[idx] <= probe->last_op && probe->ops[ops[idx]].flags & IO_URING_OP_SUPPORTED;
+
+  delete [] (char *)probe;
+
+  if(!supported || syscall(__NR_io_uring_register, mRing, IORING_REGISTER_EVENTFD, &mEvent, 1) < 0)
+  {
+    ring_close();
+    return false;
+  }
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Tears the ring down.
+ */
+void sc_aio::ring_close()
+{
+#if MALCO_URING
+  if(mSqes)
+    munmap(mSqes, mEntries * sizeof(io_uring_sqe));
+  if(mCqMap && mCqMap != mSqMap)
+    munmap(mCqMap, mCqMapLength);
+  if(mSqMap)
+    munmap(mSqMap, mSqMapLength);
+  if(mRing >= 0)
+    ::close(mRing);
+#endif
+
+  mSqes = mCqMap = mSqMap = NULL;
+  mRing = -1;
+}
+
+/**
+ * Queues the current step of a request in the ring.
+ * @param req Request.
+ */
+void sc_aio::ring_push(sc_aioreq *req)
+{
+#if MALCO_URING
+  unsigned tail = *mSqTail;
+  unsigned idx = tail & *mSqMask;
+
+  io_uring_sqe *sqe = (io_uring_sqe *)mSqes + idx;
+  memset(sqe, 0, sizeof(io_uring_sqe));
+  sqe->user_data = (uintptr_t)req;
+
+  switch(req->mStep)
+  {
+    case AIO_STEP_OPEN:
+      sqe->opcode = IORING_OP_OPENAT;
+      sqe->fd = AT_FDCWD;
+      sqe->addr = (uintptr_t)req->mName;
+      sqe->open_flags = (req->mOp == AIO_READ ? O_RDONLY : O_WRONLY | O_CREAT | O_TRUNC) | O_CLOEXEC;
+      sqe->len = 0666;
+      break;
+
+    case AIO_STEP_STAT:
+      sqe->opcode = IORING_OP_STATX;
+      sqe->fd = req->mFd;
+      sqe->addr = (uintptr_t)"";
+      sqe->len = STATX_SIZE;
+      sqe->statx_flags = AT_EMPTY_PATH;
+      sqe->off = (uintptr_t)&req->mStat;
+      break;
+
+    case AIO_STEP_IO:
+      sqe->fd = req->mFd;
+      if(req->mOp == AIO_READ)
+      {
+        sqe->opcode = IORING_OP_READ;
+        sqe->addr = (uintptr_t)(req->mBuf + req->mLength);
+        sqe->len = MIN(req->mCapacity - req->mLength, (long)FILE_COPY_KERNEL);
+        sqe->off = req->mLength;
+      }
+      else
+      {
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->addr = (uintptr_t)(req->mBuf + req->mDone);
+        sqe->len = MIN(req->mLength - req->mDone, (long)FILE_COPY_KERNEL);
+        sqe->off = req->mDone;
+      }
+      break;
+
+    case AIO_STEP_CLOSE:
+      sqe->opcode = IORING_OP_CLOSE;
+      sqe->fd = req->mFd;
+      req->mFd = -1;
+      break;
+  }
+
+  mSqArray[idx] = idx;
+  __atomic_store_n(mSqTail, tail + 1, __ATOMIC_RELEASE);
+  mQueued++;
+#endif
+}
+
+/**
+ * Takes the completions off the ring and queues the next steps.
+ */
+void sc_aio::ring_reap()
+{
+#if MALCO_URING
+  unsigned head = *mCqHead;
+  while(head != __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE))
+  {
+    io_uring_cqe *cqe = (io_uring_cqe *)mCqes + (head & *mCqMask);
+    sc_aioreq *req = (sc_aioreq *)(uintptr_t)cqe->user_data;
+    long result = cqe->res;
+
+    __atomic_store_n(mCqHead, ++head, __ATOMIC_RELEASE);
+    step(req, result);
+  }
+
+  commit();
+#endif
+}
+
+/**
+ * Moves a request of the ring to the next step.
+ * @param req Request.
+ * @param result Result of the step that has completed, -errno on failure.
+ */
+void sc_aio::step(sc_aioreq *req, long result)
+{
+#if MALCO_URING
+  if(req->mStep == AIO_STEP_CLOSE)
+  {
+    // a failed close may mean the written data is lost
+    if(result < 0 && !req->mError)
+      req->mError = -result;
+
+    req->mStep = 0;
+  }
+  else if(result < 0)
+  {
+    req->mError = -result;
+    req->mStep = req->mFd >= 0 ? AIO_STEP_CLOSE : 0;
+  }
+  else switch(req->mStep)
+  {
+    case AIO_STEP_OPEN:
+      req->mFd = result;
+      if(req->mOp == AIO_READ)
+        req->mStep = AIO_STEP_STAT;
+      else
+        req->mStep = req->mLength ? AIO_STEP_IO : AIO_STEP_CLOSE;
+      break;
+
+    case AIO_STEP_STAT:
+      // pseudo-files report no size and are read in chunks
+      req->mSize = req->mStat.stx_size;
+      req->reserve(req->mSize ? req->mSize : FILE_CHUNK);
+      req->mStep = AIO_STEP_IO;
+      break;
+
+    case AIO_STEP_IO:
+      if(req->mOp == AIO_READ)
+      {
+        req->mLength += result;
+        if(!result || req->mSize && req->mLength == req->mSize)
+          req->mStep = AIO_STEP_CLOSE;
+        else
+          req->reserve(FILE_CHUNK);
+      }
+      else
+      {
+        req->mDone += result;
+        if(!result)
+          req->mError = EIO;
+
+        if(!result || req->mDone == req->mLength)
+          req->mStep = AIO_STEP_CLOSE;
+      }
+      break;
+  }
+
+  if(req->mStep)
+  {
+    ring_push(req);
+    return;
+  }
+
+  mInRing--;
+  complete(req);
+
+  if(mBacklog)
+  {
+    sc_aioreq *next = mBacklog;
+    mBacklog = next->pNext;
+    if(!mBacklog)
+      mBacklogEnd = NULL;
+
+    next->pNext = NULL;
+    next->mStep = AIO_STEP_OPEN;
+    mInRing++;
+    ring_push(next);
+  }
+#endif
+}
+
+/**
+ * Adds a request to the completed ones.
+ * @param req Request.
+ */
+void sc_aio::complete(sc_aioreq *req)
+{
+  std::lock_guard<std::mutex> lock(mLock);
+  enqueue(&mDone, &mDoneEnd, req);
+}
+
+/**
+ * Worker body: runs queued requests and signals their completion.
+ */
+void sc_aio::work()
+{
+  while(1)
+  {
+    sc_aioreq *req;
+    {
+      std::unique_lock<std::mutex> lock(mLock);
+      mWake.wait(lock, [this] { return mStop || mQueue; });
+      if(mStop) break;
+
+      req = mQueue;
+      mQueue = req->pNext;
+      if(!mQueue)
+        mQueueEnd = NULL;
+
+      req->pNext = NULL;
+    }
+
+    perform(req);
+    complete(req);
+
+    uint64_t one = 1;
+    while(write(mEvent, &one, sizeof(one)) < 0 && errno == EINTR);
+  }
+}
+
+/**
+ * Runs a request from start to end with blocking calls, on a worker.
+ * @param req Request.
+ */
+void sc_aio::perform(sc_aioreq *req)
+{
+  int flags = (req->mOp == AIO_READ ? O_RDONLY : O_WRONLY | O_CREAT | O_TRUNC) | O_CLOEXEC;
+  while((req->mFd = open(req->mName, flags, 0666)) < 0 && errno == EINTR);
+  if(req->mFd < 0)
+  {
+    req->mError = errno;
+    return;
+  }
+
+  if(req->mOp == AIO_READ)
+  {
+    struct stat info;
+    req->mSize = fstat(req->mFd, &info) ? 0 : info.st_size;
+    req->reserve(req->mSize ? req->mSize : FILE_CHUNK);
+
+    while(true)
+    {
+      ssize_t len = pread(req->mFd, req->mBuf + req->mLength, req->mCapacity - req->mLength, req->mLength);
+      if(len < 0)
+      {
+        if(errno == EINTR)
+          continue;
+
+        req->mError = errno;
+        break;
+      }
+
+      req->mLength += len;
+      if(!len || req->mSize && req->mLength == req->mSize)
+        break;
+
+      req->reserve(FILE_CHUNK);
+    }
+  }
+  else
+  {
+    while(req->mDone < req->mLength)
+    {
+      ssize_t len = pwrite(req->mFd, req->mBuf + req->mDone, req->mLength - req->mDone, req->mDone);
+      if(len < 0)
+      {
+        if(errno == EINTR)
+          continue;
+
+        req->mError = errno;
+        break;
+      }
+
+      req->mDone += len;
+    }
+  }
+
+  if(::close(req->mFd) && !req->mError)
+    req->mError = errno;
+
+  req->mFd = -1;
+}
+
+/**
+ * Passes the result of a request to it's callback and deletes the request.
+ * The callback gets the contents of the file read, or true once the data has
+ * been written, and false if the operation has failed. Reads of a batch are
+ * kept until the last of them completes.
+ * @param head Head to run the callback on.
+ * @param req Request.
+ */
+void sc_aio::deliver(rc_head *head, sc_aioreq *req)
+{
+  rc_var *result;
+  if(req->mError)
+    result = head->new_bool(false);
+  else if(req->mOp == AIO_WRITE)
+    result = head->new_bool(true);
+  else
+  {
+    ic_string *str = new ic_string(req->mLength);
+    if(!str) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+    if(req->mLength) str->append(req->mBuf, req->mLength);
+
+    // the variable holds the only link, so the contents go away along with it
+    result = head->new_string(str, true);
+    head->obj_unlink(result->get());
+  }
+
+  sc_aiobatch *batch = req->pBatch;
+  if(!batch)
+    call(head, req->pCallback, result, req->pFile);
+  else
+  {
+    batch->mResults[req->mIndex] = result;
+    if(!--batch->mLeft)
+    {
+      ic_array *arr = new ic_array();
+      if(!arr) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+      for(long idx=0; idx<batch->mCount; idx++)
+        arr->append(batch->mResults[idx], false);
+
+      rc_var *var = head->new_array(arr, true);
+      head->obj_unlink(var->get());
+      call(head, batch->pCallback, var, NULL);
+      delete batch;
+    }
+  }
+
+  delete req;
+}
+
+/**
+ * Calls a callback and releases the variables of a request.
+ * Once a callback has thrown an exception, the rest are not called.
+ * @param head Head to run the callback on.
+ * @param fx Variable holding the method, may be NULL.
+ * @param arg Result, passed to the callback.
+ * @param file Variable holding the file, passed after the result if it's not NULL.
+ */
+void sc_aio::call(rc_head *head, rc_var *fx, rc_var *arg, rc_var *file)
+{
+  if(fx && head->mState == M_STATE_RUN)
+  {
+    head->rSRC.push(arg);
+    if(file)
+    {
+      file->mLinks++;
+      head->rSRC.push(file);
+    }
+
+    head->method_invoke((rc_method *)fx->get()->mData);
+    head->cmd_clrsrc();
+  }
+  else
+    head->obj_unlink(arg);
+
+  if(fx)
+    head->obj_unlink(fx);
+  if(file)
+    head->obj_unlink(file);
+}
+
+/**
+ * Appends a request to a queue.
+ * @param first First request of the queue.
+ * @param last Last request of the queue.
+ * @param req Request.
+ */
+void sc_aio::enqueue(sc_aioreq **first, sc_aioreq **last, sc_aioreq *req)
+{
+  req->pNext = NULL;
+  if(*last)
+    (*last)->pNext = req;
+  else
+    *first = req;
+
+  *last = req;
+}
+
+#endif
+
+#endif
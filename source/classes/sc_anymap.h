@@ -1,13 +0,0 @@
-/**
- * @file sc_anymap.h
- * @author impworks.
- * sc_anymap and sc_anymapitem header.
- * Defines properties and methods of sc_anymap and sc_anymapitem classes.
- */
-
-#ifndef SC_ANYMAP_H
-#define SC_ANYMAP_H
-
-
-
-#endif
\ No newline at end of file
@@ -0,0 +1,395 @@
+/**
+ * @file sc_fcgiconn.h
+ * @author impworks.
+ * sc_fcgiconn header.
+ * Defines properties and methods of sc_fcgiconn class.
+ */
+
+#ifndef SC_FCGICONN_H
+#define SC_FCGICONN_H
+
+#if MALCO_PLATFORM == M_PLATF_NIX
+
+/**
+ * sc_fcgiconn constructor.
+ * @param fd Connection descriptor, closed by the server.
+ */
+sc_fcgiconn::sc_fcgiconn(int fd)
+{
+  mFd = fd;
+  mFailed = false;
+
+  mInput = mOutput = NULL;
+  mInputLength = mInputPos = mInputCapacity = 0;
+  mOutputLength = mOutputCapacity = 0;
+}
+
+/**
+ * sc_fcgiconn destructor.
+ * Requests that have not been completed are dropped.
+ */
+sc_fcgiconn::~sc_fcgiconn()
+{
+  for(long idx = 0; idx < mRequests.length(); idx++)
+    delete (sc_fcgirequest *)mRequests[idx];
+
+  delete [] mInput;
+  delete [] mOutput;
+}
+
+/**
+ * Reads records until one of the requests is complete.
+ * Records of the other requests are kept by them, so requests sent over
+ * the same connection may be interleaved in any way.
+ * @param timeout Milliseconds to wait for the web server.
+ * @param max_body Largest body accepted, in bytes.
+ * @return Request to be played, or NULL if the connection is over.
+ */
+sc_fcgirequest *sc_fcgiconn::receive(long timeout, long max_body)
+{
+  while(!mFailed)
+  {
+    while(mInputLength - mInputPos >= FCGI_HEADER_LEN)
+    {
+      unsigned char *head = (unsigned char *)mInput + mInputPos;
+      if(head[0] != FCGI_VERSION)
+      {
+        mFailed = true;
+        return NULL;
+      }
+
+      int type = head[1];
+      int id = head[2] << 8 | head[3];
+      long size = head[4] << 8 | head[5];
+      long total = FCGI_HEADER_LEN + size + head[6];
+      if(mInputLength - mInputPos < total)
+        break;
+
+      mInputPos += total;
+      if(!dispatch(type, id, (char *)head + FCGI_HEADER_LEN, size, max_body))
+      {
+        mFailed = true;
+        return NULL;
+      }
+
+      sc_fcgirequest *req = find(id);
+      if(req && req->ready())
+        return mOutputLength && !send() ? NULL : req;
+    }
+
+    // answers to management records go out before waiting
+    if(mOutputLength && !send())
+      return NULL;
+
+    if(!fill(timeout))
+      return NULL;
+  }
+
+  return NULL;
+}
+
+/**
+ * Handles a record.
+ * @param type Record type.
+ * @param id Request ID, 0 for management records.
+ * @param data Record content.
+ * @param size Length of the content.
+ * @param max_body Largest body accepted, in bytes.
+ * @return false if the web server has broken the protocol.
+ */
+bool sc_fcgiconn::dispatch(int type, int id, const char *data, long size, long max_body)
+{
+  sc_fcgirequest *req = id ? find(id) : NULL;
+
+  switch(type)
+  {
+    case FCGI_BEGIN_REQUEST:
+    {
+      if(!id || req || size < 8)
+        return false;
+
+      int role = (unsigned char)data[0] << 8 | (unsigned char)data[1];
+      if(role != FCGI_RESPONDER)
+      {
+        end(id, FCGI_UNKNOWN_ROLE);
+        return true;
+      }
+
+      req = new sc_fcgirequest(this, id, data[2] & FCGI_KEEP_CONN);
+      if(!req) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+      mRequests.add(req);
+      return true;
+    }
+
+    case FCGI_ABORT_REQUEST:
+      if(req)
+      {
+        end(id, FCGI_REQUEST_COMPLETE);
+        forget(req);
+      }
+      return true;
+
+    case FCGI_PARAMS:
+      if(req)
+        req->params(data, size);
+      return true;
+
+    case FCGI_STDIN:
+      if(req)
+        req->input(data, size, max_body);
+      return true;
+
+    case FCGI_GET_VALUES:
+      if(!id)
+        values(data, size);
+      return true;
+  }
+
+  // the web server may ask for record types of later versions
+  if(!id)
+  {
+    char body[8] = { (char)type, 0, 0, 0, 0, 0, 0, 0 };
+    record(FCGI_UNKNOWN_TYPE, 0, body, 8);
+  }
+
+  return true;
+}
+
+/**
+ * Answers the web server's question about the limits of the application.
+ * @param data Names asked for, as name-value pairs with empty values.
+ * @param size Length of the data.
+ */
+void sc_fcgiconn::values(const char *data, long size)
+{
+  char result[64];
+  long length = 0;
+
+  long name_len, value_len, used;
+  while(size > 0 && (used = pair(data, size, &name_len, &value_len)) > 0)
+  {
+    const char *name = data + used - name_len - value_len;
+    if(name_len == 15 && !memcmp(name, "FCGI_MPXS_CONNS", 15))
+    {
+      result[length++] = 15;
+      result[length++] = 1;
+      memcpy(result + length, "FCGI_MPXS_CONNS1", 16);
+      length += 16;
+    }
+
+    data += used;
+    size -= used;
+  }
+
+  record(FCGI_GET_VALUES_RESULT, 0, result, length);
+}
+
+/**
+ * Reads a name-value pair.
+ * Lengths take one byte below 128 and four bytes with the top bit set otherwise.
+ * @param data Pairs.
+ * @param size Length of the data.
+ * @param[out] name_len Length of the name.
+ * @param[out] value_len Length of the value.
+ * @return Number of bytes taken by the pair, the name and the value being
+ * the last bytes of it, or -1 if the pair is cut short.
+ */
+long sc_fcgiconn::pair(const char *data, long size, long *name_len, long *value_len)
+{
+  const unsigned char *buf = (const unsigned char *)data;
+  long pos = 0;
+  long *lens[2] = { name_len, value_len };
+
+  for(int idx = 0; idx < 2; idx++)
+  {
+    if(pos >= size)
+      return -1;
+
+    if(buf[pos] < 128)
+      *lens[idx] = buf[pos++];
+    else
+    {
+      if(pos + 4 > size)
+        return -1;
+
+      *lens[idx] = (long)(buf[pos] & 0x7F) << 24 | buf[pos+1] << 16 | buf[pos+2] << 8 | buf[pos+3];
+      pos += 4;
+    }
+  }
+
+  if(*name_len > size - pos || *value_len > size - pos - *name_len)
+    return -1;
+
+  return pos + *name_len + *value_len;
+}
+
+/**
+ * Adds records of a stream to the output.
+ * The data is split into records as long as needed; empty data makes a
+ * single empty record, which ends the stream.
+ * @param type Record type.
+ * @param id Request ID.
+ * @param data Content.
+ * @param size Length of the content.
+ */
+void sc_fcgiconn::record(int type, int id, const char *data, long size)
+{
+  do
+  {
+    long length = MIN(size, FCGI_MAX_CONTENT);
+    int padding = (8 - length % 8) % 8;
+
+    reserve(&mOutput, &mOutputCapacity, mOutputLength, FCGI_HEADER_LEN + length + padding);
+
+    unsigned char *head = (unsigned char *)mOutput + mOutputLength;
+    head[0] = FCGI_VERSION;
+    head[1] = type;
+    head[2] = id >> 8;
+    head[3] = id & 0xFF;
+    head[4] = length >> 8;
+    head[5] = length & 0xFF;
+    head[6] = padding;
+    head[7] = 0;
+
+    if(length)
+      memcpy(head + FCGI_HEADER_LEN, data, length);
+    memset(head + FCGI_HEADER_LEN + length, 0, padding);
+
+    mOutputLength += FCGI_HEADER_LEN + length + padding;
+    data += length;
+    size -= length;
+  }
+  while(size > 0);
+}
+
+/**
+ * Adds the record ending a request to the output.
+ * @param id Request ID.
+ * @param protocol_status FCGI_REQUEST_COMPLETE or the reason the request has been refused.
+ */
+void sc_fcgiconn::end(int id, int protocol_status)
+{
+  char body[8] = { 0, 0, 0, 0, (char)protocol_status, 0, 0, 0 };
+  record(FCGI_END_REQUEST, id, body, 8);
+}
+
+/**
+ * Sends the output.
+ * @return false if the connection has failed.
+ */
+bool sc_fcgiconn::send()
+{
+  long pos = 0;
+  while(pos < mOutputLength && !mFailed)
+  {
+    ssize_t len = ::send(mFd, mOutput + pos, mOutputLength - pos, MSG_NOSIGNAL);
+    if(len < 0)
+    {
+      if(errno != EINTR)
+        mFailed = true;
+
+      continue;
+    }
+
+    pos += len;
+  }
+
+  mOutputLength = 0;
+  return !mFailed;
+}
+
+/**
+ * Drops a request that has been answered or aborted.
+ * @param req Request.
+ */
+void sc_fcgiconn::forget(sc_fcgirequest *req)
+{
+  for(long idx = 0; idx < mRequests.length(); idx++)
+    if(mRequests[idx] == req)
+    {
+      mRequests.del(idx);
+      break;
+    }
+
+  delete req;
+}
+
+/**
+ * Finds a request being received.
+ * @param id Request ID.
+ * @return Request or NULL.
+ */
+sc_fcgirequest *sc_fcgiconn::find(int id)
+{
+  for(long idx = 0; idx < mRequests.length(); idx++)
+    if(((sc_fcgirequest *)mRequests[idx])->mId == id)
+      return (sc_fcgirequest *)mRequests[idx];
+
+  return NULL;
+}
+
+/**
+ * Waits for data from the web server and appends it to the input.
+ * Records that have been handled are dropped first.
+ * @param timeout Milliseconds to wait.
+ * @return false if the web server has closed the connection, failed or kept silent.
+ */
+bool sc_fcgiconn::fill(long timeout)
+{
+  if(mInputPos)
+  {
+    memmove(mInput, mInput + mInputPos, mInputLength - mInputPos);
+    mInputLength -= mInputPos;
+    mInputPos = 0;
+  }
+
+  pollfd watch;
+  watch.fd = mFd;
+  watch.events = POLLIN;
+
+  int ready;
+  while((ready = poll(&watch, 1, timeout)) < 0 && errno == EINTR);
+  if(ready <= 0)
+    return false;
+
+  reserve(&mInput, &mInputCapacity, mInputLength, SOCKET_CHUNK);
+
+  ssize_t len;
+  while((len = ::recv(mFd, mInput + mInputLength, mInputCapacity - mInputLength, 0)) < 0 && errno == EINTR);
+  if(len <= 0)
+    return false;
+
+  mInputLength += len;
+  return true;
+}
+
+/**
+ * Makes sure a buffer has room for more data.
+ * @param buf Buffer, replaced if it has to grow.
+ * @param capacity Size of the buffer.
+ * @param length Number of bytes used.
+ * @param size Number of bytes to be added.
+ */
+void sc_fcgiconn::reserve(char **buf, long *capacity, long length, long size)
+{
+  if(length + size <= *capacity)
+    return;
+
+  long new_capacity = MAX(*capacity, (long)SOCKET_CHUNK);
+  while(new_capacity < length + size)
+    new_capacity <<= 1;
+
+  char *new_buf = new char[new_capacity];
+  if(!new_buf) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  if(length)
+    memcpy(new_buf, *buf, length);
+
+  delete [] *buf;
+  *buf = new_buf;
+  *capacity = new_capacity;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,239 @@
+/**
+ * @file sc_fcgirequest.h
+ * @author impworks.
+ * sc_fcgirequest header.
+ * Defines properties and methods of sc_fcgirequest class.
+ */
+
+#ifndef SC_FCGIREQUEST_H
+#define SC_FCGIREQUEST_H
+
+#if MALCO_PLATFORM == M_PLATF_NIX
+
+/**
+ * sc_fcgirequest constructor.
+ * @param conn Connection the request came from.
+ * @param id FastCGI request ID.
+ * @param keep The web server keeps the connection open after the response.
+ */
+sc_fcgirequest::sc_fcgirequest(sc_fcgiconn *conn, int id, bool keep)
+{
+  pConn = conn;
+  mId = id;
+  mCode = 0;
+  mKeepConn = keep;
+  mParamsDone = mInputDone = false;
+
+  mParams = NULL;
+  mParamsLength = mParamsCapacity = 0;
+}
+
+/**
+ * sc_fcgirequest destructor.
+ */
+sc_fcgirequest::~sc_fcgirequest()
+{
+  delete [] mParams;
+}
+
+/**
+ * Takes a record of the FCGI_PARAMS stream.
+ * Pairs may be split between records, so they are parsed once the stream ends.
+ * @param data Record content.
+ * @param size Length of the content, 0 at the end of the stream.
+ */
+void sc_fcgirequest::params(const char *data, long size)
+{
+  if(mParamsDone)
+    return;
+
+  if(!size)
+  {
+    mParamsDone = true;
+    if(!mCode && !parse_params())
+      mCode = 400;
+
+    return;
+  }
+
+  if(mParamsLength + size > FCGI_MAX_PARAMS)
+    mCode = 431;
+  else if(!mCode)
+  {
+    sc_fcgiconn::reserve(&mParams, &mParamsCapacity, mParamsLength, size);
+    memcpy(mParams + mParamsLength, data, size);
+    mParamsLength += size;
+  }
+}
+
+/**
+ * Parses the FCGI_PARAMS stream into server variables, query parameters and cookies.
+ * @return false if the stream is malformed.
+ */
+bool sc_fcgirequest::parse_params()
+{
+  long size = mParamsLength;
+  char *data = mParams;
+
+  long name_len, value_len, used;
+  while(size > 0)
+  {
+    if((used = sc_fcgiconn::pair(data, size, &name_len, &value_len)) < 0)
+      return false;
+
+    char *name = data + used - name_len - value_len;
+    if(name_len)
+    {
+      ic_string key(name, name_len);
+      ic_string value;
+      if(value_len)
+        value.set(name + name_len, value_len);
+
+      mServer.set(key.get(), &value);
+    }
+
+    data += used;
+    size -= used;
+  }
+
+  char *query = mServer.get("QUERY_STRING");
+  if(query)
+    parse_query(&mGet, query, strlen(query));
+
+  char *cookies = mServer.get("HTTP_COOKIE");
+  if(cookies)
+  {
+    ic_string copy(cookies);
+    parse_cookies(copy.get());
+  }
+
+  char *method = mServer.get("REQUEST_METHOD");
+  mNoBody = method && !strcmp(method, "HEAD");
+  return true;
+}
+
+/**
+ * Takes a record of the FCGI_STDIN stream.
+ * @param data Record content.
+ * @param size Length of the content, 0 at the end of the stream.
+ * @param max_body Largest body accepted, in bytes.
+ */
+void sc_fcgirequest::input(const char *data, long size, long max_body)
+{
+  if(mInputDone)
+    return;
+
+  if(!size)
+  {
+    mInputDone = true;
+    if(!mCode)
+      parse_body();
+
+    return;
+  }
+
+  if(mCode)
+    return;
+
+  if(mBody->length() + size > max_body)
+  {
+    mCode = 413;
+    mBody->empty();
+  }
+  else
+    mBody->append(data, size);
+}
+
+/**
+ * Checks if both input streams have ended.
+ * @return Flag indicating the request can be played.
+ */
+bool sc_fcgirequest::ready()
+{
+  return mParamsDone && mInputDone;
+}
+
+/**
+ * Sends what has been written so far.
+ */
+void sc_fcgirequest::flush()
+{
+  if(mFailed)
+    return;
+
+  if(!mSent)
+  {
+    ic_string head;
+    send_head(&head, -1);
+    pConn->record(FCGI_STDOUT, mId, head.get(), head.length());
+  }
+
+  if(mOutput->length() && !mNoBody)
+    pConn->record(FCGI_STDOUT, mId, mOutput->get(), mOutput->length());
+
+  mOutput->empty();
+  if(!pConn->send())
+    mFailed = true;
+}
+
+/**
+ * Sends the rest of the response and ends the request.
+ * A response that has failed half way is not ended, the connection is
+ * abandoned instead so that the web server sees it is incomplete.
+ * @return Flag indicating the connection can be used for the next request.
+ */
+bool sc_fcgirequest::finish()
+{
+  if(mFailed)
+    return false;
+
+  if(!mSent)
+  {
+    ic_string head;
+    send_head(&head, mOutput->length());
+    pConn->record(FCGI_STDOUT, mId, head.get(), head.length());
+  }
+
+  if(mOutput->length() && !mNoBody)
+    pConn->record(FCGI_STDOUT, mId, mOutput->get(), mOutput->length());
+
+  mOutput->empty();
+  pConn->record(FCGI_STDOUT, mId, NULL, 0);
+  pConn->end(mId, FCGI_REQUEST_COMPLETE);
+
+  return pConn->send() && mKeepConn;
+}
+
+/**
+ * Builds the response headers in the CGI format.
+ * @param[out] head String to put the headers to.
+ * @param length Length of the body, -1 if it is not known.
+ */
+void sc_fcgirequest::send_head(ic_string *head, long length)
+{
+  char line[NUMBER_BUF_SIZE * 2];
+
+  sprintf(line, "Status: %d ", mStatus);
+  head->append(line);
+  head->append(reason(mStatus));
+  head->append("\r\n");
+
+  if(!mTyped)
+    head->append("Content-Type: text/html; charset=utf-8\r\n");
+
+  if(length >= 0)
+  {
+    sprintf(line, "Content-Length: %ld\r\n", length);
+    head->append(line);
+  }
+
+  if(mHeaders->length())
+    head->append(mHeaders);
+
+  head->append("\r\n");
+  mSent = true;
+}
+
+#endif
+
+#endif
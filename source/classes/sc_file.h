@@ -8,7 +8,7 @@
 #ifndef SC_FILE_H
 #define SC_FILE_H
 
-char sc_file::mStrBuf[16] = "               ";
+thread_local char sc_file::mStrBuf[16] = "               ";
 
 /**
  * Determines file's modification time.
@@ -95,6 +95,115 @@ inline bool sc_file::remove(ic_string *name)
   return (remove(name->get()) == 0);
 }
 
+/**
+ * Copies a file, keeping it's permissions.
+ * On Unix the data does not pass through the process where the kernel can
+ * avoid it: copy_file_range lets the filesystem clone or copy the blocks
+ * itself, sendfile moves pages between files of different filesystems and
+ * a read and write loop over a large buffer is left for everything else.
+ * @param from Name of the file.
+ * @param to Name of the copy, replaced if it exists.
+ * @return Flag indicating success of the operation.
+ */
+bool sc_file::copy(const char *from, const char *to)
+{
+#if MALCO_PLATFORM == M_PLATF_NIX
+  int in = open(from, O_RDONLY | O_CLOEXEC);
+  if(in < 0)
+    return false;
+
+  // truncating the copy would destroy a source of the same name
+  struct stat info, dest;
+  if(fstat(in, &info) || S_ISDIR(info.st_mode)
+  || !stat(to, &dest) && dest.st_dev == info.st_dev && dest.st_ino == info.st_ino)
+  {
+    close(in);
+    return false;
+  }
+
+  int out = open(to, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, info.st_mode & 07777);
+  if(out < 0)
+  {
+    close(in);
+    return false;
+  }
+
+  // every way is dropped once it fails before moving any data, and so are the
+  // kernel ways that find nothing at once: pseudo-files report a zero size
+  int way = 0;
+  bool moved = false, result = true;
+  char *buf = NULL;
+  while(true)
+  {
+    ssize_t len;
+    if(way == 0)
+      len = copy_file_range(in, NULL, out, NULL, FILE_COPY_KERNEL, 0);
+    else if(way == 1)
+      len = sendfile(out, in, NULL, FILE_COPY_KERNEL);
+    else
+    {
+      if(!buf)
+      {
+        buf = new char[FILE_COPY_BUF];
+        if(!buf) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+        posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+      }
+
+      len = read(in, buf, FILE_COPY_BUF);
+      for(ssize_t pos = 0, done; len > 0 && pos < len; pos += done)
+      {
+        while((done = write(out, buf + pos, len - pos)) < 0 && errno == EINTR);
+        if(done < 0)
+        {
+          len = -1;
+          break;
+        }
+      }
+    }
+
+    if(len > 0)
+      moved = true;
+    else if(len < 0 && errno == EINTR)
+      continue;
+    else if(way < 2 && !moved)
+      way++;
+    else
+    {
+      result = len == 0;
+      break;
+    }
+  }
+
+  delete [] buf;
+  close(in);
+  return !close(out) && result;
+#else
+  FILE *in = fopen(from, "rb");
+  if(!in)
+    return false;
+
+  FILE *out = fopen(to, "wb");
+  if(!out)
+  {
+    fclose(in);
+    return false;
+  }
+
+  char *buf = new char[FILE_COPY_BUF];
+  if(!buf) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  size_t len;
+  bool result = true;
+  while(result && (len = fread(buf, 1, FILE_COPY_BUF, in)) > 0)
+    result = fwrite(buf, 1, len, out) == len;
+
+  result = result && !ferror(in);
+  delete [] buf;
+  fclose(in);
+  return !fclose(out) && result;
+#endif
+}
+
 /**
  * Calculates a checksum from the file name and it's last modification date.
  * @param name Name of the file.
@@ -0,0 +1,619 @@
+/**
+ * @file sc_hashmap.h
+ * @author impworks.
+ * sc_hashmap and sc_hashmapitem header.
+ * Defines properties and methods of sc_hashmap and sc_hashmapitem classes.
+ */
+
+#ifndef SC_HASHMAP_H
+#define SC_HASHMAP_H
+
+//--------------------------------
+//  sc_hashmapitem
+//--------------------------------
+
+/**
+ * sc_hashmapitem constructor.
+ * @param key Item key.
+ * @param val Item value.
+ * @param hash Precomputed key hash.
+ */
+template <typename T>
+sc_hashmapitem<T>::sc_hashmapitem(const char *key, T val, unsigned long hash)
+{
+  mKey = new ic_string(key);
+  if(!mKey) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  mValue = val;
+  mHash = hash;
+  mIndex = -1;
+}
+
+/**
+ * sc_hashmapitem destructor.
+ */
+template <typename T>
+sc_hashmapitem<T>::~sc_hashmapitem()
+{
+  delete mKey;
+}
+
+//--------------------------------
+//  sc_hashmap
+//--------------------------------
+
+/**
+ * sc_hashmap constructor.
+ * The table itself is only allocated with the first item.
+ */
+template <typename T>
+sc_hashmap<T>::sc_hashmap()
+{
+  mCtrl = NULL;
+  mSlots = NULL;
+  mCapacity = 0;
+  mUsed = 0;
+  mItems = NULL;
+  mNumItems = 0;
+  mItemsSize = 0;
+  mFirst = 0;
+  mLength = 0;
+  mCurr = 0;
+}
+
+/**
+ * sc_hashmap copy constructor.
+ * @param map sc_hashmap to copy.
+ */
+template <typename T>
+sc_hashmap<T>::sc_hashmap(sc_hashmap &map)
+{
+  mCtrl = NULL;
+  mSlots = NULL;
+  mCapacity = 0;
+  mUsed = 0;
+  mItems = NULL;
+  mNumItems = 0;
+  mItemsSize = 0;
+  mFirst = 0;
+  mLength = 0;
+  mCurr = 0;
+
+  // walk the items directly, so that the other map's iteration is not disturbed
+  for(long idx=map.mFirst; idx<map.mNumItems; idx++)
+  {
+    sc_hashmapitem<T> *item = map.mItems[idx];
+    if(item) set(item->mKey->get(), item->mHash, item->mValue);
+  }
+}
+
+/**
+ * sc_hashmap destructor.
+ */
+template <typename T>
+sc_hashmap<T>::~sc_hashmap()
+{
+  clear();
+}
+
+/**
+ * Returns the control byte for a hash: it's top 7 bits.
+ * @param hash Key hash.
+ */
+template <typename T>
+inline unsigned char sc_hashmap<T>::ctrl_byte(unsigned long hash)
+{
+  return (unsigned char)(hash >> (sizeof(unsigned long) * 8 - 7));
+}
+
+/**
+ * Compares all control bytes of the group to a value.
+ * @param group First control byte of the group.
+ * @param ctrl Value to look for.
+ * @return Bit mask of the matching slots.
+ */
+template <typename T>
+inline unsigned int sc_hashmap<T>::group_match(const unsigned char *group, unsigned char ctrl)
+{
+#if MALCO_SSE2 == 1
+  __m128i bytes = _mm_loadu_si128((const __m128i *)group);
+  return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8((char)ctrl)));
+#else
+  unsigned int mask = 0;
+  for(int idx=0; idx<HASHMAP_GROUP; idx++)
+    if(group[idx] == ctrl) mask |= 1u << idx;
+  return mask;
+#endif
+}
+
+/**
+ * Finds the slots of the group that are either empty or deleted.
+ * Both have the high bit set, while full slots never do.
+ * @param group First control byte of the group.
+ * @return Bit mask of the free slots.
+ */
+template <typename T>
+inline unsigned int sc_hashmap<T>::group_free(const unsigned char *group)
+{
+#if MALCO_SSE2 == 1
+  return (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+#else
+  unsigned int mask = 0;
+  for(int idx=0; idx<HASHMAP_GROUP; idx++)
+    if(group[idx] & 0x80) mask |= 1u << idx;
+  return mask;
+#endif
+}
+
+/**
+ * Returns the number of the lowest set bit.
+ * @param mask Bit mask, must not be zero.
+ */
+template <typename T>
+inline int sc_hashmap<T>::bit_first(unsigned int mask)
+{
+#if defined(__GNUC__)
+  return __builtin_ctz(mask);
+#else
+  int idx = 0;
+  while(!(mask & 1))
+  {
+    mask >>= 1;
+    idx++;
+  }
+  return idx;
+#endif
+}
+
+/**
+ * Looks for the slot holding the key.
+ * Groups are probed with growing steps, which visits every group of the table.
+ * @param key Key to be searched for.
+ * @param hash Precomputed key hash.
+ * @return Slot index or -1 if there is no such key.
+ */
+template <typename T>
+long sc_hashmap<T>::slot_find(const char *key, unsigned long hash)
+{
+  if(!mCapacity) return -1;
+
+  unsigned char ctrl = ctrl_byte(hash);
+  long mask = mCapacity / HASHMAP_GROUP - 1;
+  long group = (long)(hash & mask);
+  for(long step=1; step<=mask+1; step++)
+  {
+    unsigned char *curr = mCtrl + group * HASHMAP_GROUP;
+    for(unsigned int match = group_match(curr, ctrl); match; match &= match - 1)
+    {
+      long slot = group * HASHMAP_GROUP + bit_first(match);
+      sc_hashmapitem<T> *item = mSlots[slot];
+      if(item->mHash == hash && !item->mKey->compare(key))
+        return slot;
+    }
+
+    // the key would have been put into this group if it existed
+    if(group_match(curr, HASHMAP_EMPTY)) return -1;
+    group = (group + step) & mask;
+  }
+
+  return -1;
+}
+
+/**
+ * Looks for a slot to put a new key into.
+ * The table must have room for it.
+ * @param hash Key hash.
+ * @return Slot index.
+ */
+template <typename T>
+long sc_hashmap<T>::slot_free(unsigned long hash)
+{
+  long mask = mCapacity / HASHMAP_GROUP - 1;
+  long group = (long)(hash & mask);
+  for(long step=1; ; step++)
+  {
+    unsigned int free = group_free(mCtrl + group * HASHMAP_GROUP);
+    if(free) return group * HASHMAP_GROUP + bit_first(free);
+    group = (group + step) & mask;
+  }
+}
+
+/**
+ * Puts a new item into the table and to the end of the insertion order.
+ * The key must not be in the map yet.
+ * @param item Item to be inserted.
+ */
+template <typename T>
+void sc_hashmap<T>::insert(sc_hashmapitem<T> *item)
+{
+  // deleted slots count as used, so the table is rebuilt either
+  // at the same size to clean them up, or twice as large
+  if(mUsed + 1 > mCapacity - mCapacity / 8)
+  {
+    long capacity = mCapacity ? mCapacity : HASHMAP_MIN_SIZE;
+    while((mLength + 1) * 16 > capacity * 7)
+      capacity *= 2;
+    rehash(capacity);
+  }
+
+  if(mNumItems == mItemsSize)
+  {
+    // lots of removed items are squeezed out rather than grown over
+    if(mNumItems && mLength * 2 < mNumItems)
+      rehash(mCapacity);
+    else
+    {
+      long new_size = mItemsSize ? mItemsSize * 2 : HASHMAP_MIN_SIZE;
+      sc_hashmapitem<T> **items = new sc_hashmapitem<T>*[new_size];
+      if(!items) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+      if(mNumItems) memcpy(items, mItems, mNumItems * sizeof(sc_hashmapitem<T> *));
+      delete [] mItems;
+      mItems = items;
+      mItemsSize = new_size;
+    }
+  }
+
+  long slot = slot_free(item->mHash);
+  if(mCtrl[slot] == HASHMAP_EMPTY) mUsed++;
+  mCtrl[slot] = ctrl_byte(item->mHash);
+  mSlots[slot] = item;
+
+  item->mIndex = mNumItems;
+  mItems[mNumItems++] = item;
+  mLength++;
+
+  iter_rewind();
+}
+
+/**
+ * Rebuilds the table and squeezes removed items out of the insertion order.
+ * @param capacity New number of slots.
+ */
+template <typename T>
+void sc_hashmap<T>::rehash(long capacity)
+{
+  unsigned char *ctrl = new unsigned char[capacity];
+  sc_hashmapitem<T> **slots = new sc_hashmapitem<T>*[capacity];
+  if(!ctrl || !slots) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  memset(ctrl, HASHMAP_EMPTY, capacity);
+
+  long count = 0;
+  for(long idx=mFirst; idx<mNumItems; idx++)
+  {
+    if(!mItems[idx]) continue;
+    mItems[count] = mItems[idx];
+    mItems[count]->mIndex = count;
+    count++;
+  }
+
+  delete [] mCtrl;
+  delete [] mSlots;
+  mCtrl = ctrl;
+  mSlots = slots;
+  mCapacity = capacity;
+  mUsed = count;
+  mNumItems = count;
+  mFirst = 0;
+
+  for(long idx=0; idx<count; idx++)
+  {
+    long slot = slot_free(mItems[idx]->mHash);
+    mCtrl[slot] = ctrl_byte(mItems[idx]->mHash);
+    mSlots[slot] = mItems[idx];
+  }
+}
+
+/**
+ * Searches the map for element with such key.
+ * @param key Key to be searched for.
+ * @return Pointer to found item or null.
+ */
+template <typename T>
+inline sc_hashmapitem<T> *sc_hashmap<T>::find(const char *key)
+{
+  return find(key, sc_strpool::hash(key));
+}
+
+/**
+ * Searches the map for element with such key.
+ * @param key Key to be searched for.
+ * @param hash Precomputed key hash.
+ * @return Pointer to found item or null.
+ */
+template <typename T>
+inline sc_hashmapitem<T> *sc_hashmap<T>::find(const char *key, unsigned long hash)
+{
+  long slot = slot_find(key, hash);
+  return slot < 0 ? NULL : mSlots[slot];
+}
+
+/**
+ * Updates or inserts a value according to it's key.
+ * @param key Key of the item.
+ * @param val Value of the item.
+ */
+template <typename T>
+inline void sc_hashmap<T>::set(const char *key, T value)
+{
+  set(key, sc_strpool::hash(key), value);
+}
+
+/**
+ * Updates or inserts a value according to it's key.
+ * Empty values are not inserted.
+ * @param key Key of the item.
+ * @param hash Precomputed key hash.
+ * @param val Value of the item.
+ */
+template <typename T>
+void sc_hashmap<T>::set(const char *key, unsigned long hash, T value)
+{
+  sc_hashmapitem<T> *item = find(key, hash);
+  if(item)
+  {
+    item->mValue = value;
+    return;
+  }
+
+  if(!value) return;
+
+  item = new sc_hashmapitem<T>(key, value, hash);
+  if(!item) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  insert(item);
+}
+
+/**
+ * Updates or inserts a value according to it's key.
+ * @param key Key of the item.
+ * @param val Value of the item.
+ */
+template <typename T>
+inline void sc_hashmap<T>::set(ic_string *key, T value)
+{
+  set(key->get(), value);
+}
+
+/**
+ * Inserts an existing item, taking ownership of it.
+ * The item is not copied, so pointers to it stay valid.
+ * The key must not be in the map yet.
+ * @param item Item to be inserted.
+ */
+template <typename T>
+inline void sc_hashmap<T>::adopt(sc_hashmapitem<T> *item)
+{
+  insert(item);
+}
+
+/**
+ * Returns a value according to it's key.
+ * @param key Key of the item.
+ * @return val Value of the item.
+ */
+template <typename T>
+inline T sc_hashmap<T>::get(const char *key)
+{
+  return get(key, sc_strpool::hash(key));
+}
+
+/**
+ * Returns a value according to it's key.
+ * @param key Key of the item.
+ * @param hash Precomputed key hash.
+ * @return val Value of the item.
+ */
+template <typename T>
+inline T sc_hashmap<T>::get(const char *key, unsigned long hash)
+{
+  sc_hashmapitem<T> *item = find(key, hash);
+  return item ? item->mValue : NULL;
+}
+
+/**
+ * Returns a value according to it's key.
+ * @param key Key of the item.
+ * @return val Value of the item.
+ */
+template <typename T>
+inline T sc_hashmap<T>::get(ic_string *key)
+{
+  return get(key->get());
+}
+
+/**
+ * Removes a record according to it's key.
+ * @param key Key of the item.
+ */
+template <typename T>
+void sc_hashmap<T>::remove(const char *key)
+{
+  long slot = slot_find(key, sc_strpool::hash(key));
+  if(slot >= 0)
+  {
+    sc_hashmapitem<T> *item = mSlots[slot];
+
+    // if the group has never been full, nothing could have been probed past it
+    if(group_match(mCtrl + slot / HASHMAP_GROUP * HASHMAP_GROUP, HASHMAP_EMPTY))
+    {
+      mCtrl[slot] = HASHMAP_EMPTY;
+      mUsed--;
+    }
+    else
+      mCtrl[slot] = HASHMAP_DELETED;
+
+    mItems[item->mIndex] = NULL;
+    while(mNumItems > mFirst && !mItems[mNumItems-1])
+      mNumItems--;
+    while(mFirst < mNumItems && !mItems[mFirst])
+      mFirst++;
+    if(mFirst == mNumItems)
+      mFirst = mNumItems = 0;
+
+    delete item;
+    mLength--;
+  }
+
+  iter_rewind();
+}
+
+/**
+ * Removes a record according to it's key.
+ * @param key Key of the item.
+ */
+template <typename T>
+inline void sc_hashmap<T>::remove(ic_string *key)
+{
+  remove(key->get());
+}
+
+/**
+ * Removes all records.
+ */
+template <typename T>
+void sc_hashmap<T>::clear()
+{
+  for(long idx=mFirst; idx<mNumItems; idx++)
+    delete mItems[idx];
+
+  delete [] mCtrl;
+  delete [] mSlots;
+  delete [] mItems;
+
+  mCtrl = NULL;
+  mSlots = NULL;
+  mCapacity = 0;
+  mUsed = 0;
+  mItems = NULL;
+  mNumItems = 0;
+  mItemsSize = 0;
+  mFirst = 0;
+  mLength = 0;
+  mCurr = 0;
+}
+
+/**
+ * Resets the iterator.
+ */
+template <typename T>
+inline void sc_hashmap<T>::iter_rewind()
+{
+  mCurr = mFirst;
+}
+
+/**
+ * Returns next key\item pair in the order of insertion.
+ * @return Next key\item pair.
+ */
+template <typename T>
+inline sc_hashmapitem<T> *sc_hashmap<T>::iter_next()
+{
+  while(mCurr < mNumItems)
+  {
+    sc_hashmapitem<T> *item = mItems[mCurr++];
+    if(item) return item;
+  }
+
+  return NULL;
+}
+
+/**
+ * Returns next key\item pair in the order of insertion, using an outer position.
+ * Independent passes over the map don't disturb each other this way.
+ * @param pos Position to start from, 0 for the first item. Is moved past the item.
+ * @return Next key\item pair.
+ */
+template <typename T>
+inline sc_hashmapitem<T> *sc_hashmap<T>::iter_next(long &pos)
+{
+  if(pos < mFirst) pos = mFirst;
+  while(pos < mNumItems)
+  {
+    sc_hashmapitem<T> *item = mItems[pos++];
+    if(item) return item;
+  }
+
+  return NULL;
+}
+
+/**
+ * Returns the item inserted last.
+ */
+template <typename T>
+inline sc_hashmapitem<T> *sc_hashmap<T>::last()
+{
+  return mNumItems ? mItems[mNumItems-1] : NULL;
+}
+
+/**
+ * Returns the length of the map.
+ */
+template <typename T>
+inline long sc_hashmap<T>::length()
+{
+  return mLength;
+}
+
+/**
+ * Returns the list of keys.
+ * @return Array of key pointers.
+ */
+template <typename T>
+sc_voidarray *sc_hashmap<T>::get_keys()
+{
+  sc_voidlist list;
+  for(long idx=mFirst; idx<mNumItems; idx++)
+    if(mItems[idx]) list.add(mItems[idx]->mKey);
+  return list.pack();
+}
+
+/**
+ * Indexing operator.
+ * @param key Key of the item
+ * @return Value of the item or NULL.
+ */
+template <typename T>
+inline T sc_hashmap<T>::operator[](const char *key)
+{
+  return get(key);
+}
+
+/**
+ * Indexing operator.
+ * @param key Key of the item
+ * @return Value of the item or NULL.
+ */
+template <typename T>
+inline T sc_hashmap<T>::operator[](ic_string &key)
+{
+  return get(key.get());
+}
+
+/**
+ * Indexing operator.
+ * @param key Key of the item
+ * @return Value of the item or NULL.
+ */
+template <typename T>
+inline T sc_hashmap<T>::operator[](ic_string *key)
+{
+  return get(key->get());
+}
+
+#if MALCO_DEBUG == 1
+
+/**
+ * Displays the contents of the map.
+ */
+template <typename T>
+void sc_hashmap<T>::debug()
+{
+  printf("Map: %ld items, %ld slots, %ld used\n", mLength, mCapacity, mUsed);
+  for(long idx=mFirst; idx<mNumItems; idx++)
+  {
+    if(!mItems[idx]) continue;
+    printf("  %s (%lx): %p\n", mItems[idx]->mKey->get(), mItems[idx]->mHash, (void *)mItems[idx]->mValue);
+  }
+}
+
+#endif
+
+#endif
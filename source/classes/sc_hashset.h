@@ -0,0 +1,144 @@
+/**
+ * @file sc_hashset.h
+ * @author impworks.
+ * sc_hashset class header.
+ * Defines methods of sc_hashset class.
+ */
+
+#ifndef SC_HASHSET_H
+#define SC_HASHSET_H
+
+/**
+ * sc_hashset constructor.
+ * @param cmp Comparer.
+ * @param size Number of items to reserve room for.
+ */
+template <typename T, typename C>
+sc_hashset<T, C>::sc_hashset(C &cmp, long size) : mCmp(cmp)
+{
+  mItems = NULL;
+  mHashes = NULL;
+  mUsed = NULL;
+  mCapacity = 0;
+  mLength = 0;
+
+  long capacity = HASHSET_MIN_SIZE;
+  while(capacity < size * 2)
+    capacity <<= 1;
+
+  rehash(capacity);
+}
+
+/**
+ * sc_hashset destructor.
+ */
+template <typename T, typename C>
+sc_hashset<T, C>::~sc_hashset()
+{
+  delete [] mItems;
+  delete [] mHashes;
+  delete [] mUsed;
+}
+
+/**
+ * Adds an item unless an equal one is already there.
+ * @param item Item to be added.
+ * @param hash Hash of the item. Equal items must have equal hashes.
+ * @return true if the item has been added.
+ */
+template <typename T, typename C>
+bool sc_hashset<T, C>::add(const T &item, unsigned long hash)
+{
+  long slot = slot_find(item, hash);
+  if(mUsed[slot]) return false;
+
+  mItems[slot] = item;
+  mHashes[slot] = hash;
+  mUsed[slot] = true;
+  mLength++;
+
+  if(mLength * 2 > mCapacity)
+    rehash(mCapacity * 2);
+
+  return true;
+}
+
+/**
+ * Checks whether an equal item is in the set.
+ * @param item Item to be found.
+ * @param hash Hash of the item.
+ */
+template <typename T, typename C>
+bool sc_hashset<T, C>::has(const T &item, unsigned long hash)
+{
+  return mUsed[slot_find(item, hash)];
+}
+
+/**
+ * Returns the number of items.
+ */
+template <typename T, typename C>
+inline long sc_hashset<T, C>::length()
+{
+  return mLength;
+}
+
+/**
+ * Finds the slot holding an equal item or the free slot the item belongs to.
+ * @param item Item to be found.
+ * @param hash Hash of the item.
+ * @return Slot index.
+ */
+template <typename T, typename C>
+long sc_hashset<T, C>::slot_find(const T &item, unsigned long hash)
+{
+  long mask = mCapacity - 1;
+
+  // FNV hashes are mixed well enough in the low bits
+  for(long slot = hash & mask; ; slot = (slot + 1) & mask)
+  {
+    if(!mUsed[slot] || (mHashes[slot] == hash && mCmp.equal(mItems[slot], item)))
+      return slot;
+  }
+}
+
+/**
+ * Moves all items into a table of a new size.
+ * @param capacity Number of slots (power of 2).
+ */
+template <typename T, typename C>
+void sc_hashset<T, C>::rehash(long capacity)
+{
+  T *items = mItems;
+  unsigned long *hashes = mHashes;
+  bool *used = mUsed;
+  long old_capacity = mCapacity;
+
+  mItems = new T[capacity];
+  mHashes = new unsigned long[capacity];
+  mUsed = new bool[capacity];
+  if(!mItems || !mHashes || !mUsed) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  memset(mUsed, 0, capacity * sizeof(bool));
+  mCapacity = capacity;
+
+  // items are distinct, so a free slot is all they need
+  long mask = capacity - 1;
+  for(long idx = 0; idx < old_capacity; idx++)
+  {
+    if(!used[idx]) continue;
+
+    long slot = hashes[idx] & mask;
+    while(mUsed[slot])
+      slot = (slot + 1) & mask;
+
+    mItems[slot] = items[idx];
+    mHashes[slot] = hashes[idx];
+    mUsed[slot] = true;
+  }
+
+  delete [] items;
+  delete [] hashes;
+  delete [] used;
+}
+
+#endif
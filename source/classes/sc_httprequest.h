@@ -0,0 +1,420 @@
+/**
+ * @file sc_httprequest.h
+ * @author impworks.
+ * sc_httprequest header.
+ * Defines properties and methods of sc_httprequest class.
+ */
+
+#ifndef SC_HTTPREQUEST_H
+#define SC_HTTPREQUEST_H
+
+#if MALCO_PLATFORM == M_PLATF_NIX
+
+/**
+ * sc_httprequest constructor.
+ * @param fd Connection descriptor, closed by the server.
+ * @param remote Address of the client.
+ */
+sc_httprequest::sc_httprequest(int fd, const char *remote)
+{
+  mFd = fd;
+
+  mRemote = new ic_string(remote);
+  mInput = new ic_string();
+  if(!mRemote || !mInput) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  reset();
+}
+
+/**
+ * sc_httprequest destructor.
+ */
+sc_httprequest::~sc_httprequest()
+{
+  delete mRemote;
+  delete mInput;
+}
+
+/**
+ * Forgets the previous request and it's response.
+ * Data received after it is kept for the next one.
+ */
+void sc_httprequest::reset()
+{
+  clear();
+
+  mHttp10 = false;
+  mKeepAlive = false;
+}
+
+/**
+ * Reads the next request from the connection.
+ * @param timeout Milliseconds to wait for the client.
+ * @param max_body Largest body accepted, in bytes.
+ * @return 0 if the request has been read, -1 if the client has left
+ * and an HTTP status to be answered with otherwise.
+ */
+int sc_httprequest::receive(long timeout, long max_body)
+{
+  reset();
+
+  // the rest of the connection cannot be trusted after an error
+  int code = read(timeout, max_body);
+  if(code)
+    mKeepAlive = false;
+
+  return code;
+}
+
+/**
+ * Reads the request head and body.
+ * @param timeout Milliseconds to wait for the client.
+ * @param max_body Largest body accepted, in bytes.
+ * @return See receive().
+ */
+int sc_httprequest::read(long timeout, long max_body)
+{
+  char *buf, *end;
+
+  while(true)
+  {
+    // empty lines before a request are ignored
+    long skip = 0;
+    buf = mInput->get();
+    while(skip < mInput->length() && (buf[skip] == '\r' || buf[skip] == '\n'))
+      skip++;
+
+    if(skip)
+    {
+      mInput->substr_set(0, skip, "");
+      buf = mInput->get();
+    }
+
+    long length = mInput->length();
+    end = length > 0 ? (char *)memmem(buf, (size_t)length, "\r\n\r\n", 4) : NULL;
+    if(end) break;
+
+    if(mInput->length() > HTTP_MAX_HEAD)
+      return 431;
+
+    if(!fill(timeout))
+      return mInput->length() ? 408 : -1;
+  }
+
+  long head = end - buf;
+  if(head > HTTP_MAX_HEAD)
+    return 431;
+
+  *end = '\0';
+  int code = parse_head(buf);
+  mInput->substr_set(0, head + 4, "");
+  if(code)
+    return code;
+
+  // the body
+  long length = 0;
+  char *value = mServer.get("CONTENT_LENGTH");
+  if(value)
+  {
+    if(!*value || strspn(value, "0123456789") != strlen(value) || strlen(value) > 18)
+      return 400;
+
+    length = atol(value);
+    if(length > max_body)
+      return 413;
+  }
+
+  while(mInput->length() < length)
+    if(!fill(timeout))
+      return 408;
+
+  if(length)
+  {
+    mBody->set(mInput->get(), length);
+    mInput->substr_set(0, length, "");
+  }
+
+  parse_body();
+  return 0;
+}
+
+/**
+ * Waits for data from the client and appends it to the input.
+ * @param timeout Milliseconds to wait.
+ * @return false if the client has closed the connection, failed or kept silent.
+ */
+bool sc_httprequest::fill(long timeout)
+{
+  pollfd watch;
+  watch.fd = mFd;
+  watch.events = POLLIN;
+
+  int ready;
+  while((ready = poll(&watch, 1, timeout)) < 0 && errno == EINTR);
+  if(ready <= 0)
+    return false;
+
+  char buf[HTTP_CHUNK];
+  ssize_t len;
+  while((len = ::recv(mFd, buf, sizeof(buf), 0)) < 0 && errno == EINTR);
+  if(len <= 0)
+    return false;
+
+  mInput->append(buf, len);
+  return true;
+}
+
+/**
+ * Parses the request line and the headers.
+ * The head is cut into pieces in place.
+ * @param buf Head, without the empty line.
+ * @return 0 or an HTTP status to be answered with.
+ */
+int sc_httprequest::parse_head(char *buf)
+{
+  char *line = buf, *next;
+
+  // request line
+  next = strchr(line, '\n');
+  if(next) *next++ = '\0';
+  if(next && next[-2] == '\r') next[-2] = '\0';
+
+  char *method = line, *uri, *version;
+  if(!(uri = strchr(method, ' ')))
+    return 400;
+  *uri++ = '\0';
+
+  if(!(version = strchr(uri, ' ')))
+    return 400;
+  *version++ = '\0';
+
+  if(!*method || *uri != '/' && *uri != '*')
+    return 400;
+
+  if(!strcmp(version, "HTTP/1.1"))
+    mKeepAlive = true;
+  else if(!strcmp(version, "HTTP/1.0"))
+    mHttp10 = true;
+  else
+    return strncmp(version, "HTTP/", 5) ? 400 : 505;
+
+  mNoBody = !strcmp(method, "HEAD");
+  mServer.set("REQUEST_METHOD", method);
+  mServer.set("REQUEST_URI", uri);
+  mServer.set("SERVER_PROTOCOL", version);
+  mServer.set("SERVER_SOFTWARE", "Malco/" MALCO_VERSION);
+  mServer.set("REMOTE_ADDR", mRemote);
+
+  char *query = strchr(uri, '?');
+  if(query)
+  {
+    *query++ = '\0';
+    parse_query(&mGet, query, strlen(query));
+  }
+
+  mServer.set("QUERY_STRING", query ? query : "");
+  ic_string *path = url_decode(uri, strlen(uri));
+  mServer.set("PATH_INFO", path);
+  delete path;
+
+  // headers, named as in CGI
+  long count = 0;
+  ic_string key;
+  for(line = next; line && *line; line = next)
+  {
+    next = strchr(line, '\n');
+    if(next) *next++ = '\0';
+    if(next && next[-2] == '\r') next[-2] = '\0';
+
+    if(++count > HTTP_MAX_HEADERS)
+      return 431;
+
+    // whitespace before the colon is how requests get smuggled
+    char *value = strchr(line, ':');
+    if(!value || value == line || strcspn(line, " \t") < (size_t)(value - line))
+      return 400;
+    *value++ = '\0';
+
+    while(*value == ' ' || *value == '\t') value++;
+    char *tail = value + strlen(value);
+    while(tail > value && (tail[-1] == ' ' || tail[-1] == '\t')) *--tail = '\0';
+
+    if(!strcasecmp(line, "Transfer-Encoding"))
+      return 501;
+
+    if(!strcasecmp(line, "Connection"))
+    {
+      if(!strcasecmp(value, "close"))
+        mKeepAlive = false;
+      else if(!strcasecmp(value, "keep-alive"))
+        mKeepAlive = true;
+    }
+    else if(!strcasecmp(line, "Cookie"))
+    {
+      ic_string cookies(value);
+      parse_cookies(cookies.get());
+    }
+
+    if(!strcasecmp(line, "Content-Type") || !strcasecmp(line, "Content-Length"))
+      key.empty();
+    else
+      key.set("HTTP_");
+
+    for(char *chr = line; *chr; chr++)
+      key.append(*chr == '-' ? '_' : (char)toupper(*chr));
+
+    // repeated headers are joined, except for the length of the body
+    char *prev = mServer.get(key.get());
+    if(!prev)
+      mServer.set(key.get(), value);
+    else if(!key.compare("CONTENT_LENGTH"))
+      return 400;
+    else
+    {
+      ic_string joined(prev);
+      joined.append(", ");
+      joined.append(value, strlen(value));
+      mServer.set(key.get(), &joined);
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * Sends what has been written so far.
+ * The length of the body is not known until the script has finished, so the
+ * body is sent in chunks, or until the connection is closed to HTTP/1.0 clients.
+ */
+void sc_httprequest::flush()
+{
+  if(mFailed)
+    return;
+
+  if(!mSent)
+  {
+    if(mHttp10)
+      mKeepAlive = false;
+
+    ic_string head;
+    send_head(&head, -1);
+    if(!send(head.get(), head.length(), mOutput->length() && !mNoBody))
+      return;
+  }
+
+  send_chunk();
+}
+
+/**
+ * Sends the rest of the response.
+ * @return Flag indicating the connection can be used for the next request.
+ */
+bool sc_httprequest::finish()
+{
+  if(!mFailed && !mSent)
+  {
+    // the whole body is known: it is sent right after the headers
+    ic_string head;
+    send_head(&head, mOutput->length());
+
+    if(mNoBody || !mOutput->length())
+      send(head.get(), head.length());
+    else if(send(head.get(), head.length(), true))
+      send(mOutput->get(), mOutput->length());
+  }
+  else if(!mFailed)
+  {
+    send_chunk();
+    if(!mHttp10 && !mNoBody)
+      send("0\r\n\r\n", 5);
+  }
+
+  mOutput->empty();
+  return mKeepAlive && !mFailed;
+}
+
+/**
+ * Sends data to the client.
+ * @param data Data.
+ * @param size Number of bytes.
+ * @param more More data follows at once, so the kernel should not send a packet yet.
+ * @return false if the connection has failed.
+ */
+bool sc_httprequest::send(const char *data, long size, bool more)
+{
+  while(size > 0 && !mFailed)
+  {
+    ssize_t len = ::send(mFd, data, size, MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+    if(len < 0)
+    {
+      if(errno != EINTR)
+        mFailed = true;
+
+      continue;
+    }
+
+    data += len;
+    size -= len;
+  }
+
+  return !mFailed;
+}
+
+/**
+ * Builds the response headers.
+ * @param[out] head String to put the headers to.
+ * @param length Length of the body, -1 if it is not known.
+ */
+void sc_httprequest::send_head(ic_string *head, long length)
+{
+  char line[NUMBER_BUF_SIZE * 2];
+
+  sprintf(line, "HTTP/1.1 %d ", mStatus);
+  head->append(line);
+  head->append(reason(mStatus));
+  head->append("\r\nServer: Malco/" MALCO_VERSION "\r\n");
+
+  if(!mTyped)
+    head->append("Content-Type: text/html; charset=utf-8\r\n");
+
+  if(length >= 0)
+  {
+    sprintf(line, "Content-Length: %ld\r\n", length);
+    head->append(line);
+  }
+  else if(!mHttp10)
+    head->append("Transfer-Encoding: chunked\r\n");
+
+  head->append(mKeepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
+  if(mHeaders->length())
+    head->append(mHeaders);
+
+  head->append("\r\n");
+  mSent = true;
+}
+
+/**
+ * Sends the body written so far as a chunk.
+ */
+void sc_httprequest::send_chunk()
+{
+  long length = mOutput->length();
+  if(length && !mNoBody)
+  {
+    if(mHttp10)
+      send(mOutput->get(), length);
+    else
+    {
+      char size[NUMBER_BUF_SIZE];
+      sprintf(size, "%lx\r\n", length);
+      if(send(size, strlen(size), true) && send(mOutput->get(), length, true))
+        send("\r\n", 2);
+    }
+  }
+
+  mOutput->empty();
+}
+
+#endif
+
+#endif
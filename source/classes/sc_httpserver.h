@@ -0,0 +1,320 @@
+/**
+ * @file sc_httpserver.h
+ * @author impworks.
+ * sc_httpserver header.
+ * Defines properties and methods of sc_httpserver class.
+ */
+
+#ifndef SC_HTTPSERVER_H
+#define SC_HTTPSERVER_H
+
+#if MALCO_PLATFORM == M_PLATF_NIX
+
+/**
+ * sc_httpserver constructor.
+ * @param core Core whose image is loaded.
+ * @param keepalive Milliseconds an idle connection is kept open.
+ * @param max_body Largest request body accepted, in bytes.
+ */
+sc_httpserver::sc_httpserver(rc_core *core, long keepalive, long max_body)
+{
+  pCore = core;
+  mFd = -1;
+  mKeepAlive = keepalive > 0 ? keepalive : 1;
+  mMaxBody = max_body;
+  mFastCgi = false;
+}
+
+/**
+ * sc_httpserver destructor.
+ */
+sc_httpserver::~sc_httpserver()
+{
+  if(mFd >= 0)
+    ::close(mFd);
+}
+
+/**
+ * Binds the listening socket.
+ * @param host Address to listen at, empty for any.
+ * @param port Port number.
+ * @return Success flag.
+ */
+bool sc_httpserver::listen(const char *host, long port)
+{
+  char service[NUMBER_BUF_SIZE];
+  sprintf(service, "%ld", port);
+
+  addrinfo hints, *info;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+
+  if(getaddrinfo(*host ? host : NULL, service, &hints, &info) != 0)
+    return false;
+
+  mFd = ::socket(info->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+  int on = 1;
+  bool ok = mFd >= 0
+         && setsockopt(mFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) == 0
+         && ::bind(mFd, info->ai_addr, info->ai_addrlen) == 0
+         && ::listen(mFd, SOMAXCONN) == 0;
+
+  freeaddrinfo(info);
+
+  if(!ok && mFd >= 0)
+  {
+    ::close(mFd);
+    mFd = -1;
+  }
+
+  return ok;
+}
+
+/**
+ * Binds a Unix domain socket the web server passes FastCGI requests to.
+ * A socket left by a previous run is replaced.
+ * @param path Path of the socket.
+ * @return Success flag.
+ */
+bool sc_httpserver::listen_unix(const char *path)
+{
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if(!*path || strlen(path) >= sizeof(addr.sun_path))
+    return false;
+
+  strcpy(addr.sun_path, path);
+
+  struct stat info;
+  if(lstat(path, &info) == 0 && S_ISSOCK(info.st_mode))
+    unlink(path);
+
+  mFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  bool ok = mFd >= 0
+         && ::bind(mFd, (sockaddr *)&addr, sizeof(addr)) == 0
+         && ::listen(mFd, SOMAXCONN) == 0;
+
+  if(!ok && mFd >= 0)
+  {
+    ::close(mFd);
+    mFd = -1;
+  }
+
+  mFastCgi = ok;
+  return ok;
+}
+
+/**
+ * Serves requests until the server is killed.
+ * With several processes, the first one only forks the workers
+ * and forks a new one whenever a worker dies.
+ * @param processes Number of worker processes.
+ * @param threads Number of threads in each process, 0 for one per core.
+ * @return Exit code.
+ */
+int sc_httpserver::run(int processes, int threads)
+{
+  if(processes <= 1)
+  {
+    spawn(threads);
+    return 0;
+  }
+
+  // nothing must be printed twice by the workers
+  fflush(stdout);
+
+  for(int idx = 0; idx < processes; idx++)
+    if(fork() == 0)
+    {
+      spawn(threads);
+      _exit(0);
+    }
+
+  while(wait(NULL) > 0)
+    if(fork() == 0)
+    {
+      spawn(threads);
+      _exit(0);
+    }
+
+  return 0;
+}
+
+/**
+ * Runs the worker threads of the process.
+ * @param threads Number of threads, 0 for one per core.
+ */
+void sc_httpserver::spawn(int threads)
+{
+  if(threads <= 0)
+    threads = MAX((int)std::thread::hardware_concurrency(), 1);
+
+  std::thread *workers = new std::thread[threads];
+  if(!workers) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  for(int idx = 0; idx < threads; idx++)
+    workers[idx] = std::thread(&sc_httpserver::work, this);
+
+  for(int idx = 0; idx < threads; idx++)
+    workers[idx].join();
+
+  delete [] workers;
+}
+
+/**
+ * Worker thread body: accepts connections and serves them one by one.
+ * The head is created once and reset after every request.
+ */
+void sc_httpserver::work()
+{
+  rc_head *head = new rc_head(pCore);
+  if(!head) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  while(true)
+  {
+    sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+
+    int fd = ::accept4(mFd, (sockaddr *)&addr, &len, SOCK_CLOEXEC);
+    if(fd < 0)
+    {
+      if(errno == EINTR || errno == ECONNABORTED || errno == EPROTO)
+        continue;
+
+      // out of descriptors: let other connections finish
+      if(errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM)
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        continue;
+      }
+
+      break;
+    }
+
+    // a client that does not read the response must not hold the worker for ever
+    timeval wait;
+    wait.tv_sec = mKeepAlive / 1000;
+    wait.tv_usec = mKeepAlive % 1000 * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &wait, sizeof(wait));
+
+    if(mFastCgi)
+    {
+      serve_fcgi(head, fd);
+      ::close(fd);
+      continue;
+    }
+
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    char remote[NI_MAXHOST];
+    if(getnameinfo((sockaddr *)&addr, len, remote, sizeof(remote), NULL, 0, NI_NUMERICHOST) != 0)
+      *remote = '\0';
+
+    serve(head, fd, remote);
+    ::close(fd);
+  }
+
+  delete head;
+  sc_regexcache::clear();
+}
+
+/**
+ * Serves the requests of a connection for as long as it is kept alive.
+ * @param head Head of the worker.
+ * @param fd Connection descriptor.
+ * @param remote Address of the client.
+ */
+void sc_httpserver::serve(rc_head *head, int fd, const char *remote)
+{
+  sc_httprequest req(fd, remote);
+
+  while(true)
+  {
+    int code = req.receive(mKeepAlive, mMaxBody);
+    if(code < 0)
+      break;
+
+    if(code > 0)
+    {
+      req.error(code);
+      req.finish();
+      break;
+    }
+
+    if(!respond(head, &req))
+      break;
+  }
+}
+
+/**
+ * Serves the FastCGI requests of a connection.
+ * Requests sent over the connection at once are played one by one
+ * in the order they have been completed.
+ * @param head Head of the worker.
+ * @param fd Connection descriptor.
+ */
+void sc_httpserver::serve_fcgi(rc_head *head, int fd)
+{
+  sc_fcgiconn conn(fd);
+  sc_fcgirequest *req;
+
+  while((req = conn.receive(mKeepAlive, mMaxBody)))
+  {
+    bool keep;
+    if(req->mCode)
+    {
+      req->error(req->mCode);
+      keep = req->finish();
+    }
+    else
+      keep = respond(head, req);
+
+    conn.forget(req);
+    if(!keep)
+      break;
+  }
+}
+
+/**
+ * Plays the script for a request and sends the response.
+ * An exception the script has not caught is reported on stderr
+ * and answered with an error page.
+ * @param head Head of the worker.
+ * @param req Request.
+ * @return Flag indicating the connection is kept alive.
+ */
+bool sc_httpserver::respond(rc_head *head, sc_request *req)
+{
+  head->pRequest = req;
+
+  try
+  {
+    head->playback();
+
+    if(head->mState == M_STATE_DEAD && head->rAX)
+    {
+      sc_exception *exc = (sc_exception *)head->rAX->get()->mData;
+      fprintf(stderr, M_ERR_EXCEPTION "\n", exc->mErrorMsg->get(), exc->mFile ? exc->mFile : "", (int)exc->mLine);
+      req->error(500);
+    }
+  }
+  catch(const sc_exception &ex)
+  {
+    fprintf(stderr, M_ERR_INTERNAL "\n", ex.mErrorMsg->get());
+    req->error(500);
+  }
+
+  head->pRequest = NULL;
+  head->reset();
+
+  return req->finish();
+}
+
+#endif
+
+#endif
@@ -0,0 +1,406 @@
+/**
+ * @file sc_numarray.h
+ * @author impworks.
+ * sc_numarray class header.
+ * Defines properties and methods of sc_numarray class.
+ */
+
+#ifndef SC_NUMARRAY_H
+#define SC_NUMARRAY_H
+
+/**
+ * sc_numarray constructor.
+ * @param size Number of values to reserve room for.
+ */
+sc_numarray::sc_numarray(long size)
+{
+  mInts = NULL;
+  mFloats = NULL;
+  mLength = 0;
+  mSize = 0;
+  mUnordered = false;
+
+  if(size > 0)
+  {
+    mInts = new long[size];
+    if(!mInts) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+    mSize = size;
+  }
+}
+
+/**
+ * sc_numarray destructor.
+ */
+sc_numarray::~sc_numarray()
+{
+  delete [] mInts;
+  delete [] mFloats;
+}
+
+/**
+ * Adds an integer to the end.
+ * @param value Value to be added.
+ */
+void sc_numarray::add(long value)
+{
+  if(mLength == mSize) grow();
+
+  if(mFloats)
+  {
+    if(fabs((double)value) >= NUMARRAY_EXACT_INT) mUnordered = true;
+    mFloats[mLength++] = (double)value;
+  }
+  else
+    mInts[mLength++] = value;
+}
+
+/**
+ * Adds a float to the end.
+ * The integers added before are converted to floats.
+ * @param value Value to be added.
+ */
+void sc_numarray::add(double value)
+{
+  if(mLength == mSize) grow();
+
+  if(!mFloats)
+  {
+    mFloats = new double[mSize];
+    if(!mFloats) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+    for(long idx=0; idx<mLength; idx++)
+    {
+      if(fabs((double)mInts[idx]) >= NUMARRAY_EXACT_INT) mUnordered = true;
+      mFloats[idx] = (double)mInts[idx];
+    }
+
+    delete [] mInts;
+    mInts = NULL;
+  }
+
+  if(value != value) mUnordered = true;
+  mFloats[mLength++] = value;
+}
+
+/**
+ * Returns the number of values.
+ */
+inline long sc_numarray::length()
+{
+  return mLength;
+}
+
+/**
+ * Checks whether the values are stored as floats.
+ */
+inline bool sc_numarray::is_float()
+{
+  return mFloats != NULL;
+}
+
+/**
+ * Checks whether the values can be ordered by min_index() and max_index()
+ * the same way comparing them one by one would do.
+ * It's not so if a float is NaN, or if some integers have become equal
+ * when converted to floats, while they would be compared as integers.
+ */
+inline bool sc_numarray::ordered()
+{
+  return !mUnordered;
+}
+
+/**
+ * Returns the sum of all values.
+ * Values are added up in several independent lanes, so the rounding of
+ * floats may differ from adding them one by one.
+ */
+double sc_numarray::sum()
+{
+  long idx = 0;
+  double res;
+
+  if(mFloats)
+  {
+#if MALCO_SSE2 == 1
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    for(; idx+4<=mLength; idx+=4)
+    {
+      acc0 = _mm_add_pd(acc0, _mm_loadu_pd(mFloats + idx));
+      acc1 = _mm_add_pd(acc1, _mm_loadu_pd(mFloats + idx + 2));
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    res = lanes[0] + lanes[1];
+#else
+    double acc[4] = {0.0, 0.0, 0.0, 0.0};
+    for(; idx+4<=mLength; idx+=4)
+    {
+      acc[0] += mFloats[idx];
+      acc[1] += mFloats[idx+1];
+      acc[2] += mFloats[idx+2];
+      acc[3] += mFloats[idx+3];
+    }
+    res = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+#endif
+  }
+  else
+  {
+    double acc[4] = {0.0, 0.0, 0.0, 0.0};
+    for(; idx+4<=mLength; idx+=4)
+    {
+      acc[0] += (double)mInts[idx];
+      acc[1] += (double)mInts[idx+1];
+      acc[2] += (double)mInts[idx+2];
+      acc[3] += (double)mInts[idx+3];
+    }
+    res = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+  }
+
+  for(; idx<mLength; idx++)
+    res += at(idx);
+
+  return res;
+}
+
+/**
+ * Returns the product of all values.
+ */
+double sc_numarray::product()
+{
+  long idx = 0;
+  double res;
+
+  if(mFloats)
+  {
+#if MALCO_SSE2 == 1
+    __m128d acc0 = _mm_set1_pd(1.0), acc1 = _mm_set1_pd(1.0);
+    for(; idx+4<=mLength; idx+=4)
+    {
+      acc0 = _mm_mul_pd(acc0, _mm_loadu_pd(mFloats + idx));
+      acc1 = _mm_mul_pd(acc1, _mm_loadu_pd(mFloats + idx + 2));
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_mul_pd(acc0, acc1));
+    res = lanes[0] * lanes[1];
+#else
+    double acc[4] = {1.0, 1.0, 1.0, 1.0};
+    for(; idx+4<=mLength; idx+=4)
+    {
+      acc[0] *= mFloats[idx];
+      acc[1] *= mFloats[idx+1];
+      acc[2] *= mFloats[idx+2];
+      acc[3] *= mFloats[idx+3];
+    }
+    res = (acc[0] * acc[1]) * (acc[2] * acc[3]);
+#endif
+  }
+  else
+  {
+    double acc[4] = {1.0, 1.0, 1.0, 1.0};
+    for(; idx+4<=mLength; idx+=4)
+    {
+      acc[0] *= (double)mInts[idx];
+      acc[1] *= (double)mInts[idx+1];
+      acc[2] *= (double)mInts[idx+2];
+      acc[3] *= (double)mInts[idx+3];
+    }
+    res = (acc[0] * acc[1]) * (acc[2] * acc[3]);
+  }
+
+  for(; idx<mLength; idx++)
+    res *= at(idx);
+
+  return res;
+}
+
+/**
+ * Returns the sum of pairwise products with another set of values.
+ * Extra values of the longer set are ignored.
+ * @param other Other set of values.
+ */
+double sc_numarray::dot(sc_numarray *other)
+{
+  long len = mLength < other->mLength ? mLength : other->mLength;
+  long idx = 0;
+  double res;
+
+#if MALCO_SSE2 == 1
+  if(mFloats && other->mFloats)
+  {
+    double *left = mFloats, *right = other->mFloats;
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    for(; idx+4<=len; idx+=4)
+    {
+      acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(left + idx), _mm_loadu_pd(right + idx)));
+      acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(left + idx + 2), _mm_loadu_pd(right + idx + 2)));
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    res = lanes[0] + lanes[1];
+  }
+  else
+#endif
+  {
+    double acc[4] = {0.0, 0.0, 0.0, 0.0};
+    for(; idx+4<=len; idx+=4)
+    {
+      acc[0] += at(idx) * other->at(idx);
+      acc[1] += at(idx+1) * other->at(idx+1);
+      acc[2] += at(idx+2) * other->at(idx+2);
+      acc[3] += at(idx+3) * other->at(idx+3);
+    }
+    res = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+  }
+
+  for(; idx<len; idx++)
+    res += at(idx) * other->at(idx);
+
+  return res;
+}
+
+/**
+ * Finds the first of the smallest values.
+ * Values must be ordered().
+ * @return Index of the value or -1 if there are none.
+ */
+long sc_numarray::min_index()
+{
+  if(!mLength) return -1;
+
+  long idx = 0;
+  if(mFloats)
+  {
+    double res = mFloats[0];
+#if MALCO_SSE2 == 1
+    __m128d acc0 = _mm_set1_pd(res), acc1 = acc0;
+    for(; idx+4<=mLength; idx+=4)
+    {
+      acc0 = _mm_min_pd(acc0, _mm_loadu_pd(mFloats + idx));
+      acc1 = _mm_min_pd(acc1, _mm_loadu_pd(mFloats + idx + 2));
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_min_pd(acc0, acc1));
+    res = lanes[0] < lanes[1] ? lanes[0] : lanes[1];
+#endif
+    for(; idx<mLength; idx++)
+      if(mFloats[idx] < res) res = mFloats[idx];
+
+    // equal values keep the first one
+    for(idx=0; mFloats[idx] != res; idx++);
+  }
+  else
+  {
+    long acc[4] = {mInts[0], mInts[0], mInts[0], mInts[0]};
+    for(; idx+4<=mLength; idx+=4)
+    {
+      if(mInts[idx] < acc[0]) acc[0] = mInts[idx];
+      if(mInts[idx+1] < acc[1]) acc[1] = mInts[idx+1];
+      if(mInts[idx+2] < acc[2]) acc[2] = mInts[idx+2];
+      if(mInts[idx+3] < acc[3]) acc[3] = mInts[idx+3];
+    }
+
+    long res = acc[0];
+    for(int lane=1; lane<4; lane++)
+      if(acc[lane] < res) res = acc[lane];
+    for(; idx<mLength; idx++)
+      if(mInts[idx] < res) res = mInts[idx];
+
+    for(idx=0; mInts[idx] != res; idx++);
+  }
+
+  return idx;
+}
+
+/**
+ * Finds the first of the largest values.
+ * Values must be ordered().
+ * @return Index of the value or -1 if there are none.
+ */
+long sc_numarray::max_index()
+{
+  if(!mLength) return -1;
+
+  long idx = 0;
+  if(mFloats)
+  {
+    double res = mFloats[0];
+#if MALCO_SSE2 == 1
+    __m128d acc0 = _mm_set1_pd(res), acc1 = acc0;
+    for(; idx+4<=mLength; idx+=4)
+    {
+      acc0 = _mm_max_pd(acc0, _mm_loadu_pd(mFloats + idx));
+      acc1 = _mm_max_pd(acc1, _mm_loadu_pd(mFloats + idx + 2));
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_max_pd(acc0, acc1));
+    res = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+#endif
+    for(; idx<mLength; idx++)
+      if(mFloats[idx] > res) res = mFloats[idx];
+
+    // equal values keep the first one
+    for(idx=0; mFloats[idx] != res; idx++);
+  }
+  else
+  {
+    long acc[4] = {mInts[0], mInts[0], mInts[0], mInts[0]};
+    for(; idx+4<=mLength; idx+=4)
+    {
+      if(mInts[idx] > acc[0]) acc[0] = mInts[idx];
+      if(mInts[idx+1] > acc[1]) acc[1] = mInts[idx+1];
+      if(mInts[idx+2] > acc[2]) acc[2] = mInts[idx+2];
+      if(mInts[idx+3] > acc[3]) acc[3] = mInts[idx+3];
+    }
+
+    long res = acc[0];
+    for(int lane=1; lane<4; lane++)
+      if(acc[lane] > res) res = acc[lane];
+    for(; idx<mLength; idx++)
+      if(mInts[idx] > res) res = mInts[idx];
+
+    for(idx=0; mInts[idx] != res; idx++);
+  }
+
+  return idx;
+}
+
+/**
+ * Doubles the room for values.
+ */
+void sc_numarray::grow()
+{
+  long new_size = mSize ? mSize * 2 : 16;
+  if(mFloats)
+  {
+    double *floats = new double[new_size];
+    if(!floats) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+    if(mLength) memcpy(floats, mFloats, mLength * sizeof(double));
+    delete [] mFloats;
+    mFloats = floats;
+  }
+  else
+  {
+    long *ints = new long[new_size];
+    if(!ints) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+    if(mLength) memcpy(ints, mInts, mLength * sizeof(long));
+    delete [] mInts;
+    mInts = ints;
+  }
+
+  mSize = new_size;
+}
+
+/**
+ * Returns a value as a float.
+ * @param idx Index of the value.
+ */
+inline double sc_numarray::at(long idx)
+{
+  return mFloats ? mFloats[idx] : (double)mInts[idx];
+}
+
+#endif
@@ -0,0 +1,611 @@
+/**
+ * @file sc_number.h
+ * @author impworks.
+ * sc_number class header.
+ * Defines properties and methods of sc_number class.
+ */
+
+#ifndef SC_NUMBER_H
+#define SC_NUMBER_H
+
+const char sc_number::mDigits[201] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+const sc_number::cached_power sc_number::mPowers[79] =
+{
+  { 0xAB70FE17C79AC6CAULL, -1060, -300 },
+  { 0xFF77B1FCBEBCDC4FULL, -1034, -292 },
+  { 0xBE5691EF416BD60CULL, -1007, -284 },
+  { 0x8DD01FAD907FFC3CULL,  -980, -276 },
+  { 0xD3515C2831559A83ULL,  -954, -268 },
+  { 0x9D71AC8FADA6C9B5ULL,  -927, -260 },
+  { 0xEA9C227723EE8BCBULL,  -901, -252 },
+  { 0xAECC49914078536DULL,  -874, -244 },
+  { 0x823C12795DB6CE57ULL,  -847, -236 },
+  { 0xC21094364DFB5637ULL,  -821, -228 },
+  { 0x9096EA6F3848984FULL,  -794, -220 },
+  { 0xD77485CB25823AC7ULL,  -768, -212 },
+  { 0xA086CFCD97BF97F4ULL,  -741, -204 },
+  { 0xEF340A98172AACE5ULL,  -715, -196 },
+  { 0xB23867FB2A35B28EULL,  -688, -188 },
+  { 0x84C8D4DFD2C63F3BULL,  -661, -180 },
+  { 0xC5DD44271AD3CDBAULL,  -635, -172 },
+  { 0x936B9FCEBB25C996ULL,  -608, -164 },
+  { 0xDBAC6C247D62A584ULL,  -582, -156 },
+  { 0xA3AB66580D5FDAF6ULL,  -555, -148 },
+  { 0xF3E2F893DEC3F126ULL,  -529, -140 },
+  { 0xB5B5ADA8AAFF80B8ULL,  -502, -132 },
+  { 0x87625F056C7C4A8BULL,  -475, -124 },
+  { 0xC9BCFF6034C13053ULL,  -449, -116 },
+  { 0x964E858C91BA2655ULL,  -422, -108 },
+  { 0xDFF9772470297EBDULL,  -396, -100 },
+  { 0xA6DFBD9FB8E5B88FULL,  -369,  -92 },
+  { 0xF8A95FCF88747D94ULL,  -343,  -84 },
+  { 0xB94470938FA89BCFULL,  -316,  -76 },
+  { 0x8A08F0F8BF0F156BULL,  -289,  -68 },
+  { 0xCDB02555653131B6ULL,  -263,  -60 },
+  { 0x993FE2C6D07B7FACULL,  -236,  -52 },
+  { 0xE45C10C42A2B3B06ULL,  -210,  -44 },
+  { 0xAA242499697392D3ULL,  -183,  -36 },
+  { 0xFD87B5F28300CA0EULL,  -157,  -28 },
+  { 0xBCE5086492111AEBULL,  -130,  -20 },
+  { 0x8CBCCC096F5088CCULL,  -103,  -12 },
+  { 0xD1B71758E219652CULL,   -77,   -4 },
+  { 0x9C40000000000000ULL,   -50,    4 },
+  { 0xE8D4A51000000000ULL,   -24,   12 },
+  { 0xAD78EBC5AC620000ULL,     3,   20 },
+  { 0x813F3978F8940984ULL,    30,   28 },
+  { 0xC097CE7BC90715B3ULL,    56,   36 },
+  { 0x8F7E32CE7BEA5C70ULL,    83,   44 },
+  { 0xD5D238A4ABE98068ULL,   109,   52 },
+  { 0x9F4F2726179A2245ULL,   136,   60 },
+  { 0xED63A231D4C4FB27ULL,   162,   68 },
+  { 0xB0DE65388CC8ADA8ULL,   189,   76 },
+  { 0x83C7088E1AAB65DBULL,   216,   84 },
+  { 0xC45D1DF942711D9AULL,   242,   92 },
+  { 0x924D692CA61BE758ULL,   269,  100 },
+  { 0xDA01EE641A708DEAULL,   295,  108 },
+  { 0xA26DA3999AEF774AULL,   322,  116 },
+  { 0xF209787BB47D6B85ULL,   348,  124 },
+  { 0xB454E4A179DD1877ULL,   375,  132 },
+  { 0x865B86925B9BC5C2ULL,   402,  140 },
+  { 0xC83553C5C8965D3DULL,   428,  148 },
+  { 0x952AB45CFA97A0B3ULL,   455,  156 },
+  { 0xDE469FBD99A05FE3ULL,   481,  164 },
+  { 0xA59BC234DB398C25ULL,   508,  172 },
+  { 0xF6C69A72A3989F5CULL,   534,  180 },
+  { 0xB7DCBF5354E9BECEULL,   561,  188 },
+  { 0x88FCF317F22241E2ULL,   588,  196 },
+  { 0xCC20CE9BD35C78A5ULL,   614,  204 },
+  { 0x98165AF37B2153DFULL,   641,  212 },
+  { 0xE2A0B5DC971F303AULL,   667,  220 },
+  { 0xA8D9D1535CE3B396ULL,   694,  228 },
+  { 0xFB9B7CD9A4A7443CULL,   720,  236 },
+  { 0xBB764C4CA7A44410ULL,   747,  244 },
+  { 0x8BAB8EEFB6409C1AULL,   774,  252 },
+  { 0xD01FEF10A657842CULL,   800,  260 },
+  { 0x9B10A4E5E9913129ULL,   827,  268 },
+  { 0xE7109BFBA19C0C9DULL,   853,  276 },
+  { 0xAC2820D9623BF429ULL,   880,  284 },
+  { 0x80444B5E7AA7CF85ULL,   907,  292 },
+  { 0xBF21E44003ACDD2DULL,   933,  300 },
+  { 0x8E679C2F5E44FF8FULL,   960,  308 },
+  { 0xD433179D9C8CB841ULL,   986,  316 },
+  { 0x9E19DB92B4E31BA9ULL,  1013,  324 }
+};
+
+const double sc_number::mExact[23] =
+{
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/**
+ * Prints an integer.
+ * @param buf Buffer of at least NUMBER_BUF_SIZE characters.
+ * @param value Number to be printed.
+ * @return Number of characters written, not counting the terminating zero.
+ */
+long sc_number::format_int(char *buf, long value)
+{
+  if(value < 0)
+  {
+    *buf = '-';
+    return format_uint(buf+1, (uint64_t)0 - (uint64_t)value) + 1;
+  }
+
+  return format_uint(buf, (uint64_t)value);
+}
+
+/**
+ * Prints an unsigned integer two digits at a time.
+ * @param buf Buffer of at least NUMBER_BUF_SIZE characters.
+ * @param value Number to be printed.
+ * @return Number of characters written, not counting the terminating zero.
+ */
+long sc_number::format_uint(char *buf, uint64_t value)
+{
+  char tmp[20];
+  char *ptr = tmp + 20;
+
+  while(value >= 100)
+  {
+    unsigned idx = (unsigned)(value % 100) * 2;
+    value /= 100;
+    *--ptr = mDigits[idx+1];
+    *--ptr = mDigits[idx];
+  }
+
+  if(value >= 10)
+  {
+    unsigned idx = (unsigned)value * 2;
+    *--ptr = mDigits[idx+1];
+    *--ptr = mDigits[idx];
+  }
+  else
+    *--ptr = '0' + (char)value;
+
+  long len = tmp + 20 - ptr;
+  memcpy(buf, ptr, len);
+  buf[len] = '\0';
+  return len;
+}
+
+/**
+ * Prints a float with the shortest sequence of digits that reads back as
+ * the same value. Floats always have a decimal point, exponent notation
+ * is used for very large and very small values only.
+ * @param buf Buffer of at least NUMBER_BUF_SIZE characters.
+ * @param value Number to be printed.
+ * @return Number of characters written, not counting the terminating zero.
+ */
+long sc_number::format_float(char *buf, double value)
+{
+  char *ptr = buf;
+
+  if(std::isnan(value))
+  {
+    strcpy(buf, "nan");
+    return 3;
+  }
+
+  if(std::signbit(value))
+  {
+    *ptr++ = '-';
+    value = -value;
+  }
+
+  if(std::isinf(value))
+  {
+    strcpy(ptr, "inf");
+    return ptr - buf + 3;
+  }
+
+  if(value == 0)
+  {
+    strcpy(ptr, "0.0");
+    return ptr - buf + 3;
+  }
+
+  char digits[18];
+  int len = 0, exp = 0;
+  if(!grisu3(digits, len, exp, value))
+    shortest(digits, len, exp, value);
+
+  // position of the decimal point relative to the first digit
+  int point = len + exp;
+  if(point > -6 && point <= 21)
+  {
+    if(exp >= 0)
+    {
+      // 1234000.0
+      memcpy(ptr, digits, len);
+      ptr += len;
+      for(int idx = 0; idx < exp; idx++)
+        *ptr++ = '0';
+      *ptr++ = '.';
+      *ptr++ = '0';
+    }
+    else if(point > 0)
+    {
+      // 12.34
+      memcpy(ptr, digits, point);
+      ptr += point;
+      *ptr++ = '.';
+      memcpy(ptr, digits + point, len - point);
+      ptr += len - point;
+    }
+    else
+    {
+      // 0.001234
+      *ptr++ = '0';
+      *ptr++ = '.';
+      for(int idx = point; idx < 0; idx++)
+        *ptr++ = '0';
+      memcpy(ptr, digits, len);
+      ptr += len;
+    }
+  }
+  else
+  {
+    // 1.234e+56
+    *ptr++ = digits[0];
+    *ptr++ = '.';
+    if(len > 1)
+    {
+      memcpy(ptr, digits + 1, len - 1);
+      ptr += len - 1;
+    }
+    else
+      *ptr++ = '0';
+
+    int e10 = point - 1;
+    *ptr++ = 'e';
+    *ptr++ = e10 < 0 ? '-' : '+';
+    if(e10 < 0) e10 = -e10;
+    if(e10 < 10)
+      *ptr++ = '0';
+    ptr += format_uint(ptr, e10);
+  }
+
+  *ptr = '\0';
+  return ptr - buf;
+}
+
+/**
+ * Parses an integer the way atol does: leading whitespace is skipped,
+ * parsing stops at the first non-digit, overflowing values saturate.
+ * @param str String to be parsed.
+ * @param len Length of the string (0 to stop at the terminating zero).
+ * @return Parsed value.
+ */
+long sc_number::parse_int(const char *str, long len)
+{
+  const char *end = len ? str + len : NULL;
+  #define NUM_MORE (end ? str < end : *str != '\0')
+
+  while(NUM_MORE && isspace((unsigned char)*str)) str++;
+
+  bool negative = false;
+  if(NUM_MORE && (*str == '-' || *str == '+'))
+    negative = (*str++ == '-');
+
+  uint64_t limit = negative ? (uint64_t)LONG_MAX + 1 : (uint64_t)LONG_MAX;
+  uint64_t value = 0;
+  while(NUM_MORE && *str >= '0' && *str <= '9')
+  {
+    unsigned digit = *str++ - '0';
+    if(value > (limit - digit) / 10)
+    {
+      value = limit;
+      break;
+    }
+    value = value * 10 + digit;
+  }
+
+  #undef NUM_MORE
+  return negative ? (long)((uint64_t)0 - value) : (long)value;
+}
+
+/**
+ * Parses a float the way atof does.
+ * Decimal numbers with up to 15 significant digits and a moderate exponent
+ * are converted exactly without strtod, the rest is handed over to it.
+ * @param str String to be parsed.
+ * @param len Length of the string (0 to stop at the terminating zero).
+ * @return Parsed value.
+ */
+double sc_number::parse_float(const char *str, long len)
+{
+  const char *start = str, *end = len ? str + len : NULL;
+  #define NUM_MORE (end ? str < end : *str != '\0')
+  #define NUM_DIGIT (NUM_MORE && *str >= '0' && *str <= '9')
+
+  while(NUM_MORE && isspace((unsigned char)*str)) str++;
+
+  bool negative = false;
+  if(NUM_MORE && (*str == '-' || *str == '+'))
+    negative = (*str++ == '-');
+
+  uint64_t mant = 0;
+  int digits = 0, exp10 = 0;
+  bool any = false, exact = true;
+
+  for(; NUM_DIGIT; str++)
+  {
+    any = true;
+    if(digits < 19)
+    {
+      mant = mant * 10 + (*str - '0');
+      if(mant) digits++;
+    }
+    else
+    {
+      exp10++;
+      if(*str != '0') exact = false;
+    }
+  }
+
+  if(NUM_MORE && *str == '.')
+  {
+    for(str++; NUM_DIGIT; str++)
+    {
+      any = true;
+      if(digits < 19)
+      {
+        mant = mant * 10 + (*str - '0');
+        if(mant) digits++;
+        exp10--;
+      }
+      else if(*str != '0')
+        exact = false;
+    }
+  }
+
+  if(any && NUM_MORE && (*str == 'e' || *str == 'E'))
+  {
+    const char *save = str++;
+    bool exp_negative = false;
+    if(NUM_MORE && (*str == '-' || *str == '+'))
+      exp_negative = (*str++ == '-');
+
+    if(NUM_DIGIT)
+    {
+      int exp = 0;
+      for(; NUM_DIGIT; str++)
+        if(exp < 100000) exp = exp * 10 + (*str - '0');
+      exp10 += exp_negative ? -exp : exp;
+    }
+    else
+      str = save;
+  }
+
+  #undef NUM_DIGIT
+  #undef NUM_MORE
+
+  if(any && exact)
+  {
+    if(!mant)
+      return negative ? -0.0 : 0.0;
+
+    // both the significand and the power of 10 are exact doubles,
+    // so a single multiplication or division rounds correctly
+    if(mant <= ((uint64_t)1 << 53) && exp10 >= -22 && exp10 <= 22)
+    {
+      double value = (double)mant;
+      value = exp10 < 0 ? value / mExact[-exp10] : value * mExact[exp10];
+      return negative ? -value : value;
+    }
+  }
+
+  // hard cases, inf and nan
+  if(!end)
+    return strtod(start, NULL);
+
+  char *buf = new char[len+1];
+  if(!buf) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  memcpy(buf, start, len);
+  buf[len] = '\0';
+  double value = strtod(buf, NULL);
+  delete [] buf;
+  return value;
+}
+
+/**
+ * Multiplies two diy floats, rounding the result to 64 bits.
+ */
+inline sc_number::diyfp sc_number::mul(diyfp x, diyfp y)
+{
+  uint64_t a = x.f >> 32, b = x.f & 0xFFFFFFFFu;
+  uint64_t c = y.f >> 32, d = y.f & 0xFFFFFFFFu;
+  uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+  uint64_t mid = (bd >> 32) + (ad & 0xFFFFFFFFu) + (bc & 0xFFFFFFFFu);
+  mid += (uint64_t)1 << 31;
+
+  diyfp res;
+  res.f = ac + (ad >> 32) + (bc >> 32) + (mid >> 32);
+  res.e = x.e + y.e + 64;
+  return res;
+}
+
+/**
+ * Shifts a diy float so that the highest bit of the significand is set.
+ */
+inline sc_number::diyfp sc_number::normalize(diyfp x)
+{
+  while(!(x.f >> 63))
+  {
+    x.f <<= 1;
+    x.e--;
+  }
+  return x;
+}
+
+/**
+ * Generates the shortest digits of a positive finite double (Grisu3 by F. Loitsch).
+ * The digits are computed with 64-bit arithmetic, whose error is tracked: if
+ * the result cannot be proven to be the shortest and closest one, the
+ * function gives up.
+ * @param buf Buffer for at least 17 digits.
+ * @param len Number of digits generated.
+ * @param exp Decimal exponent: value = digits * 10^exp.
+ * @param value Number to be converted.
+ * @return false if the digits have to be found by shortest() instead.
+ */
+bool sc_number::grisu3(char *buf, int &len, int &exp, double value)
+{
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint64_t frac = bits & (((uint64_t)1 << 52) - 1);
+  int bexp = (int)(bits >> 52);
+
+  diyfp v;
+  if(bexp)
+  {
+    v.f = frac | ((uint64_t)1 << 52);
+    v.e = bexp - 1075;
+  }
+  else
+  {
+    v.f = frac;
+    v.e = -1074;
+  }
+
+  // boundaries between value and it's neighbours; the lower one is closer
+  // when the value is a power of 2
+  diyfp m_plus, m_minus;
+  m_plus.f = (v.f << 1) + 1;
+  m_plus.e = v.e - 1;
+  if(!frac && bexp > 1)
+  {
+    m_minus.f = (v.f << 2) - 1;
+    m_minus.e = v.e - 2;
+  }
+  else
+  {
+    m_minus.f = (v.f << 1) - 1;
+    m_minus.e = v.e - 1;
+  }
+
+  m_plus = normalize(m_plus);
+  m_minus.f <<= m_minus.e - m_plus.e;
+  m_minus.e = m_plus.e;
+  v = normalize(v);
+
+  // pick a cached power bringing the exponent into [-60, -32]
+  int f = -60 - m_plus.e - 1;
+  int k = (f * 78913) / (1 << 18) + (f > 0);
+  const cached_power &cached = mPowers[(300 + k + 7) / 8];
+  diyfp c;
+  c.f = cached.f;
+  c.e = cached.e;
+
+  diyfp w = mul(v, c), w_minus = mul(m_minus, c), w_plus = mul(m_plus, c);
+  exp = -cached.k;
+
+  // every product is off by less than one unit, so digits inside the
+  // widened (unsafe) interval may or may not read back as the value
+  uint64_t unit = 1;
+  uint64_t too_high = w_plus.f + unit;
+  uint64_t delta = too_high - (w_minus.f - unit);
+  uint64_t dist = too_high - w.f;
+  int shift = -w_plus.e;
+  uint64_t one = (uint64_t)1 << shift;
+  uint32_t p1 = (uint32_t)(too_high >> shift);
+  uint64_t p2 = too_high & (one - 1);
+
+  uint32_t pow10 = 1000000000;
+  int n = 10;
+  while(n > 1 && p1 < pow10)
+  {
+    pow10 /= 10;
+    n--;
+  }
+
+  len = 0;
+  while(n > 0)
+  {
+    buf[len++] = (char)('0' + p1 / pow10);
+    p1 %= pow10;
+    n--;
+
+    uint64_t rest = ((uint64_t)p1 << shift) + p2;
+    if(rest < delta)
+    {
+      exp += n;
+      return round_weed(buf, len, dist, delta, rest, (uint64_t)pow10 << shift, unit);
+    }
+    pow10 /= 10;
+  }
+
+  int m = 0;
+  for(;;)
+  {
+    p2 *= 10;
+    unit *= 10;
+    delta *= 10;
+    buf[len++] = (char)('0' + (p2 >> shift));
+    p2 &= one - 1;
+    m++;
+    if(p2 < delta) break;
+  }
+
+  exp -= m;
+  return round_weed(buf, len, dist * unit, delta, p2, one, unit);
+}
+
+/**
+ * Moves the last generated digit towards the exact value while staying
+ * inside the rounding interval, then checks that the digits are certainly
+ * the closest ones despite the error of the computation.
+ * @param buf Digits.
+ * @param len Number of digits.
+ * @param dist Distance from the upper end of the unsafe interval to the value.
+ * @param delta Width of the unsafe interval.
+ * @param rest Distance from the upper end of the unsafe interval to the digits.
+ * @param ten_k Weight of the last digit.
+ * @param unit Maximal error of the computation.
+ * @return false if the digits cannot be proven to be right.
+ */
+bool sc_number::round_weed(char *buf, int len, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t ten_k, uint64_t unit)
+{
+  uint64_t small_dist = dist - unit, big_dist = dist + unit;
+
+  while(rest < small_dist && delta - rest >= ten_k && (rest + ten_k < small_dist || small_dist - rest >= rest + ten_k - small_dist))
+  {
+    buf[len-1]--;
+    rest += ten_k;
+  }
+
+  // the digits could be moved further if the value was at the other end of the error
+  if(rest < big_dist && delta - rest >= ten_k && (rest + ten_k < big_dist || big_dist - rest > rest + ten_k - big_dist))
+    return false;
+
+  return 2 * unit <= rest && rest <= delta - 4 * unit;
+}
+
+/**
+ * Finds the shortest digits of a positive finite double by trying more and
+ * more of them until the number reads back as the same value. Used for about
+ * one value in two hundred, which Grisu3 cannot decide.
+ * @param buf Buffer for at least 17 digits.
+ * @param len Number of digits generated.
+ * @param exp Decimal exponent: value = digits * 10^exp.
+ * @param value Number to be converted.
+ */
+void sc_number::shortest(char *buf, int &len, int &exp, double value)
+{
+  char tmp[32];
+  for(int prec = 1; prec <= 17; prec++)
+  {
+    snprintf(tmp, sizeof(tmp), "%.*e", prec - 1, value);
+    if(prec < 17 && strtod(tmp, NULL) != value)
+      continue;
+
+    // the decimal point depends on the locale, only digits are taken
+    char *ptr = tmp;
+    len = 0;
+    for(; *ptr != 'e'; ptr++)
+      if(*ptr >= '0' && *ptr <= '9')
+        buf[len++] = *ptr;
+
+    exp = atoi(ptr + 1) - (len - 1);
+    while(len > 1 && buf[len-1] == '0')
+    {
+      len--;
+      exp++;
+    }
+    return;
+  }
+}
+
+#endif
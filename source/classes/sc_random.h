@@ -10,12 +10,15 @@
 
 int sc_random::state[624] = {0};
 int sc_random::index = 0;
+std::mutex sc_random::mLock;
 
 /**
  * (Re)-seeds the generator with specified integer.
  */
 void sc_random::seed(int new_seed)
 {
+  std::lock_guard<std::mutex> lock(mLock);
+
   index = 0;
   state[0] = new_seed;
   for(int i = 1; i < 624; ++i)
@@ -30,6 +33,8 @@ void sc_random::seed(int new_seed)
  */
 int sc_random::get_next()
 {
+  std::lock_guard<std::mutex> lock(mLock);
+
   if(index == 0)
   {
     generate();
@@ -0,0 +1,246 @@
+/**
+ * @file sc_reactor.h
+ * @author impworks.
+ * sc_reactor header.
+ * Defines properties and methods of sc_reactor class.
+ */
+
+#ifndef SC_REACTOR_H
+#define SC_REACTOR_H
+
+#if MALCO_PLATFORM == M_PLATF_NIX
+
+/**
+ * sc_reactor constructor.
+ */
+sc_reactor::sc_reactor()
+{
+  mFd = epoll_create1(EPOLL_CLOEXEC);
+  if(mFd < 0) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  mWatched = 0;
+  mStop = false;
+  pAio = NULL;
+}
+
+/**
+ * sc_reactor destructor.
+ * Sockets still watched are left to the head, which is gone by then.
+ */
+sc_reactor::~sc_reactor()
+{
+  ::close(mFd);
+}
+
+/**
+ * Starts, updates or stops watching a socket, depending on
+ * whether it has callbacks or output waiting to be sent.
+ * @param head Head the socket belongs to.
+ * @param obj Socket object.
+ */
+void sc_reactor::watch(rc_head *head, ic_object *obj)
+{
+  ic_socket *sock = (ic_socket *)obj->mData;
+
+  int events = 0;
+  if(sock->mFd >= 0)
+  {
+    if(sock->pOnRead && !sock->mEof)
+      events |= EPOLLIN;
+    if(sock->pending() || sock->pOnWrite)
+      events |= EPOLLOUT;
+  }
+
+  if(!events)
+  {
+    forget(head, sock);
+    return;
+  }
+
+  if(events == sock->mEvents)
+    return;
+
+  epoll_event ev;
+  ev.events = events;
+
+  if(!sock->pWatch)
+  {
+    sock->pWatch = new rc_var(obj);
+    if(!sock->pWatch) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+    ev.data.ptr = sock->pWatch;
+    epoll_ctl(mFd, EPOLL_CTL_ADD, sock->mFd, &ev);
+    mWatched++;
+  }
+  else
+  {
+    ev.data.ptr = sock->pWatch;
+    epoll_ctl(mFd, EPOLL_CTL_MOD, sock->mFd, &ev);
+  }
+
+  sock->mEvents = events;
+}
+
+/**
+ * Stops watching a socket.
+ * The socket may be released by the head right away.
+ * @param head Head the socket belongs to.
+ * @param sock Socket.
+ */
+void sc_reactor::forget(rc_head *head, ic_socket *sock)
+{
+  if(!sock->pWatch) return;
+
+  if(sock->mFd >= 0)
+    epoll_ctl(mFd, EPOLL_CTL_DEL, sock->mFd, NULL);
+
+  rc_var *var = sock->pWatch;
+  sock->pWatch = NULL;
+  sock->mEvents = 0;
+  mWatched--;
+
+  head->obj_unlink(var);
+}
+
+/**
+ * Watches the completions of asynchronous file operations.
+ * Their descriptor is told from sockets by the lack of a variable.
+ * @param aio Asynchronous file operations.
+ */
+void sc_reactor::attach(sc_aio *aio)
+{
+  epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.ptr = NULL;
+  epoll_ctl(mFd, EPOLL_CTL_ADD, aio->fd(), &ev);
+
+  pAio = aio;
+}
+
+/**
+ * Runs the callbacks of sockets that are ready and of file operations that
+ * have completed, until no sockets are watched and no operations are left,
+ * the loop is stopped or a callback throws an exception.
+ * @param head Head to run the callbacks on.
+ * @param timeout Milliseconds to wait for an event, -1 for ever.
+ * @return Number of events handled.
+ */
+long sc_reactor::run(rc_head *head, long timeout)
+{
+  epoll_event events[REACTOR_EVENTS];
+  long count = 0;
+  mStop = false;
+
+  while((mWatched || pAio && pAio->length()) && !mStop && head->mState == M_STATE_RUN)
+  {
+    int ready = epoll_wait(mFd, events, REACTOR_EVENTS, timeout);
+    if(ready < 0 && errno == EINTR)
+      continue;
+
+    if(ready <= 0)
+      break;
+
+    // callbacks may close other sockets of the same batch
+    for(int idx=0; idx<ready; idx++)
+      if(events[idx].data.ptr)
+        ((rc_var *)events[idx].data.ptr)->mLinks++;
+
+    for(int idx=0; idx<ready; idx++)
+    {
+      rc_var *var = (rc_var *)events[idx].data.ptr;
+      if(!var)
+      {
+        if(!mStop && head->mState == M_STATE_RUN)
+          count += pAio->dispatch(head);
+
+        continue;
+      }
+
+      if(!mStop && head->mState == M_STATE_RUN && ((ic_socket *)var->get()->mData)->pWatch == var)
+      {
+        dispatch(head, var, events[idx].events);
+        count++;
+      }
+
+      head->obj_unlink(var);
+    }
+  }
+
+  mStop = false;
+  return count;
+}
+
+/**
+ * Asks the loop to stop after the current callback.
+ */
+inline void sc_reactor::stop()
+{
+  mStop = true;
+}
+
+/**
+ * Returns the number of sockets watched.
+ */
+inline long sc_reactor::length()
+{
+  return mWatched;
+}
+
+/**
+ * Handles the events of a socket.
+ * Data is received before the read callback is called, and the write
+ * callback is called once, after everything written has been sent.
+ * @param head Head to run the callbacks on.
+ * @param var Variable held by the reactor for the socket.
+ * @param events Events that have occured.
+ */
+void sc_reactor::dispatch(rc_head *head, rc_var *var, int events)
+{
+  ic_object *obj = var->get();
+  ic_socket *sock = (ic_socket *)obj->mData;
+
+  if(events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+  {
+    sock->fill();
+    if(sock->pOnRead)
+      call(head, sock->pOnRead, var);
+  }
+
+  if(events & (EPOLLOUT | EPOLLHUP | EPOLLERR))
+  {
+    sock->flush();
+    if(!sock->pending() && sock->pOnWrite && head->mState == M_STATE_RUN)
+    {
+      rc_var *fx = sock->pOnWrite;
+      sock->pOnWrite = NULL;
+      call(head, fx, var);
+      head->obj_unlink(fx);
+    }
+  }
+
+  if(sock->pWatch == var)
+    watch(head, obj);
+}
+
+/**
+ * Calls a callback with the socket as the argument.
+ * @param head Head to run the callback on.
+ * @param fx Variable holding the method.
+ * @param var Variable holding the socket.
+ */
+void sc_reactor::call(rc_head *head, rc_var *fx, rc_var *var)
+{
+  // the callback may replace itself
+  fx->mLinks++;
+  var->mLinks++;
+
+  head->rSRC.push(var);
+  head->method_invoke((rc_method *)fx->get()->mData);
+  head->cmd_clrsrc();
+
+  head->obj_unlink(fx);
+}
+
+#endif
+
+#endif
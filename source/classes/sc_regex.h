@@ -0,0 +1,2387 @@
+/**
+ * @file sc_regex.h
+ * @author impworks.
+ * sc_regex class header.
+ * Defines properties and methods of sc_regex class.
+ */
+
+#ifndef SC_REGEX_H
+#define SC_REGEX_H
+
+#define RX_NODE_EMPTY       0
+#define RX_NODE_CHAR        1
+#define RX_NODE_SET         2
+#define RX_NODE_CAT         3
+#define RX_NODE_ALT         4
+#define RX_NODE_GROUP       5
+#define RX_NODE_REPEAT      6
+#define RX_NODE_ASSERT      7
+#define RX_NODE_BACKREF     8
+#define RX_NODE_LOOK        9
+#define RX_NODE_ACCEPT      10
+
+#define RX_OP_CHAR          0
+#define RX_OP_CLASS         1
+#define RX_OP_SPLIT         2
+#define RX_OP_JMP           3
+#define RX_OP_SAVE          4
+#define RX_OP_ASSERT        5
+#define RX_OP_LOOK          6
+#define RX_OP_BACKREF       7
+#define RX_OP_NULLSET       8
+#define RX_OP_NULLCHK       9
+#define RX_OP_MATCH         10
+
+#define RX_ASSERT_BOL       0
+#define RX_ASSERT_MBOL      1
+#define RX_ASSERT_EOL       2
+#define RX_ASSERT_MEOL      3
+#define RX_ASSERT_BOT       4
+#define RX_ASSERT_EOT       5
+#define RX_ASSERT_WORD      6
+#define RX_ASSERT_NWORD     7
+
+#define RX_LOOK_NEGATE      1
+#define RX_LOOK_BEHIND      2
+
+#define RX_SET_SIZE         32
+#define RX_VM_MAX_REGISTERS 4
+#define RX_SET_HAS(set, chr) ((set)[(unsigned char)(chr) >> 3] & (1 << ((unsigned char)(chr) & 7)))
+#define RX_IS_WORD(chr) (isalnum((unsigned char)(chr)) || (chr) == '_')
+
+/**
+ * sc_regex constructor.
+ */
+sc_regex::sc_regex()
+{
+  mProgram = NULL;
+  mLength = 0;
+  mSets = NULL;
+  mNumSets = 0;
+  mLooks = NULL;
+  mNumLooks = 0;
+  mGroups = 1;
+  mRegisters = 0;
+  mAnchored = false;
+  mBacktrack = false;
+  mLookKind = 0;
+  mMinWidth = 0;
+  mMaxWidth = 0;
+  mSaves = false;
+
+  mByteClasses = 0;
+  mStates = NULL;
+  mNumStates = 0;
+  mStateHash = NULL;
+  mDFAFailed = false;
+  mLinks = 1;
+  mPatterns = 0;
+
+  mPrefixLen = 0;
+  mPrefixRare = 0;
+  mRequiredLen = 0;
+  mRequiredRare = 0;
+}
+
+/**
+ * sc_regex destructor.
+ */
+sc_regex::~sc_regex()
+{
+  dfa_flush();
+  delete [] mStates;
+  delete [] mStateHash;
+
+  for(int idx=0; idx<mNumLooks; idx++)
+    delete mLooks[idx];
+
+  delete [] mLooks;
+  delete [] mSets;
+  delete [] mProgram;
+}
+
+/**
+ * Compiles a regular expression.
+ * @param pattern Regular expression body (without slashes and modifiers).
+ * @param len Length of the pattern.
+ * @param flags REGEX_* flags.
+ * @param[out] error Error message if compilation failed.
+ * @param[out] error_pos Pattern position that caused the error.
+ * @return Compiled program or NULL.
+ */
+sc_regex *sc_regex::compile(const char *pattern, long len, int flags, const char **error, long *error_pos)
+{
+  int groups;
+  node *tree = parse(pattern, len, flags, &groups, error, error_pos);
+  if(!tree) return NULL;
+
+  // the match can only start at the offset if the pattern begins with ^ or \A
+  node *first = tree;
+  while(first->type == RX_NODE_CAT || first->type == RX_NODE_GROUP)
+    first = first->left;
+  bool anchored = first->type == RX_NODE_ASSERT && (first->value == RX_ASSERT_BOL || first->value == RX_ASSERT_BOT);
+
+  sc_regex *result = build(tree, groups, anchored, error);
+  if(!result)
+  {
+    node_free(tree);
+    *error_pos = -1;
+    return NULL;
+  }
+
+  // literals the matches cannot do without
+  literal info;
+  node_literal(tree, &info);
+  node_free(tree);
+
+  if(info.pre_len)
+  {
+    memcpy(result->mPrefix, info.pre, info.pre_len);
+    result->mPrefixLen = info.pre_len;
+    result->mPrefixRare = literal_rare(info.pre, info.pre_len);
+  }
+
+  if(info.req_len > info.pre_len)
+  {
+    memcpy(result->mRequired, info.req, info.req_len);
+    result->mRequiredLen = info.req_len;
+    result->mRequiredRare = literal_rare(info.req, info.req_len);
+  }
+
+  return result;
+}
+
+/**
+ * Compiles several regular expressions into one program for scan().
+ * Every pattern ends with its own MATCH instruction that carries its index.
+ * @param count Number of patterns.
+ * @param patterns Regular expression bodies.
+ * @param lens Lengths of the patterns.
+ * @param flags REGEX_* flags of every pattern.
+ * @param[out] error Error message if compilation failed.
+ * @return Compiled program or NULL.
+ */
+sc_regex *sc_regex::compile_set(long count, const char **patterns, const long *lens, const int *flags, const char **error)
+{
+  node **trees = new node*[count];
+  if(!trees) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  long error_pos;
+  int max_groups = 0, groups;
+  for(long idx=0; idx<count; idx++)
+  {
+    trees[idx] = parse(patterns[idx], lens[idx], flags[idx], &groups, error, &error_pos);
+    if(!trees[idx])
+    {
+      for(long prev=0; prev<idx; prev++)
+        node_free(trees[prev]);
+      delete [] trees;
+      return NULL;
+    }
+
+    if(groups > max_groups) max_groups = groups;
+    node *accept = node_new(RX_NODE_ACCEPT);
+    accept->value = idx;
+    trees[idx] = node_new(RX_NODE_CAT, trees[idx], accept);
+  }
+
+  node *tree = node_join(trees, 0, count);
+  delete [] trees;
+
+  sc_regex *result = build(tree, max_groups, false, error);
+  node_free(tree);
+  if(result) result->mPatterns = count;
+
+  return result;
+}
+
+/**
+ * Returns the number of capture groups including the whole match.
+ */
+inline int sc_regex::groups()
+{
+  return mGroups;
+}
+
+/**
+ * Returns the approximate memory taken by the compiled program.
+ * The DFA cache is not accounted for, it is bounded by REGEX_DFA_MAX_STATES.
+ */
+long sc_regex::size()
+{
+  long result = sizeof(sc_regex) + mLength * sizeof(inst) + mNumSets * RX_SET_SIZE;
+  for(int idx=0; idx<mNumLooks; idx++)
+    result += mLooks[idx]->size();
+
+  return result;
+}
+
+/**
+ * Prepares the DFA so that the first match does not pay for it.
+ */
+void sc_regex::study()
+{
+  if(!mStates && !mDFAFailed) dfa_init();
+}
+
+/**
+ * Checks whether the DFA alone decides if the program matches.
+ * Assertions, lookarounds and back references are only approximated by it.
+ */
+bool sc_regex::exact()
+{
+  for(int pc=0; pc<mLength; pc++)
+    if(mProgram[pc].op == RX_OP_ASSERT || mProgram[pc].op == RX_OP_LOOK || mProgram[pc].op == RX_OP_BACKREF)
+      return false;
+
+  return true;
+}
+
+/**
+ * Searches the string for the leftmost match.
+ * @param str String to be matched.
+ * @param len Length of the string.
+ * @param offset Position to start searching from.
+ * @param[out] captures Array of groups()*2 offsets, -1 for unset groups.
+ * @return Whether a match was found.
+ */
+bool sc_regex::exec(const char *str, long len, long offset, long *captures)
+{
+  for(int idx=0; idx<mGroups*2; idx++)
+    captures[idx] = -1;
+
+  if(offset < 0 || offset > len) return false;
+
+  // input without the required literals is rejected by memchr alone
+  if(mRequiredLen && literal_find(str, len, offset, mRequired, mRequiredLen, mRequiredRare) < 0)
+    return false;
+
+  if(mPrefixLen)
+  {
+    if(mAnchored)
+    {
+      if(len - offset < mPrefixLen || memcmp(str + offset, mPrefix, mPrefixLen)) return false;
+    }
+    else if((offset = literal_find(str, len, offset, mPrefix, mPrefixLen, mPrefixRare)) < 0)
+      return false;
+  }
+
+  // the DFA is cheap and tells for sure if there is no match
+  if(!mDFAFailed && dfa_run(str, len, offset) == 0)
+    return false;
+
+  if(mBacktrack)
+    return run_backtrack(str, len, offset, -1, captures);
+  else
+    return run_vm(str, len, offset, -1, captures);
+}
+
+/**
+ * Finds out which patterns of a compile_set() program occur in the string.
+ * The string is read once by the DFA whatever the number of patterns is.
+ * Patterns that are not exact() may be reported falsely and must be verified.
+ * @param str String to be scanned.
+ * @param len Length of the string.
+ * @param[out] found Flags for every pattern, must be zeroed by the caller.
+ * @return Number of patterns found.
+ */
+long sc_regex::scan(const char *str, long len, char *found)
+{
+  if(!mStates) dfa_init();
+
+  char *seen = new char[REGEX_DFA_MAX_STATES];
+  if(!seen) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  memset(seen, 0, REGEX_DFA_MAX_STATES);
+
+  int curr = 0;
+  long count = dfa_accept(curr, seen, found);
+
+  for(long pos=0; pos<len && count<mPatterns; pos++)
+  {
+    unsigned char chr = str[pos];
+    int next = mStates[curr]->next[mByteMap[chr]];
+    if(next < 0)
+    {
+      next = dfa_step(curr, chr);
+      if(next < 0)
+      {
+        // too many states: start the cache over from the current one
+        curr = dfa_restart(curr);
+        memset(seen, 0, REGEX_DFA_MAX_STATES);
+        next = dfa_step(curr, chr);
+      }
+    }
+
+    curr = next;
+    count += dfa_accept(curr, seen, found);
+  }
+
+  delete [] seen;
+  return count;
+}
+
+//--------------------------------
+//          syntax tree
+//--------------------------------
+
+/**
+ * Creates a syntax tree node.
+ */
+sc_regex::node *sc_regex::node_new(int type, node *left, node *right)
+{
+  node *item = new node();
+  if(!item) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  item->type = type;
+  item->value = 0;
+  item->min = 0;
+  item->max = 0;
+  item->greedy = true;
+  item->set = NULL;
+  item->left = left;
+  item->right = right;
+  return item;
+}
+
+/**
+ * Deletes a syntax tree.
+ */
+void sc_regex::node_free(node *item)
+{
+  if(!item) return;
+  node_free(item->left);
+  node_free(item->right);
+  delete [] item->set;
+  delete item;
+}
+
+/**
+ * Joins syntax trees into a balanced alternation, so that large sets do not nest deeply.
+ * @param trees Trees to join, they are owned by the result.
+ * @param from First tree.
+ * @param to Position after the last tree.
+ */
+sc_regex::node *sc_regex::node_join(node **trees, long from, long to)
+{
+  if(to - from == 1) return trees[from];
+
+  long middle = from + (to - from) / 2;
+  return node_new(RX_NODE_ALT, node_join(trees, from, middle), node_join(trees, middle, to));
+}
+
+/**
+ * Collects literals that every match of the node starts with, ends with and contains.
+ * Only plain characters are accounted for: sets, back references and optional
+ * parts break literals, zero-width assertions are skipped.
+ * @param[out] info Literals of the node.
+ */
+void sc_regex::node_literal(node *item, literal *info)
+{
+  literal left, right;
+  int count = 0;
+
+  info->pre_len = info->suf_len = info->req_len = 0;
+  info->full = false;
+
+  switch(item->type)
+  {
+    case RX_NODE_SET:
+      // a one-character set is a character
+      for(int code=0; code<256; code++)
+        if(RX_SET_HAS(item->set, code) && count++ == 0)
+          info->pre[0] = (char)code;
+      if(count != 1) break;
+
+      info->suf[0] = info->req[0] = info->pre[0];
+      info->pre_len = info->suf_len = info->req_len = 1;
+      info->full = true;
+      break;
+
+    case RX_NODE_CHAR:
+      info->pre[0] = info->suf[0] = info->req[0] = (char)item->value;
+      info->pre_len = info->suf_len = info->req_len = 1;
+      info->full = true;
+      break;
+
+    case RX_NODE_EMPTY:
+    case RX_NODE_ASSERT:
+    case RX_NODE_LOOK:
+      info->full = true;
+      break;
+
+    case RX_NODE_GROUP:
+      node_literal(item->left, info);
+      break;
+
+    case RX_NODE_CAT:
+      node_literal(item->left, &left);
+      node_literal(item->right, &right);
+      literal_cat(&left, &right, info);
+      break;
+
+    case RX_NODE_ALT:
+      node_literal(item->left, &left);
+      node_literal(item->right, &right);
+      info->full = left.full && right.full && left.pre_len == right.pre_len && !memcmp(left.pre, right.pre, left.pre_len);
+
+      while(info->pre_len < left.pre_len && info->pre_len < right.pre_len && left.pre[info->pre_len] == right.pre[info->pre_len])
+        info->pre_len++;
+      memcpy(info->pre, left.pre, info->pre_len);
+
+      while(info->suf_len < left.suf_len && info->suf_len < right.suf_len
+        && left.suf[left.suf_len - info->suf_len - 1] == right.suf[right.suf_len - info->suf_len - 1])
+        info->suf_len++;
+      memcpy(info->suf, left.suf + left.suf_len - info->suf_len, info->suf_len);
+
+      literal_best(info, info->pre, info->pre_len);
+      literal_best(info, info->suf, info->suf_len);
+      break;
+
+    case RX_NODE_REPEAT:
+      if(item->min == 0) break;
+
+      node_literal(item->left, &left);
+      if(left.full && item->min == item->max)
+      {
+        *info = left;
+        for(int idx=1; idx<item->min && info->full; idx++)
+        {
+          right = *info;
+          literal_cat(&right, &left, info);
+        }
+      }
+      else
+      {
+        *info = left;
+        info->full = false;
+      }
+      break;
+  }
+}
+
+/**
+ * Combines literals of two consecutive nodes.
+ * @param[out] info Literals of the concatenation.
+ */
+void sc_regex::literal_cat(literal *left, literal *right, literal *info)
+{
+  literal result;
+  result.full = left->full && right->full && left->pre_len + right->pre_len <= REGEX_LITERAL_MAX;
+
+  // the prefix goes on while the left part is fixed
+  result.pre_len = left->pre_len;
+  memcpy(result.pre, left->pre, left->pre_len);
+  if(left->full)
+  {
+    int len = right->pre_len < REGEX_LITERAL_MAX - result.pre_len ? right->pre_len : REGEX_LITERAL_MAX - result.pre_len;
+    memcpy(result.pre + result.pre_len, right->pre, len);
+    result.pre_len += len;
+  }
+
+  // the suffix goes on while the right part is fixed
+  char buf[REGEX_LITERAL_MAX * 2];
+  int len = 0;
+  if(right->full)
+  {
+    memcpy(buf, left->suf, left->suf_len);
+    len = left->suf_len;
+  }
+  memcpy(buf + len, right->suf, right->suf_len);
+  len += right->suf_len;
+  result.suf_len = len < REGEX_LITERAL_MAX ? len : REGEX_LITERAL_MAX;
+  memcpy(result.suf, buf + len - result.suf_len, result.suf_len);
+
+  // the longest required string may cross the border
+  result.req_len = 0;
+  memcpy(buf, left->suf, left->suf_len);
+  memcpy(buf + left->suf_len, right->pre, right->pre_len);
+  literal_best(&result, buf, left->suf_len + right->pre_len);
+  literal_best(&result, left->req, left->req_len);
+  literal_best(&result, right->req, right->req_len);
+  literal_best(&result, result.pre, result.pre_len);
+  literal_best(&result, result.suf, result.suf_len);
+
+  *info = result;
+}
+
+/**
+ * Keeps the string as the required literal if it is longer than the current one.
+ * Strings above REGEX_LITERAL_MAX are cut.
+ */
+void sc_regex::literal_best(literal *info, const char *str, int len)
+{
+  if(len > REGEX_LITERAL_MAX) len = REGEX_LITERAL_MAX;
+  if(len <= info->req_len) return;
+
+  memmove(info->req, str, len);
+  info->req_len = len;
+}
+
+/**
+ * Picks the byte of a literal that is likely the rarest in text.
+ * Punctuation and capitals are preferred to digits, lowercase letters and spaces.
+ * @return Position of the byte.
+ */
+int sc_regex::literal_rare(const char *str, int len)
+{
+  int best = 0, best_rank = -1;
+  for(int idx=0; idx<len; idx++)
+  {
+    unsigned char chr = str[idx];
+    int rank = isspace(chr) ? 0 : islower(chr) ? 1 : isdigit(chr) ? 2 : isupper(chr) ? 3 : 4;
+    if(rank > best_rank)
+    {
+      best = idx;
+      best_rank = rank;
+    }
+  }
+
+  return best;
+}
+
+/**
+ * Finds a literal in the string.
+ * The rare byte is looked for by memchr, which is vectorized by the C library,
+ * the rest of the literal is only compared at its occurences.
+ * @param str String to be searched.
+ * @param len Length of the string.
+ * @param offset Position to start searching from.
+ * @param lit Literal.
+ * @param lit_len Length of the literal.
+ * @param rare Position of the literal byte to look for.
+ * @return Position of the literal or -1.
+ */
+long sc_regex::literal_find(const char *str, long len, long offset, const char *lit, int lit_len, int rare)
+{
+  const char *pos = str + offset + rare, *end = str + len - lit_len + rare + 1;
+  while(pos < end)
+  {
+    pos = (const char *)memchr(pos, lit[rare], end - pos);
+    if(!pos) return -1;
+    if(!memcmp(pos - rare, lit, lit_len)) return pos - rare - str;
+    pos++;
+  }
+
+  return -1;
+}
+
+/**
+ * Checks whether the node can match an empty string.
+ */
+bool sc_regex::node_nullable(node *item)
+{
+  switch(item->type)
+  {
+    case RX_NODE_CHAR:
+    case RX_NODE_SET:     return false;
+    case RX_NODE_CAT:     return node_nullable(item->left) && node_nullable(item->right);
+    case RX_NODE_ALT:     return node_nullable(item->left) || node_nullable(item->right);
+    case RX_NODE_GROUP:   return node_nullable(item->left);
+    case RX_NODE_REPEAT:  return item->min == 0 || node_nullable(item->left);
+    default:              return true;
+  }
+}
+
+/**
+ * Calculates the minimal and maximal length of a string the node can match.
+ * @param[out] min Minimal length.
+ * @param[out] max Maximal length, -1 if unbounded.
+ */
+void sc_regex::node_width(node *item, int *min, int *max)
+{
+  int lmin, lmax, rmin, rmax;
+  switch(item->type)
+  {
+    case RX_NODE_CHAR:
+    case RX_NODE_SET:
+      *min = *max = 1;
+      break;
+
+    case RX_NODE_CAT:
+    case RX_NODE_ALT:
+      node_width(item->left, &lmin, &lmax);
+      node_width(item->right, &rmin, &rmax);
+      if(item->type == RX_NODE_CAT)
+      {
+        *min = lmin + rmin;
+        *max = (lmax < 0 || rmax < 0) ? -1 : lmax + rmax;
+      }
+      else
+      {
+        *min = lmin < rmin ? lmin : rmin;
+        *max = (lmax < 0 || rmax < 0) ? -1 : (lmax > rmax ? lmax : rmax);
+      }
+      break;
+
+    case RX_NODE_GROUP:
+      node_width(item->left, min, max);
+      break;
+
+    case RX_NODE_REPEAT:
+      node_width(item->left, &lmin, &lmax);
+      *min = lmin * item->min;
+      if(lmax == 0)
+        *max = 0;
+      else
+        *max = (lmax < 0 || item->max < 0) ? -1 : lmax * item->max;
+      break;
+
+    case RX_NODE_BACKREF:
+      *min = 0;
+      *max = -1;
+      break;
+
+    default:
+      *min = *max = 0;
+  }
+}
+
+/**
+ * Calculates the number of instructions the node compiles to.
+ * The result is capped slightly above REGEX_MAX_PROGRAM.
+ */
+int sc_regex::node_size(node *item)
+{
+  long size, child;
+  switch(item->type)
+  {
+    case RX_NODE_EMPTY:   return 0;
+    case RX_NODE_CAT:     size = (long)node_size(item->left) + node_size(item->right); break;
+    case RX_NODE_ALT:     size = 2 + (long)node_size(item->left) + node_size(item->right); break;
+    case RX_NODE_GROUP:   size = 2 + (long)node_size(item->left); break;
+
+    case RX_NODE_REPEAT:
+      child = node_size(item->left);
+      if(item->max == -1)
+        size = (item->min ? item->min * child + 1 : child + 2) + (node_nullable(item->left) ? 2 : 0);
+      else
+        size = item->min * child + (item->max - item->min) * (child + 1);
+      break;
+
+    default:              return 1;
+  }
+
+  return size > REGEX_MAX_PROGRAM ? REGEX_MAX_PROGRAM + 1 : (int)size;
+}
+
+//--------------------------------
+//            parser
+//--------------------------------
+
+/**
+ * Parses a regular expression into a syntax tree.
+ * @param pattern Regular expression body.
+ * @param len Length of the pattern.
+ * @param flags REGEX_* flags.
+ * @param[out] groups Number of capture groups.
+ * @param[out] error Error message if the pattern is invalid.
+ * @param[out] error_pos Pattern position that caused the error.
+ * @return Syntax tree or NULL.
+ */
+sc_regex::node *sc_regex::parse(const char *pattern, long len, int flags, int *groups, const char **error, long *error_pos)
+{
+  parser p;
+  p.src = pattern;
+  p.pos = 0;
+  p.len = len;
+  p.flags = flags;
+  p.groups = 0;
+  p.max_ref = 0;
+  p.quote = false;
+  p.error = NULL;
+  p.error_pos = -1;
+
+  node *tree = parse_alt(&p);
+  if(tree && p.pos < p.len)
+  {
+    node_free(tree);
+    tree = parse_error(&p, "Unmatched parentheses");
+  }
+
+  if(tree && p.max_ref > p.groups)
+  {
+    node_free(tree);
+    p.pos = p.len;
+    tree = parse_error(&p, "Reference to non-existent subpattern");
+  }
+
+  if(!tree)
+  {
+    *error = p.error;
+    *error_pos = p.error_pos;
+    return NULL;
+  }
+
+  *groups = p.groups;
+  return tree;
+}
+
+/**
+ * Records a syntax error.
+ * @return NULL to be returned by the parser.
+ */
+sc_regex::node *sc_regex::parse_error(parser *p, const char *msg)
+{
+  if(!p->error)
+  {
+    p->error = msg;
+    p->error_pos = p->pos;
+  }
+  return NULL;
+}
+
+/**
+ * Skips \\Q and \\E quote markers, and whitespace and comments in extended mode.
+ */
+void sc_regex::parse_skip(parser *p)
+{
+  while(p->pos < p->len)
+  {
+    char chr = p->src[p->pos];
+    if(chr == '\\' && p->pos + 1 < p->len && (p->src[p->pos+1] == 'E' || (p->src[p->pos+1] == 'Q' && !p->quote)))
+    {
+      // quote markers may appear anywhere between atoms
+      p->quote = p->src[p->pos+1] == 'Q';
+      p->pos += 2;
+      continue;
+    }
+
+    if(p->quote || !(p->flags & REGEX_EXTENDED))
+      break;
+
+    if(chr == '#')
+    {
+      while(p->pos < p->len && p->src[p->pos] != '\n')
+        p->pos++;
+    }
+    else if(!isspace((unsigned char)chr))
+      break;
+
+    p->pos++;
+  }
+}
+
+/**
+ * Parses alternatives: a|b|c.
+ */
+sc_regex::node *sc_regex::parse_alt(parser *p)
+{
+  node *left = parse_cat(p);
+  if(!left) return NULL;
+
+  while(p->pos < p->len && p->src[p->pos] == '|')
+  {
+    p->pos++;
+    node *right = parse_cat(p);
+    if(!right)
+    {
+      node_free(left);
+      return NULL;
+    }
+    left = node_new(RX_NODE_ALT, left, right);
+  }
+
+  return left;
+}
+
+/**
+ * Parses a sequence of repeated atoms.
+ */
+sc_regex::node *sc_regex::parse_cat(parser *p)
+{
+  node *result = node_new(RX_NODE_EMPTY);
+  while(1)
+  {
+    parse_skip(p);
+    if(p->pos >= p->len || (!p->quote && (p->src[p->pos] == '|' || p->src[p->pos] == ')')))
+      break;
+
+    node *item = parse_repeat(p);
+    if(!item)
+    {
+      node_free(result);
+      return NULL;
+    }
+
+    if(item->type == RX_NODE_EMPTY)
+      node_free(item);
+    else if(result->type == RX_NODE_EMPTY)
+    {
+      node_free(result);
+      result = item;
+    }
+    else
+      result = node_new(RX_NODE_CAT, result, item);
+  }
+
+  return result;
+}
+
+/**
+ * Parses an atom with an optional quantifier.
+ */
+sc_regex::node *sc_regex::parse_repeat(parser *p)
+{
+  node *atom = parse_atom(p);
+  if(!atom) return NULL;
+
+  // inside \Q...\E quantifier characters are literals
+  parse_skip(p);
+  if(p->pos >= p->len || p->quote) return atom;
+
+  int min, max;
+  char chr = p->src[p->pos];
+  if(chr == '*')      { min = 0; max = -1; p->pos++; }
+  else if(chr == '+') { min = 1; max = -1; p->pos++; }
+  else if(chr == '?') { min = 0; max = 1; p->pos++; }
+  else if(chr != '{' || !parse_count(p, &min, &max)) return atom;
+
+  if(atom->type == RX_NODE_EMPTY)
+  {
+    node_free(atom);
+    return parse_error(p, "Nothing to repeat");
+  }
+
+  if(min > REGEX_MAX_REPEAT || max > REGEX_MAX_REPEAT)
+  {
+    node_free(atom);
+    return parse_error(p, "Number too big in {} quantifier");
+  }
+
+  if(max != -1 && min > max)
+  {
+    node_free(atom);
+    return parse_error(p, "Numbers out of order in {} quantifier");
+  }
+
+  node *result = node_new(RX_NODE_REPEAT, atom);
+  result->min = min;
+  result->max = max;
+
+  if(p->pos < p->len && p->src[p->pos] == '?')
+  {
+    result->greedy = false;
+    p->pos++;
+  }
+  else if(p->pos < p->len && p->src[p->pos] == '+')
+  {
+    node_free(result);
+    return parse_error(p, "Possessive quantifiers are not supported");
+  }
+
+  // a quantifier cannot be quantified again
+  parse_skip(p);
+  if(p->pos < p->len && !p->quote)
+  {
+    long pos = p->pos;
+    chr = p->src[pos];
+    if(chr == '*' || chr == '+' || chr == '?' || (chr == '{' && parse_count(p, &min, &max)))
+    {
+      p->pos = pos;
+      node_free(result);
+      return parse_error(p, "Nothing to repeat");
+    }
+  }
+
+  return result;
+}
+
+/**
+ * Parses a {n}, {n,} or {n,m} quantifier.
+ * The position is only moved if the quantifier is valid, otherwise '{' is a literal.
+ * @param[out] min Minimal repetition count.
+ * @param[out] max Maximal repetition count, -1 for infinity.
+ * @return Whether the quantifier was valid.
+ */
+bool sc_regex::parse_count(parser *p, int *min, int *max)
+{
+  long pos = p->pos + 1;
+  long low = 0, high = 0;
+
+  if(pos >= p->len || !isdigit((unsigned char)p->src[pos])) return false;
+  while(pos < p->len && isdigit((unsigned char)p->src[pos]))
+  {
+    if(low <= REGEX_MAX_REPEAT) low = low * 10 + (p->src[pos] - '0');
+    pos++;
+  }
+
+  if(pos >= p->len) return false;
+  if(p->src[pos] == '}')
+    high = low;
+  else if(p->src[pos] == ',')
+  {
+    pos++;
+    if(pos >= p->len) return false;
+    if(p->src[pos] == '}')
+      high = -1;
+    else
+    {
+      if(!isdigit((unsigned char)p->src[pos])) return false;
+      while(pos < p->len && isdigit((unsigned char)p->src[pos]))
+      {
+        if(high <= REGEX_MAX_REPEAT) high = high * 10 + (p->src[pos] - '0');
+        pos++;
+      }
+      if(pos >= p->len || p->src[pos] != '}') return false;
+    }
+  }
+  else
+    return false;
+
+  p->pos = pos + 1;
+  *min = (int)low;
+  *max = (int)high;
+  return true;
+}
+
+/**
+ * Parses a single atom: literal, set, group, assertion or escape.
+ */
+sc_regex::node *sc_regex::parse_atom(parser *p)
+{
+  char chr = p->src[p->pos];
+  node *result, *body;
+  int min, max;
+
+  if(p->quote)
+  {
+    p->pos++;
+    return make_char(p, chr);
+  }
+
+  switch(chr)
+  {
+    case '(':
+    {
+      int flags = p->flags;
+      p->pos++;
+      if(p->pos < p->len && p->src[p->pos] == '?')
+      {
+        p->pos++;
+        char kind = p->pos < p->len ? p->src[p->pos] : '\0';
+        char next = p->pos + 1 < p->len ? p->src[p->pos+1] : '\0';
+
+        if(kind == ':')
+        {
+          p->pos++;
+          body = result = parse_alt(p);
+        }
+        else if(kind == '=' || kind == '!' || (kind == '<' && (next == '=' || next == '!')))
+        {
+          int look = 0;
+          if(kind == '<')
+          {
+            look |= RX_LOOK_BEHIND;
+            kind = next;
+            p->pos++;
+          }
+          if(kind == '!') look |= RX_LOOK_NEGATE;
+          p->pos++;
+
+          body = parse_alt(p);
+          result = body ? node_new(RX_NODE_LOOK, body) : NULL;
+          if(result)
+          {
+            result->value = look;
+            node_width(body, &min, &max);
+            if((look & RX_LOOK_BEHIND) && max < 0)
+            {
+              node_free(result);
+              return parse_error(p, "Lookbehind assertion is not fixed length");
+            }
+          }
+        }
+        else if(kind == '<' || kind == '\'' || (kind == 'P' && next == '<'))
+        {
+          // named group: the name is accepted, but groups are addressed by number
+          char term = kind == '\'' ? '\'' : '>';
+          while(p->pos < p->len && p->src[p->pos] != term)
+            p->pos++;
+          if(p->pos >= p->len) return parse_error(p, "Unterminated group name");
+          p->pos++;
+
+          int id = ++p->groups;
+          body = parse_alt(p);
+          result = body ? node_new(RX_NODE_GROUP, body) : NULL;
+          if(result) result->value = id;
+        }
+        else if(kind == '#')
+        {
+          while(p->pos < p->len && p->src[p->pos] != ')')
+            p->pos++;
+          if(p->pos >= p->len) return parse_error(p, "Missing ) after comment");
+          p->pos++;
+          return node_new(RX_NODE_EMPTY);
+        }
+        else
+        {
+          // inline modifiers: (?imsx-imsx) or (?imsx-imsx:...)
+          bool negate = false;
+          int bit;
+          while(p->pos < p->len)
+          {
+            switch(p->src[p->pos])
+            {
+              case 'i': bit = REGEX_ICASE; break;
+              case 'x': bit = REGEX_EXTENDED; break;
+              case 'm': bit = REGEX_MULTILINE; break;
+              case 's': bit = REGEX_DOTALL; break;
+              case '-': bit = 0; negate = true; break;
+              default:  bit = -1;
+            }
+            if(bit < 0) break;
+            if(negate) p->flags &= ~bit; else p->flags |= bit;
+            p->pos++;
+          }
+
+          if(p->pos < p->len && p->src[p->pos] == ')')
+          {
+            // modifiers stay active up to the end of the enclosing group
+            p->pos++;
+            return node_new(RX_NODE_EMPTY);
+          }
+
+          if(p->pos >= p->len || p->src[p->pos] != ':')
+            return parse_error(p, "Unrecognized character after (? or (?-");
+
+          p->pos++;
+          body = result = parse_alt(p);
+        }
+      }
+      else
+      {
+        int id = ++p->groups;
+        body = parse_alt(p);
+        result = body ? node_new(RX_NODE_GROUP, body) : NULL;
+        if(result) result->value = id;
+      }
+
+      if(!result) return NULL;
+      if(p->pos >= p->len || p->src[p->pos] != ')')
+      {
+        node_free(result);
+        return parse_error(p, "Missing )");
+      }
+
+      p->pos++;
+      p->flags = flags;
+      return result;
+    }
+
+    case '[':
+      return parse_set(p);
+
+    case '.':
+      p->pos++;
+      result = node_new(RX_NODE_SET);
+      result->set = new unsigned char[RX_SET_SIZE];
+      memset(result->set, 0xFF, RX_SET_SIZE);
+      if(!(p->flags & REGEX_DOTALL))
+        result->set['\n' >> 3] &= ~(1 << ('\n' & 7));
+      return result;
+
+    case '^':
+    case '$':
+      p->pos++;
+      result = node_new(RX_NODE_ASSERT);
+      if(chr == '^')
+        result->value = (p->flags & REGEX_MULTILINE) ? RX_ASSERT_MBOL : RX_ASSERT_BOL;
+      else
+        result->value = (p->flags & REGEX_MULTILINE) ? RX_ASSERT_MEOL : RX_ASSERT_EOT;
+      return result;
+
+    case '\\':
+      return parse_escape(p);
+
+    case '*':
+    case '+':
+    case '?':
+      return parse_error(p, "Nothing to repeat");
+
+    case '{':
+    {
+      long pos = p->pos;
+      if(parse_count(p, &min, &max))
+      {
+        p->pos = pos;
+        return parse_error(p, "Nothing to repeat");
+      }
+      p->pos++;
+      return make_char(p, chr);
+    }
+
+    default:
+      p->pos++;
+      return make_char(p, chr);
+  }
+}
+
+/**
+ * Parses an escape sequence outside of a character set.
+ */
+sc_regex::node *sc_regex::parse_escape(parser *p)
+{
+  node *result;
+  int value;
+
+  p->pos++;
+  if(p->pos >= p->len) return parse_error(p, "\\ at end of pattern");
+
+  char chr = p->src[p->pos++];
+  switch(chr)
+  {
+    case 'd': case 'D':
+    case 'w': case 'W':
+    case 's': case 'S':
+      result = node_new(RX_NODE_SET);
+      result->set = new unsigned char[RX_SET_SIZE];
+      memset(result->set, 0, RX_SET_SIZE);
+      set_escape(result->set, chr);
+      return result;
+
+    case 'b': value = RX_ASSERT_WORD; break;
+    case 'B': value = RX_ASSERT_NWORD; break;
+    case 'A': value = RX_ASSERT_BOT; break;
+    case 'z': value = RX_ASSERT_EOT; break;
+    case 'Z': value = RX_ASSERT_EOL; break;
+
+    default:
+      if(chr >= '1' && chr <= '9')
+      {
+        // back reference
+        value = chr - '0';
+        while(p->pos < p->len && isdigit((unsigned char)p->src[p->pos]) && value < REGEX_MAX_REPEAT)
+          value = value * 10 + (p->src[p->pos++] - '0');
+
+        result = node_new(RX_NODE_BACKREF);
+        result->value = value;
+        // back references have no quantifier, the flag is reused for case sensitivity
+        result->greedy = !(p->flags & REGEX_ICASE);
+        if(value > p->max_ref) p->max_ref = value;
+        return result;
+      }
+
+      if(!parse_literal(p, chr, &value))
+        return parse_error(p, "Unrecognized escape sequence");
+      return make_char(p, (unsigned char)value);
+  }
+
+  result = node_new(RX_NODE_ASSERT);
+  result->value = value;
+  return result;
+}
+
+/**
+ * Decodes an escaped literal character (\n, \x41, \. etc).
+ * @param chr Character following the backslash.
+ * @param[out] value Character code.
+ * @return Whether the escape denotes a literal.
+ */
+bool sc_regex::parse_literal(parser *p, char chr, int *value)
+{
+  int digits = 0;
+  switch(chr)
+  {
+    case 'n': *value = '\n'; return true;
+    case 'r': *value = '\r'; return true;
+    case 't': *value = '\t'; return true;
+    case 'f': *value = '\f'; return true;
+    case 'v': *value = '\v'; return true;
+    case 'a': *value = '\a'; return true;
+    case 'e': *value = 0x1B; return true;
+
+    case '0':
+      *value = 0;
+      while(digits < 2 && p->pos < p->len && p->src[p->pos] >= '0' && p->src[p->pos] <= '7')
+      {
+        *value = *value * 8 + (p->src[p->pos++] - '0');
+        digits++;
+      }
+      return true;
+
+    case 'x':
+    {
+      bool braces = p->pos < p->len && p->src[p->pos] == '{';
+      if(braces) p->pos++;
+
+      *value = 0;
+      while(p->pos < p->len && isxdigit((unsigned char)p->src[p->pos]) && (braces || digits < 2))
+      {
+        char hex = tolower(p->src[p->pos++]);
+        *value = *value * 16 + (hex <= '9' ? hex - '0' : hex - 'a' + 10);
+        if(*value > 0xFF) return false;
+        digits++;
+      }
+
+      if(braces)
+      {
+        if(p->pos >= p->len || p->src[p->pos] != '}') return false;
+        p->pos++;
+      }
+      return true;
+    }
+
+    default:
+      if(isalnum((unsigned char)chr)) return false;
+      *value = (unsigned char)chr;
+      return true;
+  }
+}
+
+/**
+ * Parses a character set: [a-z_], [^\d] or [[:alpha:]].
+ */
+sc_regex::node *sc_regex::parse_set(parser *p)
+{
+  static const char *posix_names[] = { "alpha", "digit", "alnum", "space", "upper", "lower", "punct", "xdigit", "word", "blank", "cntrl", "print", "graph", NULL };
+  bool icase = (p->flags & REGEX_ICASE) != 0, negate = false, first = true;
+  int low, high;
+
+  p->pos++;
+  if(p->pos < p->len && p->src[p->pos] == '^')
+  {
+    negate = true;
+    p->pos++;
+  }
+
+  node *result = node_new(RX_NODE_SET);
+  unsigned char *set = result->set = new unsigned char[RX_SET_SIZE];
+  memset(set, 0, RX_SET_SIZE);
+
+  while(1)
+  {
+    if(p->pos >= p->len)
+    {
+      node_free(result);
+      return parse_error(p, "Missing terminating ] for character class");
+    }
+
+    char chr = p->src[p->pos];
+    if(chr == ']' && !first)
+    {
+      p->pos++;
+      break;
+    }
+    first = false;
+
+    // posix class
+    if(chr == '[' && p->pos + 1 < p->len && p->src[p->pos+1] == ':')
+    {
+      long start = p->pos + 2, end = start;
+      while(end + 1 < p->len && !(p->src[end] == ':' && p->src[end+1] == ']'))
+        end++;
+
+      if(end + 1 < p->len)
+      {
+        bool inverse = p->src[start] == '^';
+        if(inverse) start++;
+
+        int kind = -1;
+        for(int idx=0; posix_names[idx]; idx++)
+          if((long)strlen(posix_names[idx]) == end - start && !strncmp(posix_names[idx], p->src + start, end - start))
+            kind = idx;
+
+        if(kind < 0)
+        {
+          node_free(result);
+          return parse_error(p, "Unknown POSIX class name");
+        }
+
+        for(int code=0; code<256; code++)
+        {
+          bool has;
+          switch(kind)
+          {
+            case 0:  has = isalpha(code); break;
+            case 1:  has = isdigit(code); break;
+            case 2:  has = isalnum(code); break;
+            case 3:  has = isspace(code); break;
+            case 4:  has = isupper(code) || (icase && islower(code)); break;
+            case 5:  has = islower(code) || (icase && isupper(code)); break;
+            case 6:  has = ispunct(code); break;
+            case 7:  has = isxdigit(code); break;
+            case 8:  has = RX_IS_WORD(code); break;
+            case 9:  has = code == ' ' || code == '\t'; break;
+            case 10: has = iscntrl(code); break;
+            case 11: has = isprint(code); break;
+            default: has = isgraph(code);
+          }
+          if(code > 127) has = false;
+          if(has != inverse) set[code >> 3] |= 1 << (code & 7);
+        }
+
+        p->pos = end + 2;
+        continue;
+      }
+    }
+
+    // first character of a possible range
+    if(chr == '\\')
+    {
+      p->pos++;
+      if(p->pos >= p->len) continue;
+      chr = p->src[p->pos++];
+      if(set_escape(set, chr)) continue;
+
+      if(chr == 'b')
+        low = '\b';
+      else if(!parse_literal(p, chr, &low))
+      {
+        node_free(result);
+        return parse_error(p, "Unrecognized escape sequence");
+      }
+    }
+    else
+    {
+      low = (unsigned char)chr;
+      p->pos++;
+    }
+
+    // range
+    if(p->pos + 1 < p->len && p->src[p->pos] == '-' && p->src[p->pos+1] != ']')
+    {
+      p->pos++;
+      chr = p->src[p->pos++];
+      if(chr == '\\')
+      {
+        if(p->pos >= p->len) continue;
+        chr = p->src[p->pos++];
+        if(chr == 'b')
+          high = '\b';
+        else if(!parse_literal(p, chr, &high))
+        {
+          node_free(result);
+          return parse_error(p, "Invalid range in character class");
+        }
+      }
+      else
+        high = (unsigned char)chr;
+
+      if(high < low)
+      {
+        node_free(result);
+        return parse_error(p, "Range out of order in character class");
+      }
+
+      for(int code=low; code<=high; code++)
+        set_add(set, (unsigned char)code, icase);
+    }
+    else
+      set_add(set, (unsigned char)low, icase);
+  }
+
+  if(negate)
+  {
+    for(int idx=0; idx<RX_SET_SIZE; idx++)
+      set[idx] = ~set[idx];
+  }
+
+  return result;
+}
+
+/**
+ * Creates a literal node, folding the case if needed.
+ */
+sc_regex::node *sc_regex::make_char(parser *p, unsigned char chr)
+{
+  node *result;
+  if((p->flags & REGEX_ICASE) && isalpha(chr))
+  {
+    result = node_new(RX_NODE_SET);
+    result->set = new unsigned char[RX_SET_SIZE];
+    memset(result->set, 0, RX_SET_SIZE);
+    set_add(result->set, chr, true);
+  }
+  else
+  {
+    result = node_new(RX_NODE_CHAR);
+    result->value = chr;
+  }
+
+  return result;
+}
+
+/**
+ * Adds a character to the set.
+ */
+void sc_regex::set_add(unsigned char *set, unsigned char chr, bool icase)
+{
+  set[chr >> 3] |= 1 << (chr & 7);
+  if(icase && isalpha(chr))
+  {
+    unsigned char other = islower(chr) ? toupper(chr) : tolower(chr);
+    set[other >> 3] |= 1 << (other & 7);
+  }
+}
+
+/**
+ * Adds a \d, \w or \s class (or their negations) to the set.
+ * @return Whether chr denotes a class.
+ */
+bool sc_regex::set_escape(unsigned char *set, char chr)
+{
+  bool inverse = isupper((unsigned char)chr) != 0;
+  char kind = tolower(chr);
+  if(kind != 'd' && kind != 'w' && kind != 's') return false;
+
+  for(int code=0; code<256; code++)
+  {
+    bool has;
+    if(kind == 'd')
+      has = code >= '0' && code <= '9';
+    else if(kind == 'w')
+      has = code < 128 && RX_IS_WORD(code);
+    else
+      has = code == ' ' || (code >= '\t' && code <= '\r');
+
+    if(has != inverse) set[code >> 3] |= 1 << (code & 7);
+  }
+
+  return true;
+}
+
+//--------------------------------
+//           compiler
+//--------------------------------
+
+/**
+ * Compiles a syntax tree into a program.
+ * @param tree Syntax tree.
+ * @param groups Number of capture groups in the whole pattern.
+ * @param anchored Whether the match may only start at the offset.
+ * @param[out] error Error message if the program is too large.
+ * @return Compiled program or NULL.
+ */
+sc_regex *sc_regex::build(node *tree, int groups, bool anchored, const char **error)
+{
+  int size = node_size(tree) + 3;
+  if(size > REGEX_MAX_PROGRAM)
+  {
+    *error = "Regular expression is too large";
+    return NULL;
+  }
+
+  sc_regex *result = new sc_regex();
+  if(!result) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  result->mGroups = groups + 1;
+  result->mAnchored = anchored;
+  result->mProgram = new inst[size];
+  if(!result->mProgram) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  // SAVE 0, body, SAVE 1, MATCH
+  result->mProgram[0].op = RX_OP_SAVE;
+  result->mProgram[0].x = 0;
+  int pc = result->emit(tree, 1);
+  if(pc < 0)
+  {
+    *error = "Regular expression is too large";
+    delete result;
+    return NULL;
+  }
+
+  result->mProgram[pc].op = RX_OP_SAVE;
+  result->mProgram[pc].x = 1;
+  result->mProgram[pc+1].op = RX_OP_MATCH;
+  result->mProgram[pc+1].x = 0;
+  result->mLength = pc + 2;
+
+  // VM threads are keyed by the empty loop registers, so keep their number small
+  if(result->mRegisters > RX_VM_MAX_REGISTERS)
+    result->mBacktrack = true;
+
+  return result;
+}
+
+/**
+ * Stores a character set bitmap in the program.
+ * @return Index of the set.
+ */
+int sc_regex::emit_set(unsigned char *set)
+{
+  unsigned char *sets = new unsigned char[(mNumSets + 1) * RX_SET_SIZE];
+  if(!sets) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  if(mNumSets) memcpy(sets, mSets, mNumSets * RX_SET_SIZE);
+  memcpy(sets + mNumSets * RX_SET_SIZE, set, RX_SET_SIZE);
+
+  delete [] mSets;
+  mSets = sets;
+  return mNumSets++;
+}
+
+/**
+ * Emits instructions for a syntax tree node.
+ * @param item Node.
+ * @param pc Position to write to.
+ * @return Position after the emitted code, -1 on error.
+ */
+int sc_regex::emit(node *item, int pc)
+{
+  inst *prog = mProgram;
+  int split, check, reg = 0, end;
+  bool nullable;
+
+  switch(item->type)
+  {
+    case RX_NODE_EMPTY:
+      return pc;
+
+    case RX_NODE_CHAR:
+      prog[pc].op = RX_OP_CHAR;
+      prog[pc].x = item->value;
+      return pc + 1;
+
+    case RX_NODE_SET:
+      prog[pc].op = RX_OP_CLASS;
+      prog[pc].x = emit_set(item->set);
+      return pc + 1;
+
+    case RX_NODE_ASSERT:
+      prog[pc].op = RX_OP_ASSERT;
+      prog[pc].x = item->value;
+      return pc + 1;
+
+    case RX_NODE_BACKREF:
+      mBacktrack = true;
+      prog[pc].op = RX_OP_BACKREF;
+      prog[pc].x = item->value;
+      prog[pc].y = !item->greedy;
+      return pc + 1;
+
+    case RX_NODE_LOOK:
+    {
+      const char *error;
+      sc_regex *sub = build(item->left, mGroups - 1, true, &error);
+      if(!sub) return -1;
+      sub->mLookKind = item->value;
+      node_width(item->left, &sub->mMinWidth, &sub->mMaxWidth);
+
+      // groups inside a positive lookaround are visible to the rest of the pattern
+      for(int idx=0; idx<sub->mLength && !(item->value & RX_LOOK_NEGATE); idx++)
+        if(sub->mProgram[idx].op == RX_OP_SAVE && sub->mProgram[idx].x >= 2)
+          sub->mSaves = true;
+
+      sc_regex **looks = new sc_regex*[mNumLooks + 1];
+      if(!looks) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+      for(int idx=0; idx<mNumLooks; idx++)
+        looks[idx] = mLooks[idx];
+      delete [] mLooks;
+      mLooks = looks;
+      mLooks[mNumLooks] = sub;
+
+      prog[pc].op = RX_OP_LOOK;
+      prog[pc].x = mNumLooks++;
+      return pc + 1;
+    }
+
+    case RX_NODE_ACCEPT:
+      prog[pc].op = RX_OP_MATCH;
+      prog[pc].x = item->value;
+      return pc + 1;
+
+    case RX_NODE_CAT:
+      pc = emit(item->left, pc);
+      return pc < 0 ? -1 : emit(item->right, pc);
+
+    case RX_NODE_ALT:
+      // SPLIT L1, L2; L1: left; JMP end; L2: right; end:
+      split = pc;
+      pc = emit(item->left, pc + 1);
+      if(pc < 0) return -1;
+      check = pc;
+      end = emit(item->right, pc + 1);
+      if(end < 0) return -1;
+
+      prog[split].op = RX_OP_SPLIT;
+      prog[split].x = split + 1;
+      prog[split].y = check + 1;
+      prog[check].op = RX_OP_JMP;
+      prog[check].x = end;
+      return end;
+
+    case RX_NODE_GROUP:
+      prog[pc].op = RX_OP_SAVE;
+      prog[pc].x = item->value * 2;
+      pc = emit(item->left, pc + 1);
+      if(pc < 0) return -1;
+      prog[pc].op = RX_OP_SAVE;
+      prog[pc].x = item->value * 2 + 1;
+      return pc + 1;
+
+    case RX_NODE_REPEAT:
+    {
+      nullable = node_nullable(item->left);
+
+      // mandatory copies (the last one is the loop body for x{n,})
+      int copies = item->max == -1 && item->min > 0 ? item->min - 1 : item->min;
+      for(int idx=0; idx<copies; idx++)
+        if((pc = emit(item->left, pc)) < 0) return -1;
+
+      if(item->max == -1)
+      {
+        // empty iterations are cut off by NULLSET / NULLCHK
+        if(nullable) reg = mRegisters++;
+
+        if(item->min == 0)
+        {
+          // L1: SPLIT L2, end; L2: body; JMP L1; end:
+          split = pc++;
+          if(nullable)
+          {
+            prog[pc].op = RX_OP_NULLSET;
+            prog[pc++].x = reg;
+          }
+          if((pc = emit(item->left, pc)) < 0) return -1;
+          check = pc;
+          if(nullable) pc++;
+          prog[pc].op = RX_OP_JMP;
+          prog[pc++].x = split;
+
+          prog[split].op = RX_OP_SPLIT;
+          prog[split].x = item->greedy ? split + 1 : pc;
+          prog[split].y = item->greedy ? pc : split + 1;
+        }
+        else
+        {
+          // L1: body; SPLIT L1, end; end:
+          int start = pc;
+          if(nullable)
+          {
+            prog[pc].op = RX_OP_NULLSET;
+            prog[pc++].x = reg;
+          }
+          if((pc = emit(item->left, pc)) < 0) return -1;
+          check = pc;
+          if(nullable) pc++;
+          split = pc++;
+
+          prog[split].op = RX_OP_SPLIT;
+          prog[split].x = item->greedy ? start : pc;
+          prog[split].y = item->greedy ? pc : start;
+        }
+
+        if(nullable)
+        {
+          prog[check].op = RX_OP_NULLCHK;
+          prog[check].x = reg;
+          prog[check].y = pc;
+        }
+        return pc;
+      }
+
+      // optional copies: SPLIT L1, end; L1: body; SPLIT L2, end; L2: body; ... end:
+      int optional = item->max - item->min;
+      if(!optional) return pc;
+
+      int *splits = new int[optional];
+      if(!splits) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+      for(int idx=0; idx<optional; idx++)
+      {
+        splits[idx] = pc++;
+        if((pc = emit(item->left, pc)) < 0)
+        {
+          delete [] splits;
+          return -1;
+        }
+      }
+
+      for(int idx=0; idx<optional; idx++)
+      {
+        prog[splits[idx]].op = RX_OP_SPLIT;
+        prog[splits[idx]].x = item->greedy ? splits[idx] + 1 : pc;
+        prog[splits[idx]].y = item->greedy ? pc : splits[idx] + 1;
+      }
+
+      delete [] splits;
+      return pc;
+    }
+  }
+
+  return pc;
+}
+
+//--------------------------------
+//            matchers
+//--------------------------------
+
+/**
+ * Checks a zero-width assertion at the given position.
+ */
+bool sc_regex::check(const inst *cmd, const char *str, long len, long pos)
+{
+  switch(cmd->x)
+  {
+    case RX_ASSERT_BOL:   return pos == 0;
+    case RX_ASSERT_MBOL:  return pos == 0 || (pos < len && str[pos-1] == '\n');
+    case RX_ASSERT_EOL:   return pos == len || (pos == len - 1 && str[pos] == '\n');
+    case RX_ASSERT_MEOL:  return pos == len || str[pos] == '\n';
+    case RX_ASSERT_BOT:   return pos == 0;
+    case RX_ASSERT_EOT:   return pos == len;
+    default:
+    {
+      bool before = pos > 0 && RX_IS_WORD(str[pos-1]);
+      bool after = pos < len && RX_IS_WORD(str[pos]);
+      return (before != after) == (cmd->x == RX_ASSERT_WORD);
+    }
+  }
+}
+
+/**
+ * Evaluates a lookaround sub-program at the given position.
+ * @param[out] captures Group offsets set by the sub-program or NULL.
+ */
+bool sc_regex::test(const char *str, long len, long pos, long *captures)
+{
+  bool found = false;
+  if(mLookKind & RX_LOOK_BEHIND)
+  {
+    // try every possible width so that the match ends exactly at pos
+    for(long width=mMinWidth; width<=mMaxWidth && !found; width++)
+    {
+      if(pos - width < 0) break;
+      found = mBacktrack ? run_backtrack(str, len, pos - width, pos, captures) : run_vm(str, len, pos - width, pos, captures);
+    }
+  }
+  else
+    found = mBacktrack ? run_backtrack(str, len, pos, -1, captures) : run_vm(str, len, pos, -1, captures);
+
+  return (mLookKind & RX_LOOK_NEGATE) ? !found : found;
+}
+
+/**
+ * Adds a thread to the Pike VM list, following all empty transitions.
+ * Threads are kept in priority order, so the first match found is the
+ * one a backtracking engine would report.
+ * A thread is identified by its instruction and by the set of empty loop
+ * registers equal to the current position, as only these decide NULLCHK.
+ * @param list Thread list: sparse index, then dense list of thread keys.
+ * @param count Number of threads in the list.
+ * @param caps Thread capture storage of the list.
+ * @param pc Instruction to add.
+ * @param curr Captures of the thread being added.
+ */
+void sc_regex::add_thread(int *list, int &count, long *caps, int pc, const char *str, long len, long pos, long *curr)
+{
+  int slots = mLength << mRegisters, key = pc << mRegisters;
+  int *sparse = list, *dense = list + slots;
+  for(int idx=0; idx<mRegisters; idx++)
+    if(curr[mGroups * 2 + idx] == pos) key |= 1 << idx;
+
+  if(sparse[key] < count && dense[sparse[key]] == key) return;
+  sparse[key] = count;
+  dense[count++] = key;
+
+  inst *cmd = mProgram + pc;
+  int ncap = mGroups * 2 + mRegisters;
+  long old;
+
+  switch(cmd->op)
+  {
+    case RX_OP_JMP:
+      add_thread(list, count, caps, cmd->x, str, len, pos, curr);
+      break;
+
+    case RX_OP_SPLIT:
+      add_thread(list, count, caps, cmd->x, str, len, pos, curr);
+      add_thread(list, count, caps, cmd->y, str, len, pos, curr);
+      break;
+
+    case RX_OP_SAVE:
+    case RX_OP_NULLSET:
+    {
+      int slot = cmd->op == RX_OP_SAVE ? cmd->x : mGroups * 2 + cmd->x;
+      old = curr[slot];
+      curr[slot] = pos;
+      add_thread(list, count, caps, pc + 1, str, len, pos, curr);
+      curr[slot] = old;
+      break;
+    }
+
+    case RX_OP_NULLCHK:
+      add_thread(list, count, caps, curr[mGroups * 2 + cmd->x] == pos ? cmd->y : pc + 1, str, len, pos, curr);
+      break;
+
+    case RX_OP_ASSERT:
+      if(check(cmd, str, len, pos))
+        add_thread(list, count, caps, pc + 1, str, len, pos, curr);
+      break;
+
+    case RX_OP_LOOK:
+    {
+      sc_regex *look = mLooks[cmd->x];
+      if(!look->mSaves)
+      {
+        if(look->test(str, len, pos, NULL))
+          add_thread(list, count, caps, pc + 1, str, len, pos, curr);
+        break;
+      }
+
+      // groups found by the lookaround: new values, then the ones they replace
+      long *found = new long[mGroups * 4];
+      if(!found) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+      long *saved = found + mGroups * 2;
+      if(look->test(str, len, pos, found))
+      {
+        for(int slot=2; slot<mGroups*2; slot++)
+        {
+          saved[slot] = curr[slot];
+          if(found[slot] >= 0) curr[slot] = found[slot];
+        }
+        add_thread(list, count, caps, pc + 1, str, len, pos, curr);
+        for(int slot=2; slot<mGroups*2; slot++)
+          curr[slot] = saved[slot];
+      }
+      delete [] found;
+      break;
+    }
+
+    default:
+      memcpy(caps + (long)(count - 1) * ncap, curr, ncap * sizeof(long));
+  }
+}
+
+/**
+ * Runs the program with the Pike VM.
+ * @param need_end Position the match must end at, -1 for any.
+ * @param[out] captures Group offsets or NULL.
+ * @return Whether a match was found.
+ */
+bool sc_regex::run_vm(const char *str, long len, long offset, long need_end, long *captures)
+{
+  int ncap = mGroups * 2 + mRegisters;
+  long slots = (long)mLength << mRegisters;
+  int *lists = new int[slots * 4];
+  long *caps = new long[slots * ncap * 2 + ncap];
+  if(!lists || !caps) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  // sparse indexes are validated against the dense list, but keep them defined
+  memset(lists, 0, sizeof(int) * slots * 4);
+  int *clist = lists, *nlist = lists + slots * 2;
+  long *ccaps = caps, *ncaps = caps + slots * ncap, *init = caps + slots * ncap * 2;
+  int ccount = 0, ncount = 0;
+  bool matched = false;
+
+  for(long pos=offset; ; pos++)
+  {
+    // with no threads alive, skip right to the next occurence of the prefix
+    if(!ccount && !matched && !mAnchored && mPrefixLen)
+    {
+      pos = literal_find(str, len, pos, mPrefix, mPrefixLen, mPrefixRare);
+      if(pos < 0) break;
+    }
+
+    if(!matched && (!mAnchored || pos == offset))
+    {
+      for(int idx=0; idx<ncap; idx++)
+        init[idx] = -1;
+      add_thread(clist, ccount, ccaps, 0, str, len, pos, init);
+    }
+
+    if(!ccount && (matched || mAnchored)) break;
+
+    int *dense = clist + slots;
+    for(int idx=0; idx<ccount; idx++)
+    {
+      int pc = dense[idx] >> mRegisters;
+      inst *cmd = mProgram + pc;
+      long *curr = ccaps + (long)idx * ncap;
+      bool step = false;
+
+      if(cmd->op == RX_OP_CHAR)
+        step = pos < len && (unsigned char)str[pos] == cmd->x;
+      else if(cmd->op == RX_OP_CLASS)
+        step = pos < len && RX_SET_HAS(mSets + cmd->x * RX_SET_SIZE, str[pos]);
+      else if(cmd->op == RX_OP_MATCH && (need_end < 0 || pos == need_end))
+      {
+        if(captures) memcpy(captures, curr, mGroups * 2 * sizeof(long));
+        matched = true;
+        // threads of lower priority are cut off
+        break;
+      }
+
+      if(step) add_thread(nlist, ncount, ncaps, pc + 1, str, len, pos + 1, curr);
+    }
+
+    int *tmp = clist; clist = nlist; nlist = tmp;
+    long *tmpcaps = ccaps; ccaps = ncaps; ncaps = tmpcaps;
+    ccount = ncount;
+    ncount = 0;
+
+    if(pos >= len || (need_end >= 0 && pos >= need_end)) break;
+  }
+
+  delete [] lists;
+  delete [] caps;
+  return matched;
+}
+
+/**
+ * Runs the program with a backtracking matcher.
+ * Only used for programs with back references, which an automaton cannot match.
+ * The number of steps is limited by REGEX_BACKTRACK_LIMIT.
+ * @param need_end Position the match must end at, -1 for any.
+ * @param[out] captures Group offsets or NULL.
+ * @return Whether a match was found.
+ */
+bool sc_regex::run_backtrack(const char *str, long len, long offset, long need_end, long *captures)
+{
+  int ncap = mGroups * 2 + mRegisters;
+  long *caps = new long[ncap];
+  long size = 64, depth = 0, steps = 0;
+  // each frame is (pc, position) for a branch or (-1 - slot, old value) for a restore
+  long *stack = new long[size * 2];
+  if(!caps || !stack) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  bool matched = false;
+
+  for(long start=offset; start<=len && !matched; start++)
+  {
+    if(mAnchored && start > offset) break;
+
+    // a match can only start where the prefix occurs
+    if(mPrefixLen && (start = literal_find(str, len, start, mPrefix, mPrefixLen, mPrefixRare)) < 0)
+      break;
+
+    for(int idx=0; idx<ncap; idx++)
+      caps[idx] = -1;
+    stack[0] = 0;
+    stack[1] = start;
+    depth = 1;
+
+    while(depth && !matched)
+    {
+      depth--;
+      long pc = stack[depth*2], pos = stack[depth*2+1];
+      if(pc < 0)
+      {
+        caps[-1 - pc] = pos;
+        continue;
+      }
+
+      while(1)
+      {
+        if(++steps > REGEX_BACKTRACK_LIMIT)
+        {
+          depth = 0;
+          start = len;
+          break;
+        }
+
+        // make room for two frames
+        if(depth + 2 > size)
+        {
+          long *grown = new long[size * 4];
+          if(!grown) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+          memcpy(grown, stack, size * 2 * sizeof(long));
+          delete [] stack;
+          stack = grown;
+          size *= 2;
+        }
+
+        inst *cmd = mProgram + pc;
+        bool ok = true;
+        switch(cmd->op)
+        {
+          case RX_OP_CHAR:
+            ok = pos < len && (unsigned char)str[pos] == cmd->x;
+            pos++, pc++;
+            break;
+
+          case RX_OP_CLASS:
+            ok = pos < len && RX_SET_HAS(mSets + cmd->x * RX_SET_SIZE, str[pos]);
+            pos++, pc++;
+            break;
+
+          case RX_OP_SPLIT:
+            stack[depth*2] = cmd->y;
+            stack[depth*2+1] = pos;
+            depth++;
+            pc = cmd->x;
+            break;
+
+          case RX_OP_JMP:
+            pc = cmd->x;
+            break;
+
+          case RX_OP_SAVE:
+          case RX_OP_NULLSET:
+          {
+            int slot = cmd->op == RX_OP_SAVE ? cmd->x : mGroups * 2 + cmd->x;
+            stack[depth*2] = -1 - slot;
+            stack[depth*2+1] = caps[slot];
+            depth++;
+            caps[slot] = pos;
+            pc++;
+            break;
+          }
+
+          case RX_OP_NULLCHK:
+            pc = caps[mGroups * 2 + cmd->x] == pos ? cmd->y : pc + 1;
+            break;
+
+          case RX_OP_ASSERT:
+            ok = check(cmd, str, len, pos);
+            pc++;
+            break;
+
+          case RX_OP_LOOK:
+          {
+            sc_regex *look = mLooks[cmd->x];
+            if(!look->mSaves)
+            {
+              ok = look->test(str, len, pos, NULL);
+              pc++;
+              break;
+            }
+
+            long *found = new long[mGroups * 2];
+            if(!found) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+            ok = look->test(str, len, pos, found);
+            if(ok)
+            {
+              // store groups found by the lookaround, with restore frames for backtracking
+              while(depth + mGroups * 2 > size)
+              {
+                long *grown = new long[size * 4];
+                if(!grown) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+                memcpy(grown, stack, size * 2 * sizeof(long));
+                delete [] stack;
+                stack = grown;
+                size *= 2;
+              }
+
+              for(int slot=2; slot<mGroups*2; slot++)
+              {
+                if(found[slot] < 0) continue;
+                stack[depth*2] = -1 - slot;
+                stack[depth*2+1] = caps[slot];
+                depth++;
+                caps[slot] = found[slot];
+              }
+            }
+            delete [] found;
+            pc++;
+            break;
+          }
+
+          case RX_OP_BACKREF:
+          {
+            long from = cmd->x < mGroups ? caps[cmd->x*2] : -1, to = cmd->x < mGroups ? caps[cmd->x*2+1] : -1;
+            ok = from >= 0 && to >= from && pos + (to - from) <= len;
+            for(long idx=0; ok && idx<to-from; idx++)
+            {
+              char a = str[from+idx], b = str[pos+idx];
+              ok = cmd->y ? tolower((unsigned char)a) == tolower((unsigned char)b) : a == b;
+            }
+            if(ok) pos += to - from;
+            pc++;
+            break;
+          }
+
+          case RX_OP_MATCH:
+            ok = need_end < 0 || pos == need_end;
+            if(ok)
+            {
+              if(captures) memcpy(captures, caps, mGroups * 2 * sizeof(long));
+              matched = true;
+            }
+            break;
+        }
+
+        if(!ok || matched) break;
+      }
+    }
+  }
+
+  delete [] stack;
+  delete [] caps;
+  return matched;
+}
+
+//--------------------------------
+//           lazy DFA
+//--------------------------------
+
+/**
+ * Builds the byte class map and the start state.
+ * The DFA treats assertions and lookarounds as always true and back references
+ * as "anything", so it accepts a superset of the language: a rejection is final,
+ * an acceptance is confirmed by the exact matcher.
+ */
+void sc_regex::dfa_init()
+{
+  bool boundary[257];
+  memset(boundary, 0, sizeof(boundary));
+  boundary[0] = true;
+
+  for(int pc=0; pc<mLength; pc++)
+  {
+    if(mProgram[pc].op == RX_OP_CHAR)
+      boundary[mProgram[pc].x] = boundary[mProgram[pc].x + 1] = true;
+    else if(mProgram[pc].op == RX_OP_CLASS)
+    {
+      unsigned char *set = mSets + mProgram[pc].x * RX_SET_SIZE;
+      for(int code=1; code<256; code++)
+        if(!RX_SET_HAS(set, code) != !RX_SET_HAS(set, code - 1))
+          boundary[code] = true;
+    }
+  }
+
+  int cls = -1;
+  for(int code=0; code<256; code++)
+  {
+    if(boundary[code]) cls++;
+    mByteMap[code] = cls;
+  }
+  mByteClasses = cls + 1;
+
+  mStates = new state*[REGEX_DFA_MAX_STATES];
+  mStateHash = new int[REGEX_DFA_MAX_STATES * 2];
+  if(!mStates || !mStateHash) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  for(int idx=0; idx<REGEX_DFA_MAX_STATES*2; idx++)
+    mStateHash[idx] = -1;
+  mNumStates = 0;
+
+  // state 0 is the start state
+  int *pcs = new int[mLength], length = 0;
+  char *seen = new char[mLength];
+  memset(seen, 0, mLength);
+  dfa_closure(0, pcs, length, seen);
+  dfa_state(pcs, length);
+  delete [] pcs;
+  delete [] seen;
+}
+
+/**
+ * Deletes all cached DFA states.
+ */
+void sc_regex::dfa_flush()
+{
+  for(int idx=0; idx<mNumStates; idx++)
+  {
+    delete [] mStates[idx]->pcs;
+    delete [] mStates[idx]->next;
+    delete mStates[idx];
+  }
+  mNumStates = 0;
+}
+
+/**
+ * Collects instructions reachable from pc by empty transitions.
+ */
+void sc_regex::dfa_closure(int pc, int *pcs, int &length, char *seen)
+{
+  while(!seen[pc])
+  {
+    seen[pc] = 1;
+    inst *cmd = mProgram + pc;
+    switch(cmd->op)
+    {
+      case RX_OP_JMP:
+        pc = cmd->x;
+        break;
+
+      case RX_OP_SPLIT:
+        dfa_closure(cmd->x, pcs, length, seen);
+        pc = cmd->y;
+        break;
+
+      case RX_OP_NULLCHK:
+        dfa_closure(cmd->y, pcs, length, seen);
+        pc++;
+        break;
+
+      case RX_OP_BACKREF:
+        pcs[length++] = pc;
+        pc++;
+        break;
+
+      case RX_OP_CHAR:
+      case RX_OP_CLASS:
+      case RX_OP_MATCH:
+        pcs[length++] = pc;
+        return;
+
+      default:
+        pc++;
+    }
+  }
+}
+
+/**
+ * Finds or creates a DFA state for the set of instructions.
+ * @return State index, -1 if the cache is full.
+ */
+int sc_regex::dfa_state(int *pcs, int length)
+{
+  // sort the set so equal sets share a state
+  for(int idx=1; idx<length; idx++)
+  {
+    int val = pcs[idx], pos = idx;
+    while(pos > 0 && pcs[pos-1] > val)
+    {
+      pcs[pos] = pcs[pos-1];
+      pos--;
+    }
+    pcs[pos] = val;
+  }
+
+  unsigned long hash = (unsigned long)14695981039346656037ULL;
+  for(int idx=0; idx<length; idx++)
+    hash = (hash ^ (unsigned long)pcs[idx]) * (unsigned long)1099511628211ULL;
+
+  int mask = REGEX_DFA_MAX_STATES * 2 - 1;
+  int slot = hash & mask;
+  while(mStateHash[slot] != -1)
+  {
+    state *curr = mStates[mStateHash[slot]];
+    if(curr->hash == hash && curr->length == length && !memcmp(curr->pcs, pcs, length * sizeof(int)))
+      return mStateHash[slot];
+    slot = (slot + 1) & mask;
+  }
+
+  if(mNumStates == REGEX_DFA_MAX_STATES) return -1;
+
+  state *item = new state();
+  if(!item) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  item->pcs = new int[length ? length : 1];
+  memcpy(item->pcs, pcs, length * sizeof(int));
+  item->length = length;
+  item->hash = hash;
+  item->match = false;
+  for(int idx=0; idx<length; idx++)
+    if(mProgram[pcs[idx]].op == RX_OP_MATCH)
+      item->match = true;
+  item->next = new int[mByteClasses];
+  for(int idx=0; idx<mByteClasses; idx++)
+    item->next[idx] = -1;
+
+  mStates[mNumStates] = item;
+  mStateHash[slot] = mNumStates;
+  return mNumStates++;
+}
+
+/**
+ * Computes the transition of a state by a byte.
+ * @return Index of the next state, -1 if the cache is full.
+ */
+int sc_regex::dfa_step(int from, int chr)
+{
+  state *curr = mStates[from];
+  int *pcs = new int[mLength], length = 0;
+  char *seen = new char[mLength];
+  memset(seen, 0, mLength);
+
+  for(int idx=0; idx<curr->length; idx++)
+  {
+    int pc = curr->pcs[idx];
+    inst *cmd = mProgram + pc;
+    if(cmd->op == RX_OP_CHAR && cmd->x == chr)
+      dfa_closure(pc + 1, pcs, length, seen);
+    else if(cmd->op == RX_OP_CLASS && RX_SET_HAS(mSets + cmd->x * RX_SET_SIZE, chr))
+      dfa_closure(pc + 1, pcs, length, seen);
+    else if(cmd->op == RX_OP_BACKREF)
+      dfa_closure(pc, pcs, length, seen);
+  }
+
+  // an unanchored search may start a new match at every position
+  if(!mAnchored)
+    dfa_closure(0, pcs, length, seen);
+
+  int result = dfa_state(pcs, length);
+  if(result >= 0)
+    curr->next[mByteMap[chr]] = result;
+
+  delete [] pcs;
+  delete [] seen;
+  return result;
+}
+
+/**
+ * Scans the string with the lazy DFA.
+ * @return 0 if there is certainly no match, 1 if there may be one, -1 if the DFA gave up.
+ */
+int sc_regex::dfa_run(const char *str, long len, long offset)
+{
+  if(!mStates) dfa_init();
+
+  int curr = 0;
+  if(mStates[curr]->match) return 1;
+
+  for(long pos=offset; pos<len; pos++)
+  {
+    unsigned char chr = str[pos];
+    int next = mStates[curr]->next[mByteMap[chr]];
+    if(next < 0)
+    {
+      next = dfa_step(curr, chr);
+      if(next < 0)
+      {
+        // too many states: fall back to the VM for good
+        dfa_flush();
+        mDFAFailed = true;
+        return -1;
+      }
+    }
+
+    curr = next;
+    if(mStates[curr]->match) return 1;
+    if(!mStates[curr]->length) return 0;
+  }
+
+  return 0;
+}
+
+/**
+ * Marks patterns whose MATCH instructions belong to the state.
+ * @param from State index.
+ * @param seen States already accounted for.
+ * @param found Flags for every pattern.
+ * @return Number of newly found patterns.
+ */
+long sc_regex::dfa_accept(int from, char *seen, char *found)
+{
+  state *curr = mStates[from];
+  if(!curr->match || seen[from]) return 0;
+  seen[from] = 1;
+
+  long count = 0;
+  for(int idx=0; idx<curr->length; idx++)
+  {
+    inst *cmd = mProgram + curr->pcs[idx];
+    if(cmd->op == RX_OP_MATCH && !found[cmd->x])
+    {
+      found[cmd->x] = 1;
+      count++;
+    }
+  }
+
+  return count;
+}
+
+/**
+ * Drops all cached states except the start one and the given one.
+ * @param from State to be kept.
+ * @return New index of the kept state.
+ */
+int sc_regex::dfa_restart(int from)
+{
+  int length = mStates[from]->length;
+  int *pcs = new int[length ? length : 1];
+  memcpy(pcs, mStates[from]->pcs, length * sizeof(int));
+
+  dfa_flush();
+  for(int idx=0; idx<REGEX_DFA_MAX_STATES*2; idx++)
+    mStateHash[idx] = -1;
+
+  int *start = new int[mLength], start_length = 0;
+  char *seen = new char[mLength];
+  memset(seen, 0, mLength);
+  dfa_closure(0, start, start_length, seen);
+  dfa_state(start, start_length);
+
+  int result = dfa_state(pcs, length);
+  delete [] start;
+  delete [] seen;
+  delete [] pcs;
+  return result;
+}
+
+#endif
@@ -0,0 +1,243 @@
+/**
+ * @file sc_regexcache.h
+ * @author impworks.
+ * sc_regexcache class header.
+ * Defines properties and methods of sc_regexcache class.
+ */
+
+#ifndef SC_REGEXCACHE_H
+#define SC_REGEXCACHE_H
+
+thread_local sc_regexcacheitem **sc_regexcache::mItems = NULL;
+thread_local long sc_regexcache::mSize = 0;
+thread_local long sc_regexcache::mLength = 0;
+thread_local long sc_regexcache::mMemory = 0;
+long sc_regexcache::mMaxItems = REGEXCACHE_MAX_ITEMS;
+long sc_regexcache::mMaxMemory = REGEXCACHE_MAX_MEMORY;
+thread_local long sc_regexcache::mHits = 0;
+thread_local long sc_regexcache::mMisses = 0;
+thread_local sc_regexcacheitem *sc_regexcache::pNewest = NULL;
+thread_local sc_regexcacheitem *sc_regexcache::pOldest = NULL;
+
+/**
+ * Sets cache limits and drops programs that do not fit anymore.
+ * @param items Maximum number of cached programs (0 disables caching).
+ * @param memory Maximum memory taken by cached programs, in bytes.
+ */
+void sc_regexcache::setup(long items, long memory)
+{
+  mMaxItems = items > 0 ? items : 0;
+  mMaxMemory = memory > 0 ? memory : 0;
+
+  while(pOldest && (mLength > mMaxItems || mMemory > mMaxMemory))
+    remove(pOldest);
+}
+
+/**
+ * Returns a compiled program for the pattern, compiling it on cache miss.
+ * The program is shared: it must be released with release() instead of being deleted.
+ * @param pattern Regular expression body (without slashes and modifiers).
+ * @param len Length of the pattern.
+ * @param flags REGEX_* flags.
+ * @param[out] error Error message if compilation failed.
+ * @param[out] error_pos Pattern position that caused the error.
+ * @return Compiled program or NULL.
+ */
+sc_regex *sc_regexcache::get(const char *pattern, long len, int flags, const char **error, long *error_pos)
+{
+  unsigned long hash = sc_regexcache::hash(pattern, len, flags);
+
+  if(mLength)
+  {
+    sc_regexcacheitem *curr = mItems[hash & (mSize - 1)];
+    while(curr)
+    {
+      if(curr->mHash == hash && curr->mFlags == flags && curr->mLength == len && !memcmp(curr->mPattern, pattern, len))
+      {
+        mHits++;
+
+        // move to the head of the LRU list
+        if(curr != pNewest)
+        {
+          curr->pNewer->pOlder = curr->pOlder;
+          if(curr->pOlder) curr->pOlder->pNewer = curr->pNewer;
+          else pOldest = curr->pNewer;
+
+          curr->pNewer = NULL;
+          curr->pOlder = pNewest;
+          pNewest->pNewer = curr;
+          pNewest = curr;
+        }
+
+        curr->mProgram->mLinks++;
+        return curr->mProgram;
+      }
+
+      curr = curr->pNext;
+    }
+  }
+
+  mMisses++;
+  sc_regex *program = sc_regex::compile(pattern, len, flags, error, error_pos);
+  if(!program) return NULL;
+
+  // programs that cannot fit are handed out uncached
+  long size = program->size();
+  if(!mMaxItems || size > mMaxMemory) return program;
+
+  while(pOldest && (mLength >= mMaxItems || mMemory + size > mMaxMemory))
+    remove(pOldest);
+
+  if(mLength + 1 > mSize)
+    grow();
+
+  sc_regexcacheitem *item = new sc_regexcacheitem();
+  if(!item) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  item->mPattern = new char[len+1];
+  if(!item->mPattern) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  memcpy(item->mPattern, pattern, len);
+  item->mPattern[len] = '\0';
+  item->mLength = len;
+  item->mFlags = flags;
+  item->mHash = hash;
+  item->mSize = size;
+  item->mProgram = program;
+
+  long idx = hash & (mSize - 1);
+  item->pNext = mItems[idx];
+  mItems[idx] = item;
+
+  item->pNewer = NULL;
+  item->pOlder = pNewest;
+  if(pNewest) pNewest->pNewer = item;
+  else pOldest = item;
+  pNewest = item;
+
+  mLength++;
+  mMemory += size;
+
+  // one link is kept by the cache, one is given to the caller
+  program->mLinks++;
+  return program;
+}
+
+/**
+ * Releases a program returned by get().
+ * The program is deleted when neither the cache nor any regex uses it.
+ * @param program Program to be released.
+ */
+inline void sc_regexcache::release(sc_regex *program)
+{
+  if(program && --program->mLinks == 0)
+    delete program;
+}
+
+/**
+ * Drops all cached programs.
+ * Programs still used by regexes stay alive until they are released.
+ */
+void sc_regexcache::clear()
+{
+  while(pOldest)
+    remove(pOldest);
+}
+
+/**
+ * Returns the number of cached programs.
+ */
+inline long sc_regexcache::length()
+{
+  return mLength;
+}
+
+/**
+ * Returns the approximate memory taken by cached programs.
+ */
+inline long sc_regexcache::memory()
+{
+  return mMemory;
+}
+
+/**
+ * Returns the number of lookups served from the cache.
+ */
+inline long sc_regexcache::hits()
+{
+  return mHits;
+}
+
+/**
+ * Returns the number of lookups that had to compile a program.
+ */
+inline long sc_regexcache::misses()
+{
+  return mMisses;
+}
+
+/**
+ * Calculates a hash of the pattern and flags.
+ * @param pattern Regular expression body.
+ * @param len Length of the pattern.
+ * @param flags REGEX_* flags.
+ * @return Hash value.
+ */
+inline unsigned long sc_regexcache::hash(const char *pattern, long len, int flags)
+{
+  unsigned long result = len ? sc_strpool::hash(pattern, len) : 0;
+  return (result ^ (unsigned long)flags) * (unsigned long)1099511628211ULL;
+}
+
+/**
+ * Removes a record from the cache and releases its program.
+ * @param item Record to be removed.
+ */
+void sc_regexcache::remove(sc_regexcacheitem *item)
+{
+  sc_regexcacheitem **link = &mItems[item->mHash & (mSize - 1)];
+  while(*link != item)
+    link = &(*link)->pNext;
+  *link = item->pNext;
+
+  if(item->pNewer) item->pNewer->pOlder = item->pOlder;
+  else pNewest = item->pOlder;
+  if(item->pOlder) item->pOlder->pNewer = item->pNewer;
+  else pOldest = item->pNewer;
+
+  mLength--;
+  mMemory -= item->mSize;
+
+  release(item->mProgram);
+  delete [] item->mPattern;
+  delete item;
+}
+
+/**
+ * Doubles the number of buckets and rehashes all records.
+ */
+void sc_regexcache::grow()
+{
+  long new_size = mSize ? mSize * 2 : REGEXCACHE_MIN_SIZE;
+  sc_regexcacheitem **new_items = new sc_regexcacheitem*[new_size];
+  if(!new_items) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  for(long idx = 0; idx < new_size; idx++)
+    new_items[idx] = NULL;
+
+  for(long idx = 0; idx < mSize; idx++)
+  {
+    sc_regexcacheitem *curr = mItems[idx];
+    while(curr)
+    {
+      sc_regexcacheitem *next = curr->pNext;
+      long pos = curr->mHash & (new_size - 1);
+      curr->pNext = new_items[pos];
+      new_items[pos] = curr;
+      curr = next;
+    }
+  }
+
+  delete [] mItems;
+  mItems = new_items;
+  mSize = new_size;
+}
+
+#endif
@@ -0,0 +1,291 @@
+/**
+ * @file sc_request.h
+ * @author impworks.
+ * sc_request header.
+ * Defines properties and methods of sc_request class.
+ */
+
+#ifndef SC_REQUEST_H
+#define SC_REQUEST_H
+
+#if MALCO_PLATFORM == M_PLATF_NIX
+
+/**
+ * sc_request constructor.
+ */
+sc_request::sc_request()
+{
+  mFailed = false;
+
+  mBody = new ic_string();
+  mHeaders = new ic_string();
+  mOutput = new ic_string();
+  if(!mBody || !mHeaders || !mOutput) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  clear();
+}
+
+/**
+ * sc_request destructor.
+ */
+sc_request::~sc_request()
+{
+  delete mBody;
+  delete mHeaders;
+  delete mOutput;
+}
+
+/**
+ * Forgets the request data and the response.
+ */
+void sc_request::clear()
+{
+  mGet.clear();
+  mPost.clear();
+  mCookie.clear();
+  mServer.clear();
+
+  mBody->empty();
+  mHeaders->empty();
+  mOutput->empty();
+
+  mStatus = 200;
+  mNoBody = false;
+  mTyped = false;
+  mSent = false;
+}
+
+/**
+ * Parses URL-encoded parameters.
+ * A parameter that is repeated keeps the last value.
+ * @param map Map to put parameters to.
+ * @param str Parameters separated with ampersands.
+ * @param length Length of the string.
+ */
+void sc_request::parse_query(sc_map *map, const char *str, long length)
+{
+  const char *end = str + length;
+  while(str < end)
+  {
+    const char *next = (const char *)memchr(str, '&', end - str);
+    if(!next) next = end;
+
+    const char *eq = (const char *)memchr(str, '=', next - str);
+    if(!eq) eq = next;
+
+    if(eq > str)
+    {
+      ic_string *name = url_decode(str, eq - str);
+      ic_string *value = url_decode(eq < next ? eq + 1 : next, eq < next ? next - eq - 1 : 0);
+      map->set(name, value);
+      delete name;
+      delete value;
+    }
+
+    str = next + 1;
+  }
+}
+
+/**
+ * Parses the Cookie header.
+ * A cookie that is repeated keeps the first value, which is the most specific one.
+ * @param str Header value, cut into pieces in place.
+ */
+void sc_request::parse_cookies(char *str)
+{
+  while(str && *str)
+  {
+    char *next = strchr(str, ';');
+    if(next) *next++ = '\0';
+
+    while(*str == ' ') str++;
+    char *eq = strchr(str, '=');
+    if(eq && eq > str)
+    {
+      *eq++ = '\0';
+      if(!mCookie.get(str))
+      {
+        ic_string *value = url_decode(eq, strlen(eq));
+        mCookie.set(str, value);
+        delete value;
+      }
+    }
+
+    str = next;
+  }
+}
+
+/**
+ * Parses the body into form fields if it is URL-encoded.
+ */
+void sc_request::parse_body()
+{
+  char *type = mServer.get("CONTENT_TYPE");
+  if(mBody->length() && type && !strncasecmp(type, "application/x-www-form-urlencoded", 33))
+    parse_query(&mPost, mBody->get(), mBody->length());
+}
+
+/**
+ * Decodes a URL-encoded string.
+ * Pluses become spaces, malformed escapes are kept as they are.
+ * @param str String.
+ * @param length Length of the string.
+ * @return New string.
+ */
+ic_string *sc_request::url_decode(const char *str, long length)
+{
+  char *buf = new char[length + 1];
+  if(!buf) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  long len = 0;
+  for(long idx = 0; idx < length; idx++)
+  {
+    if(str[idx] == '+')
+      buf[len++] = ' ';
+    else if(str[idx] == '%' && idx + 2 < length && isxdigit(str[idx+1]) && isxdigit(str[idx+2]))
+    {
+      char hex[3] = { str[idx+1], str[idx+2], '\0' };
+      buf[len++] = (char)strtol(hex, NULL, 16);
+      idx += 2;
+    }
+    else
+      buf[len++] = str[idx];
+  }
+
+  ic_string *result = len ? new ic_string(buf, len) : new ic_string();
+  if(!result) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  delete [] buf;
+  return result;
+}
+
+/**
+ * Sets the status of the response.
+ * @param code HTTP status.
+ * @return false if the headers have already been sent.
+ */
+bool sc_request::status(int code)
+{
+  if(mSent || code < 100 || code > 999)
+    return false;
+
+  mStatus = code;
+  return true;
+}
+
+/**
+ * Adds a header to the response.
+ * The length of the body, the connection and the status are managed by the server.
+ * @param name Header name.
+ * @param value Header value.
+ * @return false if the headers have already been sent or the header is not valid.
+ */
+bool sc_request::header(const char *name, const char *value)
+{
+  if(mSent || !*name)
+    return false;
+
+  // line breaks would let the script's data forge headers of it's own
+  for(const char *chr = name; *chr; chr++)
+    if(*chr <= ' ' || *chr == ':' || *chr == 127)
+      return false;
+
+  if(strpbrk(value, "\r\n"))
+    return false;
+
+  if(!strcasecmp(name, "Content-Length") || !strcasecmp(name, "Transfer-Encoding")
+  || !strcasecmp(name, "Connection") || !strcasecmp(name, "Status"))
+    return false;
+
+  if(!strcasecmp(name, "Content-Type"))
+    mTyped = true;
+
+  mHeaders->append(name);
+  mHeaders->append(": ");
+  if(*value) mHeaders->append(value);
+  mHeaders->append("\r\n");
+  return true;
+}
+
+/**
+ * Writes to the response body.
+ * The body is sent once the script finishes or there is enough of it.
+ * @param data Data.
+ * @param size Number of bytes.
+ */
+void sc_request::write(const char *data, long size)
+{
+  if(mFailed || size <= 0)
+    return;
+
+  mOutput->append(data, size);
+  if(mOutput->length() >= HTTP_CHUNK)
+    flush();
+}
+
+/**
+ * Replaces the response with an error page.
+ * If the headers have already been sent, the connection is abandoned
+ * so that the client sees the response is incomplete.
+ * @param code HTTP status.
+ */
+void sc_request::error(int code)
+{
+  if(mSent)
+  {
+    mFailed = true;
+    return;
+  }
+
+  mStatus = code;
+  mTyped = true;
+  mHeaders->set("Content-Type: text/plain\r\n");
+
+  ic_string *msg = ic_string::format("%i %s\n", (long)code, reason(code));
+  mOutput->set(msg);
+  delete msg;
+}
+
+/**
+ * Returns the reason phrase of an HTTP status.
+ * @param code HTTP status.
+ * @return Reason phrase.
+ */
+const char *sc_request::reason(int code)
+{
+  switch(code)
+  {
+    case 200: return "OK";
+    case 201: return "Created";
+    case 204: return "No Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 303: return "See Other";
+    case 304: return "Not Modified";
+    case 307: return "Temporary Redirect";
+    case 308: return "Permanent Redirect";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 408: return "Request Timeout";
+    case 409: return "Conflict";
+    case 410: return "Gone";
+    case 413: return "Payload Too Large";
+    case 415: return "Unsupported Media Type";
+    case 429: return "Too Many Requests";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    case 505: return "HTTP Version Not Supported";
+  }
+
+  return "Unknown";
+}
+
+#endif
+
+#endif
@@ -0,0 +1,272 @@
+/**
+ * @file sc_sort.h
+ * @author impworks.
+ * sc_sort class header.
+ * Defines methods of sc_sort class.
+ */
+
+#ifndef SC_SORT_H
+#define SC_SORT_H
+
+/**
+ * Sorts the items.
+ * Items that are equal keep their order.
+ * @param items Items to be sorted.
+ * @param length Number of items.
+ * @param cmp Comparer.
+ */
+template <typename T, typename C>
+void sc_sort<T, C>::sort(T *items, long length, C &cmp)
+{
+  if(length < 2) return;
+
+  long min = min_run(length);
+  if(length <= min)
+  {
+    insert(items, 0, run(items, 0, length, cmp), length, cmp);
+    return;
+  }
+
+  T *buf = new T[length / 2 + 1];
+  if(!buf) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  long runs[SORT_MAX_RUNS], lengths[SORT_MAX_RUNS];
+  int count = 0;
+
+  for(long from = 0; from < length; )
+  {
+    long len = run(items, from, length, cmp);
+    if(len < min)
+    {
+      long forced = MIN(min, length - from);
+      insert(items, from, from + len, from + forced, cmp);
+      len = forced;
+    }
+
+    runs[count] = from;
+    lengths[count] = len;
+    count++;
+    from += len;
+
+    // each pending run must be longer than the two next ones together,
+    // so that the runs are merged while they are about the same size
+    while(count > 1)
+    {
+      int idx = count - 2;
+      if((idx > 0 && lengths[idx-1] <= lengths[idx] + lengths[idx+1]) || (idx > 1 && lengths[idx-2] <= lengths[idx-1] + lengths[idx]))
+      {
+        if(lengths[idx-1] < lengths[idx+1]) idx--;
+      }
+      else if(lengths[idx] > lengths[idx+1])
+        break;
+
+      merge_at(items, runs, lengths, count, idx, buf, cmp);
+    }
+  }
+
+  while(count > 1)
+  {
+    int idx = count - 2;
+    if(idx > 0 && lengths[idx-1] < lengths[idx+1]) idx--;
+    merge_at(items, runs, lengths, count, idx, buf, cmp);
+  }
+
+  delete [] buf;
+}
+
+/**
+ * Returns the shortest run worth merging for the given number of items.
+ * The number of runs is kept a power of two or slightly less.
+ * @param length Number of items.
+ */
+template <typename T, typename C>
+long sc_sort<T, C>::min_run(long length)
+{
+  long rest = 0;
+  while(length >= SORT_MIN_MERGE)
+  {
+    rest |= length & 1;
+    length >>= 1;
+  }
+
+  return length + rest;
+}
+
+/**
+ * Finds the run of ordered items at the position.
+ * A strictly descending run is reversed, so that equal items keep their order.
+ * @param items Items.
+ * @param from Position of the run.
+ * @param length Number of items.
+ * @param cmp Comparer.
+ * @return Length of the run.
+ */
+template <typename T, typename C>
+long sc_sort<T, C>::run(T *items, long from, long length, C &cmp)
+{
+  long end = from + 1;
+  if(end == length) return 1;
+
+  if(cmp.less(items[end], items[from]))
+  {
+    while(end + 1 < length && cmp.less(items[end+1], items[end]))
+      end++;
+
+    for(long left = from, right = end; left < right; left++, right--)
+    {
+      T tmp = items[left];
+      items[left] = items[right];
+      items[right] = tmp;
+    }
+  }
+  else
+  {
+    while(end + 1 < length && !cmp.less(items[end+1], items[end]))
+      end++;
+  }
+
+  return end - from + 1;
+}
+
+/**
+ * Sorts a range of items with binary insertion.
+ * @param items Items.
+ * @param from Start of the range.
+ * @param sorted End of the part of the range that is already sorted.
+ * @param to End of the range.
+ * @param cmp Comparer.
+ */
+template <typename T, typename C>
+void sc_sort<T, C>::insert(T *items, long from, long sorted, long to, C &cmp)
+{
+  for(long idx = sorted; idx < to; idx++)
+  {
+    T item = items[idx];
+
+    // goes after all equal items
+    long left = from, right = idx;
+    while(left < right)
+    {
+      long mid = left + (right - left) / 2;
+      if(cmp.less(item, items[mid]))
+        right = mid;
+      else
+        left = mid + 1;
+    }
+
+    for(long pos = idx; pos > left; pos--)
+      items[pos] = items[pos-1];
+    items[left] = item;
+  }
+}
+
+/**
+ * Merges two adjacent sorted ranges.
+ * @param items Items.
+ * @param from Start of the first range.
+ * @param mid Start of the second range.
+ * @param to End of the second range.
+ * @param buf Buffer for the smaller range.
+ * @param cmp Comparer.
+ */
+template <typename T, typename C>
+void sc_sort<T, C>::merge(T *items, long from, long mid, long to, T *buf, C &cmp)
+{
+  // ranges that are in order already are left alone
+  if(!cmp.less(items[mid], items[mid-1])) return;
+
+  // leading items of the first range that are not greater than the whole
+  // second range stay in place, as do trailing items of the second range
+  long left = from, right = mid;
+  while(left < right)
+  {
+    long pos = left + (right - left) / 2;
+    if(cmp.less(items[mid], items[pos]))
+      right = pos;
+    else
+      left = pos + 1;
+  }
+  from = left;
+
+  left = mid;
+  right = to;
+  while(left < right)
+  {
+    long pos = left + (right - left) / 2;
+    if(cmp.less(items[pos], items[mid-1]))
+      left = pos + 1;
+    else
+      right = pos;
+  }
+  to = left;
+
+  long idx1, idx2, pos;
+  if(mid - from <= to - mid)
+  {
+    // copy the first range aside and merge from the start
+    for(idx1 = from; idx1 < mid; idx1++)
+      buf[idx1 - from] = items[idx1];
+
+    long len = mid - from;
+    idx1 = 0;
+    idx2 = mid;
+    pos = from;
+    while(idx1 < len && idx2 < to)
+    {
+      if(cmp.less(items[idx2], buf[idx1]))
+        items[pos++] = items[idx2++];
+      else
+        items[pos++] = buf[idx1++];
+    }
+
+    while(idx1 < len)
+      items[pos++] = buf[idx1++];
+  }
+  else
+  {
+    // copy the second range aside and merge from the end
+    for(idx2 = mid; idx2 < to; idx2++)
+      buf[idx2 - mid] = items[idx2];
+
+    idx1 = mid - 1;
+    idx2 = to - mid - 1;
+    pos = to - 1;
+    while(idx1 >= from && idx2 >= 0)
+    {
+      if(cmp.less(buf[idx2], items[idx1]))
+        items[pos--] = items[idx1--];
+      else
+        items[pos--] = buf[idx2--];
+    }
+
+    while(idx2 >= 0)
+      items[pos--] = buf[idx2--];
+  }
+}
+
+/**
+ * Merges a pending run with the next one.
+ * @param items Items.
+ * @param runs Starts of the pending runs.
+ * @param lengths Lengths of the pending runs.
+ * @param count Number of pending runs.
+ * @param idx Index of the run to be merged.
+ * @param buf Buffer for merging.
+ * @param cmp Comparer.
+ */
+template <typename T, typename C>
+void sc_sort<T, C>::merge_at(T *items, long *runs, long *lengths, int &count, int idx, T *buf, C &cmp)
+{
+  merge(items, runs[idx], runs[idx+1], runs[idx+1] + lengths[idx+1], buf, cmp);
+  lengths[idx] += lengths[idx+1];
+
+  if(idx + 2 < count)
+  {
+    runs[idx+1] = runs[idx+2];
+    lengths[idx+1] = lengths[idx+2];
+  }
+
+  count--;
+}
+
+#endif
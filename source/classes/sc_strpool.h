@@ -0,0 +1,153 @@
+/**
+ * @file sc_strpool.h
+ * @author impworks.
+ * sc_strpool class header.
+ * Defines properties and methods of sc_strpool class.
+ */
+
+#ifndef SC_STRPOOL_H
+#define SC_STRPOOL_H
+
+sc_strpoolitem **sc_strpool::mItems = NULL;
+long sc_strpool::mSize = 0;
+long sc_strpool::mLength = 0;
+std::mutex sc_strpool::mLock;
+
+/**
+ * Calculates a hash of the string (FNV-1a).
+ * @param str String to be hashed.
+ * @param len Length of the string (0 to autocalculate).
+ * @return Hash value.
+ */
+inline unsigned long sc_strpool::hash(const char *str, long len)
+{
+  unsigned long hash = (unsigned long)14695981039346656037ULL;
+  if(len)
+  {
+    for(long idx = 0; idx < len; idx++)
+      hash = (hash ^ (unsigned char)str[idx]) * (unsigned long)1099511628211ULL;
+  }
+  else
+  {
+    while(*str)
+      hash = (hash ^ (unsigned char)*str++) * (unsigned long)1099511628211ULL;
+  }
+
+  return hash;
+}
+
+/**
+ * Searches the pool for an interned copy of the string.
+ * @param str String to be found.
+ * @param len Length of the string (0 to autocalculate).
+ * @return Pool record or NULL if the string has not been interned.
+ */
+sc_strpoolitem *sc_strpool::find(const char *str, long len)
+{
+  std::lock_guard<std::mutex> lock(mLock);
+
+  if(!mLength) return NULL;
+  if(!len) len = strlen(str);
+
+  unsigned long hash = sc_strpool::hash(str, len);
+  long idx = hash & (mSize - 1);
+  while(mItems[idx])
+  {
+    sc_strpoolitem *curr = mItems[idx];
+    if(curr->mHash == hash && curr->mLength == len && !memcmp(curr->mString, str, len))
+      return curr;
+
+    idx = (idx + 1) & (mSize - 1);
+  }
+
+  return NULL;
+}
+
+/**
+ * Interns the string: returns the pool record sharing storage with all equal strings.
+ * @param str String to be interned.
+ * @param len Length of the string (0 to autocalculate).
+ * @return Pool record.
+ */
+sc_strpoolitem *sc_strpool::add(const char *str, long len)
+{
+  std::lock_guard<std::mutex> lock(mLock);
+
+  if(!len) len = strlen(str);
+
+  // keep load factor below 1/2
+  if((mLength + 1) * 2 > mSize)
+    grow();
+
+  unsigned long hash = sc_strpool::hash(str, len);
+  long idx = hash & (mSize - 1);
+  while(mItems[idx])
+  {
+    sc_strpoolitem *curr = mItems[idx];
+    if(curr->mHash == hash && curr->mLength == len && !memcmp(curr->mString, str, len))
+      return curr;
+
+    idx = (idx + 1) & (mSize - 1);
+  }
+
+  sc_strpoolitem *item = new sc_strpoolitem();
+  if(!item) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  item->mString = new char[len+1];
+  memcpy(item->mString, str, len);
+  item->mString[len] = '\0';
+  item->mLength = len;
+  item->mHash = hash;
+
+  mItems[idx] = item;
+  mLength++;
+
+  return item;
+}
+
+/**
+ * Interns the string.
+ * @param str String to be interned.
+ * @param len Length of the string (0 to autocalculate).
+ * @return Shared immutable copy of the string.
+ */
+inline const char *sc_strpool::intern(const char *str, long len)
+{
+  return add(str, len)->mString;
+}
+
+/**
+ * Returns the number of interned strings.
+ */
+inline long sc_strpool::length()
+{
+  return mLength;
+}
+
+/**
+ * Doubles the size of the pool and rehashes all records.
+ */
+void sc_strpool::grow()
+{
+  long new_size = mSize ? mSize * 2 : STRPOOL_MIN_SIZE;
+  sc_strpoolitem **new_items = new sc_strpoolitem*[new_size];
+  if(!new_items) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  for(long idx = 0; idx < new_size; idx++)
+    new_items[idx] = NULL;
+
+  for(long idx = 0; idx < mSize; idx++)
+  {
+    sc_strpoolitem *curr = mItems[idx];
+    if(!curr) continue;
+
+    long pos = curr->mHash & (new_size - 1);
+    while(new_items[pos])
+      pos = (pos + 1) & (new_size - 1);
+    new_items[pos] = curr;
+  }
+
+  delete [] mItems;
+  mItems = new_items;
+  mSize = new_size;
+}
+
+#endif
@@ -0,0 +1,350 @@
+/**
+ * @file sc_strset.h
+ * @author impworks.
+ * sc_strset class header.
+ * Defines properties and methods of sc_strset class.
+ */
+
+#ifndef SC_STRSET_H
+#define SC_STRSET_H
+
+/**
+ * sc_strset constructor.
+ */
+sc_strset::sc_strset()
+{
+  mNodes = NULL;
+  mNumNodes = 0;
+  mNodesSize = 0;
+  mEdges = NULL;
+  mNumEdges = 0;
+  mEdgesSize = 0;
+  mSame = NULL;
+  mWidths = NULL;
+  mLength = 0;
+  mSize = 0;
+  mBuilt = false;
+
+  for(int idx=0; idx<256; idx++)
+    mRoot[idx] = 0;
+
+  node_new(0);
+}
+
+/**
+ * sc_strset destructor.
+ */
+sc_strset::~sc_strset()
+{
+  delete [] mNodes;
+  delete [] mEdges;
+  delete [] mSame;
+  delete [] mWidths;
+}
+
+/**
+ * Adds a string to the dictionary.
+ * The dictionary must be built again after that.
+ * @param str String to be added.
+ * @param len Length of the string.
+ * @return Id of the string: strings are numbered from 0 in the order they were added.
+ */
+long sc_strset::add(const char *str, long len)
+{
+  int curr = 0;
+  for(long idx=0; idx<len; idx++)
+  {
+    int next = child(curr, str[idx]);
+    if(next < 0)
+    {
+      next = node_new(mNodes[curr].depth + 1);
+      if(curr)
+        edge_new(curr, str[idx], next);
+      else
+        mRoot[(unsigned char)str[idx]] = next;
+    }
+
+    curr = next;
+  }
+
+  if(mLength == mSize)
+  {
+    long new_size = mSize ? mSize * 2 : 16;
+    long *same = new long[new_size], *widths = new long[new_size];
+    if(!same || !widths) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+    if(mLength)
+    {
+      memcpy(same, mSame, mLength * sizeof(long));
+      memcpy(widths, mWidths, mLength * sizeof(long));
+    }
+
+    delete [] mSame;
+    delete [] mWidths;
+    mSame = same;
+    mWidths = widths;
+    mSize = new_size;
+  }
+
+  // equal strings share the node and are chained to the first one
+  long id = mLength++;
+  mSame[id] = -1;
+  mWidths[id] = len;
+  if(mNodes[curr].id < 0)
+    mNodes[curr].id = id;
+  else
+  {
+    long last = mNodes[curr].id;
+    while(mSame[last] >= 0)
+      last = mSame[last];
+    mSame[last] = id;
+  }
+
+  mBuilt = false;
+  return id;
+}
+
+/**
+ * Calculates failure and output links, breadth first.
+ */
+void sc_strset::build()
+{
+  int *queue = new int[mNumNodes], head = 0, tail = 0;
+  if(!queue) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  // the root itself is never an output: empty strings are reported separately
+  for(int chr=0; chr<256; chr++)
+  {
+    int next = mRoot[chr];
+    if(!next) continue;
+    mNodes[next].fail = 0;
+    mNodes[next].output = -1;
+    queue[tail++] = next;
+  }
+
+  while(head < tail)
+  {
+    int curr = queue[head++];
+    for(int idx=mNodes[curr].edges; idx>=0; idx=mEdges[idx].next)
+    {
+      int next = mEdges[idx].target;
+      int fail = step(mNodes[curr].fail, mEdges[idx].chr);
+      mNodes[next].fail = fail;
+      mNodes[next].output = (fail && mNodes[fail].id >= 0) ? fail : mNodes[fail].output;
+      queue[tail++] = next;
+    }
+  }
+
+  delete [] queue;
+  mBuilt = true;
+}
+
+/**
+ * Returns the number of strings in the dictionary.
+ */
+inline long sc_strset::length()
+{
+  return mLength;
+}
+
+/**
+ * Returns the length of a string from the dictionary.
+ * @param id String id.
+ */
+inline long sc_strset::width(long id)
+{
+  return mWidths[id];
+}
+
+/**
+ * Checks whether any string of the dictionary occurs in the text.
+ * @param str Text to be searched.
+ * @param len Length of the text.
+ */
+bool sc_strset::any(const char *str, long len)
+{
+  if(!mBuilt) build();
+  if(mNodes[0].id >= 0) return true;
+
+  int curr = 0;
+  for(long pos=0; pos<len; pos++)
+  {
+    curr = step(curr, str[pos]);
+    if(mNodes[curr].id >= 0 || mNodes[curr].output >= 0)
+      return true;
+  }
+
+  return false;
+}
+
+/**
+ * Finds out which strings of the dictionary occur in the text.
+ * @param str Text to be searched.
+ * @param len Length of the text.
+ * @param[out] found Flags for every string, must be zeroed by the caller.
+ * @return Number of strings found.
+ */
+long sc_strset::scan(const char *str, long len, char *found)
+{
+  if(!mBuilt) build();
+
+  long count = report(0, found);
+  int curr = 0;
+  for(long pos=0; pos<len && count<mLength; pos++)
+  {
+    curr = step(curr, str[pos]);
+
+    // a reported node has had all of its output chain reported too
+    int out = mNodes[curr].id >= 0 ? curr : mNodes[curr].output;
+    while(out >= 0 && !found[mNodes[out].id])
+    {
+      count += report(out, found);
+      out = mNodes[out].output;
+    }
+  }
+
+  return count;
+}
+
+/**
+ * Finds the leftmost occurence of any string, the longest one if several start there.
+ * Empty strings are never found.
+ * @param str Text to be searched.
+ * @param len Length of the text.
+ * @param offset Position to start searching from.
+ * @param[out] start Position of the occurence.
+ * @param[out] id Id of the string found (the first one added if it was added several times).
+ * @return Whether anything was found.
+ */
+bool sc_strset::find(const char *str, long len, long offset, long *start, long *id)
+{
+  if(!mBuilt) build();
+
+  long best = -1;
+  int curr = 0;
+  for(long pos=offset; pos<len; pos++)
+  {
+    curr = step(curr, str[pos]);
+
+    // nothing that ends later can start before the current prefix
+    if(best >= 0 && pos + 1 - mNodes[curr].depth > *start)
+      break;
+
+    // the longest string ending here starts the leftmost
+    int out = (curr && mNodes[curr].id >= 0) ? curr : mNodes[curr].output;
+    if(out < 0) continue;
+
+    long out_start = pos + 1 - mNodes[out].depth;
+    if(best < 0 || out_start < *start || (out_start == *start && mNodes[out].depth > mWidths[best]))
+    {
+      best = mNodes[out].id;
+      *start = out_start;
+    }
+  }
+
+  if(best < 0) return false;
+  *id = best;
+  return true;
+}
+
+/**
+ * Returns the node the string leads to from a node by a character, following failure links.
+ */
+inline int sc_strset::step(int from, char chr)
+{
+  while(from)
+  {
+    int next = child(from, chr);
+    if(next >= 0) return next;
+    from = mNodes[from].fail;
+  }
+
+  return mRoot[(unsigned char)chr];
+}
+
+/**
+ * Returns a child of the node by a character.
+ * @return Node index, -1 if there is no such child.
+ */
+inline int sc_strset::child(int from, char chr)
+{
+  if(!from)
+    return mRoot[(unsigned char)chr] ? mRoot[(unsigned char)chr] : -1;
+
+  for(int idx=mNodes[from].edges; idx>=0; idx=mEdges[idx].next)
+    if(mEdges[idx].chr == chr)
+      return mEdges[idx].target;
+
+  return -1;
+}
+
+/**
+ * Marks all strings ending at the node as found.
+ * @return Number of strings marked.
+ */
+long sc_strset::report(int from, char *found)
+{
+  long count = 0;
+  for(long id=mNodes[from].id; id>=0; id=mSame[id])
+  {
+    if(found[id]) continue;
+    found[id] = 1;
+    count++;
+  }
+
+  return count;
+}
+
+/**
+ * Creates a trie node.
+ * @param depth Length of the prefix the node stands for.
+ * @return Node index.
+ */
+int sc_strset::node_new(int depth)
+{
+  if(mNumNodes == mNodesSize)
+  {
+    long new_size = mNodesSize ? mNodesSize * 2 : 64;
+    node *nodes = new node[new_size];
+    if(!nodes) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+    if(mNumNodes) memcpy(nodes, mNodes, mNumNodes * sizeof(node));
+    delete [] mNodes;
+    mNodes = nodes;
+    mNodesSize = new_size;
+  }
+
+  node *item = mNodes + mNumNodes;
+  item->edges = -1;
+  item->fail = 0;
+  item->output = -1;
+  item->depth = depth;
+  item->id = -1;
+  return mNumNodes++;
+}
+
+/**
+ * Creates a trie edge.
+ * @param from Parent node.
+ * @param chr Character.
+ * @param to Child node.
+ */
+void sc_strset::edge_new(int from, char chr, int to)
+{
+  if(mNumEdges == mEdgesSize)
+  {
+    long new_size = mEdgesSize ? mEdgesSize * 2 : 64;
+    edge *edges = new edge[new_size];
+    if(!edges) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+    if(mNumEdges) memcpy(edges, mEdges, mNumEdges * sizeof(edge));
+    delete [] mEdges;
+    mEdges = edges;
+    mEdgesSize = new_size;
+  }
+
+  edge *item = mEdges + mNumEdges;
+  item->chr = chr;
+  item->target = to;
+  item->next = mNodes[from].edges;
+  mNodes[from].edges = mNumEdges++;
+}
+
+#endif
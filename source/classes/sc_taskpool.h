@@ -0,0 +1,203 @@
+/**
+ * @file sc_taskpool.h
+ * @author impworks.
+ * sc_taskpool header.
+ * Defines properties and methods of sc_taskpool class.
+ */
+
+#ifndef SC_TASKPOOL_H
+#define SC_TASKPOOL_H
+
+/**
+ * sc_taskpool constructor.
+ * Starts the workers, which wait for jobs.
+ * @param core Core whose image the heads run.
+ * @param workers Number of workers.
+ */
+sc_taskpool::sc_taskpool(rc_core *core, int workers)
+{
+  pCore = core;
+  mCount = workers > 0 ? workers : 1;
+  mJob = 0;
+  mBusy = 0;
+  mStop = false;
+  pTask = NULL;
+  pData = NULL;
+  mAbort = false;
+
+  mShares = new sc_taskshare[mCount];
+  mThreads = new std::thread[mCount];
+  if(!mShares || !mThreads) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  for(int idx=0; idx<mCount; idx++)
+  {
+    mShares[idx].mFrom = mShares[idx].mTo = 0;
+    mThreads[idx] = std::thread(&sc_taskpool::work, this, idx);
+  }
+}
+
+/**
+ * sc_taskpool destructor.
+ * Stops the workers.
+ */
+sc_taskpool::~sc_taskpool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+    mStop = true;
+    mWake.notify_all();
+  }
+
+  for(int idx=0; idx<mCount; idx++)
+    mThreads[idx].join();
+
+  delete [] mThreads;
+  delete [] mShares;
+}
+
+/**
+ * Runs the function for items 0..count-1 and waits until all of them are done.
+ * Once the function fails for an item, workers take no more items.
+ * @param count Number of items.
+ * @param task Function to be run for each item.
+ * @param data Job data passed to the function.
+ * @return false if the function has failed for an item.
+ */
+bool sc_taskpool::run(long count, pool_task task, void *data)
+{
+  if(count <= 0) return true;
+
+  std::unique_lock<std::mutex> lock(mLock);
+  pTask = task;
+  pData = data;
+  mAbort = false;
+
+  for(int idx=0; idx<mCount; idx++)
+  {
+    std::lock_guard<std::mutex> share(mShares[idx].mLock);
+    mShares[idx].mFrom = count / mCount * idx + MIN(idx, count % mCount);
+    mShares[idx].mTo = mShares[idx].mFrom + count / mCount + (idx < count % mCount ? 1 : 0);
+  }
+
+  mBusy = mCount;
+  mJob++;
+  mWake.notify_all();
+  mDone.wait(lock, [this] { return mBusy == 0; });
+
+  return !mAbort;
+}
+
+/**
+ * Returns the number of workers.
+ */
+inline int sc_taskpool::workers()
+{
+  return mCount;
+}
+
+/**
+ * Worker body: waits for jobs and runs the items it takes on a head of it's own.
+ * @param idx Index of the worker.
+ */
+void sc_taskpool::work(int idx)
+{
+  long job = 0;
+
+  while(1)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mLock);
+      mWake.wait(lock, [this, job] { return mStop || mJob != job; });
+      if(mStop) break;
+      job = mJob;
+    }
+
+    rc_cmd cmd;
+    cmd.mCmd = RASM_CMD_CALL;
+    cmd.mModifier = 0;
+    cmd.mParam.addr = 0;
+
+    rc_head *head = new rc_head(pCore);
+    if(!head) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+    head->pCmd = &cmd;
+    head->pCurrClass = head->pTmpClass = pCore->mClassCache.pObject;
+    head->pCurrObj = NULL;
+
+    long item;
+    while(!mAbort && take(idx, item))
+    {
+      if(!pTask(head, item, pData))
+        mAbort = true;
+    }
+
+    delete head;
+
+    std::lock_guard<std::mutex> lock(mLock);
+    if(!--mBusy)
+      mDone.notify_all();
+  }
+
+  sc_regexcache::clear();
+}
+
+/**
+ * Takes the next item for the worker.
+ * Once the worker's share is empty, the back half of the largest share is stolen.
+ * @param idx Index of the worker.
+ * @param[out] item Item to be run.
+ * @return false if no items are left.
+ */
+bool sc_taskpool::take(int idx, long &item)
+{
+  sc_taskshare *own = &mShares[idx];
+
+  {
+    std::lock_guard<std::mutex> lock(own->mLock);
+    if(own->mFrom < own->mTo)
+    {
+      item = own->mFrom++;
+      return true;
+    }
+  }
+
+  while(1)
+  {
+    int victim = -1;
+    long most = 0;
+    for(int curr=0; curr<mCount; curr++)
+    {
+      if(curr == idx) continue;
+
+      std::lock_guard<std::mutex> lock(mShares[curr].mLock);
+      if(mShares[curr].mTo - mShares[curr].mFrom > most)
+      {
+        most = mShares[curr].mTo - mShares[curr].mFrom;
+        victim = curr;
+      }
+    }
+
+    if(victim < 0)
+      return false;
+
+    long from, to;
+    {
+      std::lock_guard<std::mutex> lock(mShares[victim].mLock);
+      from = mShares[victim].mFrom;
+      to = mShares[victim].mTo;
+
+      // someone else has been faster
+      if(from >= to) continue;
+
+      from += (to - from) / 2;
+      mShares[victim].mTo = from;
+    }
+
+    std::lock_guard<std::mutex> lock(own->mLock);
+    item = from;
+    own->mFrom = from + 1;
+    own->mTo = to;
+    return true;
+  }
+}
+
+#endif
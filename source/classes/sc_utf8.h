@@ -0,0 +1,307 @@
+/**
+ * @file sc_utf8.h
+ * @author impworks.
+ * sc_utf8 class header.
+ * Defines properties and methods of sc_utf8 class.
+ */
+
+#ifndef SC_UTF8_H
+#define SC_UTF8_H
+
+#define UTF8_HIGH_BITS      0x8080808080808080ULL
+#define UTF8_LOW_BITS       0x0101010101010101ULL
+
+/**
+ * Checks whether the byte is a continuation of a multibyte sequence.
+ */
+inline bool sc_utf8::is_tail(char chr)
+{
+  return ((unsigned char)chr & 0xC0) == 0x80;
+}
+
+/**
+ * Checks whether the text is well-formed UTF-8: no overlong forms,
+ * no surrogates, nothing above U+10FFFF. ASCII runs are skipped 8 bytes at a time.
+ * @param str Text to be checked.
+ * @param len Length of the text in bytes.
+ * @return true if the text is valid.
+ */
+bool sc_utf8::validate(const char *str, long len)
+{
+  const unsigned char *ptr = (const unsigned char *)str, *end = ptr + len;
+
+  while(ptr < end)
+  {
+    // fast path for plain ASCII
+    while(end - ptr >= 8)
+    {
+      uint64_t word;
+      memcpy(&word, ptr, 8);
+      if(word & UTF8_HIGH_BITS) break;
+      ptr += 8;
+    }
+
+    if(ptr == end) break;
+    if(*ptr < 0x80)
+    {
+      ptr++;
+      continue;
+    }
+
+    unsigned char lead = *ptr;
+    long left = end - ptr;
+    if(lead >= 0xC2 && lead <= 0xDF)
+    {
+      if(left < 2 || !is_tail(ptr[1])) return false;
+      ptr += 2;
+    }
+    else if(lead >= 0xE0 && lead <= 0xEF)
+    {
+      if(left < 3 || !is_tail(ptr[1]) || !is_tail(ptr[2])) return false;
+      // overlong forms and surrogates
+      if(lead == 0xE0 && ptr[1] < 0xA0) return false;
+      if(lead == 0xED && ptr[1] > 0x9F) return false;
+      ptr += 3;
+    }
+    else if(lead >= 0xF0 && lead <= 0xF4)
+    {
+      if(left < 4 || !is_tail(ptr[1]) || !is_tail(ptr[2]) || !is_tail(ptr[3])) return false;
+      // overlong forms and values above U+10FFFF
+      if(lead == 0xF0 && ptr[1] < 0x90) return false;
+      if(lead == 0xF4 && ptr[1] > 0x8F) return false;
+      ptr += 4;
+    }
+    else
+      return false;
+  }
+
+  return true;
+}
+
+/**
+ * Counts characters in the text.
+ * Every byte that is not a continuation byte starts a new character, so
+ * malformed bytes count as single characters. Works 8 bytes at a time.
+ * @param str Text to be measured.
+ * @param len Length of the text in bytes.
+ * @return Number of characters.
+ */
+long sc_utf8::length(const char *str, long len)
+{
+  long tails = 0, idx = 0;
+
+  for(; idx + 8 <= len; idx += 8)
+  {
+    uint64_t word;
+    memcpy(&word, str + idx, 8);
+    // continuation bytes have the high bit set and the next one cleared
+    uint64_t mask = (word & ~(word << 1)) & UTF8_HIGH_BITS;
+    tails += (long)(((mask >> 7) * UTF8_LOW_BITS) >> 56);
+  }
+
+  for(; idx < len; idx++)
+    if(is_tail(str[idx])) tails++;
+
+  // a dangling continuation byte at the very beginning is a character too
+  if(len && is_tail(*str))
+    tails--;
+
+  return len - tails;
+}
+
+/**
+ * Finds the beginning of the next character.
+ * @param str Text.
+ * @param len Length of the text in bytes.
+ * @param pos Byte offset of the current character.
+ * @return Byte offset of the next character.
+ */
+inline long sc_utf8::next(const char *str, long len, long pos)
+{
+  for(pos++; pos < len && is_tail(str[pos]); pos++);
+  return pos;
+}
+
+/**
+ * Decodes a character.
+ * Malformed sequences are decoded byte by byte.
+ * @param str Text.
+ * @param len Number of bytes available.
+ * @param code Decoded code point.
+ * @return Number of bytes consumed.
+ */
+long sc_utf8::decode(const char *str, long len, long *code)
+{
+  const unsigned char *ptr = (const unsigned char *)str;
+  long need;
+
+  if(ptr[0] < 0x80)       { *code = ptr[0]; return 1; }
+  else if(ptr[0] < 0xC2)  { *code = ptr[0]; return 1; }
+  else if(ptr[0] < 0xE0)  { *code = ptr[0] & 0x1F; need = 2; }
+  else if(ptr[0] < 0xF0)  { *code = ptr[0] & 0x0F; need = 3; }
+  else if(ptr[0] < 0xF5)  { *code = ptr[0] & 0x07; need = 4; }
+  else                    { *code = ptr[0]; return 1; }
+
+  if(len < need)
+  {
+    *code = ptr[0];
+    return 1;
+  }
+
+  for(long idx = 1; idx < need; idx++)
+  {
+    if(!is_tail(ptr[idx]))
+    {
+      *code = ptr[0];
+      return 1;
+    }
+    *code = (*code << 6) | (ptr[idx] & 0x3F);
+  }
+
+  return need;
+}
+
+/**
+ * Encodes a code point.
+ * @param code Code point.
+ * @param buf Buffer of at least 4 bytes.
+ * @return Number of bytes written.
+ */
+long sc_utf8::encode(long code, char *buf)
+{
+  if(code < 0x80)
+  {
+    buf[0] = (char)code;
+    return 1;
+  }
+  else if(code < 0x800)
+  {
+    buf[0] = (char)(0xC0 | (code >> 6));
+    buf[1] = (char)(0x80 | (code & 0x3F));
+    return 2;
+  }
+  else if(code < 0x10000)
+  {
+    buf[0] = (char)(0xE0 | (code >> 12));
+    buf[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+    buf[2] = (char)(0x80 | (code & 0x3F));
+    return 3;
+  }
+  else if(code < 0x110000)
+  {
+    buf[0] = (char)(0xF0 | (code >> 18));
+    buf[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+    buf[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+    buf[3] = (char)(0x80 | (code & 0x3F));
+    return 4;
+  }
+
+  // replacement character
+  return encode(0xFFFD, buf);
+}
+
+/**
+ * Converts a code point to uppercase.
+ * Covers Latin-1, Latin Extended-A, Greek and Cyrillic. Only mappings
+ * that keep the encoded length are done, so strings can be converted in place.
+ * @param code Code point.
+ * @return Uppercase code point.
+ */
+long sc_utf8::case_up(long code)
+{
+  if(code < 0x80)
+    return (code >= 'a' && code <= 'z') ? code - 0x20 : code;
+
+  // latin-1
+  if(code >= 0xE0 && code <= 0xFE && code != 0xF7) return code - 0x20;
+  if(code == 0xFF) return 0x178;
+
+  // latin extended-a: pairs of upper and lower letters
+  if(code == 0x130 || code == 0x131) return code;
+  if((code >= 0x100 && code <= 0x137) || (code >= 0x14A && code <= 0x177))
+    return (code & 1) ? code - 1 : code;
+  if((code >= 0x139 && code <= 0x148) || (code >= 0x179 && code <= 0x17E))
+    return (code & 1) ? code : code - 1;
+
+  // greek
+  if(code == 0x3C2) return 0x3A3;
+  if(code >= 0x3B1 && code <= 0x3C9) return code - 0x20;
+
+  // cyrillic
+  if(code >= 0x430 && code <= 0x44F) return code - 0x20;
+  if(code >= 0x450 && code <= 0x45F) return code - 0x50;
+  if((code >= 0x460 && code <= 0x481) || (code >= 0x48A && code <= 0x4BF))
+    return (code & 1) ? code - 1 : code;
+
+  return code;
+}
+
+/**
+ * Converts a code point to lowercase.
+ * @see case_up
+ * @param code Code point.
+ * @return Lowercase code point.
+ */
+long sc_utf8::case_down(long code)
+{
+  if(code < 0x80)
+    return (code >= 'A' && code <= 'Z') ? code + 0x20 : code;
+
+  // latin-1
+  if(code >= 0xC0 && code <= 0xDE && code != 0xD7) return code + 0x20;
+  if(code == 0x178) return 0xFF;
+
+  // latin extended-a
+  if(code == 0x130 || code == 0x131) return code;
+  if((code >= 0x100 && code <= 0x137) || (code >= 0x14A && code <= 0x177))
+    return (code & 1) ? code : code + 1;
+  if((code >= 0x139 && code <= 0x148) || (code >= 0x179 && code <= 0x17E))
+    return (code & 1) ? code + 1 : code;
+
+  // greek
+  if(code >= 0x391 && code <= 0x3A9 && code != 0x3A2) return code + 0x20;
+
+  // cyrillic
+  if(code >= 0x410 && code <= 0x42F) return code + 0x20;
+  if(code >= 0x400 && code <= 0x40F) return code + 0x50;
+  if((code >= 0x460 && code <= 0x481) || (code >= 0x48A && code <= 0x4BF))
+    return (code & 1) ? code : code + 1;
+
+  return code;
+}
+
+/**
+ * Changes the case of every character in place.
+ * @param str Text.
+ * @param len Length of the text in bytes.
+ * @param mode 'u' for uppercase, 'd' for lowercase, 's' to swap.
+ */
+void sc_utf8::case_map(char *str, long len, char mode)
+{
+  long pos = 0, code, mapped;
+  while(pos < len)
+  {
+    long size = decode(str + pos, len - pos, &code);
+    if(size == 1 && code >= 0x80)
+    {
+      // malformed byte, leave it alone
+      pos++;
+      continue;
+    }
+
+    if(mode == 'u')
+      mapped = case_up(code);
+    else if(mode == 'd')
+      mapped = case_down(code);
+    else
+      mapped = (case_up(code) != code) ? case_up(code) : case_down(code);
+
+    // overlong forms may not keep their length, leave them alone too
+    char buf[4];
+    if(mapped != code && encode(mapped, buf) == size)
+      memcpy(str + pos, buf, size);
+    pos += size;
+  }
+}
+
+#endif
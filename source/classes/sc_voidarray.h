@@ -45,7 +45,9 @@ sc_voidarray::~sc_voidarray()
  */
 void sc_voidarray::add(void *ptr)
 {
-  resize(mLength + 1);
+  // grow by doubling, so a long run of adds is not quadratic
+  if(mLength >= mSize)
+    resize(mSize ? mSize * 2 : 8);
   mPtr[mLength++] = ptr;
 }
 
@@ -56,7 +58,7 @@ void sc_voidarray::add(void *ptr)
 void sc_voidarray::del(long index)
 {
   if(index < mLength - 1)
-    std::memmove((void *) (mPtr + index), (void *) (mPtr + index + 1), mLength - index - 1);
+    std::memmove((void *) (mPtr + index), (void *) (mPtr + index + 1), (mLength - index - 1) * sizeof(void *));
   mLength--;
 }
 
@@ -126,7 +128,7 @@ long sc_voidarray::length() const
  */
 void sc_voidarray::resize(long size)
 {
-  if(size <= mLength || size < mSize)
+  if(size <= mLength || size <= mSize)
     return;
 
   void **new_ptr = new void *[size];
@@ -30,6 +30,7 @@
 #define M_ERR_NO_MEMORY             "Not enough memory."
 #define M_ERR_BAD_INNER_INDEX       "Index was outside of bounds."
 #define M_ERR_NO_SOURCE             "Specified source file was not found."
+#define M_ERR_BAD_SOURCE_UTF8       "Source file is not a valid UTF-8 text."
 #define M_ERR_NO_STRINGTABLE        "Corresponding string table was not found."
 #define M_ERR_NO_DEFTABLE           "Corresponding definition table was not found."
 #define M_ERR_NO_SETUP              "Setup file (malco.ini) was not found."
@@ -40,7 +41,10 @@
 #define M_ERR_BAD_MODE              "Run mode '%s' is incorrect."
 #define M_ERR_BAD_COMMANDLINE       "Incorrect command line. Usage:\n malco -f filename.mlc\n"\
                                     " malco -b filename.rbc\n malco -e 'code'\n"\
-                                    " malco -c (filename.mlc|filename.rasm)\n malco -v\n malco -i"
+                                    " malco -c (filename.mlc|filename.rasm)\n malco -s filename.rbc\n malco -fcgi filename.rbc\n malco -v\n malco -i"
+#define M_ERR_SERVER_LISTEN         "Cannot listen at '%s', port %i."
+#define M_ERR_SERVER_SOCKET         "Cannot listen at socket '%s'."
+#define M_ERR_SERVER_PLATFORM       "The built-in server is not supported on this platform."
 #define M_ERR_CACHE_WRITE_FAIL      "Cannot save bytecode cache / tables on disk."
 
 #define M_ERR_PARSE_UNEXPECTED      "Unexpected token '%s'."
@@ -82,6 +86,16 @@
 #define M_ERR_BAD_IDENTIFIER        "No class/method/constant named '%s' found in '%s'."
 #define M_ERR_BAD_BIND              "Cannot bind a non-method object."
 #define M_ERR_FROZEN                "Cannot modify a frozen object."
+#define M_ERR_THREAD_COPY           "Objects of class '%s' cannot be passed between threads."
+#define M_ERR_THREAD_SCOPE          "Lambdas bound to a scope cannot be run in a thread."
+#define M_ERR_THREAD_MAIN           "Method '%s' can only be called inside a thread."
+#define M_ERR_STATIC_THREAD         "Static member '%s' of class '%s' can only be used by the main thread."
+#define M_ERR_GENERATOR_RUNNING     "Generator is already running."
+#define M_ERR_YIELD                 "Only the method of a generator can yield, and not from inside other methods."
+#define M_ERR_SOCKET_TYPE           "Unknown socket type '%s', expected 'tcp', 'udp' or 'unix'."
+#define M_ERR_SOCKET_THREAD         "Sockets can only be used by the main thread."
+#define M_ERR_FILE_THREAD           "Asynchronous file operations can only be used by the main thread."
+#define M_ERR_FILE_MODE             "Unknown file mode '%s', expected 'r', 'w' or 'a' with optional '+' and 'b'."
 #define M_ERR_DIRECT_OP_INVOKE      "Cannot invoke an operator directly by it's name."
 #define M_ERR_OBJECT_PARENT         "The Object class has no parent."
 #define M_ERR_CLASS_ROOT            "Class '%s' is on the top level and has no root."
@@ -95,6 +109,7 @@
 #define M_ERR_RETURN_1              "Cannot return from level 1."
 #define M_ERR_EXCEPTION             "Uncaught exception:\n%s\nFile: %s; line: %i"
 #define M_ERR_BAD_REGEXP            "Regular expression could not compile."
+#define M_ERR_REGEX_SYNTAX          "Regular expression '%s' could not compile: %s."
 #define M_ERR_BAD_ITERATOR          "Object given for foreach is not iterable."
 #define M_ERR_BAD_TO_A              "to_a() method should return an array or it's derived type."
 #define M_ERR_BAD_TO_B              "to_b() method should return a boolean or it's derived type."
@@ -134,8 +149,9 @@
 #define M_WARN_FX_UNKNOWN_PARAM     "Method '%s' does not have a parameter named '%s'."
 #define M_WARN_FX_NO_RETURN         "Method was expected to return something, but it didn't. Using undef as default."
 #define M_WARN_FX_BAD_RETURN_COUNT  "Method returned %i values, but was expected to return %i. Other values omitted."
-#define M_WARN_REGEX_SUBSTR_ID      "Match data can only store up to 10 substrings, from 0 to 9."
+#define M_WARN_REGEX_SUBSTR_ID      "Substring index is outside of the match data."
 #define M_WARN_EMPTY_SUBSTR         "Source string was not of sufficient length to get a proper substring."
+#define M_WARN_BAD_UTF8             "String constant is not valid UTF-8, malformed bytes are treated as single characters."
 #define M_WARN_ARRAY_INCOMPARABLE   "Array contains incomparable objects, '%s' failed."
 #define M_WARN_DUPLICATE_KEY        "Key '%s' was duplicate, thus only the last value has been saved."
 
@@ -23,6 +23,14 @@
 #include <ctime>
 #include <cmath>
 #include <cstdarg>
+#include <cstdint>
+#include <cstdlib>
+#include <climits>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 //****************************************************************
 //*                                                              *
@@ -82,6 +90,8 @@
 #define M_STATE_RUN                       4
 #define M_STATE_DONE                      5
 #define M_STATE_DEAD                      6
+#define M_STATE_PAUSED                    7
+#define M_STATE_UNWIND                    8
 
 // tasks
 #define M_TASK_WTF                        0
@@ -91,6 +101,8 @@
 #define M_TASK_RUN                        4
 #define M_TASK_RUN_BC                     5
 #define M_TASK_EVAL                       6
+#define M_TASK_SERVE                      7
+#define M_TASK_FCGI                       8
 
 // properties
 #define M_PROP_PUBLIC                     1
@@ -119,6 +131,10 @@
 #define M_CLASS_METHOD                    13
 #define M_CLASS_CLASS                     14
 #define M_CLASS_EXCEPTION                 15
+#define M_CLASS_REGEXSET                  16
+#define M_CLASS_LAZY                      17
+#define M_CLASS_THREAD                    18
+#define M_CLASS_GENERATOR                 19
 #define M_CLASS_OTHER                     42
 
 // platform
@@ -136,7 +152,12 @@
 #define MALCO_VERSION                     "1.0"
 #define MALCO_RELEASE                     "0.0.1"
 #define MALCO_BUILD                       1
+#ifndef MALCO_UNICODE
 #define MALCO_UNICODE                     0
+#endif
+#ifndef MALCO_URING
+#define MALCO_URING                       0
+#endif
 #define MALCO_DEBUG                       1
 #define MALCO_COPYRIGHT                   "(c) Impworks & ForNeVeR, 2006-#inf"
 
@@ -157,6 +178,37 @@
 #include <windows.h>
 #endif
 
+#if MALCO_PLATFORM == M_PLATF_NIX
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#if MALCO_URING
+#include <linux/io_uring.h>
+#endif
+#endif
+
+// SSE2 is used to probe hash tables
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MALCO_SSE2                        1
+#else
+#define MALCO_SSE2                        0
+#endif
+
 //****************************************************************
 //*                                                              *
 //*                       general includes                       *
@@ -182,31 +234,53 @@
 #include "classes/ic_string.h"
 #include "classes/ic_regex.h"
 #include "classes/ic_match.h"
+#include "classes/ic_matchiter.h"
+#include "classes/ic_regexset.h"
 #include "classes/ic_time.h"
 #include "classes/ic_file.h"
 #include "classes/ic_dir.h"
 #include "classes/ic_socket.h"
 #include "classes/ic_range.h"
 #include "classes/ic_array.h"
+#include "classes/ic_lazy.h"
+#include "classes/ic_thread.h"
+#include "classes/ic_generator.h"
 #include "classes/ic_object.h"
 
 #include "classes/sc_exception.h"
 #include "classes/sc_list.h"
 #include "classes/sc_voidlist.h"
 #include "classes/sc_voidarray.h"
+#include "classes/sc_hashmap.h"
 #include "classes/sc_map.h"
-#include "classes/sc_voidmap.h"
-#include "classes/sc_anymap.h"
 #include "classes/sc_ini.h"
 #include "classes/sc_md5.h"
 #include "classes/sc_file.h"
 #include "classes/sc_random.h"
+#include "classes/sc_strpool.h"
+#include "classes/sc_number.h"
+#include "classes/sc_utf8.h"
+#include "classes/sc_regex.h"
+#include "classes/sc_regexcache.h"
+#include "classes/sc_strset.h"
+#include "classes/sc_numarray.h"
+#include "classes/sc_sort.h"
+#include "classes/sc_hashset.h"
+#include "classes/sc_taskpool.h"
+#include "classes/sc_reactor.h"
+#include "classes/sc_aio.h"
+#include "classes/sc_request.h"
+#include "classes/sc_httprequest.h"
+#include "classes/sc_fcgirequest.h"
+#include "classes/sc_fcgiconn.h"
+#include "classes/sc_httpserver.h"
 
 #include "classes/rc_core.h"
 #include "classes/rc_tape.h"
 #include "classes/rc_strtable.h"
 #include "classes/rc_deftable.h"
 #include "classes/rc_head.h"
+#include "classes/rc_class.h"
 #include "classes/rc_method.h"
 #include "classes/rc_var.h"
 #include "classes/rc_rasm.h"
@@ -228,13 +302,21 @@
 #include "methods/m_range.h"
 #include "methods/m_regex.h"
 #include "methods/m_match.h"
+#include "methods/m_regexset.h"
 #include "methods/m_time.h"
 #include "methods/m_array.h"
+#include "methods/m_lazy.h"
+#include "methods/m_thread.h"
+#include "methods/m_generator.h"
+#include "methods/m_file.h"
+#include "methods/m_dir.h"
+#include "methods/m_socket.h"
 #include "methods/m_method.h"
 #include "methods/m_class.h"
 #include "methods/m_exception.h"
 
 #include "methods/m_malco.h"
 #include "methods/m_math.h"
+#include "methods/m_env.h"
 
 #endif
@@ -25,6 +25,7 @@ void object_untaint_do(rc_head *head);
 void object_frozen(rc_head *head);
 void object_freeze_do(rc_head *head);
 void object_id(rc_head *head);
+void object_op_hash(rc_head *head);
 void object_exec(rc_head *head);
 void object_assert(rc_head *head);
 void object_class(rc_head *head);
@@ -160,6 +161,8 @@ void string_op_cmp_string(rc_head *head);
 void string_op_rel_regex(rc_head *head);
 void string_inspect(rc_head *head);
 void string_length(rc_head *head);
+void string_capacity(rc_head *head);
+void string_reserve_do(rc_head *head);
 void string_trim(rc_head *head);
 void string_trim_left(rc_head *head);
 void string_trim_right(rc_head *head);
@@ -180,6 +183,7 @@ void string_append_do(rc_head *head);
 void string_prepend_do(rc_head *head);
 void string_replace_do(rc_head *head);
 void string_split(rc_head *head);
+void string_scan(rc_head *head);
 void string_apply(rc_head *head);
 void string_apply_do(rc_head *head);
 void string_insert(rc_head *head);
@@ -219,6 +223,10 @@ void range_op_cmp_string(rc_head *head);
 void range_op_rel_int(rc_head *head);
 void range_op_rel_float(rc_head *head);
 void range_inspect(rc_head *head);
+void range_lazy(rc_head *head);
+void range_parallel_each(rc_head *head);
+void range_parallel_map(rc_head *head);
+void range_parallel_select(rc_head *head);
 void range_length(rc_head *head);
 void range_set_do(rc_head *head);
 void range_next(rc_head *head);
@@ -243,7 +251,9 @@ void regex_op_cmp_regex(rc_head *head);
 void regex_op_cmp_string(rc_head *head);
 void regex_inspect(rc_head *head);
 void regex_match(rc_head *head);
+void regex_each_match(rc_head *head);
 void regex_study(rc_head *head);
+void regex_cache(rc_head *head);
 void regex_to_b(rc_head *head);
 void regex_to_s(rc_head *head);
 
@@ -262,6 +272,17 @@ void match_to_b(rc_head *head);
 void match_to_i(rc_head *head);
 void match_to_s(rc_head *head);
 
+//--------------------------------
+//           regex_set
+//--------------------------------
+
+void regexset_op_create(rc_head *head);
+void regexset_add_do(rc_head *head);
+void regexset_count(rc_head *head);
+void regexset_inspect(rc_head *head);
+void regexset_match(rc_head *head);
+void regexset_to_b(rc_head *head);
+
 //--------------------------------
 //             time
 //--------------------------------
@@ -306,8 +327,14 @@ void file_open(rc_head *head);
 void file_close(rc_head *head);
 void file_read(rc_head *head);
 void file_read_all(rc_head *head);
+void file_read_line(rc_head *head);
 void file_read_lines(rc_head *head);
+void file_each_line(rc_head *head);
 void file_write(rc_head *head);
+void file_read_async(rc_head *head);
+void file_write_async(rc_head *head);
+void file_read_many(rc_head *head);
+void file_loop(rc_head *head);
 void file_seek(rc_head *head);
 void file_tell(rc_head *head);
 void file_exists(rc_head *head);
@@ -326,17 +353,23 @@ void file_to_s(rc_head *head);
 //--------------------------------
 
 void socket_op_create(rc_head *head);
-void socket_inspect(rc_head *head);
-void socket_open(rc_head *head);
+void socket_accept(rc_head *head);
 void socket_close(rc_head *head);
-void socket_read(rc_head *head);
-void socket_read_all(rc_head *head);
-void socket_read_lines(rc_head *head);
-void socket_write(rc_head *head);
+void socket_connect(rc_head *head);
+void socket_eof(rc_head *head);
 void socket_length(rc_head *head);
+void socket_listen(rc_head *head);
+void socket_loop(rc_head *head);
+void socket_on_read(rc_head *head);
+void socket_on_write(rc_head *head);
+void socket_pending(rc_head *head);
+void socket_read(rc_head *head);
+void socket_read_line(rc_head *head);
+void socket_stop(rc_head *head);
 void socket_to_b(rc_head *head);
 void socket_to_i(rc_head *head);
 void socket_to_s(rc_head *head);
+void socket_write(rc_head *head);
 
 //--------------------------------
 //             dir
@@ -386,21 +419,18 @@ void array_next_key(rc_head *head);
 void array_next_pair(rc_head *head);
 void array_rewind(rc_head *head);
 void array_find(rc_head *head);
-void array_flip(rc_head *head);                       // <<< todo
-void array_flip_do(rc_head *head);                    // <<< todo
+void array_flip(rc_head *head);
+void array_flip_do(rc_head *head);
 void array_sort(rc_head *head);
 void array_sort_do(rc_head *head);
-void array_sort_quick(rc_head *head);
-void array_sort_quick_do(rc_head *head);
-void array_sort_shell(rc_head *head);
-void array_sort_shell_do(rc_head *head);
-void array_sort_by(rc_head *head);                    // <<< todo
-void array_sort_by_do(rc_head *head);                 // <<< todo
+void array_sort_by(rc_head *head);
+void array_sort_by_do(rc_head *head);
 void array_shuffle(rc_head *head);
 void array_shuffle_do(rc_head *head);
 void array_map_do(rc_head *head);
 void array_sum(rc_head *head);
 void array_mul(rc_head *head);
+void array_dot(rc_head *head);
 void array_join(rc_head *head);
 void array_reindex(rc_head *head);
 void array_reindex_do(rc_head *head);
@@ -429,6 +459,56 @@ void array_length(rc_head *head);
 void array_to_b(rc_head *head);
 void array_to_i(rc_head *head);
 void array_to_s(rc_head *head);
+void array_lazy(rc_head *head);
+void array_parallel_each(rc_head *head);
+void array_parallel_map(rc_head *head);
+void array_parallel_select(rc_head *head);
+
+//--------------------------------
+//             lazy
+//--------------------------------
+
+void lazy_op_create(rc_head *head);
+void lazy_count(rc_head *head);
+void lazy_each(rc_head *head);
+void lazy_first(rc_head *head);
+void lazy_inspect(rc_head *head);
+void lazy_map(rc_head *head);
+void lazy_reject(rc_head *head);
+void lazy_select(rc_head *head);
+void lazy_sum(rc_head *head);
+void lazy_take(rc_head *head);
+void lazy_to_a(rc_head *head);
+void lazy_to_b(rc_head *head);
+void lazy_to_s(rc_head *head);
+void lazy_zip(rc_head *head);
+
+//--------------------------------
+//             thread
+//--------------------------------
+
+void thread_op_create(rc_head *head);
+void thread_alive(rc_head *head);
+void thread_cores(rc_head *head);
+void thread_join(rc_head *head);
+void thread_listen(rc_head *head);
+void thread_receive(rc_head *head);
+void thread_reply(rc_head *head);
+void thread_send(rc_head *head);
+void thread_to_b(rc_head *head);
+void thread_to_s(rc_head *head);
+
+//--------------------------------
+//           generator
+//--------------------------------
+
+void generator_op_create(rc_head *head);
+void generator_each(rc_head *head);
+void generator_next(rc_head *head);
+void generator_take(rc_head *head);
+void generator_to_a(rc_head *head);
+void generator_to_b(rc_head *head);
+void generator_to_s(rc_head *head);
 
 //--------------------------------
 //            method
@@ -529,4 +609,17 @@ void math_max(rc_head *head);
 void math_even(rc_head *head);
 void math_base_cvt(rc_head *head);
 
+//--------------------------------
+//            env
+//--------------------------------
+
+void env_body(rc_head *head);
+void env_cookie(rc_head *head);
+void env_flush(rc_head *head);
+void env_get(rc_head *head);
+void env_header(rc_head *head);
+void env_post(rc_head *head);
+void env_server(rc_head *head);
+void env_status(rc_head *head);
+
 #endif
\ No newline at end of file
@@ -49,14 +49,15 @@ void array_op_idx(rc_head *head)
     }
     else if(cls == M_CLASS_INT)
     {
-      // convert int to string and index
-      rc_var *result = arr->get(((ic_int *)item->mData)->to_s());
+      // numeric keys go straight to packed items
+      long key = ((ic_int *)item->mData)->mValue;
+      rc_var *result = arr->get(key);
       if(!result)
       {
         // register new empty sub-array at location
         result = head->new_array();
         result->mLinks++;
-        arr->set(((ic_int *)item->mData)->to_s(), result);
+        arr->set(key, result);
       }
 
       result->mLinks++;
@@ -65,13 +66,11 @@ void array_op_idx(rc_head *head)
     else if(cls == M_CLASS_RANGE)
     {
       // retrieve many objects, which are available
-      ic_int key;
       ic_range *rg = (ic_range *)item->mData;
       rg->iter_rewind();
       while(!rg->mFinished)
       {
-        key.mValue = rg->iter_next();
-        rc_var *result = arr->get(key.to_s());
+        rc_var *result = arr->get(rg->iter_next());
         if(result)
         {
           result->mLinks++;
@@ -193,9 +192,9 @@ void array_op_cmp_array(rc_head *head)
   {
     left->iter_rewind();
     right->iter_rewind();
-    while(1)
+    sc_voidmapitem *curr1, *curr2;
+    while((curr1 = left->iter_next()) && (curr2 = right->iter_next()))
     {
-      sc_voidmapitem *curr1 = left->iter_next(), *curr2 = right->iter_next();
       char res = head->sub_compare((rc_var *)curr1->mValue, (rc_var *)curr2->mValue);
       if(res)
       {
@@ -512,47 +511,79 @@ void array_all(rc_head *head)
 }
 
 /**
- * Checks if the array has the object.
- * @todo implement recursive search
+ * Checks whether two values are equal.
+ * Values of the same built-in class are compared natively, others with #cmp.
+ * @param left Left value.
+ * @param right Right value.
+ * @param strict Values of different classes are never equal.
  */
-void array_has(rc_head *head)
+bool array_equal(rc_head *head, rc_var *left, rc_var *right, bool strict)
 {
-  ic_object *obj = head->pCurrObj->get();
-  rc_var *search_var = head->rSRC.pop();
-  ic_object *search = search_var->get();
-  ic_array *arr = (ic_array *)obj->mData;
-  sc_voidmapitem *curr;
+  ic_object *lobj = left->get(), *robj = right->get();
+  if(lobj == robj) return true;
 
-  // save to-find object in AX,
-  // current object in rSRC[0]
-  arr->iter_rewind();
-  rc_var *tmp = head->rAX;
-  head->rAX = search_var;
-  while(curr = arr->iter_next())
+  if(lobj->pClass == robj->pClass)
   {
-    rc_var *item = (rc_var *)curr->mValue;
-    item->mLinks++;
-    head->rSRC.push(item);
-    char type = head->sub_compare();
-
-    if(type == M_CLASS_INT)
+    switch(head->pCore->class_type(lobj->pClass))
     {
-      if(((ic_int *)head->rSRC.get(0)->get()->mData)->mValue == 0)
-      {
-        head->obj_unlink(head->rSRC.pop());
-        head->rSRC.push(head->new_bool(false, obj->mTainted));
-        head->obj_unlink(head->rAX);
-        head->rAX = tmp;
-        return;
-      }
+      case M_CLASS_BOOL:    return ((ic_bool *)lobj->mData)->mValue == ((ic_bool *)robj->mData)->mValue;
+      case M_CLASS_INT:     return ((ic_int *)lobj->mData)->mValue == ((ic_int *)robj->mData)->mValue;
+      case M_CLASS_FLOAT:   return ((ic_float *)lobj->mData)->mValue == ((ic_float *)robj->mData)->mValue;
+      case M_CLASS_STRING:  return ((ic_string *)lobj->mData)->compare((ic_string *)robj->mData) == 0;
+      case M_CLASS_RANGE:   return ((ic_range *)lobj->mData)->length() == ((ic_range *)robj->mData)->length();
+      case M_CLASS_TIME:    return ((ic_time *)lobj->mData)->mTimestamp == ((ic_time *)robj->mData)->mTimestamp;
     }
+  }
+  else if(strict)
+    return false;
+
+  return head->sub_compare(left, right, strict) == 0;
+}
 
-    head->obj_unlink(head->rSRC.pop());
+/**
+ * Hash set comparer for strictly equal values.
+ */
+struct array_hashcmp
+{
+  rc_head *pHead;             /**< Head to invoke operators with. */
+  bool equal(rc_var *const &a, rc_var *const &b)
+  {
+    return array_equal(pHead, a, b, true);
   }
+};
 
-  head->obj_unlink(head->rAX);
-  head->rAX = tmp;
-  head->rSRC.push(head->new_bool(false, obj->mTainted));
+/**
+ * Finds the first item equal to the value.
+ * @param arr Array to search in.
+ * @param needle Value to be found.
+ * @return Item or NULL if there is none.
+ */
+sc_voidmapitem *array_search(rc_head *head, ic_array *arr, rc_var *needle)
+{
+  sc_voidmapitem *curr;
+  arr->iter_rewind();
+  while(curr = arr->iter_next())
+  {
+    if(array_equal(head, needle, (rc_var *)curr->mValue, false))
+      return curr;
+  }
+
+  return NULL;
+}
+
+/**
+ * Checks if the array has the object.
+ * @todo implement recursive search
+ */
+void array_has(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *search_var = head->rSRC.pop();
+
+  bool found = array_search(head, (ic_array *)obj->mData, search_var) != NULL;
+  head->rSRC.push(head->new_bool(found, obj->mTainted));
+
+  head->obj_unlink(search_var);
 }
 
 /**
@@ -603,7 +634,7 @@ void array_each_key(rc_head *head)
     arr->iter_rewind();
     while(curr = arr->iter_next())
     {
-      head->rSRC.push(head->new_string(curr->mKey));
+      head->rSRC.push(head->new_string(curr->mKey->get()));
       head->method_invoke((rc_method *)fx->mData);
       head->cmd_clrsrc();
     }
@@ -632,7 +663,7 @@ void array_each_pair(rc_head *head)
     arr->iter_rewind();
     while(curr = arr->iter_next())
     {
-      head->rSRC.push(head->new_string(curr->mKey));
+      head->rSRC.push(head->new_string(curr->mKey->get()));
       rc_var *currobj = (rc_var *)curr->mValue;
       currobj->mLinks++;
       head->rSRC.push(currobj);
@@ -665,7 +696,7 @@ void array_next_key(rc_head *head)
 {
   ic_object *obj = head->pCurrObj->get();
   sc_voidmapitem *pair = ((ic_array *)obj->mData)->iter_next();
-  head->rSRC.push(head->new_string(pair->mKey, obj->mTainted));
+  head->rSRC.push(head->new_string(pair->mKey->get(), obj->mTainted));
 }
 
 /**
@@ -677,7 +708,7 @@ void array_next_pair(rc_head *head)
   sc_voidmapitem *pair = ((ic_array *)obj->mData)->iter_next();
   ((rc_var *)pair->mValue)->mLinks++;
   ic_array *arr = new ic_array();
-  arr->append(head->new_string(pair->mKey, obj->mTainted), false);
+  arr->append(head->new_string(pair->mKey->get(), obj->mTainted), false);
   arr->append((rc_var *)pair->mValue, false);
 
   head->rSRC.push(head->new_array(arr, obj->mTainted));
@@ -699,64 +730,67 @@ void array_find(rc_head *head)
 {
   ic_object *obj = head->pCurrObj->get();
   rc_var *needle_var = head->rSRC.pop();
-  ic_array *arr = (ic_array *)obj->mData;
-  sc_voidmapitem *curr;
 
-  rc_var *tmp = head->rAX;
-  head->rAX = needle_var;
-  arr->iter_rewind();
-  while(curr = arr->iter_next())
-  {
-    rc_var *item = (rc_var *)curr->mValue;
-    item->mLinks++;
-    head->rSRC.push(item);
-    char test = head->sub_compare();
-    if(test == M_CLASS_INT)
-    {
-      long value = ((ic_int *)head->rSRC.get(0)->get()->mData)->mValue;
-      if(!value)
-      {
-        // object found
-        head->obj_unlink(head->rSRC.pop());
-        head->obj_unlink(needle_var);
-        head->rAX = tmp;
-        head->rSRC.push(head->new_string(curr->mKey, obj->mTainted));
-        return;
-      }
+  sc_voidmapitem *curr = array_search(head, (ic_array *)obj->mData, needle_var);
+  if(curr)
+    head->rSRC.push(head->new_string(curr->mKey->get(), obj->mTainted));
 
-      head->obj_unlink(head->rSRC.pop());
-    }
-  }
-
-  head->rAX = tmp;
   head->obj_unlink(needle_var);
 }
 
 /**
- * Returns an array with keys and values switched.
+ * Returns the array's keys by it's values.
+ * Ints and strings are used as keys directly, other values are converted with to_s.
+ * @param arr Array to be flipped.
  */
-void array_flip(rc_head *head)
+ic_array *array_flipped(rc_head *head, ic_array *arr)
 {
-  ic_object *obj = head->pCurrObj->get();
-  ic_array *arr = (ic_array *)obj->mData;
   ic_array *new_arr = new ic_array();
   sc_voidmapitem *curr;
+  char buf[NUMBER_BUF_SIZE];
 
   arr->iter_rewind();
   while(curr = arr->iter_next())
   {
-    rc_var *tmp = head->convert_string((rc_var *)curr->mValue);
-    ic_string *key = (ic_string *)tmp->get()->mData;
+    ic_object *value = ((rc_var *)curr->mValue)->get();
+    rc_var *tmp = NULL;
+    const char *key;
+
+    switch(head->pCore->class_type(value->pClass))
+    {
+      case M_CLASS_STRING:  key = ((ic_string *)value->mData)->get();
+                            break;
+      case M_CLASS_INT:     sc_number::format_int(buf, ((ic_int *)value->mData)->mValue);
+                            key = buf;
+                            break;
+      default:              tmp = head->convert_string((rc_var *)curr->mValue);
+                            key = ((ic_string *)tmp->get()->mData)->get();
+    }
 
     // issue a warning if key already exists
-    if(new_arr->get(key))
-      head->warning(M_WARN_DUPLICATE_KEY, key->get());
+    rc_var *old = new_arr->get(key);
+    if(old)
+    {
+      head->warning(M_WARN_DUPLICATE_KEY, key);
+      head->obj_unlink(old);
+    }
 
-    new_arr->set(key, head->new_string(curr->mKey));
+    new_arr->set(key, head->new_string(curr->mKey->get()));
 
-    head->obj_unlink(tmp);
+    if(tmp)
+      head->obj_unlink(tmp);
   }
 
+  return new_arr;
+}
+
+/**
+ * Returns an array with keys and values switched.
+ */
+void array_flip(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  ic_array *new_arr = array_flipped(head, (ic_array *)obj->mData);
   head->rSRC.push(head->new_array(new_arr, obj->mTainted));
 }
 
@@ -766,24 +800,7 @@ void array_flip(rc_head *head)
 void array_flip_do(rc_head *head)
 {
   ic_object *obj = head->pCurrObj->get();
-  ic_array *arr = (ic_array *)obj->mData;
-  ic_array *new_arr = new ic_array();
-  sc_voidmapitem *curr;
-
-  arr->iter_rewind();
-  while(curr = arr->iter_next())
-  {
-    rc_var *tmp = head->convert_string((rc_var *)curr->mValue);
-    ic_string *key = (ic_string *)tmp->get()->mData;
-
-    // issue a warning if key already exists
-    if(new_arr->get(key))
-      head->warning(M_WARN_DUPLICATE_KEY, key->get());
-
-    new_arr->set(key, head->new_string(curr->mKey));
-
-    head->obj_unlink(tmp);
-  }
+  ic_array *new_arr = array_flipped(head, (ic_array *)obj->mData);
 
   head->var_save(head->pCurrObj, head->new_array(new_arr, obj->mTainted));
   head->pCurrObj->mLinks++;
@@ -791,290 +808,385 @@ void array_flip_do(rc_head *head)
 }
 
 /**
- * Returns the array sorted with a best-fitting algorithm.
- * @todo direction
+ * Sort key: position of an array item and the value it is ordered by.
+ * Plain ints, floats and strings are unboxed, so that they can be compared natively.
  */
-void array_sort(rc_head *head)
+struct array_sortkey
 {
-  ic_object *obj = head->pCurrObj->get();
-  if(((ic_array *)obj->mData)->length() < 1000)
-    array_sort_shell(head);
-  else
-    array_sort_quick(head);
-}
+  long pos;                   /**< Iteration position of the item. */
+  rc_var *var;                /**< Value the item is ordered by. */
+  union
+  {
+    long mInt;
+    double mFloat;
+    ic_string *mString;
+  };
+};
 
 /**
- * Actual recursive quicksort function.
- * @todo direction
+ * Orders sort keys by plain ints.
  */
-void array_sort_quick_r(rc_head *head, sc_voidmapitem **arr, long start, long end)
+struct array_sortcmp_int
 {
-  long idx = start, idx2 = end;
-  rc_var *curr = (rc_var *)arr[(start + end) / 2]->mValue;
+  bool mDesc;                 /**< Descending order. */
+  bool less(const array_sortkey &a, const array_sortkey &b)
+  {
+    return mDesc ? b.mInt < a.mInt : a.mInt < b.mInt;
+  }
+};
 
-  do
+/**
+ * Orders sort keys by plain numbers, converted to floats.
+ */
+struct array_sortcmp_float
+{
+  bool mDesc;                 /**< Descending order. */
+  bool less(const array_sortkey &a, const array_sortkey &b)
   {
-    while (head->sub_compare((rc_var *)arr[idx]->mValue, curr) == -1) idx++;
-    while (head->sub_compare((rc_var *)arr[idx2]->mValue, curr) == 1) idx2--;
+    return mDesc ? b.mFloat < a.mFloat : a.mFloat < b.mFloat;
+  }
+};
 
-    if(idx <= idx2)
+/**
+ * Orders sort keys by plain strings.
+ */
+struct array_sortcmp_string
+{
+  bool mDesc;                 /**< Descending order. */
+  bool less(const array_sortkey &a, const array_sortkey &b)
+  {
+    // compare() returns 1 if the argument is greater
+    return (mDesc ? b.mString->compare(a.mString) : a.mString->compare(b.mString)) == 1;
+  }
+};
+
+/**
+ * Orders sort keys by calling the #cmp operator.
+ * Objects that cannot be compared are considered equal.
+ */
+struct array_sortcmp_object
+{
+  rc_head *pHead;             /**< Head to invoke operators with. */
+  bool mDesc;                 /**< Descending order. */
+  bool mIncomparable;         /**< Some objects could not be compared. */
+  bool less(const array_sortkey &a, const array_sortkey &b)
+  {
+    char res = pHead->sub_compare(a.var, b.var);
+    if(res == -2)
     {
-      if (idx < idx2)
-      {
-        sc_voidmapitem *tmp = arr[idx];
-        arr[idx] = arr[idx2];
-        arr[idx2] = tmp;
-      }
-      idx++;
-      idx2--;
+      mIncomparable = true;
+      return false;
     }
-  } while (idx <= idx2);
-
-  if (idx < end)
-    array_sort_quick_r(head, arr, idx, end);
 
-  if (start < idx2)
-    array_sort_quick_r(head, arr, start, idx2);
-}
+    // #cmp returns 1 if the argument is greater
+    return res == (mDesc ? -1 : 1);
+  }
+};
 
 /**
- * Returns the array sorted using quick sort algorithm.
- * @todo direction
+ * Checks whether the sort order argument asks for descending order.
+ * A negative number or the "desc" string do.
+ * @param order Order argument, may be NULL.
  */
-void array_sort_quick(rc_head *head)
+bool array_sort_desc(rc_head *head, rc_var *order)
 {
-  ic_object *obj = head->pCurrObj->get();
-  ic_array *arr = (ic_array *)obj->mData;
-  long idx = 0;
-  sc_voidmapitem *curr;
+  if(!order) return false;
 
-  // create temp array of pointers
-  arr->iter_rewind();
-  sc_voidmapitem **tmparr = new sc_voidmapitem*[arr->length()];
-  while(curr = arr->iter_next())
+  ic_object *obj = order->get();
+  switch(head->pCore->class_type(obj->pClass))
   {
-    tmparr[idx] = curr;
-    idx++;
+    case M_CLASS_INT:     return ((ic_int *)obj->mData)->mValue < 0;
+    case M_CLASS_FLOAT:   return ((ic_float *)obj->mData)->mValue < 0;
+    case M_CLASS_STRING:  return ((ic_string *)obj->mData)->compare("desc") == 0;
   }
 
-  // sort array
-  array_sort_quick_r(head, tmparr, 0, idx-1);
-
-  // create new ic_array from temp array
-  ic_array *newarr = new ic_array();
-  for(idx = 0; idx < arr->length(); idx++)
-    newarr->set(tmparr[idx]->mKey, (rc_var *)tmparr[idx]->mValue);
-
-  delete [] tmparr;
-
-  head->rSRC.push(head->new_array(newarr, obj->mTainted));
+  return false;
 }
 
 /**
- * Returns the array sorted using shell sort algorithm.
- * @todo direction
+ * Sorts the array items and returns them as a new array, keeping the keys.
+ * Equal items keep their order. If all values are plain ints, floats or strings,
+ * they are compared natively, otherwise the #cmp operator is invoked.
+ * @param arr Array to be sorted.
+ * @param desc Descending order.
+ * @param fx Method returning the value to order an item by, NULL to order by the items themselves.
+ * @param name Method name for warnings.
  */
-void array_sort_shell(rc_head *head)
+ic_array *array_sorted(rc_head *head, ic_array *arr, bool desc, rc_method *fx, const char *name)
 {
-  ic_object *obj = head->pCurrObj->get();
-  ic_array *arr = (ic_array *)obj->mData;
-  long idx = 0, idx2;
-  sc_voidmapitem *curr;
+  long length = arr->length(), idx = 0, pos = 0;
+  array_sortkey *keys = new array_sortkey[length ? length : 1];
+  if(!keys) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
 
-  // create temp array of pointers
-  arr->iter_rewind();
-  sc_voidmapitem **tmparr = new sc_voidmapitem*[arr->length()];
-  while(curr = arr->iter_next())
+  sc_voidmapitem *curr;
+  while(idx < length && (curr = arr->iter_next(pos)))
   {
-    tmparr[idx] = curr;
+    keys[idx].pos = pos - 1;
+    keys[idx].var = (rc_var *)curr->mValue;
     idx++;
   }
+  length = idx;
 
-  // sort array
-  long step = arr->length() / 2;
-  while (step > 0)
+  // the ordering value of every item is computed only once
+  if(fx)
   {
-    for (idx = step; idx < arr->length(); idx2++)
+    for(idx = 0; idx < length; idx++)
     {
-      sc_voidmapitem *value = tmparr[idx];
+      head->rSRC.push(keys[idx].var);
+      keys[idx].var->mLinks++;
+      head->method_invoke(fx);
 
-      for (idx2 = idx - step; (idx2 >= 0) && (head->sub_compare((rc_var *)tmparr[idx2]->mValue, (rc_var *)value->mValue) > 0); idx2 -= step)
-        tmparr[idx2 + step] = tmparr[idx2];
+      if(head->rSRC.mLength == 0)
+      {
+        head->warning(M_WARN_FX_NO_RETURN);
+        head->rSRC.push(head->new_undef());
+      }
+
+      if(head->rSRC.mLength > 1)
+        head->warning(M_WARN_FX_BAD_RETURN_COUNT, head->rSRC.mLength, 1);
 
-      tmparr[idx2 + step] = value;
+      keys[idx].var = head->rSRC.pop();
+      head->cmd_clrsrc();
     }
-    step /= 2;
   }
 
-  // create new ic_array from temp array
-  ic_array *newarr = new ic_array();
-  for(idx = 0; idx < arr->length(); idx++)
-    newarr->set(tmparr[idx]->mKey, (rc_var *)tmparr[idx]->mValue);
+  // see whether all values are of the same plain class
+  rc_class *int_class = head->pCore->mClassCache.pInt;
+  rc_class *float_class = head->pCore->mClassCache.pFloat;
+  rc_class *string_class = head->pCore->mClassCache.pString;
+  bool ints = true, numbers = true, strings = true;
+  for(idx = 0; idx < length && (numbers || strings); idx++)
+  {
+    ic_object *obj = keys[idx].var ? keys[idx].var->get() : NULL;
+    rc_class *cls = obj ? obj->pClass : NULL;
+    if(cls == int_class)
+    {
+      keys[idx].mInt = ((ic_int *)obj->mData)->mValue;
+      strings = false;
+    }
+    else if(cls == float_class)
+    {
+      ints = strings = false;
 
-  delete [] tmparr;
+      // NaN is not ordered, so the operator has to decide
+      if(((ic_float *)obj->mData)->mValue != ((ic_float *)obj->mData)->mValue)
+        numbers = false;
+    }
+    else if(cls == string_class)
+    {
+      keys[idx].mString = (ic_string *)obj->mData;
+      ints = numbers = false;
+    }
+    else
+      ints = numbers = strings = false;
+  }
 
-  head->rSRC.push(head->new_array(newarr, obj->mTainted));
-}
+  // mixed numbers compare as floats, unless some integers don't fit a float exactly
+  if(numbers && !ints)
+  {
+    for(idx = 0; idx < length && numbers; idx++)
+    {
+      ic_object *obj = keys[idx].var->get();
+      if(obj->pClass == float_class)
+        keys[idx].mFloat = ((ic_float *)obj->mData)->mValue;
+      else if(fabs((double)((ic_int *)obj->mData)->mValue) < NUMARRAY_EXACT_INT)
+        keys[idx].mFloat = (double)((ic_int *)obj->mData)->mValue;
+      else
+        numbers = false;
+    }
+  }
 
-/**
- * Sorts the array with a best-fitting algorithm.
- * @todo direction
- */
-void array_sort_do(rc_head *head)
-{
-  ic_object *obj = head->pCurrObj->get();
-  if(((ic_array *)obj->mData)->length() < 1000)
-    array_sort_shell_do(head);
+  if(ints)
+  {
+    array_sortcmp_int cmp = {desc};
+    sc_sort<array_sortkey, array_sortcmp_int>::sort(keys, length, cmp);
+  }
+  else if(numbers)
+  {
+    array_sortcmp_float cmp = {desc};
+    sc_sort<array_sortkey, array_sortcmp_float>::sort(keys, length, cmp);
+  }
+  else if(strings)
+  {
+    array_sortcmp_string cmp = {desc};
+    sc_sort<array_sortkey, array_sortcmp_string>::sort(keys, length, cmp);
+  }
   else
-    array_sort_quick_do(head);
+  {
+    array_sortcmp_object cmp = {head, desc, false};
+    sc_sort<array_sortkey, array_sortcmp_object>::sort(keys, length, cmp);
+    if(cmp.mIncomparable)
+      head->warning(M_WARN_ARRAY_INCOMPARABLE, name);
+  }
+
+  // a packed array has no items to hold on to, so they are looked up by position
+  ic_array *newarr = new ic_array();
+  for(idx = 0; idx < length; idx++)
+  {
+    pos = keys[idx].pos;
+    if(curr = arr->iter_next(pos))
+    {
+      rc_var *value = (rc_var *)curr->mValue;
+      value->mLinks++;
+      newarr->set(curr->mKey, value);
+    }
+
+    if(fx)
+      head->obj_unlink(keys[idx].var);
+  }
+
+  delete [] keys;
+  return newarr;
 }
 
 /**
- * Sorts the array using quick sort algorithm.
- * @todo Rewrite the assign part to restrain it from cloning objects!
- * @todo direction
+ * Returns the sorted array.
  */
-void array_sort_quick_do(rc_head *head)
+void array_sort(rc_head *head)
 {
   ic_object *obj = head->pCurrObj->get();
-  ic_array *arr = (ic_array *)obj->mData;
-  long idx = 0;
-  sc_voidmapitem *curr;
+  rc_var *order_var = head->rSRC.pop();
 
-  // create temp array of pointers
-  arr->iter_rewind();
-  sc_voidmapitem **tmparr = new sc_voidmapitem*[arr->length()];
-  while(curr = arr->iter_next())
-  {
-    tmparr[idx] = curr;
-    idx++;
-  }
-
-  // sort array
-  array_sort_quick_r(head, tmparr, 0, idx-1);
-
-  // create new ic_array from temp array
-  ic_array *newarr = new ic_array();
-  for(idx = 0; idx < arr->length(); idx++)
-    newarr->set(tmparr[idx]->mKey, (rc_var *)tmparr[idx]->mValue);
-
-  head->var_save(head->pCurrObj, head->new_array(newarr));
-
-  delete [] tmparr;
+  ic_array *newarr = array_sorted(head, (ic_array *)obj->mData, array_sort_desc(head, order_var), NULL, "sort");
+  head->rSRC.push(head->new_array(newarr, obj->mTainted));
 
-  head->rSRC.push(head->pCurrObj);
+  head->obj_unlink(order_var);
 }
 
 /**
- * Sorts the array using shell sort algorithm.
- * @todo direction
+ * Sorts the array.
  */
-void array_sort_shell_do(rc_head *head)
+void array_sort_do(rc_head *head)
 {
   ic_object *obj = head->pCurrObj->get();
-  ic_array *arr = (ic_array *)obj->mData;
-  long idx = 0, idx2;
-  sc_voidmapitem *curr;
+  rc_var *order_var = head->rSRC.pop();
 
   if(!obj->mFrozen)
   {
-    // create temp array of pointers
-    arr->iter_rewind();
-    sc_voidmapitem **tmparr = new sc_voidmapitem*[arr->length()];
-    while(curr = arr->iter_next())
-    {
-      tmparr[idx] = curr;
-      idx++;
-    }
-
-    // sort array
-    long step = arr->length() / 2;
-    while (step > 0)
-    {
-      for (idx = step; idx < arr->length(); idx2++)
-      {
-        sc_voidmapitem *value = tmparr[idx];
-
-        for (idx2 = idx - step; (idx2 >= 0) && (head->sub_compare((rc_var *)tmparr[idx2]->mValue, (rc_var *)value->mValue) > 0); idx2 -= step)
-          tmparr[idx2 + step] = tmparr[idx2];
-
-        tmparr[idx2 + step] = value;
-      }
-      step /= 2;
-    }
-
-    // create new ic_array from temp array
-    ic_array *newarr = new ic_array();
-    for(idx = 0; idx < arr->length(); idx++)
-      newarr->set(tmparr[idx]->mKey, (rc_var *)tmparr[idx]->mValue);
-
+    ic_array *newarr = array_sorted(head, (ic_array *)obj->mData, array_sort_desc(head, order_var), NULL, "sort!");
     head->var_save(head->pCurrObj, head->new_array(newarr, obj->mTainted));
 
-    delete [] tmparr;
-
     head->pCurrObj->mLinks++;
     head->rSRC.push(head->pCurrObj);
   }
   else
     head->exception(M_ERR_FROZEN, M_EXC_SCRIPT);
+
+  head->obj_unlink(order_var);
 }
 
 /**
- * Returns the array sorted according to a specific function.
- * @todo implement
+ * Returns the array sorted by values a specific function returns for items.
  */
 void array_sort_by(rc_head *head)
 {
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *fx_var = head->rSRC.pop(), *order_var = head->rSRC.pop();
+  ic_object *fx = fx_var->get();
 
+  if(head->pCore->class_type(fx->pClass) == M_CLASS_METHOD)
+  {
+    ic_array *newarr = array_sorted(head, (ic_array *)obj->mData, array_sort_desc(head, order_var), (rc_method *)fx->mData, "sort_by");
+    head->rSRC.push(head->new_array(newarr, obj->mTainted));
+  }
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "method", "sort_by"), M_EXC_ARGS);
+
+  head->obj_unlink(fx_var);
+  head->obj_unlink(order_var);
 }
 
 /**
- * Sorts the array according to a specific function.
- * @todo implement
+ * Sorts the array by values a specific function returns for items.
  */
 void array_sort_by_do(rc_head *head)
 {
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *fx_var = head->rSRC.pop(), *order_var = head->rSRC.pop();
+  ic_object *fx = fx_var->get();
+
+  if(obj->mFrozen)
+    head->exception(M_ERR_FROZEN, M_EXC_SCRIPT);
+  else if(head->pCore->class_type(fx->pClass) == M_CLASS_METHOD)
+  {
+    ic_array *newarr = array_sorted(head, (ic_array *)obj->mData, array_sort_desc(head, order_var), (rc_method *)fx->mData, "sort_by!");
+    head->var_save(head->pCurrObj, head->new_array(newarr, obj->mTainted));
+
+    head->pCurrObj->mLinks++;
+    head->rSRC.push(head->pCurrObj);
+  }
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "method", "sort_by!"), M_EXC_ARGS);
 
+  head->obj_unlink(fx_var);
+  head->obj_unlink(order_var);
 }
 
 /**
- * The random-value function for shuffling array.
+ * Returns the array items in random order, keeping the keys.
+ * Uses Fisher-Yates shuffle.
+ * @param arr Array to be shuffled.
  */
-void array_shuffle_rand(rc_head *head)
+ic_array *array_shuffled(ic_array *arr)
 {
-  // discard input
-  head->obj_unlink(head->rSRC.pop());
-  head->rSRC.push(head->new_int(sc_random::get_next()));
+  long length = arr->length(), idx = 0, pos = 0;
+  long *positions = new long[length ? length : 1];
+  if(!positions) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  // positions are shuffled, as a packed array has no items to hold on to
+  sc_voidmapitem *curr;
+  while(idx < length && arr->iter_next(pos))
+    positions[idx++] = pos - 1;
+  length = idx;
+
+  for(idx = length - 1; idx > 0; idx--)
+  {
+    long other = sc_random::get_next((int)idx);
+    pos = positions[idx];
+    positions[idx] = positions[other];
+    positions[other] = pos;
+  }
+
+  ic_array *newarr = new ic_array();
+  for(idx = 0; idx < length; idx++)
+  {
+    pos = positions[idx];
+    curr = arr->iter_next(pos);
+    ((rc_var *)curr->mValue)->mLinks++;
+    newarr->set(curr->mKey, (rc_var *)curr->mValue);
+  }
+
+  delete [] positions;
+  return newarr;
 }
 
 /**
  * Returns array randomly shuffled.
- * @todo rewrite using more efficient technique (maybe)
  */
 void array_shuffle(rc_head *head)
 {
-  rc_method *shuf = new rc_method();
-  shuf->setup(1, 1, false, "item");
-  shuf->mProperties = M_PROP_STATIC | M_PROP_PUBLIC;
-  shuf->pClass = head->pCore->mClassCache.pObject;
-
-  head->rSRC.push(head->new_method(shuf));
-  array_sort_by(head);
+  ic_object *obj = head->pCurrObj->get();
+  ic_array *newarr = array_shuffled((ic_array *)obj->mData);
+  head->rSRC.push(head->new_array(newarr, obj->mTainted));
 }
 
 /**
  * Randomly shuffles array.
- * @todo rewrite using more efficient technique (maybe)
  */
 void array_shuffle_do(rc_head *head)
 {
-  rc_method *shuf = new rc_method();
-  shuf->setup(1, 1, false, "item");
-  shuf->mProperties = M_PROP_STATIC | M_PROP_PUBLIC;
-  shuf->pClass = head->pCore->mClassCache.pObject;
+  ic_object *obj = head->pCurrObj->get();
 
-  head->rSRC.push(head->new_method(shuf));
-  array_sort_by_do(head);
+  if(!obj->mFrozen)
+  {
+    ic_array *newarr = array_shuffled((ic_array *)obj->mData);
+    head->var_save(head->pCurrObj, head->new_array(newarr, obj->mTainted));
+
+    head->pCurrObj->mLinks++;
+    head->rSRC.push(head->pCurrObj);
+  }
+  else
+    head->exception(M_ERR_FROZEN, M_EXC_SCRIPT);
 }
 
 /**
@@ -1109,6 +1221,51 @@ void array_map_do(rc_head *head)
   head->obj_unlink(item_var);
 }
 
+/**
+ * Copies plain numbers from the array into a numeric buffer.
+ * Subclasses of int and float are not accepted, as they may override operators.
+ * @param arr Array to be copied.
+ * @param nums Buffer to copy numbers into.
+ * @param[out] tainted Set if any of the numbers is tainted.
+ * @return Whether all items are numbers.
+ */
+bool array_unbox(rc_head *head, ic_array *arr, sc_numarray *nums, bool *tainted)
+{
+  rc_class *cls_int = head->pCore->mClassCache.pInt, *cls_float = head->pCore->mClassCache.pFloat;
+  sc_voidmapitem *curr;
+
+  arr->iter_rewind();
+  while(curr = arr->iter_next())
+  {
+    if(!curr->mValue) return false;
+
+    ic_object *item = ((rc_var *)curr->mValue)->get();
+    if(item->pClass == cls_int)
+      nums->add(((ic_int *)item->mData)->mValue);
+    else if(item->pClass == cls_float)
+      nums->add(((ic_float *)item->mData)->mValue);
+    else
+      return false;
+
+    if(item->mTainted) *tainted = true;
+  }
+
+  return true;
+}
+
+/**
+ * Returns an array item by it's position in the order of iteration.
+ * @param arr Array to be searched.
+ * @param idx Position of the item.
+ */
+rc_var *array_nth(ic_array *arr, long idx)
+{
+  sc_voidmapitem *curr;
+  arr->iter_rewind();
+  while((curr = arr->iter_next()) && idx--);
+  return curr ? (rc_var *)curr->mValue : NULL;
+}
+
 /**
  * Returns sum of all array values.
  */
@@ -1118,6 +1275,15 @@ void array_sum(rc_head *head)
   sc_voidmapitem *curr;
   ic_array *arr = (ic_array *)obj->mData;
 
+  // plain numbers are added up without calling operators
+  sc_numarray nums(arr->length());
+  bool tainted = false;
+  if(array_unbox(head, arr, &nums, &tainted))
+  {
+    head->rSRC.push(head->new_float(nums.sum(), tainted));
+    return;
+  }
+
   rc_var *tmp = head->rAX;
   head->rSRC.push(head->new_float(0.0, false));
   arr->iter_rewind();
@@ -1128,6 +1294,8 @@ void array_sum(rc_head *head)
     head->cmd_add();
     head->obj_unlink(head->rAX);
   }
+
+  head->rAX = tmp;
 }
 
 /**
@@ -1139,8 +1307,17 @@ void array_mul(rc_head *head)
   sc_voidmapitem *curr;
   ic_array *arr = (ic_array *)obj->mData;
 
+  // plain numbers are multiplied without calling operators
+  sc_numarray nums(arr->length());
+  bool tainted = false;
+  if(array_unbox(head, arr, &nums, &tainted))
+  {
+    head->rSRC.push(head->new_float(nums.product(), tainted));
+    return;
+  }
+
   rc_var *tmp = head->rAX;
-  head->rSRC.push(head->new_float(0.0, false));
+  head->rSRC.push(head->new_float(1.0, false));
   arr->iter_rewind();
   while(curr = arr->iter_next())
   {
@@ -1149,6 +1326,35 @@ void array_mul(rc_head *head)
     head->cmd_mul();
     head->obj_unlink(head->rAX);
   }
+
+  head->rAX = tmp;
+}
+
+/**
+ * Returns the sum of pairwise products of two arrays of numbers.
+ * Extra items of the longer array are ignored.
+ */
+void array_dot(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *item_var = head->rSRC.pop();
+  ic_object *item = item_var->get();
+  bool tainted = obj->mTainted || item->mTainted;
+
+  if(head->pCore->class_type(item->pClass) == M_CLASS_ARRAY)
+  {
+    ic_array *arr1 = (ic_array *)obj->mData, *arr2 = (ic_array *)item->mData;
+    sc_numarray nums1(arr1->length()), nums2(arr2->length());
+
+    if(array_unbox(head, arr1, &nums1, &tainted) && array_unbox(head, arr2, &nums2, &tainted))
+      head->rSRC.push(head->new_float(nums1.dot(&nums2), tainted));
+    else
+      head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "array of numbers", "dot"), M_EXC_ARGS);
+  }
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "array", "dot"), M_EXC_ARGS);
+
+  head->obj_unlink(item_var);
 }
 
 /**
@@ -1287,15 +1493,7 @@ void array_reindex_do(rc_head *head)
   ic_array *arr = (ic_array *)obj->mData;
   if(!obj->mFrozen)
   {
-    ic_int *idx = new ic_int();
-    sc_voidmapitem *curr;
-
-    arr->iter_rewind();
-    while(curr = arr->iter_next())
-    {
-      curr->mKey->set(idx->to_s());
-      idx->mValue++;
-    }
+    arr->reindex();
 
     head->pCurrObj->mLinks++;
     head->rSRC.push(head->pCurrObj);
@@ -1388,36 +1586,54 @@ void array_inflate(rc_head *head)
 }
 
 /**
- * Returns unique values from the array.
+ * Returns the array without duplicates, keeping the first of strictly equal items.
+ * Hashable values are looked up in a hash set, the rest are compared one by one.
+ * @param arr Array to be filtered.
  */
-void array_unique(rc_head *head)
+ic_array *array_uniq(rc_head *head, ic_array *arr)
 {
-  ic_object *obj = head->pCurrObj->get();
-  ic_array *arr = (ic_array *)obj->mData;
   ic_array *new_arr = new ic_array();
-  sc_voidmapitem *curr, *curr2;
+  array_hashcmp cmp = {head};
+  sc_hashset<rc_var *, array_hashcmp> seen(cmp, arr->length());
+  sc_voidarray rest;
+  sc_voidmapitem *curr;
 
-  // append items
   arr->iter_rewind();
   while(curr = arr->iter_next())
   {
-    new_arr->iter_rewind();
+    rc_var *item = (rc_var *)curr->mValue;
+    unsigned long hash;
     bool found = false;
-    while(curr2 = new_arr->iter_next())
+
+    if(head->sub_hash(item, &hash))
+      found = !seen.add(item, hash);
+    else
     {
-      // sub_compare in strict mode: -1 & 1 or 1 & 1 give 1, 0 or 2 give 0
-      if(head->sub_compare((rc_var *)curr->mValue, (rc_var *)curr->mValue, true) & 1)
-      {
-        found = true;
-        break;
-      }
+      for(long idx = 0; idx < rest.length() && !found; idx++)
+        found = array_equal(head, (rc_var *)rest[idx], item, true);
+
+      if(!found)
+        rest.add(item);
     }
 
     // append the item if it has not been found in the array
     if(!found)
-      new_arr->append((rc_var *)curr->mValue);
+    {
+      item->mLinks++;
+      new_arr->append(item);
+    }
   }
 
+  return new_arr;
+}
+
+/**
+ * Returns unique values from the array.
+ */
+void array_unique(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  ic_array *new_arr = array_uniq(head, (ic_array *)obj->mData);
   head->rSRC.push(head->new_array(new_arr, obj->mTainted));
 }
 
@@ -1435,13 +1651,22 @@ void array_select(rc_head *head)
     ic_array *arr = (ic_array *)obj->mData, *newarr = new ic_array();
     arr->iter_rewind();
     sc_voidmapitem *curr;
+    ic_string key;
 
     while(curr = arr->iter_next())
     {
-      head->rSRC.push((rc_var *)curr->mValue);
+      // the method may iterate the array as well, moving a packed array's cursor
+      rc_var *value = (rc_var *)curr->mValue;
+      key.set(curr->mKey);
+
+      value->mLinks++;
+      head->rSRC.push(value);
       head->method_invoke((rc_method *)fx->mData);
       if(head->sub_value(head->rSRC.get(0)))
-        newarr->set(curr->mKey, (rc_var *)curr->mValue);
+      {
+        value->mLinks++;
+        newarr->set(&key, value);
+      }
       head->cmd_clrsrc();
     }
 
@@ -1467,13 +1692,22 @@ void array_reject(rc_head *head)
     ic_array *arr = (ic_array *)obj->mData, *newarr = new ic_array();
     arr->iter_rewind();
     sc_voidmapitem *curr;
+    ic_string key;
 
     while(curr = arr->iter_next())
     {
-      head->rSRC.push((rc_var *)curr->mValue);
+      // the method may iterate the array as well, moving a packed array's cursor
+      rc_var *value = (rc_var *)curr->mValue;
+      key.set(curr->mKey);
+
+      value->mLinks++;
+      head->rSRC.push(value);
       head->method_invoke((rc_method *)fx->mData);
       if(!head->sub_value(head->rSRC.get(0)))
-        newarr->set(curr->mKey, (rc_var *)curr->mValue);
+      {
+        value->mLinks++;
+        newarr->set(&key, value);
+      }
       head->cmd_clrsrc();
     }
 
@@ -1606,30 +1840,7 @@ void array_inflate_do(rc_head *head)
 void array_unique_do(rc_head *head)
 {
   ic_object *obj = head->pCurrObj->get();
-  ic_array *arr = (ic_array *)obj->mData;
-  ic_array *new_arr = new ic_array();
-  sc_voidmapitem *curr, *curr2;
-
-  // append items
-  arr->iter_rewind();
-  while(curr = arr->iter_next())
-  {
-    new_arr->iter_rewind();
-    bool found = false;
-    while(curr2 = new_arr->iter_next())
-    {
-      // sub_compare in strict mode: -1 & 1 or 1 & 1 give 1, 0 or 2 give 0
-      if(head->sub_compare((rc_var *)curr->mValue, (rc_var *)curr->mValue, true) & 1)
-      {
-        found = true;
-        break;
-      }
-    }
-
-    // append the item if it has not been found in the array
-    if(!found)
-      new_arr->append((rc_var *)curr->mValue);
-  }
+  ic_array *new_arr = array_uniq(head, (ic_array *)obj->mData);
 
   head->var_save(head->pCurrObj, head->new_array(new_arr, obj->mTainted));
   head->pCurrObj->mLinks++;
@@ -1650,20 +1861,24 @@ void array_select_do(rc_head *head)
     if(head->pCore->class_type(fx->pClass) == M_CLASS_METHOD)
     {
       ic_array *arr = (ic_array *)obj->mData;
-      arr->iter_rewind();
       sc_voidmapitem *curr;
-      sc_voidarray data;
-      data.resize(arr->length());
-      while(curr = arr->iter_next())
-        data.add((void *)curr);
+      ic_string key;
+      long pos = 0;
 
-      for(long idx = 0; idx < data.length(); idx ++)
+      // removing an item keeps the positions of the others
+      while(curr = arr->iter_next(pos))
       {
-        curr = (sc_voidmapitem *)data.get(idx);
-        head->rSRC.push((rc_var *)curr->mValue);
+        rc_var *value = (rc_var *)curr->mValue;
+        key.set(curr->mKey);
+
+        value->mLinks++;
+        head->rSRC.push(value);
         head->method_invoke((rc_method *)fx->mData);
         if(!head->sub_value(head->rSRC.get(0)))
-          arr->unset(curr->mKey);
+        {
+          arr->unset(&key);
+          head->obj_unlink(value);
+        }
         head->cmd_clrsrc();
       }
 
@@ -1693,15 +1908,24 @@ void array_reject_do(rc_head *head)
     if(head->pCore->class_type(fx->pClass) == M_CLASS_METHOD)
     {
       ic_array *arr = (ic_array *)obj->mData;
-      arr->iter_rewind();
       sc_voidmapitem *curr;
+      ic_string key;
+      long pos = 0;
 
-      while(curr = arr->iter_next())
+      // removing an item keeps the positions of the others
+      while(curr = arr->iter_next(pos))
       {
-        head->rSRC.push((rc_var *)curr->mValue);
+        rc_var *value = (rc_var *)curr->mValue;
+        key.set(curr->mKey);
+
+        value->mLinks++;
+        head->rSRC.push(value);
         head->method_invoke((rc_method *)fx->mData);
         if(head->sub_value(head->rSRC.get(0)))
-          arr->unset(curr->mKey);
+        {
+          arr->unset(&key);
+          head->obj_unlink(value);
+        }
         head->cmd_clrsrc();
       }
 
@@ -1862,6 +2086,17 @@ void array_min(rc_head *head)
   if(arr->length() == 0)
     return;
 
+  // plain numbers are compared without calling operators
+  sc_numarray nums(arr->length());
+  bool tainted = false;
+  if(array_unbox(head, arr, &nums, &tainted) && nums.ordered())
+  {
+    rc_var *res = array_nth(arr, nums.min_index());
+    res->mLinks++;
+    head->rSRC.push(res);
+    return;
+  }
+
   arr->iter_rewind();
 
   // minimal value is stored in AX register
@@ -1916,6 +2151,17 @@ void array_max(rc_head *head)
   if(arr->length() == 0)
     return;
 
+  // plain numbers are compared without calling operators
+  sc_numarray nums(arr->length());
+  bool tainted = false;
+  if(array_unbox(head, arr, &nums, &tainted) && nums.ordered())
+  {
+    rc_var *res = array_nth(arr, nums.max_index());
+    res->mLinks++;
+    head->rSRC.push(res);
+    return;
+  }
+
   arr->iter_rewind();
 
   // maximal value is stored in AX register
@@ -1970,29 +2216,41 @@ void array_min_max(rc_head *head)
   if(arr->length() == 0)
     return;
 
-  arr->iter_rewind();
-
-  // register first value as both minimal and maximal
   rc_var *min, *max;
-  min = max = (rc_var *)((ic_array *)obj->mData)->iter_next()->mValue;
 
-  while(curr = arr->iter_next())
+  // plain numbers are compared without calling operators
+  sc_numarray nums(arr->length());
+  bool tainted = false;
+  if(array_unbox(head, arr, &nums, &tainted) && nums.ordered())
   {
-    rc_var *item = (rc_var *)curr->mValue;
-    char minres = head->sub_compare(item, min);
-    char maxres = head->sub_compare(item, max);
+    min = array_nth(arr, nums.min_index());
+    max = array_nth(arr, nums.max_index());
+  }
+  else
+  {
+    arr->iter_rewind();
 
-    // incomparable types
-    if(minres == -2 || maxres == -2)
+    // register first value as both minimal and maximal
+    min = max = (rc_var *)((ic_array *)obj->mData)->iter_next()->mValue;
+
+    while(curr = arr->iter_next())
     {
-      head->warning(M_WARN_ARRAY_INCOMPARABLE, "min_max");
-      head->rSRC.push(head->new_undef());
-      return;
-    }
+      rc_var *item = (rc_var *)curr->mValue;
+      char minres = head->sub_compare(item, min);
+      char maxres = head->sub_compare(item, max);
+
+      // incomparable types
+      if(minres == -2 || maxres == -2)
+      {
+        head->warning(M_WARN_ARRAY_INCOMPARABLE, "min_max");
+        head->rSRC.push(head->new_undef());
+        return;
+      }
 
-    // replace new items if needed
-    if(minres == 1) min = item;
-    if(maxres == -1) max = item;
+      // replace new items if needed
+      if(minres == 1) min = item;
+      if(maxres == -1) max = item;
+    }
   }
 
   ic_array *newarr = new ic_array();
@@ -2054,14 +2312,16 @@ void array_inspect(rc_head *head)
   arr->iter_rewind();
   while(curr = arr->iter_next())
   {
+    // the key goes first, as inspecting the value may move a packed array's cursor
+    str->append(curr->mKey);
+    str->append(":");
+
     head->method_invoke("inspect", (rc_var *)curr->mValue);
     rc_var *item_var = head->rSRC.pop();
     ic_object *item = item_var->get();
 
     if(head->pCore->class_type(item->pClass) == M_CLASS_STRING)
     {
-      str->append(curr->mKey);
-      str->append(":");
       str->append((ic_string*)item->mData);
 
       // not the last item yet
@@ -2084,4 +2344,102 @@ void array_inspect(rc_head *head)
   head->rSRC.push(head->new_string(str, obj->mTainted));
 }
 
+/**
+ * Returns a lazy enumerator over the array.
+ */
+void array_lazy(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+
+  ic_lazy *lazy = new ic_lazy();
+  if(!lazy) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  head->pCurrObj->mLinks++;
+  lazy->set(head->pCurrObj);
+
+  head->rSRC.push(head->new_lazy(lazy, obj->mTainted));
+}
+
+/**
+ * Calls the method for each item on the pool workers and pushes the result.
+ * @param obj Array object.
+ * @param fx_var Variable holding the method.
+ * @param mode POOL_EACH, POOL_MAP or POOL_SELECT.
+ * @param name Name of the calling method for errors.
+ */
+void array_parallel(rc_head *head, ic_object *obj, rc_var *fx_var, int mode, const char *name)
+{
+  ic_object *fx = fx_var->get();
+  if(head->pCore->class_type(fx->pClass) != M_CLASS_METHOD)
+  {
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "method", name), M_EXC_ARGS);
+    return;
+  }
+
+  ic_array *arr = (ic_array *)obj->mData;
+  long count = arr->length(), pos = 0, idx;
+  rc_var **values = new rc_var*[count + 1];
+  rc_var **results = new rc_var*[count + 1];
+  if(!values || !results) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  for(idx=0; idx<count; idx++)
+    values[idx] = (rc_var *)arr->iter_next(pos)->mValue;
+
+  if(head->parallel((rc_method *)fx->mData, values, 0, count, mode, results) && mode != POOL_EACH)
+  {
+    // results are merged in the order of the items, going over the keys again
+    ic_array *newarr = new ic_array();
+    if(!newarr) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+    sc_voidmapitem *curr;
+    pos = 0;
+    for(idx=0; idx<count && (curr = arr->iter_next(pos)); idx++)
+    {
+      if(mode == POOL_MAP)
+        newarr->set(curr->mKey, results[idx]);
+      else if(results[idx])
+      {
+        values[idx]->mLinks++;
+        newarr->set(curr->mKey, values[idx]);
+        head->obj_unlink(results[idx]);
+      }
+    }
+
+    head->rSRC.push(head->new_array(newarr, obj->mTainted));
+  }
+
+  delete [] values;
+  delete [] results;
+}
+
+/**
+ * Calls a function on each item from the array on the pool workers.
+ */
+void array_parallel_each(rc_head *head)
+{
+  rc_var *fx_var = head->rSRC.pop();
+  array_parallel(head, head->pCurrObj->get(), fx_var, POOL_EACH, "parallel_each");
+  head->obj_unlink(fx_var);
+}
+
+/**
+ * Returns an array of values the function returns for each item, called on the pool workers.
+ */
+void array_parallel_map(rc_head *head)
+{
+  rc_var *fx_var = head->rSRC.pop();
+  array_parallel(head, head->pCurrObj->get(), fx_var, POOL_MAP, "parallel_map");
+  head->obj_unlink(fx_var);
+}
+
+/**
+ * Returns items that match the condition in the lambda, called on the pool workers.
+ */
+void array_parallel_select(rc_head *head)
+{
+  rc_var *fx_var = head->rSRC.pop();
+  array_parallel(head, head->pCurrObj->get(), fx_var, POOL_SELECT, "parallel_select");
+  head->obj_unlink(fx_var);
+}
+
 #endif
\ No newline at end of file
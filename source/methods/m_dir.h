@@ -0,0 +1,205 @@
+/**
+ * @file m_dir.h
+ * @author impworks
+ * Dir method header.
+ * Defines all methods for dir class.
+ */
+
+#ifndef M_DIR_H
+#define M_DIR_H
+
+/**
+ * Makes an array of the directory item names.
+ * @param type DIR_FILES, DIR_DIRS or 0 for all items.
+ */
+void dir_list(rc_head *head, char type)
+{
+  ic_object *obj = head->pCurrObj->get();
+  ic_dir *dir = (ic_dir *)obj->mData;
+
+  ic_array *arr = new ic_array();
+  if(!arr) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  // names come from the filesystem, not from the script
+  dir->iter_rewind();
+  ic_string *name;
+  while(name = dir->iter_next(type))
+  {
+    rc_var *var = head->new_string(name, true);
+    head->obj_unlink(var->get());
+    arr->append(var, false);
+  }
+
+  rc_var *var = head->new_array(arr, true);
+  head->obj_unlink(var->get());
+  head->rSRC.push(var);
+}
+
+/**
+ * Dir constructor.
+ */
+void dir_op_create(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *name_var = head->rSRC.pop();
+  ic_object *name = name_var->get();
+
+  if(head->pCore->class_type(name->pClass) == M_CLASS_STRING)
+    ((ic_dir *)obj->mData)->choose((ic_string *)name->mData);
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string", "new dir"), M_EXC_ARGS);
+
+  head->obj_unlink(name_var);
+}
+
+/**
+ * Returns the names of all items in the directory.
+ */
+void dir_content(rc_head *head)
+{
+  dir_list(head, 0);
+}
+
+/**
+ * Copies the directory with everything in it to another name and location.
+ * The files are copied in parallel on the pool, except on heads other than the
+ * main one, which might be running on the pool themselves.
+ */
+void dir_copy(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *name_var = head->rSRC.pop();
+  ic_object *name = name_var->get();
+
+  if(head->pCore->class_type(name->pClass) == M_CLASS_STRING)
+  {
+    sc_taskpool *pool = head == head->pCore->mHead ? head->pCore->pool() : NULL;
+    head->rSRC.push(head->new_bool(((ic_dir *)obj->mData)->copy((ic_string *)name->mData, pool)));
+  }
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string", "copy"), M_EXC_ARGS);
+
+  head->obj_unlink(name_var);
+}
+
+/**
+ * Creates the directory if it doesn't exist.
+ */
+void dir_create(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_bool(((ic_dir *)obj->mData)->create()));
+}
+
+/**
+ * Returns the names of subdirectories.
+ */
+void dir_dirs(rc_head *head)
+{
+  dir_list(head, DIR_DIRS);
+}
+
+/**
+ * Checks if the directory exists.
+ */
+void dir_exists(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_bool(((ic_dir *)obj->mData)->exists()));
+}
+
+/**
+ * Returns the names of files in the directory.
+ */
+void dir_files(rc_head *head)
+{
+  dir_list(head, DIR_FILES);
+}
+
+/**
+ * Returns a detailed representation of the directory.
+ */
+void dir_inspect(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  char *name = ((ic_dir *)obj->mData)->to_s();
+
+  ic_string *str = new ic_string("{dir:");
+  if(name)
+    str->append(name);
+
+  str->append("}");
+  head->rSRC.push(head->new_string(str));
+}
+
+/**
+ * Removes the directory.
+ * A directory that is not empty is only removed along with everything in it
+ * if true is passed.
+ */
+void dir_remove(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *really_var = head->rSRC.pop();
+
+  bool really = head->sub_value(really_var);
+  head->rSRC.push(head->new_bool(((ic_dir *)obj->mData)->remove(really)));
+
+  head->obj_unlink(really_var);
+}
+
+/**
+ * Renames or moves the directory.
+ */
+void dir_rename(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *name_var = head->rSRC.pop();
+  ic_object *name = name_var->get();
+
+  if(head->pCore->class_type(name->pClass) == M_CLASS_STRING)
+    head->rSRC.push(head->new_bool(((ic_dir *)obj->mData)->rename((ic_string *)name->mData)));
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string", "rename"), M_EXC_ARGS);
+
+  head->obj_unlink(name_var);
+}
+
+/**
+ * Returns a boolean representation of the directory.
+ */
+void dir_to_b(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_bool(((ic_dir *)obj->mData)->exists(), obj->mTainted));
+}
+
+/**
+ * Returns a float representation of the directory.
+ */
+void dir_to_f(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_float((double)((ic_dir *)obj->mData)->length(), obj->mTainted));
+}
+
+/**
+ * Returns an integer representation of the directory.
+ */
+void dir_to_i(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_int(((ic_dir *)obj->mData)->length(), obj->mTainted));
+}
+
+/**
+ * Returns a string representation of the directory.
+ */
+void dir_to_s(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  char *name = ((ic_dir *)obj->mData)->to_s();
+  head->rSRC.push(head->new_string(name ? name : "", obj->mTainted));
+}
+
+#endif
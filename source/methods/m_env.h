@@ -0,0 +1,166 @@
+/**
+ * @file m_env.h
+ * @author impworks
+ * Env method header.
+ * Defines all methods for env static class.
+ */
+
+#ifndef M_ENV_H
+#define M_ENV_H
+
+/**
+ * Returns a value of the request data or all of it as an array.
+ * Outside of the server there is no request, so nothing is found.
+ * @param map Request data or NULL.
+ * @param name Method name for the error message.
+ */
+void env_lookup(rc_head *head, sc_map *map, const char *name)
+{
+  rc_var *key_var = head->rSRC.pop();
+  ic_object *key = key_var->get();
+  int key_id = head->pCore->class_type(key->pClass);
+
+  if(key_id == M_CLASS_STRING)
+  {
+    char *value = map ? map->get((ic_string *)key->mData) : NULL;
+    head->rSRC.push(value ? head->new_string(value, true) : head->new_undef());
+  }
+  else if(key_id == M_CLASS_UNDEF)
+  {
+    ic_array *arr = new ic_array();
+    if(!arr) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+    if(map)
+    {
+      sc_mapitem *item;
+      map->iter_rewind();
+      while(item = map->iter_next())
+        arr->set(item->mKey, head->new_string(item->mValue->get(), true));
+    }
+
+    head->rSRC.push(head->new_array(arr, true));
+  }
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string", name), M_EXC_ARGS);
+
+  head->obj_unlink(key_var);
+}
+
+/**
+ * Returns the raw body of the request.
+ */
+void env_body(rc_head *head)
+{
+  ic_string *body = head->pRequest ? new ic_string(*head->pRequest->mBody) : new ic_string();
+  if(!body) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  head->rSRC.push(head->new_string(body, true));
+}
+
+/**
+ * Returns a cookie sent with the request, or all of them.
+ */
+void env_cookie(rc_head *head)
+{
+  env_lookup(head, head->pRequest ? &head->pRequest->mCookie : NULL, "cookie");
+}
+
+/**
+ * Sends what has been printed so far, along with the headers.
+ * Returns false outside of the server.
+ */
+void env_flush(rc_head *head)
+{
+  if(head->pRequest)
+    head->pRequest->flush();
+
+  head->rSRC.push(head->new_bool(head->pRequest != NULL));
+}
+
+/**
+ * Returns a parameter of the query string, or all of them.
+ */
+void env_get(rc_head *head)
+{
+  env_lookup(head, head->pRequest ? &head->pRequest->mGet : NULL, "get");
+}
+
+/**
+ * Adds a header to the response.
+ * Returns false if the headers have been sent or the header is not allowed.
+ */
+void env_header(rc_head *head)
+{
+  rc_var *name_var = head->rSRC.pop();
+  rc_var *value_var = head->rSRC.pop();
+  ic_object *name = name_var->get();
+  ic_object *value = value_var->get();
+
+  if(head->pCore->class_type(name->pClass) != M_CLASS_STRING)
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string", "header"), M_EXC_ARGS);
+  else if(head->pCore->class_type(value->pClass) != M_CLASS_STRING)
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 2, "string", "header"), M_EXC_ARGS);
+  else
+  {
+    bool result = head->pRequest && head->pRequest->header(((ic_string *)name->mData)->get(), ((ic_string *)value->mData)->get());
+    head->rSRC.push(head->new_bool(result));
+  }
+
+  head->obj_unlink(name_var);
+  head->obj_unlink(value_var);
+}
+
+/**
+ * Returns a field of a form sent with the request, or all of them.
+ */
+void env_post(rc_head *head)
+{
+  env_lookup(head, head->pRequest ? &head->pRequest->mPost : NULL, "post");
+}
+
+/**
+ * Returns a value describing the request or the server, or all of them.
+ * Outside of the server the environment of the process is used.
+ */
+void env_server(rc_head *head)
+{
+  if(head->pRequest)
+  {
+    env_lookup(head, &head->pRequest->mServer, "server");
+    return;
+  }
+
+  sc_map vars;
+  for(char **var = environ; var && *var; var++)
+  {
+    char *eq = strchr(*var, '=');
+    if(!eq || eq == *var) continue;
+
+    ic_string name(*var, eq - *var);
+    vars.set(name.get(), eq + 1);
+  }
+
+  env_lookup(head, &vars, "server");
+}
+
+/**
+ * Sets the status of the response.
+ * Returns false if the headers have been sent.
+ */
+void env_status(rc_head *head)
+{
+  rc_var *code_var = head->rSRC.pop();
+  ic_object *code = code_var->get();
+
+  if(head->pCore->class_type(code->pClass) == M_CLASS_INT)
+  {
+    bool result = head->pRequest && head->pRequest->status(((ic_int *)code->mData)->mValue);
+    head->rSRC.push(head->new_bool(result));
+  }
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "int", "status"), M_EXC_ARGS);
+
+  head->obj_unlink(code_var);
+}
+
+#endif
@@ -9,231 +9,625 @@
 #define M_FILE_H
 
 /**
- * File constructor.
+ * Converts a mode of fopen into a file access mode.
+ * @param mode Mode string, such as 'r', 'w+' or 'ab'.
+ * @return File access mode or 0 if the mode is unknown.
  */
-void file_op_create(rc_head *head)
+char file_mode(const char *mode)
 {
-  ic_object *name = head->rIN.pop();
-  head->pCurrObj->mData = new ic_file(name);
+  char result;
+  switch(*mode)
+  {
+    case 'r': result = IO_READ; break;
+    case 'w': result = IO_WRITE; break;
+    case 'a': result = IO_WRITE | FILE_APPEND; break;
+    default:  return 0;
+  }
+
+  for(const char *chr = mode + 1; *chr; chr++)
+  {
+    if(*chr == '+' && (result & IO_RW) != IO_RW)
+      result |= *mode == 'w' ? IO_RW | FILE_REPLACE : IO_RW;
+    else if(*chr == 'b' && !(result & FILE_BINARY))
+      result |= FILE_BINARY;
+    else
+      return 0;
+  }
+
+  return result;
 }
 
 /**
- * Opens the selected file.
+ * Makes sure the file can be read, opening it for the time of the call if it is closed.
+ * @param file File.
+ * @param[out] opened The file has been opened here and has to be closed afterwards.
+ * @return false if the file cannot be read.
  */
-void file_open(rc_head *head)
+bool file_reader(ic_file *file, bool &opened)
 {
-  ic_object *obj = head->rIN.pop();
-  if(obj->class_id() == M_CLASS_INT)
+  opened = false;
+  if(file->mFile)
+    return file->mMode & IO_READ;
+
+  opened = file->open(IO_READ | FILE_BINARY);
+  return opened;
+}
+
+/**
+ * Makes a string variable of a line.
+ * The variable holds the only link to it's string, so a line is released
+ * as soon as the script drops it and files of any size can be iterated.
+ * @param line First character of the line.
+ * @param length Length of the line.
+ * @return Variable holding the line.
+ */
+rc_var *file_line(rc_head *head, const char *line, long length)
+{
+  // lines are sized to fit, a log of short lines would take several times it's size otherwise
+  ic_string *str = new ic_string(length);
+  if(!str) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  if(length) str->append(line, length);
+
+  rc_var *var = head->new_string(str, true);
+  head->obj_unlink(var->get());
+  return var;
+}
+
+/**
+ * Returns the engine of asynchronous operations, which only the main thread
+ * may use, since the callbacks are run by it's event loop.
+ * @return Engine or NULL if an exception has been thrown.
+ */
+sc_aio *file_aio(rc_head *head)
+{
+  if(std::this_thread::get_id() != head->pCore->mMainThread)
   {
-    char mode = (char)((ic_int *)obj->mData)->mValue;
-    bool result = ((ic_file *)head->pCurrObj->mData)->open(mode);
-    head->rOUT.push(head->obj_bool(result));
+    head->exception(M_ERR_FILE_THREAD, M_EXC_SCRIPT);
+    return NULL;
   }
+
+  return head->pCore->aio();
 }
 
 /**
- * Closes the selected file.
+ * File constructor.
+ */
+void file_op_create(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *name_var = head->rSRC.pop();
+  ic_object *name = name_var->get();
+
+  if(head->pCore->class_type(name->pClass) == M_CLASS_STRING)
+    ((ic_file *)obj->mData)->choose((ic_string *)name->mData);
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string", "new file"), M_EXC_ARGS);
+
+  head->obj_unlink(name_var);
+}
+
+/**
+ * Closes the file.
  */
 void file_close(rc_head *head)
 {
-  ((ic_file *)head->pCurrObj->mData)->close();  
+  ic_object *obj = head->pCurrObj->get();
+  ((ic_file *)obj->mData)->close();
 }
 
 /**
- * Reads a specified amount of data from a file.
+ * Copies the file to another name and location.
+ * The copy is made by the kernel where it can be, see sc_file::copy.
  */
-void file_read(rc_head *head)
+void file_copy(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *name_var = head->rSRC.pop();
+  ic_object *name = name_var->get();
+
+  if(head->pCore->class_type(name->pClass) == M_CLASS_STRING)
+    head->rSRC.push(head->new_bool(((ic_file *)obj->mData)->copy((ic_string *)name->mData)));
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string", "copy"), M_EXC_ARGS);
+
+  head->obj_unlink(name_var);
+}
+
+/**
+ * Calls a function on each line of the file, starting at the current position.
+ * Lines are read one by one, so the file may be of any size.
+ * Returns false if the file cannot be read.
+ */
+void file_each_line(rc_head *head)
 {
-  ic_file *file = (ic_file *)head->pCurrObj->mData;
-  if(file->mMode & IO_READ)
+  ic_object *obj = head->pCurrObj->get();
+  ic_file *file = (ic_file *)obj->mData;
+  rc_var *fx_var = head->rSRC.pop();
+  ic_object *fx = fx_var->get();
+
+  if(head->pCore->class_type(fx->pClass) == M_CLASS_METHOD)
   {
-    ic_object *obj = head->rIN.pop();
-    if(obj->class_id() == M_CLASS_INT)
+    bool opened;
+    if(file_reader(file, opened))
     {
-      ic_string *str = file->read(((ic_int *)obj->mData)->mValue);
-      head->rOUT.push(head->obj_string(str));
-    } 
+      const char *line;
+      long length;
+
+      while(head->mState == M_STATE_RUN && file->read_line(&line, &length))
+      {
+        head->rSRC.push(file_line(head, line, length));
+        head->method_invoke((rc_method *)fx->mData);
+        head->cmd_clrsrc();
+      }
+
+      if(opened)
+        file->close();
+    }
+    else
+      head->rSRC.push(head->new_bool(false));
   }
   else
-    head->rOUT.push(head->obj_bool(false));
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "method", "each_line"), M_EXC_ARGS);
+
+  head->obj_unlink(fx_var);
 }
 
 /**
- * Reads the whole file as a string.
+ * Checks if the file exists.
  */
-void file_read_all(rc_head *head)
+void file_exists(rc_head *head)
 {
-  ic_file *file = (ic_file *)head->pCurrObj->mData;
-  if(file->mMode & IO_READ)
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_bool(((ic_file *)obj->mData)->exists()));
+}
+
+/**
+ * Returns a detailed representation of the file.
+ */
+void file_inspect(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  ic_file *file = (ic_file *)obj->mData;
+
+  ic_string *str = new ic_string("{file:");
+  if(file->mName)
+    str->append(file->mName);
+
+  if(file->mFile)
   {
-    ic_string *str = new ic_string();
-    str->file_load(((ic_file *)head->pCurrObj->mData)->mName);
-    head->rOUT.push(head->obj_string(str));
+    str->append(" open(");
+    str->append_int(file->mMode);
+    str->append(")");
   }
-  else
-    head->rOUT.push(head->obj_bool(false));
+
+  str->append("}");
+  head->rSRC.push(head->new_string(str));
 }
 
 /**
- * Reads the whole file as an array of lines.
+ * Returns the length of the file.
  */
-void file_read_lines(rc_head *head)
+void file_length(rc_head *head)
 {
-  ic_file *file = (ic_file *)head->pCurrObj->mData;
-  if(file->mMode & IO_READ)
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_int(((ic_file *)obj->mData)->length()));
+}
+
+/**
+ * Runs the callbacks of asynchronous operations until all of them are complete.
+ * The loop is shared with sockets, whose callbacks are run as well.
+ * Returns the number of events handled.
+ */
+void file_loop(rc_head *head)
+{
+  rc_var *timeout_var = head->rSRC.pop();
+  ic_object *timeout = timeout_var->get();
+  int timeout_id = head->pCore->class_type(timeout->pClass);
+
+  if(timeout_id != M_CLASS_INT && timeout_id != M_CLASS_UNDEF)
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "int", "loop"), M_EXC_ARGS);
+  else if(file_aio(head))
   {
-    // make array and string
-    ic_string *str = new ic_string();
-    ic_array *arr = new ic_array();
+    long ms = timeout_id == M_CLASS_INT ? ((ic_int *)timeout->mData)->mValue : -1;
+    head->rSRC.push(head->new_int(head->pCore->reactor()->run(head, ms)));
+  }
 
-    long tmp_pos = ftell(file->mFile);
-    fseek(file->mFile, 0, SEEK_SET);
+  head->obj_unlink(timeout_var);
+}
 
-    char buf;
-    while(!feof(file->mFile))
-    {
-      fread(&buf, 1, 1, file->mFile);
-      if(buf != '\n')
-        str->append(&buf, 1);
-      else
-      {
-        arr->append(head->obj_string(str));
-        str = new ic_string();
-      }
-    }
-    fseek(file->mFile, tmp_pos, SEEK_SET);
+/**
+ * Opens the file.
+ * The mode is the same as for fopen: 'r' (default), 'w', 'a', 'r+', 'w+' or 'a+',
+ * optionally followed by 'b'.
+ */
+void file_open(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *mode_var = head->rSRC.pop();
+  ic_object *mode_obj = mode_var->get();
+  int mode_id = head->pCore->class_type(mode_obj->pClass);
 
-    arr->append(head->obj_string(str));
-    head->rOUT.push(head->obj_array(arr));
+  if(mode_id == M_CLASS_STRING || mode_id == M_CLASS_UNDEF)
+  {
+    const char *name = mode_id == M_CLASS_STRING ? ((ic_string *)mode_obj->mData)->get() : "r";
+    char mode = file_mode(name);
+
+    if(mode)
+      head->rSRC.push(head->new_bool(((ic_file *)obj->mData)->open(mode)));
+    else
+      head->exception(ic_string::format(M_ERR_FILE_MODE, name), M_EXC_ARGS);
   }
   else
-    head->rOUT.push(head->obj_bool(false));
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string", "open"), M_EXC_ARGS);
+
+  head->obj_unlink(mode_var);
 }
 
 /**
- * Seeks a position inside the file.
+ * Reads a specified amount of data from the file.
+ * Returns false if the file is not open for reading.
  */
-void file_seek(rc_head *head)
+void file_read(rc_head *head)
 {
-  ic_object *mode = head->rIN.pop(), *pos = head->rIN.pop();
-  if((mode->class_id() & pos->class_id()) == M_CLASS_INT)
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *size_var = head->rSRC.pop();
+  ic_object *size = size_var->get();
+
+  if(head->pCore->class_type(size->pClass) == M_CLASS_INT)
   {
-    long imode = ((ic_int*)mode->mData)->mValue;
-    long ipos = ((ic_int*)mode->mData)->mValue;
-    ((ic_file *)head->pCurrObj->mData)->seek(ipos, imode);
+    ic_string *str = ((ic_file *)obj->mData)->read(((ic_int *)size->mData)->mValue);
+    head->rSRC.push(str ? head->new_string(str, true) : head->new_bool(false));
   }
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "int", "read"), M_EXC_ARGS);
+
+  head->obj_unlink(size_var);
 }
 
 /**
- * Tells the current position in the file.
+ * Reads the whole file as a string.
+ * Returns false if the file does not exist.
  */
-void file_tell(rc_head *head)
+void file_read_all(rc_head *head)
 {
-  long pos = ((ic_file *)head->pCurrObj->mData)->tell();
-  head->rOUT.push(head->obj_int(pos));
+  ic_object *obj = head->pCurrObj->get();
+  ic_file *file = (ic_file *)obj->mData;
+
+  if(file->exists())
+  {
+    ic_string *str = new ic_string();
+    if(!str) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+    str->file_load(file->mName);
+    head->rSRC.push(head->new_string(str, true));
+  }
+  else
+    head->rSRC.push(head->new_bool(false));
 }
 
 /**
- * Checks for file existence.
+ * Reads the whole file in the background.
+ * The callback gets the contents, or false if the file cannot be read, and
+ * the file itself, once file.loop() or socket.loop() is running.
+ * Returns false if the file has no name.
  */
-void file_exists(rc_head *head)
+void file_read_async(rc_head *head)
 {
-  bool exists = sc_file::exists((ic_file)head->pCurrObj->mData)->mName);
-  head->rOUT.push(head->obj_bool(exists));
+  ic_object *obj = head->pCurrObj->get();
+  ic_file *file = (ic_file *)obj->mData;
+  rc_var *fx_var = head->rSRC.pop();
+
+  if(head->pCore->class_type(fx_var->get()->pClass) != M_CLASS_METHOD)
+  {
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "method", "read_async"), M_EXC_ARGS);
+    head->obj_unlink(fx_var);
+    return;
+  }
+
+  sc_aio *aio = file_aio(head);
+  if(!aio || !file->mName)
+  {
+    if(aio)
+      head->rSRC.push(head->new_bool(false));
+
+    head->obj_unlink(fx_var);
+    return;
+  }
+
+  // data written through the stream has to reach the file first
+  if(file->mFile && file->mMode & IO_WRITE)
+    fflush(file->mFile);
+
+  sc_aioreq *req = new sc_aioreq(AIO_READ, file->mName);
+  if(!req) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  req->pFile = new rc_var(obj);
+  req->pCallback = fx_var;
+  aio->submit(req);
+  aio->commit();
+
+  head->rSRC.push(head->new_bool(true));
 }
 
 /**
- * Returns file length.
+ * Reads the next line of the file, or returns undef at the end of it.
  */
-void file_length(rc_head *head)
+void file_read_line(rc_head *head)
 {
-  long length = ((ic_file *)head->pCurrObj->mData)->length();
-  head->rOUT.push(head->obj_int(length));
+  ic_object *obj = head->pCurrObj->get();
+  const char *line;
+  long length;
+
+  if(((ic_file *)obj->mData)->read_line(&line, &length))
+    head->rSRC.push(file_line(head, line, length));
+  else
+    head->rSRC.push(head->new_undef());
 }
 
 /**
- * Copies a file to a new location.
+ * Reads the whole file as an array of lines.
+ * The position in an open file is kept.
+ * Returns false if the file cannot be read.
  */
-void file_copy(rc_head *head)
+void file_read_lines(rc_head *head)
 {
-  ic_object *obj = head->rIN.pop();
-  if(obj->class_id() == M_CLASS_STRING)
+  ic_object *obj = head->pCurrObj->get();
+  ic_file *file = (ic_file *)obj->mData;
+
+  bool opened;
+  if(!file_reader(file, opened))
   {
-    ic_string *name = (ic_string*)obj->mData;
-    ((ic_file*)head->pCurrObj->mData)->copy(name);
+    head->rSRC.push(head->new_bool(false));
+    return;
   }
+
+  long pos = file->tell();
+  file->seek(0, SEEK_SET);
+
+  ic_array *arr = new ic_array();
+  if(!arr) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  const char *line;
+  long length;
+  while(file->read_line(&line, &length))
+    arr->append(file_line(head, line, length), false);
+
+  if(opened)
+    file->close();
+  else
+    file->seek(pos, SEEK_SET);
+
+  // the lines go away along with the array
+  rc_var *var = head->new_array(arr, true);
+  head->obj_unlink(var->get());
+  head->rSRC.push(var);
 }
 
 /**
- * Renames / moves the file.
+ * Reads several files in the background at once.
+ * The callback gets an array of their contents, in the order of the names,
+ * with false in place of files that cannot be read.
+ * Returns false if no names are given.
  */
-void file_rename(rc_head *head)
+void file_read_many(rc_head *head)
 {
-  ic_object *obj = head->rIN.pop();
-  if(obj->class_id() == M_CLASS_STRING)
+  rc_var *names_var = head->rSRC.pop();
+  rc_var *fx_var = head->rSRC.pop();
+  ic_object *names = names_var->get();
+
+  if(head->pCore->class_type(names->pClass) != M_CLASS_ARRAY)
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "array", "read_many"), M_EXC_ARGS);
+  else if(head->pCore->class_type(fx_var->get()->pClass) != M_CLASS_METHOD)
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 2, "method", "read_many"), M_EXC_ARGS);
+  else
   {
-    ic_string *name = (ic_string*)obj->mData;
-    ((ic_file*)head->pCurrObj->mData)->rename(name);
+    ic_array *arr = (ic_array *)names->mData;
+    sc_voidmapitem *curr;
+
+    // names are checked before any read is started
+    arr->iter_rewind();
+    while(curr = arr->iter_next())
+      if(head->pCore->class_type(((rc_var *)curr->mValue)->get()->pClass) != M_CLASS_STRING)
+      {
+        head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "array of strings", "read_many"), M_EXC_ARGS);
+        break;
+      }
+
+    sc_aio *aio = curr ? NULL : file_aio(head);
+    if(aio && arr->length())
+    {
+      sc_aiobatch *batch = new sc_aiobatch(arr->length(), fx_var);
+      if(!batch) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+      long idx = 0;
+      arr->iter_rewind();
+      while(curr = arr->iter_next())
+      {
+        ic_string *name = (ic_string *)((rc_var *)curr->mValue)->get()->mData;
+        sc_aioreq *req = new sc_aioreq(AIO_READ, name->get());
+        if(!req) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+        req->pBatch = batch;
+        req->mIndex = idx++;
+        aio->submit(req);
+      }
+
+      // the whole batch goes to the kernel in one call
+      aio->commit();
+      head->rSRC.push(head->new_bool(true));
+      head->obj_unlink(names_var);
+      return;
+    }
+
+    if(aio)
+      head->rSRC.push(head->new_bool(false));
   }
+
+  head->obj_unlink(names_var);
+  head->obj_unlink(fx_var);
 }
 
 /**
- * Removes the file.
+ * Renames or moves the file.
  */
 void file_rename(rc_head *head)
 {
-  ((ic_file*)head->pCurrObj->mData)->remove(name);
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *name_var = head->rSRC.pop();
+  ic_object *name = name_var->get();
+
+  if(head->pCore->class_type(name->pClass) == M_CLASS_STRING)
+    head->rSRC.push(head->new_bool(((ic_file *)obj->mData)->rename((ic_string *)name->mData)));
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string", "rename"), M_EXC_ARGS);
+
+  head->obj_unlink(name_var);
+}
+
+/**
+ * Removes the file.
+ */
+void file_remove(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_bool(((ic_file *)obj->mData)->remove()));
 }
 
 /**
- * Truncates the file.
+ * Moves to another position in the file.
+ * The position is counted from the start (0, default), the current position (1) or the end (2).
  */
-void file_truncate(rc_head *head)
+void file_seek(rc_head *head)
 {
-  ic_object *obj = head->rIN.pop();
-  if(obj->class_id() == M_CLASS_INT)
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *pos_var = head->rSRC.pop();
+  rc_var *from_var = head->rSRC.pop();
+  ic_object *pos = pos_var->get();
+  ic_object *from = from_var->get();
+  int from_id = head->pCore->class_type(from->pClass);
+
+  if(head->pCore->class_type(pos->pClass) != M_CLASS_INT)
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "int", "seek"), M_EXC_ARGS);
+  else if(from_id != M_CLASS_INT && from_id != M_CLASS_UNDEF)
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 2, "int", "seek"), M_EXC_ARGS);
+  else
   {
-    long size = ((ic_int *)obj->mData)->mValue;
-    ((ic_file*)head->pCurrObj->mData)->truncate(name);
+    long whence = from_id == M_CLASS_INT ? ((ic_int *)from->mData)->mValue : 0;
+    char mode = whence == 1 ? SEEK_CUR : whence == 2 ? SEEK_END : SEEK_SET;
+    ((ic_file *)obj->mData)->seek(((ic_int *)pos->mData)->mValue, mode);
   }
+
+  head->obj_unlink(pos_var);
+  head->obj_unlink(from_var);
+}
+
+/**
+ * Returns the current position in the file.
+ */
+void file_tell(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_int(((ic_file *)obj->mData)->tell()));
 }
 
 /**
- * Returns a boolean representation of a file.
+ * Returns a boolean representation of the file.
  */
 void file_to_b(rc_head *head)
 {
-  file_exists(head);
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_bool(((ic_file *)obj->mData)->to_b(), obj->mTainted));
 }
 
 /**
- * Returns an integer representation of a file.
+ * Returns an integer representation of the file.
  */
 void file_to_i(rc_head *head)
 {
-  file_length(head);
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_int(((ic_file *)obj->mData)->to_i(), obj->mTainted));
 }
 
 /**
- * Inspect object
+ * Returns a string representation of the file.
  */
-void file_inspect(rc_head *head)
+void file_to_s(rc_head *head)
 {
-  ic_string *str = new ic_string("{file:");
-  ic_file *file = (ic_file *)head->pCurrObj->mData;
-  str->append(file->mName);
+  ic_object *obj = head->pCurrObj->get();
+  char *name = ((ic_file *)obj->mData)->to_s();
+  head->rSRC.push(head->new_string(name ? name : "", obj->mTainted));
+}
 
-  if(file->mFile)
+/**
+ * Writes a string to the file.
+ * Returns false if the file is not open for writing.
+ */
+void file_write(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *data_var = head->rSRC.pop();
+  ic_object *data = data_var->get();
+
+  if(head->pCore->class_type(data->pClass) == M_CLASS_STRING)
   {
-    ic_int *mode = new ic_int(file->mMode);
-    str->append(" open(");
-    str->append(mode->to_s());
-    str->append(")");
+    bool result = ((ic_file *)obj->mData)->write((ic_string *)data->mData);
+    head->rSRC.push(head->new_bool(result));
   }
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string", "write"), M_EXC_ARGS);
 
-  str->append("}");
+  head->obj_unlink(data_var);
+}
+
+/**
+ * Writes the data to the file in the background, replacing what it has.
+ * The callback, if any, gets true once the data is written, or false if the
+ * file cannot be written, and the file itself.
+ * Returns false if the file has no name.
+ */
+void file_write_async(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  ic_file *file = (ic_file *)obj->mData;
+  rc_var *data_var = head->rSRC.pop();
+  rc_var *fx_var = head->rSRC.pop();
+  ic_object *data = data_var->get();
+  int fx_id = head->pCore->class_type(fx_var->get()->pClass);
+
+  if(head->pCore->class_type(data->pClass) != M_CLASS_STRING)
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string", "write_async"), M_EXC_ARGS);
+  else if(fx_id != M_CLASS_METHOD && fx_id != M_CLASS_UNDEF)
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 2, "method", "write_async"), M_EXC_ARGS);
+  else if(sc_aio *aio = file_aio(head))
+  {
+    if(file->mName)
+    {
+      // the data is copied, so the script may change the string in the meantime
+      ic_string *str = (ic_string *)data->mData;
+      sc_aioreq *req = new sc_aioreq(AIO_WRITE, file->mName);
+      if(!req) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+      req->reserve(str->length());
+      memcpy(req->mBuf, str->get(), str->length());
+      req->mLength = str->length();
+
+      req->pFile = new rc_var(obj);
+      if(fx_id == M_CLASS_METHOD)
+      {
+        req->pCallback = fx_var;
+        fx_var = NULL;
+      }
+
+      aio->submit(req);
+      aio->commit();
+    }
+
+    head->rSRC.push(head->new_bool(file->mName != NULL));
+  }
 
-  head->rOUT.push(head->obj_string(str));
+  head->obj_unlink(data_var);
+  if(fx_var)
+    head->obj_unlink(fx_var);
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -351,7 +351,8 @@ void float_to_i(rc_head *head)
 void float_to_s(rc_head *head)
 {
   ic_object *obj = head->pCurrObj->get();
-  const char *str = ((ic_float *)obj->mData)->to_s();
+  ic_string *str = new ic_string(NUMBER_BUF_SIZE);
+  str->append_float(((ic_float *)obj->mData)->mValue);
   head->rSRC.push(head->new_string(str, obj->mTainted));
 }
 
@@ -0,0 +1,170 @@
+/**
+ * @file m_generator.h
+ * @author impworks
+ * Generator method header.
+ * Defines all methods for generator class.
+ */
+
+#ifndef M_GENERATOR_H
+#define M_GENERATOR_H
+
+/**
+ * Resumes the generator for the next value.
+ * An exception thrown by the method is thrown again.
+ * @param gen Generator.
+ * @param thrown Set to true if the method has thrown an exception.
+ * @return Value or NULL if the method has finished.
+ */
+rc_var *generator_fetch(rc_head *head, ic_generator *gen, bool *thrown = NULL)
+{
+  // the method has asked for it's own next value
+  if(gen->mStarted && !gen->mFinished && gen->mHead->mState == M_STATE_RUN)
+  {
+    head->exception(M_ERR_GENERATOR_RUNNING, M_EXC_SCRIPT);
+    return NULL;
+  }
+
+  if(gen->resume())
+    return gen->value();
+
+  rc_var *exc = gen->error();
+  if(exc)
+  {
+    if(thrown) *thrown = true;
+    head->obj_unlink(head->rAX);
+    head->rAX = exc;
+    head->cmd_throw();
+  }
+
+  return NULL;
+}
+
+/**
+ * Generator constructor.
+ * The method is not run until the first value is requested.
+ */
+void generator_op_create(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *fx_var = head->rSRC.pop();
+  ic_object *fx = fx_var->get();
+
+  if(head->pCore->class_type(fx->pClass) == M_CLASS_METHOD)
+    ((ic_generator *)obj->mData)->start(head, (rc_method *)fx->mData);
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "method", "new generator"), M_EXC_ARGS);
+
+  head->cmd_clrsrc();
+  head->obj_unlink(fx_var);
+}
+
+/**
+ * Calls a function on each value the generator yields.
+ */
+void generator_each(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *fx_var = head->rSRC.pop();
+  ic_object *fx = fx_var->get();
+
+  if(head->pCore->class_type(fx->pClass) == M_CLASS_METHOD)
+  {
+    rc_var *item;
+    while(item = generator_fetch(head, (ic_generator *)obj->mData))
+    {
+      head->rSRC.push(item);
+      head->method_invoke((rc_method *)fx->mData);
+      head->cmd_clrsrc();
+    }
+  }
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "method", "each"), M_EXC_ARGS);
+
+  head->obj_unlink(fx_var);
+}
+
+/**
+ * Returns the next value or undef if the method has finished.
+ */
+void generator_next(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  bool thrown = false;
+  rc_var *item = generator_fetch(head, (ic_generator *)obj->mData, &thrown);
+
+  // the exception is on SRC already
+  if(!thrown)
+    head->rSRC.push(item ? item : head->new_undef());
+}
+
+/**
+ * Returns an array of at most N next values.
+ */
+void generator_take(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *count_var = head->rSRC.pop();
+  ic_object *count = count_var->get();
+
+  if(head->pCore->class_type(count->pClass) == M_CLASS_INT)
+  {
+    ic_array *arr = new ic_array();
+    if(!arr) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+    rc_var *item;
+    bool thrown = false;
+    for(long idx = ((ic_int *)count->mData)->mValue; idx > 0 && (item = generator_fetch(head, (ic_generator *)obj->mData, &thrown)); idx--)
+      arr->append(item, false);
+
+    rc_var *res = head->new_array(arr, obj->mTainted);
+    if(thrown)
+      head->obj_unlink(res);
+    else
+      head->rSRC.push(res);
+  }
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "int", "take"), M_EXC_ARGS);
+
+  head->obj_unlink(count_var);
+}
+
+/**
+ * Returns an array of all values left.
+ */
+void generator_to_a(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  ic_array *arr = new ic_array();
+  if(!arr) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  rc_var *item;
+  bool thrown = false;
+  while(item = generator_fetch(head, (ic_generator *)obj->mData, &thrown))
+    arr->append(item, false);
+
+  rc_var *res = head->new_array(arr, obj->mTainted);
+  if(thrown)
+    head->obj_unlink(res);
+  else
+    head->rSRC.push(res);
+}
+
+/**
+ * Returns a boolean representation of the generator.
+ */
+void generator_to_b(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_bool(((ic_generator *)obj->mData)->to_b(), obj->mTainted));
+}
+
+/**
+ * Returns a string representation of the generator.
+ */
+void generator_to_s(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_string(((ic_generator *)obj->mData)->to_s(), obj->mTainted));
+}
+
+#endif
@@ -484,6 +484,14 @@ void int_char(rc_head *head)
 {
   ic_object *obj = head->pCurrObj->get();
   long val = ((ic_int *)obj->mData)->mValue;
+#if MALCO_UNICODE == 1
+  if(val >= 0 && val < 0x110000)
+  {
+    char str[5];
+    str[sc_utf8::encode(val, str)] = '\0';
+    head->rSRC.push(head->new_string(str, obj->mTainted));
+  }
+#else
   if(val >= 0 && val <= 255)
   {
     char str[2] = " ";
@@ -491,6 +499,7 @@ void int_char(rc_head *head)
     str[1] = '\0';
     head->rSRC.push(head->new_string(str, obj->mTainted));
   }
+#endif
 }
 
 /**
@@ -528,7 +537,8 @@ void int_to_i(rc_head *head)
 void int_to_s(rc_head *head)
 {
   ic_object *obj = head->pCurrObj->get();
-  const char *str = ((ic_int *)obj->mData)->to_s();
+  ic_string *str = new ic_string(NUMBER_BUF_SIZE);
+  str->append_int(((ic_int *)obj->mData)->mValue);
   head->rSRC.push(head->new_string(str, obj->mTainted));
 }
 
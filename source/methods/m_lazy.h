@@ -0,0 +1,538 @@
+/**
+ * @file m_lazy.h
+ * @author impworks
+ * Lazy enumerator method header.
+ * Defines all methods for lazy class.
+ */
+
+#ifndef M_LAZY_H
+#define M_LAZY_H
+
+/**
+ * Pass over a lazy enumerator.
+ * Items are pulled from the source one at a time and pushed through the stages.
+ * The buffer holds what the last stage has let through, which is never more than
+ * one item per zip stage doubling it.
+ */
+struct lazy_cursor
+{
+  ic_lazy *pLazy;             /**< Enumerator. */
+  long mPos;                  /**< Offset in the range or position in the array. */
+  bool mFinished;             /**< No more items are to be taken from the source. */
+  bool mTainted;              /**< Values generated by the range are tainted. */
+  long *mCounts;              /**< Items passed by every take stage. */
+  lazy_cursor **mZips;        /**< Passes over the zipped enumerators. */
+  sc_queue mBuffer;           /**< Items that have passed all stages. */
+};
+
+/**
+ * Starts a pass over the enumerator.
+ * @param lazy Enumerator.
+ * @param tainted Taint generated values.
+ */
+lazy_cursor *lazy_open(ic_lazy *lazy, bool tainted)
+{
+  lazy_cursor *cur = new lazy_cursor();
+  if(!cur) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  long length = lazy->length();
+  cur->pLazy = lazy;
+  cur->mPos = 0;
+  cur->mFinished = false;
+  cur->mTainted = tainted;
+  cur->mCounts = new long[length ? length : 1];
+  cur->mZips = new lazy_cursor*[length ? length : 1];
+  if(!cur->mCounts || !cur->mZips) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  for(long idx = 0; idx < length; idx++)
+  {
+    ic_lazy::stage *curr = lazy->get(idx);
+    cur->mCounts[idx] = 0;
+    cur->mZips[idx] = NULL;
+
+    if(curr->mType == LAZY_TAKE && curr->mCount <= 0)
+      cur->mFinished = true;
+    else if(curr->mType == LAZY_ZIP)
+    {
+      ic_object *other = curr->pArg->get();
+      cur->mZips[idx] = lazy_open((ic_lazy *)other->mData, other->mTainted);
+    }
+  }
+
+  return cur;
+}
+
+/**
+ * Ends the pass, dropping the items that have not been taken.
+ * @param cur Pass to be closed.
+ */
+void lazy_close(rc_head *head, lazy_cursor *cur)
+{
+  while(cur->mBuffer.mLength)
+    head->obj_unlink(cur->mBuffer.pop());
+
+  for(long idx = 0; idx < cur->pLazy->length(); idx++)
+    if(cur->mZips[idx])
+      lazy_close(head, cur->mZips[idx]);
+
+  delete [] cur->mCounts;
+  delete [] cur->mZips;
+  delete cur;
+}
+
+/**
+ * Calls a method with the item and returns the result.
+ * @param fx Variable holding the method.
+ * @param item Argument. It's link is passed to the method.
+ * @return Result, to be unlinked by the caller.
+ */
+rc_var *lazy_call(rc_head *head, rc_var *fx, rc_var *item)
+{
+  head->rSRC.push(item);
+  head->method_invoke((rc_method *)fx->get()->mData);
+
+  // check function for returning a proper value
+  if(head->rSRC.mLength == 0)
+  {
+    head->warning(M_WARN_FX_NO_RETURN);
+    return head->new_undef();
+  }
+
+  // check function for returning too many values
+  if(head->rSRC.mLength > 1)
+    head->warning(M_WARN_FX_BAD_RETURN_COUNT, head->rSRC.mLength, 1);
+
+  rc_var *res = head->rSRC.pop();
+  head->cmd_clrsrc();
+  return res;
+}
+
+rc_var *lazy_next(rc_head *head, lazy_cursor *cur);
+
+/**
+ * Takes the next item from the source.
+ * @param cur Pass over the enumerator.
+ * @return Item or NULL if the source is exhausted.
+ */
+rc_var *lazy_source(rc_head *head, lazy_cursor *cur)
+{
+  ic_lazy *lazy = cur->pLazy;
+  if(cur->mFinished) return NULL;
+
+  if(lazy->mSource == LAZY_RANGE)
+  {
+    // same values as the range iteration gives
+    long value = lazy->mStart + cur->mPos++;
+    if(value >= lazy->mEnd) cur->mFinished = true;
+    return head->new_int(value, cur->mTainted);
+  }
+
+  sc_voidmapitem *curr = ((ic_array *)lazy->pArray->get()->mData)->iter_next(cur->mPos);
+  if(!curr)
+  {
+    cur->mFinished = true;
+    return NULL;
+  }
+
+  rc_var *item = (rc_var *)curr->mValue;
+  item->mLinks++;
+  return item;
+}
+
+/**
+ * Pushes an item through the stages, starting from a given one.
+ * @param cur Pass over the enumerator.
+ * @param idx Index of the stage.
+ * @param item Item. It's link is taken over.
+ */
+void lazy_feed(rc_head *head, lazy_cursor *cur, long idx, rc_var *item)
+{
+  for(; idx < cur->pLazy->length(); idx++)
+  {
+    ic_lazy::stage *curr = cur->pLazy->get(idx);
+    rc_var *res, *other;
+    bool keep;
+
+    switch(curr->mType)
+    {
+      case LAZY_MAP:    item = lazy_call(head, curr->pArg, item);
+                        break;
+
+      case LAZY_SELECT:
+      case LAZY_REJECT: item->mLinks++;
+                        res = lazy_call(head, curr->pArg, item);
+                        keep = head->sub_value(res) == (curr->mType == LAZY_SELECT);
+                        head->obj_unlink(res);
+                        if(!keep)
+                        {
+                          head->obj_unlink(item);
+                          return;
+                        }
+                        break;
+
+      case LAZY_TAKE:   if(cur->mCounts[idx] >= curr->mCount)
+                        {
+                          head->obj_unlink(item);
+                          return;
+                        }
+
+                        // nothing more is needed from the source once the count is reached
+                        if(++cur->mCounts[idx] >= curr->mCount)
+                          cur->mFinished = true;
+                        break;
+
+      case LAZY_ZIP:    other = lazy_next(head, cur->mZips[idx]);
+                        if(!other)
+                        {
+                          head->obj_unlink(item);
+                          cur->mFinished = true;
+                          return;
+                        }
+
+                        // items are interleaved, as array's zip does
+                        lazy_feed(head, cur, idx + 1, item);
+                        lazy_feed(head, cur, idx + 1, other);
+                        return;
+    }
+  }
+
+  cur->mBuffer.push(item);
+}
+
+/**
+ * Returns the next item that has passed all the stages.
+ * @param cur Pass over the enumerator.
+ * @return Item to be unlinked by the caller, or NULL if there are no more.
+ */
+rc_var *lazy_next(rc_head *head, lazy_cursor *cur)
+{
+  while(!cur->mBuffer.mLength && !cur->mFinished)
+  {
+    rc_var *item = lazy_source(head, cur);
+    if(item)
+      lazy_feed(head, cur, 0, item);
+  }
+
+  return cur->mBuffer.mLength ? cur->mBuffer.pop() : NULL;
+}
+
+/**
+ * Returns a copy of the enumerator with a stage appended.
+ * @param obj Enumerator object.
+ * @param type Stage type.
+ * @param arg Method or zipped enumerator. The link is taken over.
+ * @param count Number of items to take.
+ */
+rc_var *lazy_stage(rc_head *head, ic_object *obj, char type, rc_var *arg, long count)
+{
+  ic_lazy *lazy = new ic_lazy();
+  if(!lazy) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  *lazy = *((ic_lazy *)obj->mData);
+  lazy->link();
+  lazy->add(type, arg, count);
+
+  return head->new_lazy(lazy, obj->mTainted);
+}
+
+/**
+ * Sets a range, an array or another enumerator as the source.
+ * @param lazy Enumerator to be set up.
+ * @param source Range, array or enumerator.
+ * @return Whether the source is of a proper class.
+ */
+bool lazy_init(rc_head *head, ic_lazy *lazy, rc_var *source)
+{
+  ic_object *obj = source->get();
+
+  switch(head->pCore->class_type(obj->pClass))
+  {
+    case M_CLASS_RANGE:   lazy->set(((ic_range *)obj->mData)->mStart, ((ic_range *)obj->mData)->mEnd);
+                          return true;
+
+    case M_CLASS_ARRAY:   source->mLinks++;
+                          lazy->set(source);
+                          return true;
+
+    case M_CLASS_LAZY:    *lazy = *((ic_lazy *)obj->mData);
+                          lazy->link();
+                          return true;
+  }
+
+  return false;
+}
+
+/**
+ * Lazy enumerator constructor.
+ */
+void lazy_op_create(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *source_var = head->rSRC.pop();
+
+  if(!lazy_init(head, (ic_lazy *)obj->mData, source_var))
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "range, array or lazy", "new lazy"), M_EXC_ARGS);
+
+  head->obj_unlink(source_var);
+}
+
+/**
+ * Appends a stage calling a method.
+ * @param type Stage type.
+ * @param name Method name for errors.
+ */
+void lazy_stage_fx(rc_head *head, char type, const char *name)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *fx_var = head->rSRC.pop();
+
+  if(head->pCore->class_type(fx_var->get()->pClass) == M_CLASS_METHOD)
+    head->rSRC.push(lazy_stage(head, obj, type, fx_var, 0));
+  else
+  {
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "method", name), M_EXC_ARGS);
+    head->obj_unlink(fx_var);
+  }
+}
+
+/**
+ * Returns an enumerator of values the method returns for items.
+ */
+void lazy_map(rc_head *head)
+{
+  lazy_stage_fx(head, LAZY_MAP, "map");
+}
+
+/**
+ * Returns an enumerator of items the method returns true for.
+ */
+void lazy_select(rc_head *head)
+{
+  lazy_stage_fx(head, LAZY_SELECT, "select");
+}
+
+/**
+ * Returns an enumerator of items the method returns false for.
+ */
+void lazy_reject(rc_head *head)
+{
+  lazy_stage_fx(head, LAZY_REJECT, "reject");
+}
+
+/**
+ * Returns an enumerator of the first items.
+ */
+void lazy_take(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *count_var = head->rSRC.pop();
+  ic_object *count = count_var->get();
+
+  if(head->pCore->class_type(count->pClass) == M_CLASS_INT)
+    head->rSRC.push(lazy_stage(head, obj, LAZY_TAKE, NULL, ((ic_int *)count->mData)->mValue));
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "int", "take"), M_EXC_ARGS);
+
+  head->obj_unlink(count_var);
+}
+
+/**
+ * Returns an enumerator of items interleaved with items of another range, array or enumerator.
+ */
+void lazy_zip(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *other_var = head->rSRC.pop();
+
+  ic_lazy *other = new ic_lazy();
+  if(!other) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  if(lazy_init(head, other, other_var))
+    head->rSRC.push(lazy_stage(head, obj, LAZY_ZIP, head->new_lazy(other, other_var->get()->mTainted), 0));
+  else
+  {
+    delete other;
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "range, array or lazy", "zip"), M_EXC_ARGS);
+  }
+
+  head->obj_unlink(other_var);
+}
+
+/**
+ * Calls a function with each item.
+ */
+void lazy_each(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *fx_var = head->rSRC.pop();
+
+  if(head->pCore->class_type(fx_var->get()->pClass) == M_CLASS_METHOD)
+  {
+    lazy_cursor *cur = lazy_open((ic_lazy *)obj->mData, obj->mTainted);
+    rc_var *item;
+    while(item = lazy_next(head, cur))
+    {
+      head->rSRC.push(item);
+      head->method_invoke((rc_method *)fx_var->get()->mData);
+      head->cmd_clrsrc();
+    }
+    lazy_close(head, cur);
+  }
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "method", "each"), M_EXC_ARGS);
+
+  head->obj_unlink(fx_var);
+}
+
+/**
+ * Returns the number of items.
+ */
+void lazy_count(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  lazy_cursor *cur = lazy_open((ic_lazy *)obj->mData, obj->mTainted);
+  rc_var *item;
+  long count = 0;
+
+  while(item = lazy_next(head, cur))
+  {
+    head->obj_unlink(item);
+    count++;
+  }
+  lazy_close(head, cur);
+
+  head->rSRC.push(head->new_int(count, obj->mTainted));
+}
+
+/**
+ * Returns the first item or undef.
+ */
+void lazy_first(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  lazy_cursor *cur = lazy_open((ic_lazy *)obj->mData, obj->mTainted);
+  rc_var *item = lazy_next(head, cur);
+  lazy_close(head, cur);
+
+  head->rSRC.push(item ? item : head->new_undef());
+}
+
+/**
+ * Returns sum of all items.
+ * Plain numbers are added up without calling operators.
+ */
+void lazy_sum(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  lazy_cursor *cur = lazy_open((ic_lazy *)obj->mData, obj->mTainted);
+  rc_class *int_class = head->pCore->mClassCache.pInt;
+  rc_class *float_class = head->pCore->mClassCache.pFloat;
+  rc_var *item, *acc = NULL, *tmp = head->rAX;
+  double sum = 0.0;
+  bool tainted = false;
+
+  while(item = lazy_next(head, cur))
+  {
+    ic_object *value = item->get();
+    if(!acc && (value->pClass == int_class || value->pClass == float_class))
+    {
+      sum += value->pClass == int_class ? (double)((ic_int *)value->mData)->mValue : ((ic_float *)value->mData)->mValue;
+      tainted = tainted || value->mTainted;
+      head->obj_unlink(item);
+      continue;
+    }
+
+    // anything else is added with the operator from now on. the sum
+    // is kept off the stack, as the stages may call methods
+    if(!acc)
+      acc = head->new_float(sum, tainted);
+
+    head->rSRC.push(acc);
+    head->rAX = item;
+    head->cmd_add();
+    head->obj_unlink(head->rAX);
+    head->rAX = tmp;
+    acc = head->rSRC.pop();
+  }
+  lazy_close(head, cur);
+
+  head->rSRC.push(acc ? acc : head->new_float(sum, tainted));
+}
+
+/**
+ * Returns all items as an array.
+ */
+void lazy_to_a(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  lazy_cursor *cur = lazy_open((ic_lazy *)obj->mData, obj->mTainted);
+  ic_array *arr = new ic_array();
+  rc_var *item;
+
+  while(item = lazy_next(head, cur))
+    arr->append(item, false);
+  lazy_close(head, cur);
+
+  head->rSRC.push(head->new_array(arr, obj->mTainted));
+}
+
+/**
+ * Returns a boolean representation of the enumerator.
+ */
+void lazy_to_b(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_bool(((ic_lazy *)obj->mData)->to_b(), obj->mTainted));
+}
+
+/**
+ * Returns a string representation of the enumerator.
+ */
+void lazy_to_s(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_string(((ic_lazy *)obj->mData)->to_s(), obj->mTainted));
+}
+
+/**
+ * Returns enumerator's debug info: the source and the stages.
+ */
+void lazy_inspect(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  ic_lazy *lazy = (ic_lazy *)obj->mData;
+  ic_string *str = new ic_string("{lazy:");
+  char buf[NUMBER_BUF_SIZE];
+
+  if(lazy->mSource == LAZY_RANGE)
+  {
+    sc_number::format_int(buf, lazy->mStart);
+    str->append(buf);
+    str->append("..");
+    sc_number::format_int(buf, lazy->mEnd);
+    str->append(buf);
+  }
+  else
+    str->append("array");
+
+  for(long idx = 0; idx < lazy->length(); idx++)
+  {
+    ic_lazy::stage *curr = lazy->get(idx);
+    switch(curr->mType)
+    {
+      case LAZY_MAP:    str->append(" map"); break;
+      case LAZY_SELECT: str->append(" select"); break;
+      case LAZY_REJECT: str->append(" reject"); break;
+      case LAZY_ZIP:    str->append(" zip"); break;
+      case LAZY_TAKE:   str->append(" take ");
+                        sc_number::format_int(buf, curr->mCount);
+                        str->append(buf);
+                        break;
+    }
+  }
+  str->append("}");
+
+  head->rSRC.push(head->new_string(str, obj->mTainted));
+}
+
+#endif
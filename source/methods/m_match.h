@@ -79,7 +79,7 @@ void match_get(rc_head *head)
   if(head->pCore->class_type(id->pClass))
   {
     long val = ((ic_int *)id->mData)->mValue;
-    if(val >= 0 && val <= ((ic_match *)obj->mData)->count())
+    if(val >= 0 && val < ((ic_match *)obj->mData)->count())
     {
       const char *str = ((ic_match *)obj->mData)->get(val);
       head->rSRC.push(head->new_string(str, obj->mTainted));
@@ -104,7 +104,7 @@ void match_bounds(rc_head *head)
   if(head->pCore->class_type(id->pClass))
   {
     long val = ((ic_int *)id->mData)->mValue;
-    if(val >= 0 && val <= 9)
+    if(val >= 0 && val < ((ic_match *)obj->mData)->count())
     {
       long bounds[2];
       ((ic_match *)obj->mData)->bounds(val, bounds);
@@ -143,6 +143,19 @@ void object_id(rc_head *head)
   head->rSRC.push(head->new_int((long)head->pCurrObj->get()));
 }
 
+/**
+ * Returns the hash of object's value, or undef if it cannot be hashed.
+ * Strictly equal objects have equal hashes.
+ */
+void object_op_hash(rc_head *head)
+{
+  unsigned long hash;
+  if(head->sub_hash(head->pCurrObj, &hash))
+    head->rSRC.push(head->new_int((long)hash));
+  else
+    head->rSRC.push(head->new_undef());
+}
+
 /**
  * Returns object's class.
  */
@@ -267,7 +280,10 @@ void object_print(rc_head *head)
     var = (rc_var *)items.get(idx);
     rc_var *curr = head->convert_string(var);
     ic_string *str = (ic_string *)curr->get()->mData;
-    printf("%s", str->get());
+    if(head->pRequest)
+      head->pRequest->write(str->get(), str->length());
+    else
+      printf("%s", str->get());
 
     head->obj_unlink(var);
     if(var != curr)
@@ -223,8 +223,15 @@ void range_each(rc_head *head)
   ic_object *obj = head->pCurrObj->get();
   ic_range *rg = (ic_range *)obj->mData;
   rc_var *fx_var = head->rSRC.pop();
-  ic_object *fx = fx_var->get();
 
+  // without a function, the range is enumerated lazily
+  if(!fx_var)
+  {
+    range_lazy(head);
+    return;
+  }
+
+  ic_object *fx = fx_var->get();
   if(head->pCore->class_type(fx->pClass) == M_CLASS_METHOD)
   {
     rg->iter_rewind();
@@ -244,6 +251,95 @@ void range_each(rc_head *head)
   head->obj_unlink(fx_var);
 }
 
+/**
+ * Returns a lazy enumerator over the range.
+ */
+void range_lazy(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  ic_range *rg = (ic_range *)obj->mData;
+
+  ic_lazy *lazy = new ic_lazy();
+  if(!lazy) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+  lazy->set(rg->mStart, rg->mEnd);
+
+  head->rSRC.push(head->new_lazy(lazy, obj->mTainted));
+}
+
+/**
+ * Calls the method for each value in range on the pool workers and pushes the result.
+ * @param obj Range object.
+ * @param fx_var Variable holding the method.
+ * @param mode POOL_EACH, POOL_MAP or POOL_SELECT.
+ * @param name Name of the calling method for errors.
+ */
+void range_parallel(rc_head *head, ic_object *obj, rc_var *fx_var, int mode, const char *name)
+{
+  ic_object *fx = fx_var->get();
+  if(head->pCore->class_type(fx->pClass) != M_CLASS_METHOD)
+  {
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "method", name), M_EXC_ARGS);
+    return;
+  }
+
+  // same values as iteration yields
+  ic_range *rg = (ic_range *)obj->mData;
+  long count = rg->mStart <= rg->mEnd ? rg->mEnd - rg->mStart + 1 : 1, idx;
+  rc_var **results = new rc_var*[count];
+  if(!results) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  if(head->parallel((rc_method *)fx->mData, NULL, rg->mStart, count, mode, results, obj->mTainted) && mode != POOL_EACH)
+  {
+    rc_var *arr_var = head->new_array(obj->mTainted);
+    ic_array *arr = (ic_array *)arr_var->get()->mData;
+
+    for(idx=0; idx<count; idx++)
+    {
+      if(mode == POOL_MAP)
+        arr->append(results[idx], false);
+      else if(results[idx])
+      {
+        arr->append(head->new_int(rg->mStart + idx, obj->mTainted), false);
+        head->obj_unlink(results[idx]);
+      }
+    }
+
+    head->rSRC.push(arr_var);
+  }
+
+  delete [] results;
+}
+
+/**
+ * Invokes the function for each value in range on the pool workers.
+ */
+void range_parallel_each(rc_head *head)
+{
+  rc_var *fx_var = head->rSRC.pop();
+  range_parallel(head, head->pCurrObj->get(), fx_var, POOL_EACH, "parallel_each");
+  head->obj_unlink(fx_var);
+}
+
+/**
+ * Returns an array of values the function returns for each value in range, called on the pool workers.
+ */
+void range_parallel_map(rc_head *head)
+{
+  rc_var *fx_var = head->rSRC.pop();
+  range_parallel(head, head->pCurrObj->get(), fx_var, POOL_MAP, "parallel_map");
+  head->obj_unlink(fx_var);
+}
+
+/**
+ * Returns an array of values in range that match the condition in the lambda, called on the pool workers.
+ */
+void range_parallel_select(rc_head *head)
+{
+  rc_var *fx_var = head->rSRC.pop();
+  range_parallel(head, head->pCurrObj->get(), fx_var, POOL_SELECT, "parallel_select");
+  head->obj_unlink(fx_var);
+}
+
 /**
  * Gets or sets range's starting value.
  */
@@ -17,19 +17,33 @@ void regex_op_create(rc_head *head)
   rc_var *item_var = head->rSRC.pop();
   ic_object *item = (item_var ? item_var->get() : NULL);
 
+  const char *pattern = NULL;
   if(item)
   {
     char cls = head->pCore->class_type(item->pClass);
     if(cls == M_CLASS_REGEX)
+      pattern = ((ic_regex *)item->mData)->to_s();
+    else if(cls == M_CLASS_STRING)
+      pattern = ((ic_string *)item->mData)->get();
+    else if(cls != M_CLASS_UNDEF)
+      head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string or regex", "new regex"), M_EXC_ARGS);
+  }
+
+  // a bad pattern is a script exception rather than an internal error
+  if(pattern)
+  {
+    ic_regex *rx = (ic_regex *)obj->mData;
+    try
     {
-      ((ic_regex *)obj->mData)->set(((ic_regex *)item->mData)->to_s());
+      rx->set(pattern);
     }
-    else if(cls == M_CLASS_STRING)
+    catch(const sc_exception &)
     {
-      ((ic_regex *)obj->mData)->set(((ic_string *)item->mData)->get());
+      if(!rx->error()) throw;
     }
-    else if(cls != M_CLASS_UNDEF)
-      head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string or regex", "new regex"), M_EXC_ARGS);
+
+    if(rx->error())
+      head->exception(ic_string::format(M_ERR_REGEX_SYNTAX, pattern, rx->error()), M_EXC_REGEX);
   }
 
   head->obj_unlink(item_var);
@@ -98,6 +112,41 @@ void regex_match(rc_head *head)
   head->obj_unlink(str_var);
 }
 
+/**
+ * Calls a function on each match of the regex in a string.
+ * Matches are found on demand, so the string is scanned in a single pass.
+ */
+void regex_each_match(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *str_var = head->rSRC.pop(), *fx_var = head->rSRC.pop();
+  ic_object *str = str_var->get(), *fx = fx_var->get();
+
+  if(head->pCore->class_type(str->pClass) != M_CLASS_STRING)
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string", "each_match"), M_EXC_ARGS);
+  else if(head->pCore->class_type(fx->pClass) != M_CLASS_METHOD)
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 2, "method", "each_match"), M_EXC_ARGS);
+  else
+  {
+    ic_string *text = (ic_string *)str->mData;
+    ic_matchiter iter((ic_regex *)obj->mData, text->get(), text->length());
+    ic_match *match;
+
+    while(match = iter.next())
+    {
+      head->rSRC.push(head->new_match(match, obj->mTainted || str->mTainted));
+      head->method_invoke((rc_method *)fx->mData);
+      head->cmd_clrsrc();
+
+      // the function might have modified the string
+      iter.source(text->get(), text->length());
+    }
+  }
+
+  head->obj_unlink(str_var);
+  head->obj_unlink(fx_var);
+}
+
 /**
  * Studies the regex for faster execution.
  */
@@ -107,6 +156,21 @@ void regex_study(rc_head *head)
   ((ic_regex *)obj->mData)->study();
 }
 
+/**
+ * Returns the counters of the current thread's compiled regex cache
+ * as [hits, misses, programs].
+ */
+void regex_cache(rc_head *head)
+{
+  rc_var *arr_var = head->new_array();
+  ic_array *arr = (ic_array *)arr_var->get()->mData;
+  arr->append(head->new_int(sc_regexcache::hits()), false);
+  arr->append(head->new_int(sc_regexcache::misses()), false);
+  arr->append(head->new_int(sc_regexcache::length()), false);
+
+  head->rSRC.push(arr_var);
+}
+
 /**
  * Returns a bool representation of the regex.
  */
@@ -0,0 +1,164 @@
+/**
+ * @file m_regexset.h
+ * @author impworks
+ * Regex set method header.
+ * Defines all methods for regex_set class.
+ */
+
+#ifndef M_REGEXSET_H
+#define M_REGEXSET_H
+
+/**
+ * Adds a regex, a string to be compiled or an array of them to the set.
+ * @return Whether the item was of a proper type.
+ */
+bool regexset_add_item(rc_head *head, ic_regexset *set, ic_object *item)
+{
+  char cls = head->pCore->class_type(item->pClass);
+  if(cls == M_CLASS_REGEX)
+    set->add((ic_regex *)item->mData);
+  else if(cls == M_CLASS_STRING)
+    set->add(((ic_string *)item->mData)->get());
+  else if(cls == M_CLASS_ARRAY)
+  {
+    ic_array *arr = (ic_array *)item->mData;
+    sc_voidmapitem *curr;
+    arr->iter_rewind();
+    while(curr = arr->iter_next())
+    {
+      ic_object *sub = ((rc_var *)curr->mValue)->get();
+      char sub_cls = head->pCore->class_type(sub->pClass);
+      if(sub_cls == M_CLASS_REGEX)
+        set->add((ic_regex *)sub->mData);
+      else if(sub_cls == M_CLASS_STRING)
+        set->add(((ic_string *)sub->mData)->get());
+      else
+        return false;
+    }
+  }
+  else
+    return false;
+
+  return true;
+}
+
+/**
+ * Regex set constructor.
+ */
+void regexset_op_create(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *item_var = head->rSRC.pop();
+  ic_object *item = (item_var ? item_var->get() : NULL);
+
+  if(item && head->pCore->class_type(item->pClass) != M_CLASS_UNDEF)
+  {
+    if(!regexset_add_item(head, (ic_regexset *)obj->mData, item))
+      head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "array of strings or regexes", "new regex_set"), M_EXC_ARGS);
+  }
+
+  head->obj_unlink(item_var);
+}
+
+/**
+ * Adds regexes to the set.
+ */
+void regexset_add_do(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *item_var = head->rSRC.pop();
+  ic_object *item = item_var->get();
+
+  if(!obj->mFrozen)
+  {
+    if(regexset_add_item(head, (ic_regexset *)obj->mData, item))
+    {
+      if(item->mTainted) obj->mTainted = true;
+      head->pCurrObj->mLinks++;
+      head->rSRC.push(head->pCurrObj);
+    }
+    else
+      head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "regex, string or array", "add!"), M_EXC_ARGS);
+  }
+  else
+    head->exception(M_ERR_FROZEN, M_EXC_SCRIPT);
+
+  head->obj_unlink(item_var);
+}
+
+/**
+ * Returns the number of regexes in the set.
+ */
+void regexset_count(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  long count = ((ic_regexset *)obj->mData)->length();
+  head->rSRC.push(head->new_int(count, obj->mTainted));
+}
+
+/**
+ * Returns an array of indexes of the regexes that match the string.
+ * The string is scanned once, however many regexes the set has.
+ */
+void regexset_match(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *str_var = head->rSRC.pop();
+  ic_object *str = str_var->get();
+
+  if(head->pCore->class_type(str->pClass) == M_CLASS_STRING)
+  {
+    ic_regexset *set = (ic_regexset *)obj->mData;
+    ic_string *text = (ic_string *)str->mData;
+    ic_array *arr = new ic_array();
+    bool tainted = obj->mTainted || str->mTainted;
+
+    if(set->length())
+    {
+      char *found = new char[set->length()];
+      if(!found) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+      set->match(text->get(), text->length(), found);
+
+      for(long idx=0; idx<set->length(); idx++)
+        if(found[idx]) arr->append(head->new_int(idx, tainted));
+
+      delete [] found;
+    }
+
+    head->rSRC.push(head->new_array(arr, tainted));
+  }
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string", "match"), M_EXC_ARGS);
+
+  head->obj_unlink(str_var);
+}
+
+/**
+ * Returns a bool representation of the set.
+ */
+void regexset_to_b(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  bool val = ((ic_regexset *)obj->mData)->to_b();
+  head->rSRC.push(head->new_bool(val, obj->mTainted));
+}
+
+/**
+ * Inspect object
+ */
+void regexset_inspect(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  ic_regexset *set = (ic_regexset *)obj->mData;
+  ic_string *str = new ic_string("{regex_set:");
+  for(long idx=0; idx<set->length(); idx++)
+  {
+    if(idx) str->append(", ");
+    str->append(set->get(idx)->to_s());
+  }
+  str->append("}");
+
+  head->rSRC.push(head->new_string(str));
+}
+
+#endif
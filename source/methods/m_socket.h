@@ -0,0 +1,370 @@
+/**
+ * @file m_socket.h
+ * @author impworks
+ * Socket method header.
+ * Defines all methods for socket class.
+ */
+
+#ifndef M_SOCKET_H
+#define M_SOCKET_H
+
+/**
+ * Returns the event loop, which only the main thread may use.
+ * @return Reactor or NULL if an exception has been thrown.
+ */
+sc_reactor *socket_reactor(rc_head *head)
+{
+  if(std::this_thread::get_id() != head->pCore->mMainThread)
+  {
+    head->exception(M_ERR_SOCKET_THREAD, M_EXC_SCRIPT);
+    return NULL;
+  }
+
+  return head->pCore->reactor();
+}
+
+/**
+ * Socket constructor.
+ * The type is either 'tcp' (default), 'udp' or 'unix'.
+ */
+void socket_op_create(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *type_var = head->rSRC.pop();
+  ic_object *type = type_var->get();
+
+  if(!socket_reactor(head))
+  {
+    head->obj_unlink(type_var);
+    return;
+  }
+
+  int type_id = head->pCore->class_type(type->pClass);
+  if(type_id == M_CLASS_STRING)
+  {
+    ic_string *name = (ic_string *)type->mData;
+    ic_socket *sock = (ic_socket *)obj->mData;
+
+    if(!name->compare("tcp"))
+      sock->mType = SOCKET_TCP;
+    else if(!name->compare("udp"))
+      sock->mType = SOCKET_UDP;
+    else if(!name->compare("unix"))
+      sock->mType = SOCKET_UNIX;
+    else
+      head->exception(ic_string::format(M_ERR_SOCKET_TYPE, name->get()), M_EXC_ARGS);
+  }
+  else if(type_id != M_CLASS_UNDEF)
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string", "new socket"), M_EXC_ARGS);
+
+  head->obj_unlink(type_var);
+}
+
+/**
+ * Takes the host and the port for listen and connect.
+ * @param host_var Host variable.
+ * @param port_var Port variable.
+ * @param[out] port Port number.
+ * @param name Method name for the error message.
+ * @return Host name or NULL if the arguments are wrong.
+ */
+const char *socket_address(rc_head *head, rc_var *host_var, rc_var *port_var, long &port, const char *name)
+{
+  ic_object *host = host_var->get(), *port_obj = port_var->get();
+  int port_id = head->pCore->class_type(port_obj->pClass);
+
+  if(head->pCore->class_type(host->pClass) != M_CLASS_STRING)
+  {
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string", name), M_EXC_ARGS);
+    return NULL;
+  }
+
+  if(port_id != M_CLASS_INT && port_id != M_CLASS_UNDEF)
+  {
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 2, "int", name), M_EXC_ARGS);
+    return NULL;
+  }
+
+  port = port_id == M_CLASS_INT ? ((ic_int *)port_obj->mData)->mValue : 0;
+  return ((ic_string *)host->mData)->get();
+}
+
+/**
+ * Accepts a pending connection.
+ * Returns a new socket or undef if there are no connections pending.
+ */
+void socket_accept(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *conn = head->obj_create(head->pCore->mClassCache.pSocket);
+
+  if(((ic_socket *)obj->mData)->accept((ic_socket *)conn->get()->mData))
+    head->rSRC.push(conn);
+  else
+  {
+    head->obj_unlink(conn);
+    head->rSRC.push(head->new_undef());
+  }
+}
+
+/**
+ * Closes the socket and drops it's callbacks.
+ * Output that has not been sent yet is lost.
+ */
+void socket_close(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  ic_socket *sock = (ic_socket *)obj->mData;
+
+  head->pCore->reactor()->forget(head, sock);
+  head->obj_unlink(sock->pOnRead);
+  head->obj_unlink(sock->pOnWrite);
+  sock->pOnRead = sock->pOnWrite = NULL;
+  sock->close();
+}
+
+/**
+ * Connects the socket to a host and port, or a path for Unix domain sockets.
+ * The connection is established in the background.
+ */
+void socket_connect(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  ic_socket *sock = (ic_socket *)obj->mData;
+  rc_var *host_var = head->rSRC.pop(), *port_var = head->rSRC.pop();
+
+  long port;
+  const char *host = socket_address(head, host_var, port_var, port, "connect");
+  if(host)
+  {
+    head->pCore->reactor()->forget(head, sock);
+    bool result = sock->connect(host, port);
+    head->pCore->reactor()->watch(head, obj);
+    head->rSRC.push(head->new_bool(result));
+  }
+
+  head->obj_unlink(host_var);
+  head->obj_unlink(port_var);
+}
+
+/**
+ * Checks whether the peer has closed the connection and everything has been read.
+ */
+void socket_eof(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  ic_socket *sock = (ic_socket *)obj->mData;
+  sock->fill();
+  head->rSRC.push(head->new_bool(sock->mEof && !sock->mInput->length()));
+}
+
+/**
+ * Returns the number of bytes received, but not read yet.
+ */
+void socket_length(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  ic_socket *sock = (ic_socket *)obj->mData;
+  sock->fill();
+  head->rSRC.push(head->new_int(sock->mInput->length()));
+}
+
+/**
+ * Binds the socket to a host and port, or a path for Unix domain sockets.
+ * TCP and Unix domain sockets start accepting connections.
+ */
+void socket_listen(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  ic_socket *sock = (ic_socket *)obj->mData;
+  rc_var *host_var = head->rSRC.pop(), *port_var = head->rSRC.pop();
+
+  long port;
+  const char *host = socket_address(head, host_var, port_var, port, "listen");
+  if(host)
+  {
+    head->pCore->reactor()->forget(head, sock);
+    bool result = sock->listen(host, port);
+    head->pCore->reactor()->watch(head, obj);
+    head->rSRC.push(head->new_bool(result));
+  }
+
+  head->obj_unlink(host_var);
+  head->obj_unlink(port_var);
+}
+
+/**
+ * Runs the callbacks of the sockets until none are watched, the loop
+ * is stopped or no socket has become ready within the timeout.
+ * Returns the number of events handled.
+ */
+void socket_loop(rc_head *head)
+{
+  rc_var *timeout_var = head->rSRC.pop();
+  ic_object *timeout = timeout_var->get();
+  int timeout_id = head->pCore->class_type(timeout->pClass);
+
+  if(timeout_id != M_CLASS_INT && timeout_id != M_CLASS_UNDEF)
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "int", "loop"), M_EXC_ARGS);
+  else if(sc_reactor *reactor = socket_reactor(head))
+  {
+    long ms = timeout_id == M_CLASS_INT ? ((ic_int *)timeout->mData)->mValue : -1;
+    head->rSRC.push(head->new_int(reactor->run(head, ms)));
+  }
+
+  head->obj_unlink(timeout_var);
+}
+
+/**
+ * Sets a callback for a socket event.
+ * @param fx Callback slot.
+ * @param name Method name for the error message.
+ */
+void socket_callback(rc_head *head, rc_var **fx, const char *name)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *fx_var = head->rSRC.pop();
+  int fx_id = head->pCore->class_type(fx_var->get()->pClass);
+
+  if(fx_id != M_CLASS_METHOD && fx_id != M_CLASS_UNDEF)
+  {
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "method", name), M_EXC_ARGS);
+    head->obj_unlink(fx_var);
+    return;
+  }
+
+  head->obj_unlink(*fx);
+  if(fx_id == M_CLASS_METHOD)
+    *fx = fx_var;
+  else
+  {
+    *fx = NULL;
+    head->obj_unlink(fx_var);
+  }
+
+  head->pCore->reactor()->watch(head, obj);
+
+  head->pCurrObj->mLinks++;
+  head->rSRC.push(head->pCurrObj);
+}
+
+/**
+ * Sets the method to be called when there is data to read or
+ * a connection to accept. Undef removes the callback.
+ */
+void socket_on_read(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  socket_callback(head, &((ic_socket *)obj->mData)->pOnRead, "on_read");
+}
+
+/**
+ * Sets the method to be called once, when everything written has been sent
+ * or the connection has been established. Undef removes the callback.
+ */
+void socket_on_write(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  socket_callback(head, &((ic_socket *)obj->mData)->pOnWrite, "on_write");
+}
+
+/**
+ * Returns the number of bytes written, but not sent yet.
+ */
+void socket_pending(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_int(((ic_socket *)obj->mData)->pending()));
+}
+
+/**
+ * Reads the data received, all of it unless the size is given.
+ * Data from the network is tainted.
+ */
+void socket_read(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *size_var = head->rSRC.pop();
+  ic_object *size = size_var->get();
+  int size_id = head->pCore->class_type(size->pClass);
+
+  if(size_id == M_CLASS_INT || size_id == M_CLASS_UNDEF)
+  {
+    long len = size_id == M_CLASS_INT ? ((ic_int *)size->mData)->mValue : 0;
+    head->rSRC.push(head->new_string(((ic_socket *)obj->mData)->read(len), true));
+  }
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "int", "read"), M_EXC_ARGS);
+
+  head->obj_unlink(size_var);
+}
+
+/**
+ * Reads a line of the data received, or returns undef if there is no whole line yet.
+ */
+void socket_read_line(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  ic_string *line = ((ic_socket *)obj->mData)->read_line();
+  head->rSRC.push(line ? head->new_string(line, true) : head->new_undef());
+}
+
+/**
+ * Stops the event loop after the current callback.
+ */
+void socket_stop(rc_head *head)
+{
+  if(sc_reactor *reactor = socket_reactor(head))
+    reactor->stop();
+}
+
+/**
+ * Returns a boolean representation of the socket.
+ */
+void socket_to_b(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_bool(((ic_socket *)obj->mData)->to_b(), obj->mTainted));
+}
+
+/**
+ * Returns the descriptor of the socket.
+ */
+void socket_to_i(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_int(((ic_socket *)obj->mData)->to_i(), obj->mTainted));
+}
+
+/**
+ * Returns a string representation of the socket.
+ */
+void socket_to_s(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_string(((ic_socket *)obj->mData)->to_s(), obj->mTainted));
+}
+
+/**
+ * Writes a string to the socket.
+ * Output that cannot be sent at once is sent by the event loop.
+ */
+void socket_write(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *data_var = head->rSRC.pop();
+  ic_object *data = data_var->get();
+
+  if(head->pCore->class_type(data->pClass) == M_CLASS_STRING)
+  {
+    bool result = ((ic_socket *)obj->mData)->write((ic_string *)data->mData);
+    head->pCore->reactor()->watch(head, obj);
+    head->rSRC.push(head->new_bool(result));
+  }
+  else
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string", "write"), M_EXC_ARGS);
+
+  head->obj_unlink(data_var);
+}
+
+#endif
@@ -72,9 +72,12 @@ void string_op_mul_int(rc_head *head)
   rc_var *item_var = head->rSRC.pop();
   ic_object *item = item_var->get();
 
-  ic_string *newstr = new ic_string(*(ic_string *)obj->mData);
-  for(int idx = ((ic_int *)item->mData)->mValue; idx > 1; idx--)
-    newstr->append((ic_string *)obj->mData);
+  ic_string *src = (ic_string *)obj->mData;
+  long count = ((ic_int *)item->mData)->mValue;
+  ic_string *newstr = new ic_string(src->length() * (count > 1 ? count : 1));
+  newstr->append(src);
+  for(long idx = count; idx > 1; idx--)
+    newstr->append(src);
 
   head->rSRC.push(head->new_string(newstr));
   head->obj_unlink(item_var);
@@ -125,7 +128,9 @@ void string_op_shl_bool(rc_head *head)
   rc_var *item_var = head->rSRC.pop();
   ic_object *item = item_var->get();
 
-  ic_string *newstr = new ic_string(*(ic_string *)obj->mData);
+  ic_string *src = (ic_string *)obj->mData;
+  ic_string *newstr = new ic_string(src->length() + 5);
+  newstr->append(src);
   newstr->append(((ic_bool *)item->mData)->mValue ? "true" : "false");
   head->rSRC.push(head->new_string(newstr));
 
@@ -141,8 +146,10 @@ void string_op_shl_int(rc_head *head)
   rc_var *item_var = head->rSRC.pop();
   ic_object *item = item_var->get();
 
-  ic_string *newstr = new ic_string(*(ic_string *)obj->mData);
-  newstr->append(((ic_int *)item->mData)->to_s());
+  ic_string *src = (ic_string *)obj->mData;
+  ic_string *newstr = new ic_string(src->length() + 24);
+  newstr->append(src);
+  newstr->append_int(((ic_int *)item->mData)->mValue);
   head->rSRC.push(head->new_string(newstr));
 
   head->obj_unlink(item_var);
@@ -157,8 +164,10 @@ void string_op_shl_float(rc_head *head)
   rc_var *item_var = head->rSRC.pop();
   ic_object *item = item_var->get();
 
-  ic_string *newstr = new ic_string(*(ic_string *)obj->mData);
-  newstr->append(((ic_float *)item->mData)->to_s());
+  ic_string *src = (ic_string *)obj->mData;
+  ic_string *newstr = new ic_string(src->length() + 32);
+  newstr->append(src);
+  newstr->append_float(((ic_float *)item->mData)->mValue);
   head->rSRC.push(head->new_string(newstr));
 
   head->obj_unlink(item_var);
@@ -173,8 +182,10 @@ void string_op_shl_string(rc_head *head)
   rc_var *str_var = head->rSRC.pop();
   ic_object *str = str_var->get();
 
-  ic_string *newstr = new ic_string(*(ic_string *)obj->mData);
-  newstr->append((ic_string *)str->mData);
+  ic_string *src = (ic_string *)obj->mData, *right = (ic_string *)str->mData;
+  ic_string *newstr = new ic_string(src->length() + right->length());
+  newstr->append(src);
+  newstr->append(right);
   head->rSRC.push(head->new_string(newstr));
 
   head->obj_unlink(str_var);
@@ -215,8 +226,10 @@ void string_op_shl_object(rc_head *head)
     return;
   }
 
-  ic_string *newstr = new ic_string(*(ic_string *)obj->mData);
-  newstr->append((ic_string *)str->mData);
+  ic_string *src = (ic_string *)obj->mData, *right = (ic_string *)str->mData;
+  ic_string *newstr = new ic_string(src->length() + right->length());
+  newstr->append(src);
+  newstr->append(right);
   head->rSRC.push(head->new_string(newstr, obj->mTainted || str->mTainted));
 
   head->obj_unlink(str_var);
@@ -236,7 +249,11 @@ void string_op_idx(rc_head *head)
   {
     // return a substring by range
     ic_range *rg = (ic_range*)item->mData;
+#if MALCO_UNICODE == 1
+    ic_string *newstr = ((ic_string *)obj->mData)->substr_chars(rg->mStart, rg->mEnd - rg->mStart);
+#else
     ic_string *newstr = ((ic_string *)obj->mData)->substr_get(rg->mStart, rg->mEnd - rg->mStart);
+#endif
     head->rSRC.push(head->new_string(newstr, obj->mTainted));
   }
   else if(cls == M_CLASS_STRING)
@@ -259,6 +276,8 @@ void string_op_idx(rc_head *head)
     }
     else
       head->rSRC.push(head->new_int(-1, obj->mTainted));
+
+    delete match;
   }
   else
     head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "range, string or regex", "[]"), M_EXC_ARGS);
@@ -345,10 +364,50 @@ void string_op_rel_regex(rc_head *head)
 void string_length(rc_head *head)
 {
   ic_object *obj = head->pCurrObj->get();
+#if MALCO_UNICODE == 1
+  long length = ((ic_string*)obj->mData)->chars();
+#else
   long length = ((ic_string*)obj->mData)->length();
+#endif
   head->rSRC.push(head->new_int(length, obj->mTainted));
 }
 
+/**
+ * Returns the number of characters the string can hold without reallocating.
+ */
+void string_capacity(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  long capacity = ((ic_string*)obj->mData)->capacity();
+  head->rSRC.push(head->new_int(capacity, obj->mTainted));
+}
+
+/**
+ * Preallocates memory for a string that is going to be built with append!.
+ */
+void string_reserve_do(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *cpc_var = head->rSRC.pop();
+  ic_object *cpc = cpc_var->get();
+
+  if(!obj->mFrozen)
+  {
+    if(cpc->class_id() == M_CLASS_INT)
+    {
+      ((ic_string *)obj->mData)->reserve(((ic_int *)cpc->mData)->mValue);
+      head->pCurrObj->mLinks++;
+      head->rSRC.push(head->pCurrObj);
+    }
+    else
+      head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "int", "reserve!"), M_EXC_ARGS);
+  }
+  else
+    head->exception(M_ERR_FROZEN, M_EXC_SCRIPT);
+
+  head->obj_unlink(cpc_var);
+}
+
 /**
  * Returns the trimmed string.
  */
@@ -440,8 +499,12 @@ void string_trim_right_do(rc_head *head)
 void string_ord(rc_head *head)
 {
   ic_object *obj = head->pCurrObj->get();
-  char chr = ((ic_string *)obj->mData)->char_at(0);
-  head->rSRC.push(head->new_int((long)chr, obj->mTainted));
+#if MALCO_UNICODE == 1
+  long chr = ((ic_string *)obj->mData)->char_code(0);
+#else
+  long chr = (unsigned char)((ic_string *)obj->mData)->char_at(0);
+#endif
+  head->rSRC.push(head->new_int(chr, obj->mTainted));
 }
 
 /**
@@ -450,8 +513,12 @@ void string_ord(rc_head *head)
 void string_reverse(rc_head *head)
 {
   ic_object *obj = head->pCurrObj->get();
-  rc_var *newobj = head->new_string((ic_string *)obj->mData, obj->mTainted);
+  rc_var *newobj = head->new_string(new ic_string(*(ic_string *)obj->mData), obj->mTainted);
+#if MALCO_UNICODE == 1
+  ((ic_string *)newobj->get()->mData)->reverse_chars();
+#else
   ((ic_string *)newobj->get()->mData)->reverse();
+#endif
   newobj->get()->taint(obj->mTainted);
   head->rSRC.push(newobj);
 }
@@ -464,7 +531,11 @@ void string_reverse_do(rc_head *head)
   ic_object *obj = head->pCurrObj->get();
   if(!obj->mFrozen)
   {
+#if MALCO_UNICODE == 1
+    ((ic_string *)obj->mData)->reverse_chars();
+#else
     ((ic_string *)obj->mData)->reverse();
+#endif
     head->pCurrObj->mLinks++;
     head->rSRC.push(head->pCurrObj);
   }
@@ -484,7 +555,11 @@ void string_sub(rc_head *head)
   if(head->pCore->class_type(start->pClass) == M_CLASS_RANGE && !len)
   {
     ic_range *iv = (ic_range *)start->mData;
+#if MALCO_UNICODE == 1
+    ic_string *str = ((ic_string *)obj->mData)->substr_chars(iv->mStart, iv->mEnd-iv->mStart);
+#else
     ic_string *str = ((ic_string *)obj->mData)->substr_get(iv->mStart, iv->mEnd-iv->mStart);
+#endif
     if(str)
       head->rSRC.push(head->new_string(str, obj->mTainted));
     else
@@ -498,7 +573,11 @@ void string_sub(rc_head *head)
     if(head->pCore->class_type(len->pClass) == M_CLASS_INT)
     {
       long s = ((ic_int *)start->mData)->mValue, l = ((ic_int *)len->mData)->mValue;
+#if MALCO_UNICODE == 1
+      ic_string *str = ((ic_string *)obj->mData)->substr_chars(s, l);
+#else
       ic_string *str = ((ic_string *)obj->mData)->substr_get(s, l);
+#endif
       if(str)
         head->rSRC.push(head->new_string(str, obj->mTainted));
       else
@@ -631,8 +710,10 @@ void string_append(rc_head *head)
     }
   }
 
-  ic_string *newstr = new ic_string(*(ic_string *)obj->mData);
-  newstr->append((ic_string *)str->mData);
+  ic_string *src = (ic_string *)obj->mData, *right = (ic_string *)str->mData;
+  ic_string *newstr = new ic_string(src->length() + right->length());
+  newstr->append(src);
+  newstr->append(right);
   head->rSRC.push(head->new_string(newstr, obj->mTainted || str->mTainted));
 
   head->obj_unlink(str_var);
@@ -669,8 +750,64 @@ void string_prepend(rc_head *head)
   head->obj_unlink(str_var);
 }
 
+/**
+ * Builds a dictionary of an array of strings to be replaced at once.
+ * @param from Array of strings to search for.
+ * @param to Replacement string or array of replacements for every string.
+ * @param[out] set Dictionary to fill.
+ * @param name Method name for error messages.
+ * @return Replacement for every string id, NULL if arguments are wrong (an exception is raised).
+ */
+ic_string **string_replace_dict(rc_head *head, ic_object *from, ic_object *to, sc_strset *set, const char *name)
+{
+  ic_array *from_arr = (ic_array *)from->mData, *to_arr = NULL;
+  sc_voidmapitem *curr;
+
+  if(head->pCore->class_type(to->pClass) == M_CLASS_ARRAY)
+  {
+    to_arr = (ic_array *)to->mData;
+    if(to_arr->length() != from_arr->length())
+    {
+      head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 2, "array of the same length", name), M_EXC_ARGS);
+      return NULL;
+    }
+    to_arr->iter_rewind();
+  }
+
+  ic_string **list = new ic_string*[from_arr->length() ? from_arr->length() : 1];
+  if(!list) ERROR(M_ERR_NO_MEMORY, M_EMODE_ERROR);
+
+  from_arr->iter_rewind();
+  while(curr = from_arr->iter_next())
+  {
+    ic_object *item = ((rc_var *)curr->mValue)->get(), *rep = to;
+    if(to_arr)
+      rep = ((rc_var *)to_arr->iter_next()->mValue)->get();
+
+    if(head->pCore->class_type(item->pClass) != M_CLASS_STRING)
+    {
+      head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "array of strings", name), M_EXC_ARGS);
+      delete [] list;
+      return NULL;
+    }
+
+    if(head->pCore->class_type(rep->pClass) != M_CLASS_STRING)
+    {
+      head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 2, "string or array of strings", name), M_EXC_ARGS);
+      delete [] list;
+      return NULL;
+    }
+
+    ic_string *str = (ic_string *)item->mData;
+    list[set->add(str->get(), str->length())] = (ic_string *)rep->mData;
+  }
+
+  return list;
+}
+
 /**
  * Returns a string with substring matched by string / regex replaced.
+ * An array of strings is replaced in a single pass, the leftmost and longest one first.
  */
 void string_replace(rc_head *head)
 {
@@ -695,8 +832,9 @@ void string_replace(rc_head *head)
     }
   }
 
-  // validate 'to'
-  if(head->pCore->class_type(to->pClass) != M_CLASS_STRING)
+  // validate 'to' (an array is only allowed for an array of strings)
+  char cls = head->pCore->class_type(from->pClass);
+  if(head->pCore->class_type(to->pClass) != M_CLASS_STRING && (cls != M_CLASS_ARRAY || head->pCore->class_type(to->pClass) != M_CLASS_ARRAY))
   {
     head->obj_unlink(from_var);
     head->obj_unlink(to_var);
@@ -706,7 +844,6 @@ void string_replace(rc_head *head)
   }
 
   // validate 'from'
-  char cls = head->pCore->class_type(from->pClass);
   if(cls == M_CLASS_STRING)
   {
     newstr->replace((ic_string *)from->mData, (ic_string *)to->mData, count);
@@ -717,8 +854,21 @@ void string_replace(rc_head *head)
     newstr->replace((ic_regex *)from->mData, (ic_string *)to->mData, count);
     head->rSRC.push(head->new_string(newstr, obj->mTainted || to->mTainted));
   }
+  else if(cls == M_CLASS_ARRAY)
+  {
+    sc_strset set;
+    ic_string **list = string_replace_dict(head, from, to, &set, "replace");
+    if(list)
+    {
+      newstr->replace(&set, list, count);
+      head->rSRC.push(head->new_string(newstr, obj->mTainted || to->mTainted));
+      delete [] list;
+    }
+    else
+      delete newstr;
+  }
   else
-    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string or regex", "replace"), M_EXC_ARGS);
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string, regex or array", "replace"), M_EXC_ARGS);
 
   head->obj_unlink(from_var);
   head->obj_unlink(to_var);
@@ -736,7 +886,26 @@ void string_append_do(rc_head *head)
 
   if(!obj->mFrozen)
   {
-    if(head->pCore->class_type(str->pClass) != M_CLASS_STRING)
+    // numbers are printed right into the string without a to_s temporary
+    char cls = head->pCore->class_type(str->pClass);
+    if(cls == M_CLASS_INT || cls == M_CLASS_FLOAT || cls == M_CLASS_BOOL)
+    {
+      ic_string *self = (ic_string *)obj->mData;
+      if(cls == M_CLASS_INT)
+        self->append_int(((ic_int *)str->mData)->mValue);
+      else if(cls == M_CLASS_FLOAT)
+        self->append_float(((ic_float *)str->mData)->mValue);
+      else
+        self->append(((ic_bool *)str->mData)->mValue ? "true" : "false");
+
+      if(str->mTainted) obj->mTainted = true;
+      head->pCurrObj->mLinks++;
+      head->rSRC.push(head->pCurrObj);
+      head->obj_unlink(str_var);
+      return;
+    }
+
+    if(cls != M_CLASS_STRING)
     {
       head->method_invoke("to_s", str_var);
       head->obj_unlink(str_var);
@@ -801,6 +970,7 @@ void string_prepend_do(rc_head *head)
 
 /**
  * Replaces a substring matched by string / regex.
+ * An array of strings is replaced in a single pass, the leftmost and longest one first.
  */
 void string_replace_do(rc_head *head)
 {
@@ -826,8 +996,9 @@ void string_replace_do(rc_head *head)
       }
     }
 
-    // validate 'to'
-    if(head->pCore->class_type(to->pClass) != M_CLASS_STRING)
+    // validate 'to' (an array is only allowed for an array of strings)
+    char cls = head->pCore->class_type(from->pClass);
+    if(head->pCore->class_type(to->pClass) != M_CLASS_STRING && (cls != M_CLASS_ARRAY || head->pCore->class_type(to->pClass) != M_CLASS_ARRAY))
     {
       head->obj_unlink(from_var);
       head->obj_unlink(to_var);
@@ -837,7 +1008,6 @@ void string_replace_do(rc_head *head)
     }
 
     // validate 'from'
-    char cls = head->pCore->class_type(from->pClass);
     if(cls == M_CLASS_STRING)
     {
       ((ic_string *)obj->mData)->replace((ic_string *)from->mData, (ic_string *)to->mData, count);
@@ -850,8 +1020,20 @@ void string_replace_do(rc_head *head)
       head->pCurrObj->mLinks++;
       head->rSRC.push(head->pCurrObj);
     }
+    else if(cls == M_CLASS_ARRAY)
+    {
+      sc_strset set;
+      ic_string **list = string_replace_dict(head, from, to, &set, "replace!");
+      if(list)
+      {
+        ((ic_string *)obj->mData)->replace(&set, list, count);
+        head->pCurrObj->mLinks++;
+        head->rSRC.push(head->pCurrObj);
+        delete [] list;
+      }
+    }
     else
-      head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string or regex", "replace!"), M_EXC_ARGS);
+      head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string, regex or array", "replace!"), M_EXC_ARGS);
 
     if(to->mTainted) obj->mTainted = true;
   }
@@ -924,6 +1106,89 @@ void string_split(rc_head *head)
   head->obj_unlink(max_var);
 }
 
+/**
+ * Scans the string for all occurences of a substring or matches of a regex.
+ * For a substring, returns an array of positions where it is found.
+ * For a regex, calls a function on each match, or returns an array of matched
+ * substrings (arrays of groups if the regex has any) when no function is given.
+ */
+void string_scan(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *rx_var = head->rSRC.pop(), *fx_var = head->rSRC.pop();
+  ic_object *rx = rx_var->get(), *fx = (fx_var ? fx_var->get() : NULL);
+  ic_string *str = (ic_string *)obj->mData;
+
+  if(fx && head->pCore->class_type(fx->pClass) == M_CLASS_UNDEF)
+    fx = NULL;
+
+  char cls = head->pCore->class_type(rx->pClass);
+  if(cls == M_CLASS_STRING)
+  {
+    ic_string *sub = (ic_string *)rx->mData;
+    ic_array *arr = new ic_array();
+    long pos = 0, step = sub->length() ? sub->length() : 1;
+
+    while(pos <= str->length() && (pos = str->substr_first(sub, pos)) != -1)
+    {
+      arr->append(head->new_int(pos, obj->mTainted));
+      pos += step;
+    }
+
+    head->rSRC.push(head->new_array(arr, obj->mTainted));
+  }
+  else if(cls != M_CLASS_REGEX)
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string or regex", "scan"), M_EXC_ARGS);
+  else if(fx && head->pCore->class_type(fx->pClass) != M_CLASS_METHOD)
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 2, "method", "scan"), M_EXC_ARGS);
+  else if(fx)
+  {
+    ic_matchiter iter((ic_regex *)rx->mData, str->get(), str->length());
+    ic_match *match;
+
+    while(match = iter.next())
+    {
+      head->rSRC.push(head->new_match(match, obj->mTainted));
+      head->method_invoke((rc_method *)fx->mData);
+      head->cmd_clrsrc();
+
+      // the function might have modified the string
+      iter.source(str->get(), str->length());
+    }
+  }
+  else
+  {
+    const char *buf = str->get();
+    ic_matchiter iter((ic_regex *)rx->mData, buf, str->length());
+    const long *bounds = iter.captures();
+    ic_array *arr = new ic_array();
+
+    while(iter.find())
+    {
+      if(iter.count() == 1)
+      {
+        ic_string *item = bounds[1] > bounds[0] ? new ic_string(buf+bounds[0], bounds[1]-bounds[0]) : new ic_string();
+        arr->append(head->new_string(item, obj->mTainted));
+        continue;
+      }
+
+      ic_array *groups = new ic_array();
+      for(long idx=1; idx<iter.count(); idx++)
+      {
+        long from = bounds[idx*2], to = bounds[idx*2+1];
+        ic_string *item = to > from ? new ic_string(buf+from, to-from) : new ic_string();
+        groups->append(head->new_string(item, obj->mTainted));
+      }
+      arr->append(head->new_array(groups, obj->mTainted));
+    }
+
+    head->rSRC.push(head->new_array(arr, obj->mTainted));
+  }
+
+  head->obj_unlink(rx_var);
+  head->obj_unlink(fx_var);
+}
+
 /**
  * Returns a string with a lambda applied to the string's part.
  */
@@ -1078,19 +1343,47 @@ void string_insert_do(rc_head *head)
 
 /**
  * Checks if string contains a substring.
+ * For an array of strings, checks if it contains any of them in a single pass.
  */
 void string_has(rc_head *head)
 {
   ic_object *obj = head->pCurrObj->get();
   rc_var *str_var = head->rSRC.pop();
   ic_object *str = str_var->get();
-  if(head->pCore->class_type(str->pClass) == M_CLASS_STRING)
+  char cls = head->pCore->class_type(str->pClass);
+  if(cls == M_CLASS_STRING)
   {
     bool has = ((ic_string *)obj->mData)->substr_first((ic_string *)str->mData) > -1;
     head->rSRC.push(head->new_bool(has, obj->mTainted));
   }
+  else if(cls == M_CLASS_ARRAY)
+  {
+    ic_array *arr = (ic_array *)str->mData;
+    sc_voidmapitem *curr;
+    sc_strset set;
+    bool valid = true;
+
+    arr->iter_rewind();
+    while(valid && (curr = arr->iter_next()))
+    {
+      ic_object *item = ((rc_var *)curr->mValue)->get();
+      if(head->pCore->class_type(item->pClass) == M_CLASS_STRING)
+        set.add(((ic_string *)item->mData)->get(), ((ic_string *)item->mData)->length());
+      else
+        valid = false;
+    }
+
+    if(valid)
+    {
+      ic_string *text = (ic_string *)obj->mData;
+      bool has = set.any(text->get(), text->length());
+      head->rSRC.push(head->new_bool(has, obj->mTainted));
+    }
+    else
+      head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string or array of strings", "has"), M_EXC_ARGS);
+  }
   else
-    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string", "has"), M_EXC_ARGS);
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "string or array of strings", "has"), M_EXC_ARGS);
 
   head->obj_unlink(str_var);
 }
@@ -1189,6 +1482,13 @@ void string_chars(rc_head *head)
   ic_array *newarr = new ic_array();
   
   char *buf = str->get();
+#if MALCO_UNICODE == 1
+  for(long pos = 0, next; pos < str->length(); pos = next)
+  {
+    next = sc_utf8::next(buf, str->length(), pos);
+    newarr->append(head->new_string(new ic_string(buf + pos, next - pos)), obj->mTainted);
+  }
+#else
   char newstr[2];
   newstr[1] = '\0';
   for(long idx=0; idx < str->length(); idx++)
@@ -1196,6 +1496,7 @@ void string_chars(rc_head *head)
     newstr[0] = buf[idx];
     newarr->append(head->new_string(newstr), obj->mTainted);
   }
+#endif
 
   head->rSRC.push(head->new_array(newarr, obj->mTainted));
 }
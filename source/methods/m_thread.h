@@ -0,0 +1,146 @@
+/**
+ * @file m_thread.h
+ * @author impworks
+ * Thread method header.
+ * Defines all methods for thread class.
+ */
+
+#ifndef M_THREAD_H
+#define M_THREAD_H
+
+/**
+ * Thread constructor.
+ * Starts the method with a copy of the other arguments.
+ */
+void thread_op_create(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *fx_var = head->rSRC.pop();
+  ic_object *fx = fx_var->get();
+
+  if(head->pCore->class_type(fx->pClass) != M_CLASS_METHOD)
+    head->exception(ic_string::format(M_ERR_FX_WRONG_TYPE, 1, "method", "new thread"), M_EXC_ARGS);
+  else if(((rc_method *)fx->mData)->pExternalScope)
+    head->exception(M_ERR_THREAD_SCOPE, M_EXC_ARGS);
+  else
+    ((ic_thread *)obj->mData)->start(head, (rc_method *)fx->mData);
+
+  head->cmd_clrsrc();
+  head->obj_unlink(fx_var);
+}
+
+/**
+ * Checks whether the thread is still running.
+ */
+void thread_alive(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_bool(((ic_thread *)obj->mData)->alive()));
+}
+
+/**
+ * Returns the number of threads the hardware can run at once.
+ */
+void thread_cores(rc_head *head)
+{
+  long count = (long)std::thread::hardware_concurrency();
+  head->rSRC.push(head->new_int(count ? count : 1));
+}
+
+/**
+ * Waits for the thread and returns a copy of the value the method has returned.
+ * An exception thrown by the method is thrown again.
+ */
+void thread_join(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  ic_thread *thread = (ic_thread *)obj->mData;
+  thread->join();
+
+  if(!thread->mResult)
+    head->rSRC.push(head->new_undef());
+  else if(thread->mFailed)
+  {
+    head->obj_unlink(head->rAX);
+    head->rAX = head->obj_copy(thread->mResult);
+    head->cmd_throw();
+  }
+  else
+    head->rSRC.push(head->obj_copy(thread->mResult));
+}
+
+/**
+ * Waits for a message sent to the current thread.
+ * Returns undef once the main head has finished.
+ */
+void thread_listen(rc_head *head)
+{
+  if(head->pThread)
+  {
+    rc_var *msg = head->pThread->listen();
+    head->rSRC.push(msg ? msg : head->new_undef());
+  }
+  else
+    head->exception(ic_string::format(M_ERR_THREAD_MAIN, "listen"), M_EXC_SCRIPT);
+}
+
+/**
+ * Waits for a message from the thread.
+ * Returns undef if the thread has finished without sending any.
+ */
+void thread_receive(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *msg = ((ic_thread *)obj->mData)->receive();
+  head->rSRC.push(msg ? msg : head->new_undef());
+}
+
+/**
+ * Sends a copy of the value to the head that has started the current thread.
+ */
+void thread_reply(rc_head *head)
+{
+  rc_var *msg = head->rSRC.pop();
+
+  if(head->pThread)
+    head->pThread->reply(head->obj_copy(msg));
+  else
+    head->exception(ic_string::format(M_ERR_THREAD_MAIN, "reply"), M_EXC_SCRIPT);
+
+  head->obj_unlink(msg);
+}
+
+/**
+ * Sends a copy of the value to the thread.
+ */
+void thread_send(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  rc_var *msg = head->rSRC.pop();
+
+  ((ic_thread *)obj->mData)->send(head->obj_copy(msg));
+  head->obj_unlink(msg);
+
+  head->pCurrObj->mLinks++;
+  head->rSRC.push(head->pCurrObj);
+}
+
+/**
+ * Returns a boolean representation of the thread.
+ */
+void thread_to_b(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_bool(((ic_thread *)obj->mData)->to_b(), obj->mTainted));
+}
+
+/**
+ * Returns a string representation of the thread.
+ */
+void thread_to_s(rc_head *head)
+{
+  ic_object *obj = head->pCurrObj->get();
+  head->rSRC.push(head->new_string(((ic_thread *)obj->mData)->to_s(), obj->mTainted));
+}
+
+#endif
@@ -91,6 +91,7 @@
 #define RASM_CMD_RETURN       51
 #define RASM_CMD_NSP          52
 #define RASM_CMD_BINDLAMBDA   53
+#define RASM_CMD_YIELD        68
 
 // array-specific actions
 #define RASM_CMD_INDEX        54
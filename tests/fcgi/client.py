@@ -0,0 +1,96 @@
+"""
+FastCGI test client.
+Sends two requests interleaved over one connection, the way a web server
+multiplexing requests would, and prints what has come back for each of them.
+Usage: client.py <socket>
+"""
+
+import socket
+import struct
+import sys
+import time
+
+VERSION = 1
+BEGIN_REQUEST, END_REQUEST, PARAMS, STDIN, STDOUT, STDERR = 1, 3, 4, 5, 6, 7
+RESPONDER, KEEP_CONN = 1, 1
+
+
+def record(type, id, content=b""):
+    return struct.pack(">BBHHBx", VERSION, type, id, len(content), 0) + content
+
+
+def pair(name, value):
+    name, value = name.encode(), value.encode()
+    return bytes([len(name), len(value)]) + name + value
+
+
+def params(query, body):
+    return (pair("REQUEST_METHOD", "POST") + pair("REQUEST_URI", "/?" + query) +
+            pair("QUERY_STRING", query) + pair("CONTENT_LENGTH", str(len(body))))
+
+
+def connect(path):
+    for _ in range(50):
+        try:
+            conn = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            conn.connect(path)
+            return conn
+        except OSError:
+            conn.close()
+            time.sleep(0.1)
+    sys.exit("could not connect to " + path)
+
+
+def main():
+    conn = connect(sys.argv[1])
+    conn.settimeout(5)
+
+    begin = struct.pack(">HB5x", RESPONDER, KEEP_CONN)
+    conn.sendall(b"".join([
+        record(BEGIN_REQUEST, 1, begin),
+        record(BEGIN_REQUEST, 2, begin),
+        record(PARAMS, 2, params("name=second", "two")),
+        record(PARAMS, 1, params("name=first", "one, split")),
+        record(PARAMS, 1),
+        record(STDIN, 1, b"one, "),
+        record(PARAMS, 2),
+        record(STDIN, 2, b"two"),
+        record(STDIN, 1, b"split"),
+        record(STDIN, 2),
+        record(STDIN, 1),
+    ]))
+
+    # read records until both requests have ended
+    data, out, ended = b"", {1: b"", 2: b""}, {}
+    closed = {1: False, 2: False}
+    while len(ended) < 2:
+        while len(data) >= 8:
+            version, type, id, size, padding = struct.unpack(">BBHHBx", data[:8])
+            if len(data) < 8 + size + padding:
+                break
+            content, data = data[8:8 + size], data[8 + size + padding:]
+            if type == STDOUT and size:
+                out[id] += content
+            elif type == STDOUT:
+                closed[id] = True
+            elif type == END_REQUEST:
+                ended[id] = struct.unpack(">IB3x", content)
+            elif type == STDERR:
+                sys.stderr.write(content.decode())
+        if len(ended) == 2:
+            break
+        chunk = conn.recv(65536)
+        if not chunk:
+            sys.exit("connection closed before both requests have ended")
+        data += chunk
+
+    conn.close()
+
+    for id in (1, 2):
+        print("request %d:" % id)
+        print(out[id].decode().replace("\r\n", "\n"))
+        print("stdout closed: %s" % closed[id])
+        print("end: app status %d, protocol status %d" % ended[id])
+
+
+main()
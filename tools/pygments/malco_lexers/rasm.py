@@ -16,7 +16,7 @@ class RasmLexer(RegexLexer):
             (r';.*?$', Comment.Single),
             
             # Commands, tables, modifiers
-            (r'(LOADAX|LOADBX|SAVEAX|SAVEBX|XCHG|ASSIGN|UNSPLASSIGN|ADD|SUB|MUL|DIV|MOD|POW|SHL|SHR|BAND|BOR|BXOR|AND|OR|XOR|INC|DEC|NEG|EQ|EQ_STRICT|REL|LESS|LESS_EQ|GREATER|GREATER_EQ|CMP|JTRUE|JFALSE|JMP|PUSHUS|POPUS|PUSHSRC|POPSRC|PUSHDST |POPDST|SPLAT|UNSPLAT|CLRSRC|CLRDST|NEW|CALL|RETURN|NSP|BINDLAMBDA|INDEX|INCLUDE|REQUIRE|GC|SETPTY|SETFILE|SETLINE |THROW|TRY|TRIED|EXIT|REGCLASS|REGPROPERTY|REGMETHOD|INSPECT)\b', bygroups(Name.Builtin)),
+            (r'(LOADAX|LOADBX|SAVEAX|SAVEBX|XCHG|ASSIGN|UNSPLASSIGN|ADD|SUB|MUL|DIV|MOD|POW|SHL|SHR|BAND|BOR|BXOR|AND|OR|XOR|INC|DEC|NEG|EQ|EQ_STRICT|REL|LESS|LESS_EQ|GREATER|GREATER_EQ|CMP|JTRUE|JFALSE|JMP|PUSHUS|POPUS|PUSHSRC|POPSRC|PUSHDST |POPDST|SPLAT|UNSPLAT|CLRSRC|CLRDST|NEW|CALL|RETURN|NSP|BINDLAMBDA|YIELD|INDEX|INCLUDE|REQUIRE|GC|SETPTY|SETFILE|SETLINE |THROW|TRY|TRIED|EXIT|REGCLASS|REGPROPERTY|REGMETHOD|INSPECT)\b', bygroups(Name.Builtin)),
             (r'(INT|FLOAT|STR|VAL)', Keyword.Type),
             
             # Pseudo commands (more complicated than others)